@@ -129,6 +129,7 @@ include $(CLEAR_VARS)
 LOCAL_MODULE := VkLayer_screenshot
 LOCAL_SRC_FILES += $(SRC_DIR)/layersvt/screenshot.cpp
 LOCAL_SRC_FILES += $(SRC_DIR)/layersvt/screenshot_parsing.cpp
+LOCAL_SRC_FILES += $(SRC_DIR)/layersvt/screenshot_encoding.cpp
 LOCAL_SRC_FILES += $(SRC_DIR)/layers/vk_layer_table.cpp
 LOCAL_C_INCLUDES += $(SRC_DIR)/include \
                     $(SRC_DIR)/layers \
@@ -32,7 +32,11 @@
 #include <map>
 #include <set>
 #include <vector>
+#include <deque>
 #include <fstream>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 using namespace std;
 
@@ -43,6 +47,7 @@ using namespace std;
 #include "vk_layer_utils.h"
 
 #include "screenshot_parsing.h"
+#include "screenshot_encoding.h"
 
 #ifdef ANDROID
 
@@ -135,31 +140,75 @@ typedef enum colorSpaceFormat {
 
 colorSpaceFormat userColorSpaceFormat = UNDEFINED;
 
+// File format of the screenshots and number of writer threads, read from
+// vk_layer_settings.txt
+static ScreenshotFileFormat screenshotFileFormat = SCREENSHOT_FILE_PPM;
+static uint32_t writerThreadCount = 1;
+
+// Number of screenshots of a swapchain that can be in flight at once, at the
+// least.  The copy of a screenshot is checked for completion at the presents
+// that follow it, and the screenshot is then written by a writer thread.  A
+// present only waits when every readback of its swapchain is still busy.
+static const uint32_t minReadbacksPerSwapchain = 3;
+
+typedef enum ReadbackState {
+    READBACK_IDLE = 0,     // free for the next screenshot
+    READBACK_PENDING = 1,  // copy submitted, not known to be complete yet
+    READBACK_WRITING = 2,  // copy complete, queued on or being written by a writer thread
+} ReadbackState;
+
+// Resources that read back one screenshot.  They are created the first time
+// they're needed and reused for later screenshots of the same swapchain.
+typedef struct {
+    bool created;
+    ReadbackState state;
+    uint64_t sequence;             // submission order of the pending copies
+    VkImage blitImage;             // swapchain image converted to the screenshot format, if needed
+    VkDeviceMemory blitMemory;
+    VkBuffer buffer;               // host visible screenshot, rows tightly packed
+    VkDeviceMemory bufferMemory;
+    bool bufferCoherent;
+    const char *bufferData;        // buffer memory, mapped for as long as the readback exists
+    VkCommandBuffer commandBuffer;
+    VkFence fence;
+    VkSemaphore semaphore;         // signaled by the copy, waited on by the present
+    string fileName;
+} ScreenshotReadback;
+
+// Screenshot format and readbacks of a swapchain, created on its first screenshot
+typedef struct {
+    VkDevice device;
+    uint32_t width;
+    uint32_t height;
+    ScreenshotPixelLayout pixelLayout;  // of the buffers, which the writers convert to RGB
+    VkFormat destFormat;
+    bool copyOnly;
+    VkDeviceSize rowPitch;
+    uint64_t nextSequence;
+    vector<ScreenshotReadback> readbacks;  // never resized, as writer jobs point into it
+} SwapchainReadbackStruct;
+
 // unordered map: associates a swap chain with a device, image extent, format,
-// and list of images
+// list of images, and its screenshot readbacks
 typedef struct {
     VkDevice device;
     VkExtent2D imageExtent;
     VkFormat format;
     VkImage *imageList;
+    SwapchainReadbackStruct *readback;
 } SwapchainMapStruct;
 static unordered_map<VkSwapchainKHR, SwapchainMapStruct *> swapchainMap;
 
-// unordered map: associates an image with a device, image extent, and format
-typedef struct {
-    VkDevice device;
-    VkExtent2D imageExtent;
-    VkFormat format;
-} ImageMapStruct;
-static unordered_map<VkImage, ImageMapStruct *> imageMap;
-
-// unordered map: associates a device with a queue, commandPool, and physical
-// device also contains per device info including dispatch table
+// unordered map: associates a device with a queue and physical device, also
+// contains per device info including dispatch table, and the queue and
+// command pool that screenshots are copied with
 typedef struct {
     VkLayerDispatchTable *device_dispatch_table;
     bool wsi_enabled;
     VkQueue queue;
-    std::list<VkCommandPool> commandPools;
+    uint32_t queueFamilyIndex;
+    VkQueue captureQueue;
+    VkCommandPool captureCommandPool;
     VkPhysicalDevice physicalDevice;
     PFN_vkSetDeviceLoaderData pfn_dev_init;
 } DeviceMapStruct;
@@ -251,6 +300,27 @@ void readScreenShotFormatENV(void) {
     }
 }
 
+// Read the file format of the screenshots and the number of writer threads
+// from vk_layer_settings.txt
+static void readScreenShotSettings(void) {
+    const char *fileFormat = getLayerOption("lunarg_screenshot.file_format");
+    if (*fileFormat && !parseScreenshotFileFormat(fileFormat, &screenshotFileFormat)) {
+#ifdef ANDROID
+#else
+        fprintf(stderr, "Selected file format:%s\nIs NOT in the list:\nPPM, PNG, QOI\nPPM will be used instead\n", fileFormat);
+#endif
+    }
+
+    // Every writer thread adds a readback to each swapchain, so only use as
+    // many as were asked for, or two if the CPU has them
+    int threads = atoi(getLayerOption("lunarg_screenshot.writer_threads"));
+    if (threads > 0) {
+        writerThreadCount = std::min(threads, 16);
+    } else {
+        writerThreadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), 2u));
+    }
+}
+
 // detect if frameNumber reach or beyond the right edge for screenshot in the range.
 // return:
 //       if frameNumber is already the last screenshot frame of the range(mean no another screenshot frame number >frameNumber and
@@ -342,83 +412,17 @@ static void init_screenshot() {
         globalLockInitialized = 1;
     }
     readScreenShotFormatENV();
+    readScreenShotSettings();
 }
 
-// Track allocated resources in writePPM()
-// and clean them up when they go out of scope.
-struct WritePPMCleanupData {
-    VkDevice device;
-    VkLayerDispatchTable *pTableDevice;
-    VkImage image2;
-    VkImage image3;
-    VkDeviceMemory mem2;
-    VkDeviceMemory mem3;
-    bool mem2mapped;
-    bool mem3mapped;
-    VkCommandBuffer commandBuffer;
-    VkCommandPool commandPool;
-    ~WritePPMCleanupData();
-};
-
-WritePPMCleanupData::~WritePPMCleanupData() {
-    if (mem2mapped) pTableDevice->UnmapMemory(device, mem2);
-    if (mem2) pTableDevice->FreeMemory(device, mem2, NULL);
-    if (image2) pTableDevice->DestroyImage(device, image2, NULL);
-
-    if (mem3mapped) pTableDevice->UnmapMemory(device, mem3);
-    if (mem3) pTableDevice->FreeMemory(device, mem3, NULL);
-    if (image3) pTableDevice->DestroyImage(device, image3, NULL);
-
-    if (commandBuffer) pTableDevice->FreeCommandBuffers(device, commandPool, 1, &commandBuffer);
-}
-
-// Save an image to a PPM image file.
-//
-// This function issues commands to copy/convert the swapchain image
-// from whatever compatible format the swapchain image uses
-// to a single format (VK_FORMAT_R8G8B8A8_UNORM) so that the converted
-// result can be easily written to a PPM file.
-//
-// Error handling: If there is a problem, this function should silently
-// fail without affecting the Present operation going on in the caller.
-// The numerous debug asserts are to catch programming errors and are not
-// expected to assert.  Recovery and clean up are implemented for image memory
-// allocation failures.
-// (TODO) It would be nice to pass any failure info to DebugReport or something.
-static void writePPM(const char *filename, VkImage image1) {
-    VkResult err;
-    bool pass;
-
-    // Bail immediately if we can't find the image.
-    if (imageMap.empty() || imageMap.find(image1) == imageMap.end()) return;
-
-    // Collect object info from maps.  This info is generally recorded
-    // by the other functions hooked in this layer.
-    VkDevice device = imageMap[image1]->device;
-    VkPhysicalDevice physicalDevice = deviceMap[device]->physicalDevice;
-    VkInstance instance = physDeviceMap[physicalDevice]->instance;
-    VkQueue queue = deviceMap[device]->queue;
-    DeviceMapStruct *devMap = get_dev_info(device);
-    if (NULL == devMap) {
-        assert(0);
-        return;
-    }
-    VkLayerDispatchTable *pTableDevice = devMap->device_dispatch_table;
-    VkLayerDispatchTable *pTableQueue = get_dev_info(static_cast<VkDevice>(static_cast<void *>(queue)))->device_dispatch_table;
-    VkLayerInstanceDispatchTable *pInstanceTable;
-    pInstanceTable = instance_dispatch_table(instance);
-
-    // Gather incoming image info and check image format for compatibility with
-    // the target format.
-    // This function supports both 24-bit and 32-bit swapchain images.
-    uint32_t const width = imageMap[image1]->imageExtent.width;
-    uint32_t const height = imageMap[image1]->imageExtent.height;
-    VkFormat const format = imageMap[image1]->format;
+// Choose the format a swapchain image is converted to for its screenshot.
+// Returns VK_FORMAT_UNDEFINED if the swapchain format isn't supported.
+static VkFormat getScreenshotFormat(VkFormat format) {
     uint32_t const numChannels = FormatChannelCount(format);
 
     if ((3 != numChannels) && (4 != numChannels)) {
         assert(0);
-        return;
+        return VK_FORMAT_UNDEFINED;
     }
 
     // Initial dest format is undefined as we will look for one
@@ -480,12 +484,10 @@ static void writePPM(const char *filename, VkImage image1) {
     if (destformat == VK_FORMAT_UNDEFINED) {
         // Here we reserve swapchain color space only as RGBA swizzle will be later.
         //
-        // One Potential optimization here would be: set destination to RGB all the
-        // time instead RGBA. PPM does not support Alpha channel, so we can write
-        // RGB one row by row but RGBA written one pixel at a time.
-        // This requires BLIT operation to get involved but current drivers (mostly)
-        // does not support BLIT operations on 3 Channel rendertargets.
-        // So format conversion gets costly.
+        // The alpha channel is dropped by the writer threads, as screenshots
+        // are written as RGB.  Blitting to RGB instead would save that work, but
+        // current drivers (mostly) do not support BLIT operations on 3 Channel
+        // rendertargets.
         if (numChannels == 4) {
             if (FormatIsUNorm(format))
                 destformat = VK_FORMAT_R8G8B8A8_UNORM;
@@ -538,186 +540,492 @@ static void writePPM(const char *filename, VkImage image1) {
 
     if ((FormatCompatibilityClass(destformat) != FormatCompatibilityClass(format))) {
         assert(0);
+        return VK_FORMAT_UNDEFINED;
+    }
+    return destformat;
+}
+
+// Writer threads encode screenshots and write them to their files, so that
+// presents don't wait for the conversion or the file IO.
+typedef struct {
+    const SwapchainReadbackStruct *swapchainReadback;
+    ScreenshotReadback *readback;
+} WriterJob;
+
+static std::mutex writerLock;  // guards the writer queue and the state of every readback
+static std::condition_variable writerCondition;
+static std::deque<WriterJob> writerJobs;
+static vector<std::thread> writerThreads;
+static bool writerStop = false;
+static uint32_t swapchainReadbackCount = 0;
+
+// Write the screenshot of a readback whose copy is complete to its file.  The
+// file is encoded in buffers, which are reused from one screenshot to the next.
+static void writeScreenshot(const WriterJob &job, ScreenshotEncoderBuffers *buffers) {
+    const SwapchainReadbackStruct *swapchainReadback = job.swapchainReadback;
+    encodeScreenshot(screenshotFileFormat, swapchainReadback->pixelLayout,
+                     reinterpret_cast<const uint8_t *>(job.readback->bufferData), swapchainReadback->width,
+                     swapchainReadback->height, swapchainReadback->rowPitch, buffers);
+
+    const char *filename = job.readback->fileName.c_str();
+    ofstream file(filename, ios::binary);
+    if (!file.is_open()) {
+#ifdef ANDROID
+        __android_log_print(ANDROID_LOG_DEBUG, "screenshot",
+                            "Failed to open output file: %s.  Be sure to grant read and write permissions.", filename);
+#else
+        fprintf(stderr, "Failed to open output file:%s,  Be sure to grant read and write permissions\n", filename);
+#endif
         return;
     }
+    file.write(buffers->file.data(), buffers->file.size());
+    file.close();
+}
 
-    // General Approach
-    //
-    // The idea here is to copy/convert the swapchain image into another image
-    // that can be mapped and read by the CPU to produce a PPM file.
-    // The image must be untiled and converted to a specific format for easy
-    // parsing.  The memory for the final image must be host-visible.
-    // Note that in Vulkan, a BLIT operation must be used to perform a format
-    // conversion.
-    //
-    // Devices vary in their ability to blit to/from linear and optimal tiling.
-    // So we must query the device properties to get this information.
-    //
-    // If the device cannot BLIT to a LINEAR image, then the operation must be
-    // done in two steps:
-    // 1) BLIT the swapchain image (image1) to a temp image (image2) that is
-    // created with TILING_OPTIMAL.
-    // 2) COPY image2 to another temp image (image3) that is created with
-    // TILING_LINEAR.
-    // 3) Map image 3 and write the PPM file.
-    //
-    // If the device can BLIT to a LINEAR image, then:
-    // 1) BLIT the swapchain image (image1) to a temp image (image2) that is
-    // created with TILING_LINEAR.
-    // 2) Map image 2 and write the PPM file.
-    //
-    // There seems to be no way to tell if the swapchain image (image1) is tiled
-    // or not.  We therefore assume that the BLIT operation can always read from
-    // both linear and optimal tiled (swapchain) images.
-    // There is therefore no point in looking at the BLIT_SRC properties.
-    //
-    // There is also the optimization where the incoming and target formats are
-    // the same.  In this case, just do a COPY.
+static void writerMain() {
+    ScreenshotEncoderBuffers buffers;
+    std::unique_lock<std::mutex> lock(writerLock);
+    while (true) {
+        writerCondition.wait(lock, [] { return writerStop || !writerJobs.empty(); });
+        if (writerJobs.empty()) break;
+        WriterJob job = writerJobs.front();
+        writerJobs.pop_front();
+
+        lock.unlock();
+        writeScreenshot(job, &buffers);
+        lock.lock();
+
+        job.readback->state = READBACK_IDLE;
+        writerCondition.notify_all();
+    }
+}
 
-    VkFormatProperties targetFormatProps;
-    pInstanceTable->GetPhysicalDeviceFormatProperties(physicalDevice, destformat, &targetFormatProps);
-    bool need2steps = false;
-    bool copyOnly = false;
-    if (destformat == format) {
-        copyOnly = true;
-    } else {
-        bool const bltLinear = targetFormatProps.linearTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT ? true : false;
-        bool const bltOptimal = targetFormatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT ? true : false;
-        if (!bltLinear && !bltOptimal) {
-            // Cannot blit to either target tiling type.  It should be pretty
-            // unlikely to have a device that cannot blit to either type.
-            // But punt by just doing a copy and possibly have the wrong
-            // colors.  This should be quite rare.
-            copyOnly = true;
-        } else if (!bltLinear && bltOptimal) {
-            // Cannot blit to a linear target but can blt to optimal, so copy
-            // after blit is needed.
-            need2steps = true;
+static void startWriters() {
+    if (!writerThreads.empty()) return;
+    writerStop = false;
+    for (uint32_t i = 0; i < writerThreadCount; i++) writerThreads.emplace_back(writerMain);
+}
+
+// Stop the writer threads once they have written every queued screenshot
+static void stopWriters() {
+    if (writerThreads.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(writerLock);
+        writerStop = true;
+    }
+    writerCondition.notify_all();
+    for (auto &writerThread : writerThreads) writerThread.join();
+    writerThreads.clear();
+}
+
+// Queue a readback whose copy is complete for the writer threads
+static void writeReadback(DeviceMapStruct *devMap, SwapchainReadbackStruct *swapchainReadback, ScreenshotReadback *readback) {
+    if (!readback->bufferCoherent) {
+        const VkMappedMemoryRange range = {VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL, readback->bufferMemory, 0, VK_WHOLE_SIZE};
+        devMap->device_dispatch_table->InvalidateMappedMemoryRanges(swapchainReadback->device, 1, &range);
+    }
+
+    startWriters();
+    {
+        std::lock_guard<std::mutex> lock(writerLock);
+        readback->state = READBACK_WRITING;
+        writerJobs.push_back({swapchainReadback, readback});
+    }
+    writerCondition.notify_all();
+}
+
+// Queue every screenshot of the swapchain whose copy has completed for the writer threads
+static void pollSwapchainReadback(DeviceMapStruct *devMap, SwapchainReadbackStruct *swapchainReadback) {
+    VkLayerDispatchTable *pTableDevice = devMap->device_dispatch_table;
+    for (auto &readbackElem : swapchainReadback->readbacks) {
+        ScreenshotReadback *readback = &readbackElem;
+        bool pending;
+        {
+            std::lock_guard<std::mutex> lock(writerLock);
+            pending = readback->state == READBACK_PENDING;
         }
-        // Else bltLinear is available and only 1 step is needed.
-    }
-
-    // Put resources that need to be cleaned up in a struct with a destructor
-    // so that things get cleaned up when this function is exited.
-    WritePPMCleanupData data = {};
-    data.device = device;
-    data.pTableDevice = pTableDevice;
-
-    // Set up the image creation info for both the blit and copy images, in case
-    // both are needed.
-    VkImageCreateInfo imgCreateInfo2 = {
-        VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-        NULL,
-        0,
-        VK_IMAGE_TYPE_2D,
-        destformat,
-        {width, height, 1},
-        1,
-        1,
-        VK_SAMPLE_COUNT_1_BIT,
-        VK_IMAGE_TILING_LINEAR,
-        VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-        VK_SHARING_MODE_EXCLUSIVE,
-        0,
-        NULL,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-    };
-    VkImageCreateInfo imgCreateInfo3 = imgCreateInfo2;
+        if (pending && pTableDevice->GetFenceStatus(swapchainReadback->device, readback->fence) == VK_SUCCESS) {
+            writeReadback(devMap, swapchainReadback, readback);
+        }
+    }
+}
 
-    // If we need both images, set up image2 to be read/write and tiled.
-    if (need2steps) {
-        imgCreateInfo2.tiling = VK_IMAGE_TILING_OPTIMAL;
-        imgCreateInfo2.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+// Queue the pending screenshots of every swapchain for the writer threads,
+// waiting for their copies to complete
+static void flushPendingReadbacks() {
+    for (auto swapchainIter = swapchainMap.begin(); swapchainIter != swapchainMap.end(); swapchainIter++) {
+        SwapchainReadbackStruct *swapchainReadback = swapchainIter->second->readback;
+        DeviceMapStruct *devMap = get_dev_info(swapchainIter->second->device);
+        if (!swapchainReadback || !devMap) continue;
+        for (auto &readbackElem : swapchainReadback->readbacks) {
+            ScreenshotReadback *readback = &readbackElem;
+            bool pending;
+            {
+                std::lock_guard<std::mutex> lock(writerLock);
+                pending = readback->state == READBACK_PENDING;
+            }
+            if (!pending) continue;
+            devMap->device_dispatch_table->WaitForFences(swapchainReadback->device, 1, &readback->fence, VK_TRUE, UINT64_MAX);
+            writeReadback(devMap, swapchainReadback, readback);
+        }
     }
+}
 
+// Writes the screenshots still in flight and joins the writer threads when
+// the process exits, or the layer is unloaded, without the application
+// destroying its swapchains first.  Declared after the maps and the writer
+// state so that it is destroyed before them.
+static struct WriterGuard {
+    ~WriterGuard() {
+        if (globalLockInitialized) loader_platform_thread_lock_mutex(&globalLock);
+        flushPendingReadbacks();
+        stopWriters();
+        if (globalLockInitialized) loader_platform_thread_unlock_mutex(&globalLock);
+    }
+} writerGuard;
+
+static void destroyReadback(DeviceMapStruct *devMap, VkDevice device, ScreenshotReadback *readback) {
+    VkLayerDispatchTable *pTableDevice = devMap->device_dispatch_table;
+    if (readback->semaphore) pTableDevice->DestroySemaphore(device, readback->semaphore, NULL);
+    if (readback->fence) pTableDevice->DestroyFence(device, readback->fence, NULL);
+    if (readback->commandBuffer) pTableDevice->FreeCommandBuffers(device, devMap->captureCommandPool, 1, &readback->commandBuffer);
+    if (readback->bufferData) pTableDevice->UnmapMemory(device, readback->bufferMemory);
+    if (readback->buffer) pTableDevice->DestroyBuffer(device, readback->buffer, NULL);
+    if (readback->bufferMemory) pTableDevice->FreeMemory(device, readback->bufferMemory, NULL);
+    if (readback->blitImage) pTableDevice->DestroyImage(device, readback->blitImage, NULL);
+    if (readback->blitMemory) pTableDevice->FreeMemory(device, readback->blitMemory, NULL);
+    readback->semaphore = VK_NULL_HANDLE;
+    readback->fence = VK_NULL_HANDLE;
+    readback->commandBuffer = VK_NULL_HANDLE;
+    readback->bufferData = nullptr;
+    readback->buffer = VK_NULL_HANDLE;
+    readback->bufferMemory = VK_NULL_HANDLE;
+    readback->blitImage = VK_NULL_HANDLE;
+    readback->blitMemory = VK_NULL_HANDLE;
+    readback->created = false;
+}
+
+// Create the resources of a readback.
+//
+// If the swapchain format has to be converted, the swapchain image is blitted
+// to an optimally tiled image of the screenshot format, which is then copied to
+// the buffer.  Otherwise the swapchain image is copied to the buffer directly.
+// Copying to a buffer, rather than to a linear image, works on every device
+// and gives rows without padding.  The buffer memory is host cached when
+// possible, as a writer thread reads every byte of it.
+static bool createReadback(DeviceMapStruct *devMap, SwapchainReadbackStruct *swapchainReadback, ScreenshotReadback *readback) {
+    VkResult err;
+    VkDevice device = swapchainReadback->device;
+    VkPhysicalDevice physicalDevice = devMap->physicalDevice;
+    VkInstance instance = physDeviceMap[physicalDevice]->instance;
+    VkLayerDispatchTable *pTableDevice = devMap->device_dispatch_table;
+    VkLayerInstanceDispatchTable *pInstanceTable = instance_dispatch_table(instance);
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    pInstanceTable->GetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    VkMemoryRequirements memRequirements;
     VkMemoryAllocateInfo memAllocInfo = {
         VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL,
         0,  // allocationSize, queried later
         0   // memoryTypeIndex, queried later
     };
-    VkMemoryRequirements memRequirements;
-    VkPhysicalDeviceMemoryProperties memoryProperties;
 
-    // Create image2 and allocate its memory.  It could be the intermediate or
-    // final image.
-    err = pTableDevice->CreateImage(device, &imgCreateInfo2, NULL, &data.image2);
-    assert(!err);
-    if (VK_SUCCESS != err) return;
-    pTableDevice->GetImageMemoryRequirements(device, data.image2, &memRequirements);
-    memAllocInfo.allocationSize = memRequirements.size;
-    pInstanceTable->GetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
-    pass = memory_type_from_properties(&memoryProperties, memRequirements.memoryTypeBits,
-                                       need2steps ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-                                       &memAllocInfo.memoryTypeIndex);
-    assert(pass);
-    err = pTableDevice->AllocateMemory(device, &memAllocInfo, NULL, &data.mem2);
-    assert(!err);
-    if (VK_SUCCESS != err) return;
-    err = pTableQueue->BindImageMemory(device, data.image2, data.mem2, 0);
-    assert(!err);
-    if (VK_SUCCESS != err) return;
+    if (!swapchainReadback->copyOnly) {
+        const VkImageCreateInfo imgCreateInfo = {
+            VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            NULL,
+            0,
+            VK_IMAGE_TYPE_2D,
+            swapchainReadback->destFormat,
+            {swapchainReadback->width, swapchainReadback->height, 1},
+            1,
+            1,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0,
+            NULL,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+        err = pTableDevice->CreateImage(device, &imgCreateInfo, NULL, &readback->blitImage);
+        assert(!err);
+        if (VK_SUCCESS != err) goto fail;
+        pTableDevice->GetImageMemoryRequirements(device, readback->blitImage, &memRequirements);
+        memAllocInfo.allocationSize = memRequirements.size;
+        if (!memory_type_from_properties(&memoryProperties, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                         &memAllocInfo.memoryTypeIndex)) {
+            assert(0);
+            goto fail;
+        }
+        err = pTableDevice->AllocateMemory(device, &memAllocInfo, NULL, &readback->blitMemory);
+        assert(!err);
+        if (VK_SUCCESS != err) goto fail;
+        err = pTableDevice->BindImageMemory(device, readback->blitImage, readback->blitMemory, 0);
+        assert(!err);
+        if (VK_SUCCESS != err) goto fail;
+    }
 
-    // Create image3 and allocate its memory, if needed.
-    if (need2steps) {
-        err = pTableDevice->CreateImage(device, &imgCreateInfo3, NULL, &data.image3);
+    {
+        const VkBufferCreateInfo bufferCreateInfo = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                                                     NULL,
+                                                     0,
+                                                     swapchainReadback->rowPitch * swapchainReadback->height,
+                                                     VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                     VK_SHARING_MODE_EXCLUSIVE,
+                                                     0,
+                                                     NULL};
+        err = pTableDevice->CreateBuffer(device, &bufferCreateInfo, NULL, &readback->buffer);
         assert(!err);
-        if (VK_SUCCESS != err) return;
-        pTableDevice->GetImageMemoryRequirements(device, data.image3, &memRequirements);
+        if (VK_SUCCESS != err) goto fail;
+        pTableDevice->GetBufferMemoryRequirements(device, readback->buffer, &memRequirements);
         memAllocInfo.allocationSize = memRequirements.size;
-        pInstanceTable->GetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
-        pass = memory_type_from_properties(&memoryProperties, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-                                           &memAllocInfo.memoryTypeIndex);
-        assert(pass);
-        err = pTableDevice->AllocateMemory(device, &memAllocInfo, NULL, &data.mem3);
+        if (!memory_type_from_properties(&memoryProperties, memRequirements.memoryTypeBits,
+                                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+                                         &memAllocInfo.memoryTypeIndex) &&
+            !memory_type_from_properties(&memoryProperties, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                         &memAllocInfo.memoryTypeIndex)) {
+            assert(0);
+            goto fail;
+        }
+        readback->bufferCoherent =
+            (memoryProperties.memoryTypes[memAllocInfo.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+        err = pTableDevice->AllocateMemory(device, &memAllocInfo, NULL, &readback->bufferMemory);
         assert(!err);
-        if (VK_SUCCESS != err) return;
-        err = pTableQueue->BindImageMemory(device, data.image3, data.mem3, 0);
+        if (VK_SUCCESS != err) goto fail;
+        err = pTableDevice->BindBufferMemory(device, readback->buffer, readback->bufferMemory, 0);
         assert(!err);
-        if (VK_SUCCESS != err) return;
+        if (VK_SUCCESS != err) goto fail;
+        err = pTableDevice->MapMemory(device, readback->bufferMemory, 0, VK_WHOLE_SIZE, 0, (void **)&readback->bufferData);
+        assert(!err);
+        if (VK_SUCCESS != err) goto fail;
     }
 
-    // Set up the command buffer.  We get a command buffer from a pool we saved
-    // in a hooked function, which would be the application's pool.
-    if (deviceMap[device]->commandPools.empty()) {
-        assert(!deviceMap[device]->commandPools.empty());
-        return;
+    {
+        const VkCommandBufferAllocateInfo allocCommandBufferInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, NULL,
+                                                                    devMap->captureCommandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1};
+        err = pTableDevice->AllocateCommandBuffers(device, &allocCommandBufferInfo, &readback->commandBuffer);
+        assert(!err);
+        if (VK_SUCCESS != err) goto fail;
+
+        // We have just created a dispatchable object, but the dispatch table has
+        // not been placed in the object yet.  When a "normal" application creates
+        // a command buffer, the dispatch table is installed by the top-level api
+        // binding (trampoline.c). But here, we have to do it ourselves.
+        if (!devMap->pfn_dev_init) {
+            *((const void **)readback->commandBuffer) = *(void **)device;
+        } else {
+            err = devMap->pfn_dev_init(device, (void *)readback->commandBuffer);
+            assert(!err);
+        }
     }
 
-    VkCommandPool commandPool = deviceMap[device]->commandPools.front();
+    {
+        const VkFenceCreateInfo fenceCreateInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, NULL, 0};
+        err = pTableDevice->CreateFence(device, &fenceCreateInfo, NULL, &readback->fence);
+        assert(!err);
+        if (VK_SUCCESS != err) goto fail;
+        const VkSemaphoreCreateInfo semaphoreCreateInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, NULL, 0};
+        err = pTableDevice->CreateSemaphore(device, &semaphoreCreateInfo, NULL, &readback->semaphore);
+        assert(!err);
+        if (VK_SUCCESS != err) goto fail;
+    }
 
-    const VkCommandBufferAllocateInfo allocCommandBufferInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, NULL,
-        commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1};
-    data.commandPool = commandPool;
-    err = pTableDevice->AllocateCommandBuffers(device, &allocCommandBufferInfo, &data.commandBuffer);
-    assert(!err);
-    if (VK_SUCCESS != err) return;
-
-    VkDevice cmdBuf = static_cast<VkDevice>(static_cast<void *>(data.commandBuffer));
-    deviceMap.emplace(cmdBuf, devMap);
-    VkLayerDispatchTable *pTableCommandBuffer;
-    pTableCommandBuffer = get_dev_info(cmdBuf)->device_dispatch_table;
-
-    // We have just created a dispatchable object, but the dispatch table has
-    // not been placed in the object yet.  When a "normal" application creates
-    // a command buffer, the dispatch table is installed by the top-level api
-    // binding (trampoline.c). But here, we have to do it ourselves.
-    if (!devMap->pfn_dev_init) {
-        *((const void **)data.commandBuffer) = *(void **)device;
+    readback->created = true;
+    return true;
+
+fail:
+    destroyReadback(devMap, device, readback);
+    return false;
+}
+
+// The 8 bit BGR(A) formats follow the RGB(A) formats of the same numeric
+// types, in the same order.
+static bool formatIsBGR(VkFormat format) {
+    return (format >= VK_FORMAT_B8G8R8_UNORM && format <= VK_FORMAT_B8G8R8_SRGB) ||
+           (format >= VK_FORMAT_B8G8R8A8_UNORM && format <= VK_FORMAT_B8G8R8A8_SRGB);
+}
+
+// Get the RGB(A) format with the numeric type of a BGR(A) format
+static VkFormat getRGBOrderFormat(VkFormat format) {
+    if (format >= VK_FORMAT_B8G8R8_UNORM && format <= VK_FORMAT_B8G8R8_SRGB)
+        return static_cast<VkFormat>(format - VK_FORMAT_B8G8R8_UNORM + VK_FORMAT_R8G8B8_UNORM);
+    if (format >= VK_FORMAT_B8G8R8A8_UNORM && format <= VK_FORMAT_B8G8R8A8_SRGB)
+        return static_cast<VkFormat>(format - VK_FORMAT_B8G8R8A8_UNORM + VK_FORMAT_R8G8B8A8_UNORM);
+    return format;
+}
+
+// Create the screenshot format info of a swapchain.  Its readbacks are created
+// when they are first used.
+static SwapchainReadbackStruct *createSwapchainReadback(DeviceMapStruct *devMap, SwapchainMapStruct *swapchainMapElem) {
+    VkFormat const format = swapchainMapElem->format;
+    VkFormat const destformat = getScreenshotFormat(format);
+    if (destformat == VK_FORMAT_UNDEFINED) return nullptr;
+
+    // Devices vary in their ability to blit to/from linear and optimal tiling.
+    // Screenshots are blitted to an optimally tiled image when the format has
+    // to be converted, and that image is then copied to a buffer the CPU reads.
+    //
+    // There seems to be no way to tell if the swapchain image is tiled or not.
+    // We therefore assume that the BLIT operation can always read from both
+    // linear and optimal tiled (swapchain) images.
+    //
+    // There is also the optimization where the incoming and target formats are
+    // the same, or only differ in the order of red and blue.  In this case,
+    // just do a COPY, and the writer threads swap red and blue if needed.
+    VkInstance instance = physDeviceMap[devMap->physicalDevice]->instance;
+    VkFormatProperties targetFormatProps;
+    instance_dispatch_table(instance)->GetPhysicalDeviceFormatProperties(devMap->physicalDevice, destformat, &targetFormatProps);
+    bool copyOnly = false;
+    if (destformat == format || destformat == getRGBOrderFormat(format)) {
+        copyOnly = true;
+    } else if (!(targetFormatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT)) {
+        // Cannot blit to the target format.  It should be pretty unlikely to
+        // have a device that cannot.  But punt by just doing a copy and
+        // possibly have the wrong colors.  This should be quite rare.
+        copyOnly = true;
+    }
+
+    // The buffers hold the swapchain format when the image is only copied
+    VkFormat const bufferFormat = copyOnly ? format : destformat;
+    ScreenshotPixelLayout pixelLayout;
+    if (3 == FormatChannelCount(bufferFormat)) {
+        pixelLayout = formatIsBGR(bufferFormat) ? SCREENSHOT_PIXELS_BGR : SCREENSHOT_PIXELS_RGB;
     } else {
-        err = devMap->pfn_dev_init(device, (void *)data.commandBuffer);
+        pixelLayout = formatIsBGR(bufferFormat) ? SCREENSHOT_PIXELS_BGRA : SCREENSHOT_PIXELS_RGBA;
+    }
+
+    SwapchainReadbackStruct *swapchainReadback = new SwapchainReadbackStruct();
+    swapchainReadback->device = swapchainMapElem->device;
+    swapchainReadback->width = swapchainMapElem->imageExtent.width;
+    swapchainReadback->height = swapchainMapElem->imageExtent.height;
+    swapchainReadback->pixelLayout = pixelLayout;
+    swapchainReadback->destFormat = destformat;
+    swapchainReadback->copyOnly = copyOnly;
+    swapchainReadback->rowPitch = static_cast<VkDeviceSize>(FormatSize(destformat)) * swapchainReadback->width;
+    // Enough for every writer thread to be busy while another copy is pending
+    swapchainReadback->readbacks.resize(std::max(minReadbacksPerSwapchain, writerThreadCount + 1));
+    swapchainReadbackCount++;
+    return swapchainReadback;
+}
+
+// Finish the screenshots of a swapchain and destroy its readbacks
+static void destroySwapchainReadback(DeviceMapStruct *devMap, SwapchainMapStruct *swapchainMapElem) {
+    SwapchainReadbackStruct *swapchainReadback = swapchainMapElem->readback;
+    if (!swapchainReadback) return;
+
+    // Also waits for the presents that wait on the readback semaphores
+    devMap->device_dispatch_table->DeviceWaitIdle(swapchainReadback->device);
+    for (auto &readbackElem : swapchainReadback->readbacks) {
+        ScreenshotReadback *readback = &readbackElem;
+        bool pending;
+        {
+            std::lock_guard<std::mutex> lock(writerLock);
+            pending = readback->state == READBACK_PENDING;
+        }
+        if (pending) writeReadback(devMap, swapchainReadback, readback);
+    }
+    {
+        std::unique_lock<std::mutex> lock(writerLock);
+        writerCondition.wait(lock, [swapchainReadback] {
+            for (const auto &readback : swapchainReadback->readbacks) {
+                if (readback.state != READBACK_IDLE) return false;
+            }
+            return true;
+        });
+    }
+
+    for (auto &readback : swapchainReadback->readbacks) {
+        destroyReadback(devMap, swapchainReadback->device, &readback);
+    }
+    delete swapchainReadback;
+    swapchainMapElem->readback = nullptr;
+
+    if (--swapchainReadbackCount == 0) stopWriters();
+}
+
+// Get an idle readback of the swapchain.  When every readback is busy, this
+// waits for the oldest copy, and then for the writer threads if needed.
+static ScreenshotReadback *acquireReadback(DeviceMapStruct *devMap, SwapchainReadbackStruct *swapchainReadback) {
+    while (true) {
+        ScreenshotReadback *oldest = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(writerLock);
+            for (auto &readbackElem : swapchainReadback->readbacks) {
+                ScreenshotReadback *readback = &readbackElem;
+                if (readback->state == READBACK_IDLE) return readback;
+                if (readback->state == READBACK_PENDING && (!oldest || readback->sequence < oldest->sequence)) {
+                    oldest = readback;
+                }
+            }
+            if (!oldest) {
+                writerCondition.wait(lock);
+                continue;
+            }
+        }
+        devMap->device_dispatch_table->WaitForFences(swapchainReadback->device, 1, &oldest->fence, VK_TRUE, UINT64_MAX);
+        writeReadback(devMap, swapchainReadback, oldest);
+    }
+}
+
+// Take a screenshot of a swapchain image that is about to be presented.
+//
+// This function records and submits commands that copy/convert the swapchain
+// image to a host visible buffer, without waiting for them.  The copy waits
+// for the semaphores of the present, and the present is expected to wait for
+// the semaphore returned in pSemaphore instead.  The screenshot is written to
+// its file by a writer thread once the copy has completed.
+//
+// Error handling: If there is a problem, this function should silently
+// fail without affecting the Present operation going on in the caller.
+// The numerous debug asserts are to catch programming errors and are not
+// expected to assert.
+// (TODO) It would be nice to pass any failure info to DebugReport or something.
+static bool takeScreenshot(const string &fileName, SwapchainMapStruct *swapchainMapElem, VkImage image1,
+                           const VkPresentInfoKHR *pPresentInfo, VkSemaphore *pSemaphore) {
+    VkResult err;
+    VkDevice device = swapchainMapElem->device;
+    DeviceMapStruct *devMap = get_dev_info(device);
+    if (NULL == devMap || !devMap->queue) {
+        assert(0);
+        return false;
+    }
+    VkLayerDispatchTable *pTableDevice = devMap->device_dispatch_table;
+
+    // Screenshots are copied on the queue and with a command pool of our own,
+    // whose command buffers can be reused.
+    if (!devMap->captureCommandPool) {
+        const VkCommandPoolCreateInfo commandPoolCreateInfo = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO, NULL,
+                                                               VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                                                               devMap->queueFamilyIndex};
+        err = pTableDevice->CreateCommandPool(device, &commandPoolCreateInfo, NULL, &devMap->captureCommandPool);
         assert(!err);
+        if (VK_SUCCESS != err) return false;
+        devMap->captureQueue = devMap->queue;
+    }
+
+    if (!swapchainMapElem->readback) {
+        swapchainMapElem->readback = createSwapchainReadback(devMap, swapchainMapElem);
+        if (!swapchainMapElem->readback) return false;
     }
+    SwapchainReadbackStruct *swapchainReadback = swapchainMapElem->readback;
+    uint32_t const width = swapchainReadback->width;
+    uint32_t const height = swapchainReadback->height;
+
+    ScreenshotReadback *readback = acquireReadback(devMap, swapchainReadback);
+    if (!readback->created && !createReadback(devMap, swapchainReadback, readback)) return false;
 
     const VkCommandBufferBeginInfo commandBufferBeginInfo = {
         VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
     };
-    err = pTableCommandBuffer->BeginCommandBuffer(data.commandBuffer, &commandBufferBeginInfo);
+    err = pTableDevice->BeginCommandBuffer(readback->commandBuffer, &commandBufferBeginInfo);
     assert(!err);
+    if (VK_SUCCESS != err) return false;
 
     // This barrier is used to transition from/to present Layout
     VkImageMemoryBarrier presentMemoryBarrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
                                                  NULL,
-                                                 VK_ACCESS_TRANSFER_WRITE_BIT,
+                                                 0,
                                                  VK_ACCESS_TRANSFER_READ_BIT,
                                                  VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
                                                  VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
@@ -726,50 +1034,31 @@ static void writePPM(const char *filename, VkImage image1) {
                                                  image1,
                                                  {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
 
-    // This barrier is used to transition from a newly-created layout to a blt
-    // or copy destination layout.
-    VkImageMemoryBarrier destMemoryBarrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                                              NULL,
-                                              0,
-                                              VK_ACCESS_TRANSFER_WRITE_BIT,
-                                              VK_IMAGE_LAYOUT_UNDEFINED,
-                                              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                              VK_QUEUE_FAMILY_IGNORED,
-                                              VK_QUEUE_FAMILY_IGNORED,
-                                              data.image2,
-                                              {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
-
-    // This barrier is used to transition a dest layout to general layout.
-    VkImageMemoryBarrier generalMemoryBarrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                                                 NULL,
-                                                 VK_ACCESS_TRANSFER_WRITE_BIT,
-                                                 VK_ACCESS_TRANSFER_READ_BIT,
-                                                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                                 VK_IMAGE_LAYOUT_GENERAL,
-                                                 VK_QUEUE_FAMILY_IGNORED,
-                                                 VK_QUEUE_FAMILY_IGNORED,
-                                                 data.image2,
-                                                 {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
-
     VkPipelineStageFlags srcStages = VK_PIPELINE_STAGE_TRANSFER_BIT;
     VkPipelineStageFlags dstStages = VK_PIPELINE_STAGE_TRANSFER_BIT;
 
     // The source image needs to be transitioned from present to transfer
     // source.
-    pTableCommandBuffer->CmdPipelineBarrier(data.commandBuffer, srcStages, dstStages, 0, 0, NULL, 0, NULL, 1,
-                                            &presentMemoryBarrier);
-
-    // image2 needs to be transitioned from its undefined state to transfer
-    // destination.
-    pTableCommandBuffer->CmdPipelineBarrier(data.commandBuffer, srcStages, dstStages, 0, 0, NULL, 0, NULL, 1, &destMemoryBarrier);
-
-    const VkImageCopy imageCopyRegion = {
-        {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1}, {0, 0, 0}, {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1}, {0, 0, 0}, {width, height, 1}};
+    pTableDevice->CmdPipelineBarrier(readback->commandBuffer, srcStages, dstStages, 0, 0, NULL, 0, NULL, 1,
+                                     &presentMemoryBarrier);
+
+    VkImage copyImage = image1;
+    if (!swapchainReadback->copyOnly) {
+        // The blit image needs to be transitioned from its undefined state to
+        // transfer destination.
+        VkImageMemoryBarrier destMemoryBarrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                                                  NULL,
+                                                  0,
+                                                  VK_ACCESS_TRANSFER_WRITE_BIT,
+                                                  VK_IMAGE_LAYOUT_UNDEFINED,
+                                                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                  VK_QUEUE_FAMILY_IGNORED,
+                                                  VK_QUEUE_FAMILY_IGNORED,
+                                                  readback->blitImage,
+                                                  {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+        pTableDevice->CmdPipelineBarrier(readback->commandBuffer, srcStages, dstStages, 0, 0, NULL, 0, NULL, 1,
+                                         &destMemoryBarrier);
 
-    if (copyOnly) {
-        pTableCommandBuffer->CmdCopyImage(data.commandBuffer, image1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, data.image2,
-                                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageCopyRegion);
-    } else {
         VkImageBlit imageBlitRegion = {};
         imageBlitRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
         imageBlitRegion.srcSubresource.baseArrayLayer = 0;
@@ -786,127 +1075,86 @@ static void writePPM(const char *filename, VkImage image1) {
         imageBlitRegion.dstOffsets[1].y = height;
         imageBlitRegion.dstOffsets[1].z = 1;
 
-        pTableCommandBuffer->CmdBlitImage(data.commandBuffer, image1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, data.image2,
-                                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageBlitRegion, VK_FILTER_NEAREST);
-        if (need2steps) {
-            // image 3 needs to be transitioned from its undefined state to a
-            // transfer destination.
-            destMemoryBarrier.image = data.image3;
-            pTableCommandBuffer->CmdPipelineBarrier(data.commandBuffer, srcStages, dstStages, 0, 0, NULL, 0, NULL, 1,
-                                                    &destMemoryBarrier);
-
-            // Transition image2 so that it can be read for the upcoming copy to
-            // image 3.
-            destMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            destMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-            destMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            destMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-            destMemoryBarrier.image = data.image2;
-            pTableCommandBuffer->CmdPipelineBarrier(data.commandBuffer, srcStages, dstStages, 0, 0, NULL, 0, NULL, 1,
-                                                    &destMemoryBarrier);
-
-            // This step essentially untiles the image.
-            pTableCommandBuffer->CmdCopyImage(data.commandBuffer, data.image2, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, data.image3,
-                                              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageCopyRegion);
-            generalMemoryBarrier.image = data.image3;
-        }
+        pTableDevice->CmdBlitImage(readback->commandBuffer, image1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback->blitImage,
+                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageBlitRegion, VK_FILTER_NEAREST);
+
+        // Transition the blit image so that it can be read for the upcoming
+        // copy to the buffer.
+        destMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        destMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        destMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        destMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        pTableDevice->CmdPipelineBarrier(readback->commandBuffer, srcStages, dstStages, 0, 0, NULL, 0, NULL, 1,
+                                         &destMemoryBarrier);
+        copyImage = readback->blitImage;
     }
 
-    // The destination needs to be transitioned from the optimal copy format to
-    // the format we can read with the CPU.
-    pTableCommandBuffer->CmdPipelineBarrier(data.commandBuffer, srcStages, dstStages, 0, 0, NULL, 0, NULL, 1,
-                                            &generalMemoryBarrier);
-
-    // Restore the swap chain image layout to what it was before.
-    // This may not be strictly needed, but it is generally good to restore
-    // things to original state.
+    // This step essentially untiles the image.
+    const VkBufferImageCopy bufferCopyRegion = {0, 0, 0, {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1}, {0, 0, 0}, {width, height, 1}};
+    pTableDevice->CmdCopyImageToBuffer(readback->commandBuffer, copyImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback->buffer,
+                                       1, &bufferCopyRegion);
+
+    // Make the copy visible to the host once the fence is signaled.
+    const VkBufferMemoryBarrier hostMemoryBarrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                                                     NULL,
+                                                     VK_ACCESS_TRANSFER_WRITE_BIT,
+                                                     VK_ACCESS_HOST_READ_BIT,
+                                                     VK_QUEUE_FAMILY_IGNORED,
+                                                     VK_QUEUE_FAMILY_IGNORED,
+                                                     readback->buffer,
+                                                     0,
+                                                     VK_WHOLE_SIZE};
+    pTableDevice->CmdPipelineBarrier(readback->commandBuffer, srcStages, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1,
+                                     &hostMemoryBarrier, 0, NULL);
+
+    // Restore the swap chain image layout for the present.
     presentMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
     presentMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
     presentMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
     presentMemoryBarrier.dstAccessMask = 0;
-    pTableCommandBuffer->CmdPipelineBarrier(data.commandBuffer, srcStages, dstStages, 0, 0, NULL, 0, NULL, 1,
-                                            &presentMemoryBarrier);
+    pTableDevice->CmdPipelineBarrier(readback->commandBuffer, srcStages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 0, NULL,
+                                     1, &presentMemoryBarrier);
+
+    err = pTableDevice->EndCommandBuffer(readback->commandBuffer);
+    assert(!err);
+    if (VK_SUCCESS != err) return false;
 
-    err = pTableCommandBuffer->EndCommandBuffer(data.commandBuffer);
+    err = pTableDevice->ResetFences(device, 1, &readback->fence);
     assert(!err);
+    if (VK_SUCCESS != err) return false;
 
-    VkFence nullFence = {VK_NULL_HANDLE};
+    // The copy waits for everything the present waits for.
+    vector<VkPipelineStageFlags> waitStages(pPresentInfo->waitSemaphoreCount, VK_PIPELINE_STAGE_TRANSFER_BIT);
     VkSubmitInfo submitInfo;
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submitInfo.pNext = NULL;
-    submitInfo.waitSemaphoreCount = 0;
-    submitInfo.pWaitSemaphores = NULL;
-    submitInfo.pWaitDstStageMask = NULL;
+    submitInfo.waitSemaphoreCount = pPresentInfo->waitSemaphoreCount;
+    submitInfo.pWaitSemaphores = pPresentInfo->pWaitSemaphores;
+    submitInfo.pWaitDstStageMask = waitStages.data();
     submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &data.commandBuffer;
-    submitInfo.signalSemaphoreCount = 0;
-    submitInfo.pSignalSemaphores = NULL;
-
-    err = pTableQueue->QueueSubmit(queue, 1, &submitInfo, nullFence);
-    assert(!err);
+    submitInfo.pCommandBuffers = &readback->commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &readback->semaphore;
 
-    err = pTableQueue->QueueWaitIdle(queue);
+    err = pTableDevice->QueueSubmit(devMap->captureQueue, 1, &submitInfo, readback->fence);
     assert(!err);
+    if (VK_SUCCESS != err) return false;
 
-    err = pTableDevice->DeviceWaitIdle(device);
-    assert(!err);
-
-    // Map the final image so that the CPU can read it.
-    const VkImageSubresource sr = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0};
-    VkSubresourceLayout srLayout;
-    const char *ptr;
-    if (!need2steps) {
-        pTableDevice->GetImageSubresourceLayout(device, data.image2, &sr, &srLayout);
-        err = pTableDevice->MapMemory(device, data.mem2, 0, VK_WHOLE_SIZE, 0, (void **)&ptr);
-        assert(!err);
-        if (VK_SUCCESS != err) return;
-        data.mem2mapped = true;
-    } else {
-        pTableDevice->GetImageSubresourceLayout(device, data.image3, &sr, &srLayout);
-        err = pTableDevice->MapMemory(device, data.mem3, 0, VK_WHOLE_SIZE, 0, (void **)&ptr);
-        assert(!err);
-        if (VK_SUCCESS != err) return;
-        data.mem3mapped = true;
-    }
-
-    // Write the data to a PPM file.
-    ofstream file(filename, ios::binary);
-    assert(file.is_open());
-
-    if (!file.is_open()) {
-#ifdef ANDROID
-        __android_log_print(ANDROID_LOG_DEBUG, "screenshot",
-                            "Failed to open output file: %s.  Be sure to grant read and write permissions.", filename);
-#else
-        fprintf(stderr, "Failed to open output file:%s,  Be sure to grant read and write permissions\n", filename);
-#endif
-        return;
-    }
-
-    file << "P6\n";
-    file << width << "\n";
-    file << height << "\n";
-    file << 255 << "\n";
-
-    ptr += srLayout.offset;
-    if (3 == numChannels) {
-        for (uint32_t y = 0; y < height; y++) {
-            file.write(ptr, 3 * width);
-            ptr += srLayout.rowPitch;
-        }
-    } else if (4 == numChannels) {
-        for (uint32_t y = 0; y < height; y++) {
-            const unsigned int *row = (const unsigned int *)ptr;
-            for (uint32_t x = 0; x < width; x++) {
-                file.write((char *)row, 3);
-                row++;
-            }
-            ptr += srLayout.rowPitch;
-        }
+    {
+        std::lock_guard<std::mutex> lock(writerLock);
+        readback->state = READBACK_PENDING;
+        readback->sequence = swapchainReadback->nextSequence++;
+        readback->fileName = fileName;
     }
-    file.close();
+    *pSemaphore = readback->semaphore;
+    return true;
+}
 
-    // Clean up handled by ~WritePPMCleanupData()
+// Finish the screenshots of a swapchain and free its map entry
+static void destroySwapchainMapElem(DeviceMapStruct *devMap, SwapchainMapStruct *swapchainMapElem) {
+    if (devMap) destroySwapchainReadback(devMap, swapchainMapElem);
+    delete[] swapchainMapElem->imageList;
+    delete swapchainMapElem;
 }
 
 VKAPI_ATTR VkResult VKAPI_CALL CreateInstance(const VkInstanceCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator,
@@ -934,7 +1182,26 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateInstance(const VkInstanceCreateInfo *pCreat
     return result;
 }
 
-// TODO hook DestroyInstance to cleanup
+VKAPI_ATTR void VKAPI_CALL DestroyInstance(VkInstance instance, const VkAllocationCallbacks *pAllocator) {
+    dispatch_key key = get_dispatch_key(instance);
+
+    // The devices, and so the swapchains, of the instance are gone by now, so
+    // the writer threads only have to write what is already queued.
+    loader_platform_thread_lock_mutex(&globalLock);
+    stopWriters();
+    for (auto physDeviceIter = physDeviceMap.begin(); physDeviceIter != physDeviceMap.end();) {
+        if (physDeviceIter->second->instance == instance) {
+            delete physDeviceIter->second;
+            physDeviceIter = physDeviceMap.erase(physDeviceIter);
+        } else {
+            physDeviceIter++;
+        }
+    }
+    loader_platform_thread_unlock_mutex(&globalLock);
+
+    instance_dispatch_table(instance)->DestroyInstance(instance, pAllocator);
+    destroy_instance_dispatch_table(key);
+}
 
 static void createDeviceRegisterExtensions(const VkDeviceCreateInfo *pCreateInfo, VkDevice device) {
     uint32_t i;
@@ -945,6 +1212,7 @@ static void createDeviceRegisterExtensions(const VkDeviceCreateInfo *pCreateInfo
     pDisp->GetSwapchainImagesKHR = (PFN_vkGetSwapchainImagesKHR)gpa(device, "vkGetSwapchainImagesKHR");
     pDisp->AcquireNextImageKHR = (PFN_vkAcquireNextImageKHR)gpa(device, "vkAcquireNextImageKHR");
     pDisp->QueuePresentKHR = (PFN_vkQueuePresentKHR)gpa(device, "vkQueuePresentKHR");
+    pDisp->DestroySwapchainKHR = (PFN_vkDestroySwapchainKHR)gpa(device, "vkDestroySwapchainKHR");
     devMap->wsi_enabled = false;
     for (i = 0; i < pCreateInfo->enabledExtensionCount; i++) {
         if (strcmp(pCreateInfo->ppEnabledExtensionNames[i], VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0) devMap->wsi_enabled = true;
@@ -973,7 +1241,7 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateDevice(VkPhysicalDevice gpu, const VkDevice
     }
 
     assert(deviceMap.find(*pDevice) == deviceMap.end());
-    DeviceMapStruct *deviceMapElem = new DeviceMapStruct;
+    DeviceMapStruct *deviceMapElem = new DeviceMapStruct();
     deviceMap[*pDevice] = deviceMapElem;
 
     // Setup device dispatch table
@@ -1017,6 +1285,20 @@ VKAPI_ATTR void VKAPI_CALL DestroyDevice(VkDevice device, const VkAllocationCall
     DeviceMapStruct *devMap = get_dev_info(device);
     assert(devMap);
     VkLayerDispatchTable *pDisp = devMap->device_dispatch_table;
+
+    // Finish the screenshots of the device's swapchains before it goes away.
+    loader_platform_thread_lock_mutex(&globalLock);
+    for (auto swapchainIter = swapchainMap.begin(); swapchainIter != swapchainMap.end();) {
+        if (swapchainIter->second->device == device) {
+            destroySwapchainMapElem(devMap, swapchainIter->second);
+            swapchainIter = swapchainMap.erase(swapchainIter);
+        } else {
+            swapchainIter++;
+        }
+    }
+    if (devMap->captureCommandPool) pDisp->DestroyCommandPool(device, devMap->captureCommandPool, NULL);
+    loader_platform_thread_unlock_mutex(&globalLock);
+
     pDisp->DestroyDevice(device, pAllocator);
 
     local_free_getenv(vk_screenshot_format);
@@ -1047,51 +1329,10 @@ VKAPI_ATTR void VKAPI_CALL GetDeviceQueue(VkDevice device, uint32_t queueNodeInd
 
     // Create a mapping from a device to a queue
     devMap->queue = *pQueue;
+    devMap->queueFamilyIndex = queueNodeIndex;
     loader_platform_thread_unlock_mutex(&globalLock);
 }
 
-VKAPI_ATTR VkResult VKAPI_CALL CreateCommandPool(VkDevice device, const VkCommandPoolCreateInfo *pCreateInfo,
-                                                 const VkAllocationCallbacks *pAllocator, VkCommandPool *pCommandPool) {
-    DeviceMapStruct *devMap = get_dev_info(device);
-    assert(devMap);
-    VkLayerDispatchTable *pDisp = devMap->device_dispatch_table;
-    VkResult result = pDisp->CreateCommandPool(device, pCreateInfo, pAllocator, pCommandPool);
-
-    // Save the command pool on a map if we are taking screenshots.
-    loader_platform_thread_lock_mutex(&globalLock);
-    if (screenshotFramesReceived && screenshotFrames.empty() && !screenShotFrameRange.valid) {
-        // No screenshots in the list to take
-        loader_platform_thread_unlock_mutex(&globalLock);
-        return result;
-    }
-
-    // Create a mapping from a device to a commandPool
-    devMap->commandPools.push_front(*pCommandPool);
-    loader_platform_thread_unlock_mutex(&globalLock);
-    return result;
-}
-
-VKAPI_ATTR void VKAPI_CALL DestroyCommandPool(VkDevice device, VkCommandPool commandPool, const VkAllocationCallbacks *pAllocator) {
-    DeviceMapStruct *devMap = get_dev_info(device);
-    assert(devMap);
-    VkLayerDispatchTable *pDisp = devMap->device_dispatch_table;
-    pDisp->DestroyCommandPool(device, commandPool, pAllocator);
-
-    // Remove the command pool from the map if we are taking screenshots.
-    loader_platform_thread_lock_mutex(&globalLock);
-    if (screenshotFramesReceived && screenshotFrames.empty() && !screenShotFrameRange.valid) {
-        // No screenshots in the list to take
-        loader_platform_thread_unlock_mutex(&globalLock);
-        return;
-    }
-
-    // Remove the commandPool from the device mapping
-    devMap->commandPools.remove(commandPool);
-    loader_platform_thread_unlock_mutex(&globalLock);
-    return;
-}
-
-
 VKAPI_ATTR VkResult VKAPI_CALL CreateSwapchainKHR(VkDevice device, const VkSwapchainCreateInfoKHR *pCreateInfo,
                                                   const VkAllocationCallbacks *pAllocator, VkSwapchainKHR *pSwapchain) {
     DeviceMapStruct *devMap = get_dev_info(device);
@@ -1115,7 +1356,7 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateSwapchainKHR(VkDevice device, const VkSwapc
     if (result == VK_SUCCESS) {
         // Create a mapping for a swapchain to a device, image extent, and
         // format
-        SwapchainMapStruct *swapchainMapElem = new SwapchainMapStruct;
+        SwapchainMapStruct *swapchainMapElem = new SwapchainMapStruct();
         swapchainMapElem->device = device;
         swapchainMapElem->imageExtent = pCreateInfo->imageExtent;
         swapchainMapElem->format = pCreateInfo->imageFormat;
@@ -1146,24 +1387,13 @@ VKAPI_ATTR VkResult VKAPI_CALL GetSwapchainImagesKHR(VkDevice device, VkSwapchai
     }
 
     if (result == VK_SUCCESS && pSwapchainImages && !swapchainMap.empty() && swapchainMap.find(swapchain) != swapchainMap.end()) {
-        unsigned i;
-
-        for (i = 0; i < *pCount; i++) {
-            // Create a mapping for an image to a device, image extent, and
-            // format
-            if (imageMap[pSwapchainImages[i]] == NULL) {
-                ImageMapStruct *imageMapElem = new ImageMapStruct;
-                imageMap[pSwapchainImages[i]] = imageMapElem;
-            }
-            imageMap[pSwapchainImages[i]]->device = swapchainMap[swapchain]->device;
-            imageMap[pSwapchainImages[i]]->imageExtent = swapchainMap[swapchain]->imageExtent;
-            imageMap[pSwapchainImages[i]]->format = swapchainMap[swapchain]->format;
-        }
+        unsigned i = *pCount;
 
         // Add list of images to swapchain to image map
         SwapchainMapStruct *swapchainMapElem = swapchainMap[swapchain];
         if (i >= 1 && swapchainMapElem) {
             VkImage *imageList = new VkImage[i];
+            delete[] swapchainMapElem->imageList;
             swapchainMapElem->imageList = imageList;
             for (unsigned j = 0; j < i; j++) {
                 swapchainMapElem->imageList[j] = pSwapchainImages[j];
@@ -1174,6 +1404,23 @@ VKAPI_ATTR VkResult VKAPI_CALL GetSwapchainImagesKHR(VkDevice device, VkSwapchai
     return result;
 }
 
+VKAPI_ATTR void VKAPI_CALL DestroySwapchainKHR(VkDevice device, VkSwapchainKHR swapchain, const VkAllocationCallbacks *pAllocator) {
+    DeviceMapStruct *devMap = get_dev_info(device);
+    assert(devMap);
+    VkLayerDispatchTable *pDisp = devMap->device_dispatch_table;
+
+    // Finish the screenshots of the swapchain before its images go away.
+    loader_platform_thread_lock_mutex(&globalLock);
+    auto swapchainIter = swapchainMap.find(swapchain);
+    if (swapchainIter != swapchainMap.end()) {
+        destroySwapchainMapElem(devMap, swapchainIter->second);
+        swapchainMap.erase(swapchainIter);
+    }
+    loader_platform_thread_unlock_mutex(&globalLock);
+
+    pDisp->DestroySwapchainKHR(device, swapchain, pAllocator);
+}
+
 VKAPI_ATTR VkResult VKAPI_CALL QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR *pPresentInfo) {
     static int frameNumber = 0;
     if (frameNumber == 10) {
@@ -1182,7 +1429,9 @@ VKAPI_ATTR VkResult VKAPI_CALL QueuePresentKHR(VkQueue queue, const VkPresentInf
     DeviceMapStruct *devMap = get_dev_info((VkDevice)queue);
     assert(devMap);
     VkLayerDispatchTable *pDisp = devMap->device_dispatch_table;
-    VkResult result = pDisp->QueuePresentKHR(queue, pPresentInfo);
+    VkPresentInfoKHR presentInfo = *pPresentInfo;
+    VkSemaphore screenshotSemaphore = VK_NULL_HANDLE;
+    bool lastScreenshot = false;
     loader_platform_thread_lock_mutex(&globalLock);
 
     if (!screenshotFramesReceived) {
@@ -1202,7 +1451,13 @@ VKAPI_ATTR VkResult VKAPI_CALL QueuePresentKHR(VkQueue queue, const VkPresentInf
         local_free_getenv(vk_screenshot_frames);
     }
 
-    if (result == VK_SUCCESS && (!screenshotFrames.empty() || screenShotFrameRange.valid)) {
+    // Hand the screenshots whose copies have completed to the writer threads.
+    for (auto swapchainIter = swapchainMap.begin(); swapchainIter != swapchainMap.end(); swapchainIter++) {
+        SwapchainMapStruct *swapchainMapElem = swapchainIter->second;
+        if (swapchainMapElem->readback) pollSwapchainReadback(get_dev_info(swapchainMapElem->device), swapchainMapElem->readback);
+    }
+
+    if (!screenshotFrames.empty() || screenShotFrameRange.valid) {
         set<int>::iterator it;
         bool inScreenShotFrames = false;
         bool inScreenShotFrameRange = false;
@@ -1217,45 +1472,54 @@ VKAPI_ATTR VkResult VKAPI_CALL QueuePresentKHR(VkQueue queue, const VkPresentInf
             char buffer[64];
             snprintf(buffer, sizeof(buffer), "/sdcard/Android/%d", frameNumber);
             std::string base(buffer);
-            fileName = base + ".ppm";
+            fileName = base + screenshotFileExtension(screenshotFileFormat);
 #else
-            fileName = to_string(frameNumber) + ".ppm";
+            fileName = to_string(frameNumber) + screenshotFileExtension(screenshotFileFormat);
             printf("Screen Capture file is: %s \n", fileName.c_str());
 #endif
 
-            VkImage image;
-            VkSwapchainKHR swapchain;
             // We'll dump only one image: the first
-            swapchain = pPresentInfo->pSwapchains[0];
-            image = swapchainMap[swapchain]->imageList[pPresentInfo->pImageIndices[0]];
-            writePPM(fileName.c_str(), image);
+            auto swapchainIter = swapchainMap.find(pPresentInfo->pSwapchains[0]);
+            if (swapchainIter != swapchainMap.end() && swapchainIter->second->imageList) {
+                SwapchainMapStruct *swapchainMapElem = swapchainIter->second;
+                VkImage image = swapchainMapElem->imageList[pPresentInfo->pImageIndices[0]];
+                if (takeScreenshot(fileName, swapchainMapElem, image, pPresentInfo, &screenshotSemaphore)) {
+                    // The copy waited for the present's semaphores, so the
+                    // present only needs to wait for the copy.
+                    presentInfo.waitSemaphoreCount = 1;
+                    presentInfo.pWaitSemaphores = &screenshotSemaphore;
+                }
+            }
             if (inScreenShotFrames) {
                 screenshotFrames.erase(it);
             }
 
             if (screenshotFrames.empty() && isEndOfScreenShotFrameRange(frameNumber, &screenShotFrameRange)) {
-                // Free all our maps since we are done with them.
-                for (auto swapchainIter = swapchainMap.begin(); swapchainIter != swapchainMap.end(); swapchainIter++) {
-                    SwapchainMapStruct *swapchainMapElem = swapchainIter->second;
-                    delete swapchainMapElem;
-                }
-                for (auto imageIter = imageMap.begin(); imageIter != imageMap.end(); imageIter++) {
-                    ImageMapStruct *imageMapElem = imageIter->second;
-                    delete imageMapElem;
-                }
-                for (auto physDeviceIter = physDeviceMap.begin(); physDeviceIter != physDeviceMap.end(); physDeviceIter++) {
-                    PhysDeviceMapStruct *physDeviceMapElem = physDeviceIter->second;
-                    delete physDeviceMapElem;
-                }
-                swapchainMap.clear();
-                imageMap.clear();
-                physDeviceMap.clear();
-                screenShotFrameRange.valid = false;
+                lastScreenshot = true;
             }
         }
     }
     frameNumber++;
     loader_platform_thread_unlock_mutex(&globalLock);
+
+    VkResult result = pDisp->QueuePresentKHR(queue, &presentInfo);
+
+    if (lastScreenshot) {
+        loader_platform_thread_lock_mutex(&globalLock);
+        // Finish the screenshots, and free all our maps since we are done with them.
+        for (auto swapchainIter = swapchainMap.begin(); swapchainIter != swapchainMap.end(); swapchainIter++) {
+            SwapchainMapStruct *swapchainMapElem = swapchainIter->second;
+            destroySwapchainMapElem(get_dev_info(swapchainMapElem->device), swapchainMapElem);
+        }
+        for (auto physDeviceIter = physDeviceMap.begin(); physDeviceIter != physDeviceMap.end(); physDeviceIter++) {
+            PhysDeviceMapStruct *physDeviceMapElem = physDeviceIter->second;
+            delete physDeviceMapElem;
+        }
+        swapchainMap.clear();
+        physDeviceMap.clear();
+        screenShotFrameRange.valid = false;
+        loader_platform_thread_unlock_mutex(&globalLock);
+    }
     return result;
 }
 
@@ -1343,6 +1607,7 @@ static PFN_vkVoidFunction intercept_core_instance_command(const char *name) {
     } core_instance_commands[] = {
         {"vkGetInstanceProcAddr", reinterpret_cast<PFN_vkVoidFunction>(GetInstanceProcAddr)},
         {"vkCreateInstance", reinterpret_cast<PFN_vkVoidFunction>(CreateInstance)},
+        {"vkDestroyInstance", reinterpret_cast<PFN_vkVoidFunction>(DestroyInstance)},
         {"vkCreateDevice", reinterpret_cast<PFN_vkVoidFunction>(CreateDevice)},
         {"vkEnumeratePhysicalDevices", reinterpret_cast<PFN_vkVoidFunction>(EnumeratePhysicalDevices)},
         {"vkEnumerateInstanceLayerProperties", reinterpret_cast<PFN_vkVoidFunction>(EnumerateInstanceLayerProperties)},
@@ -1364,8 +1629,6 @@ static PFN_vkVoidFunction intercept_core_device_command(const char *name) {
     } core_device_commands[] = {
         {"vkGetDeviceProcAddr", reinterpret_cast<PFN_vkVoidFunction>(GetDeviceProcAddr)},
         {"vkGetDeviceQueue", reinterpret_cast<PFN_vkVoidFunction>(GetDeviceQueue)},
-        {"vkCreateCommandPool", reinterpret_cast<PFN_vkVoidFunction>(CreateCommandPool)},
-        {"vkDestroyCommandPool", reinterpret_cast<PFN_vkVoidFunction>(DestroyCommandPool)},
         {"vkDestroyDevice", reinterpret_cast<PFN_vkVoidFunction>(DestroyDevice)},
     };
 
@@ -1383,6 +1646,7 @@ static PFN_vkVoidFunction intercept_khr_swapchain_command(const char *name, VkDe
     } khr_swapchain_commands[] = {
         {"vkCreateSwapchainKHR", reinterpret_cast<PFN_vkVoidFunction>(CreateSwapchainKHR)},
         {"vkGetSwapchainImagesKHR", reinterpret_cast<PFN_vkVoidFunction>(GetSwapchainImagesKHR)},
+        {"vkDestroySwapchainKHR", reinterpret_cast<PFN_vkVoidFunction>(DestroySwapchainKHR)},
         {"vkQueuePresentKHR", reinterpret_cast<PFN_vkVoidFunction>(QueuePresentKHR)},
     };
 
@@ -0,0 +1,603 @@
+/*
+ * Copyright (c) 2018 Valve Corporation
+ * Copyright (c) 2018 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "screenshot_encoding.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SCREENSHOT_X86_KERNELS
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC compiles intrinsics for any instruction set without options
+#define SCREENSHOT_TARGET(isa)
+#else
+#define SCREENSHOT_TARGET(isa) __attribute__((target(isa)))
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SCREENSHOT_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
+namespace screenshot {
+
+bool parseScreenshotFileFormat(const char *name, ScreenshotFileFormat *pFileFormat) {
+    if (!strcmp(name, "PPM")) {
+        *pFileFormat = SCREENSHOT_FILE_PPM;
+    } else if (!strcmp(name, "PNG")) {
+        *pFileFormat = SCREENSHOT_FILE_PNG;
+    } else if (!strcmp(name, "QOI")) {
+        *pFileFormat = SCREENSHOT_FILE_QOI;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *screenshotFileExtension(ScreenshotFileFormat fileFormat) {
+    switch (fileFormat) {
+        case SCREENSHOT_FILE_PNG:
+            return ".png";
+        case SCREENSHOT_FILE_QOI:
+            return ".qoi";
+        default:
+            return ".ppm";
+    }
+}
+
+// Row conversion
+//
+// Dropping the alpha channel of 4 channel pixels, and swapping red and blue
+// for BGRA swapchains, is done with byte shuffles where the CPU has them.
+// Kernels return the number of pixels they converted, and the rest of the row
+// is converted by the scalar loop.
+
+typedef uint32_t (*StripAlphaKernel)(const uint8_t *src, uint8_t *dst, uint32_t width, bool swapRB);
+
+static void convertPixelsScalar(const uint8_t *src, uint8_t *dst, uint32_t first, uint32_t width, uint32_t channels,
+                                bool swapRB) {
+    const uint32_t red = swapRB ? 2 : 0;
+    const uint32_t blue = swapRB ? 0 : 2;
+    for (uint32_t x = first; x < width; x++) {
+        dst[3 * x] = src[channels * x + red];
+        dst[3 * x + 1] = src[channels * x + 1];
+        dst[3 * x + 2] = src[channels * x + blue];
+    }
+}
+
+#if !defined(SCREENSHOT_NEON_KERNELS)
+// Leaves the whole row to the scalar loop, for CPUs without byte shuffles
+static uint32_t stripAlphaScalar(const uint8_t *, uint8_t *, uint32_t, bool) { return 0; }
+#endif
+
+#if defined(SCREENSHOT_X86_KERNELS)
+
+// 16 pixels at a time, written with three full 16 byte stores
+SCREENSHOT_TARGET("ssse3")
+static uint32_t stripAlphaSSSE3(const uint8_t *src, uint8_t *dst, uint32_t width, bool swapRB) {
+    const __m128i shuffle = swapRB ? _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1)
+                                   : _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m128i *in = reinterpret_cast<const __m128i *>(src + 4 * x);
+        __m128i *out = reinterpret_cast<__m128i *>(dst + 3 * x);
+        // 12 bytes of RGB in each, followed by 4 zero bytes
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(in), shuffle);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(in + 1), shuffle);
+        __m128i c = _mm_shuffle_epi8(_mm_loadu_si128(in + 2), shuffle);
+        __m128i d = _mm_shuffle_epi8(_mm_loadu_si128(in + 3), shuffle);
+        _mm_storeu_si128(out, _mm_or_si128(a, _mm_slli_si128(b, 12)));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+        _mm_storeu_si128(out + 2, _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+    }
+    return x;
+}
+
+// 8 pixels at a time.  Each 32 byte store leaves 8 bytes for the next one to
+// overwrite, so this stops while there are 3 pixels left for them.
+SCREENSHOT_TARGET("avx2")
+static uint32_t stripAlphaAVX2(const uint8_t *src, uint8_t *dst, uint32_t width, bool swapRB) {
+    const __m256i shuffle =
+        swapRB ? _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13,
+                                  12, -1, -1, -1, -1)
+               : _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13,
+                                  14, -1, -1, -1, -1);
+    // The shuffle packs each 128 bit lane on its own; this joins the lanes
+    const __m256i pack = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+    uint32_t x = 0;
+    for (; x + 11 <= width; x += 8) {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 4 * x));
+        pixels = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(pixels, shuffle), pack);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 3 * x), pixels);
+    }
+    return x;
+}
+
+static bool cpuHasSSSE3() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+static bool cpuHasAVX2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    // AVX also needs the OS to save the upper halves of the registers
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static StripAlphaKernel selectStripAlphaKernel() {
+    if (cpuHasAVX2()) return stripAlphaAVX2;
+    if (cpuHasSSSE3()) return stripAlphaSSSE3;
+    return stripAlphaScalar;
+}
+
+#elif defined(SCREENSHOT_NEON_KERNELS)
+
+static uint32_t stripAlphaNEON(const uint8_t *src, uint8_t *dst, uint32_t width, bool swapRB) {
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x4_t pixels = vld4q_u8(src + 4 * x);
+        uint8x16x3_t rgb;
+        rgb.val[0] = swapRB ? pixels.val[2] : pixels.val[0];
+        rgb.val[1] = pixels.val[1];
+        rgb.val[2] = swapRB ? pixels.val[0] : pixels.val[2];
+        vst3q_u8(dst + 3 * x, rgb);
+    }
+    return x;
+}
+
+static StripAlphaKernel selectStripAlphaKernel() { return stripAlphaNEON; }
+
+#else
+
+static StripAlphaKernel selectStripAlphaKernel() { return stripAlphaScalar; }
+
+#endif
+
+void convertScreenshotRow(ScreenshotPixelLayout layout, const uint8_t *src, uint8_t *dst, uint32_t width) {
+    static const StripAlphaKernel stripAlpha = selectStripAlphaKernel();
+
+    switch (layout) {
+        case SCREENSHOT_PIXELS_RGB:
+            memcpy(dst, src, 3 * static_cast<size_t>(width));
+            break;
+        case SCREENSHOT_PIXELS_BGR:
+            convertPixelsScalar(src, dst, 0, width, 3, true);
+            break;
+        case SCREENSHOT_PIXELS_RGBA:
+            convertPixelsScalar(src, dst, stripAlpha(src, dst, width, false), width, 4, false);
+            break;
+        case SCREENSHOT_PIXELS_BGRA:
+            convertPixelsScalar(src, dst, stripAlpha(src, dst, width, true), width, 4, true);
+            break;
+    }
+}
+
+// Byte order helpers
+
+static inline uint8_t *putBigEndian32(uint8_t *out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+    return out + 4;
+}
+
+static inline uint32_t load32(const uint8_t *data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// PPM
+
+static void encodePPM(ScreenshotPixelLayout layout, const uint8_t *src, uint32_t width, uint32_t height, uint64_t rowPitch,
+                      ScreenshotEncoderBuffers *buffers) {
+    char header[64];
+    int headerSize = snprintf(header, sizeof(header), "P6\n%u\n%u\n255\n", width, height);
+    const size_t rowSize = 3 * static_cast<size_t>(width);
+    buffers->file.resize(headerSize + rowSize * height);
+    memcpy(buffers->file.data(), header, headerSize);
+
+    uint8_t *out = reinterpret_cast<uint8_t *>(buffers->file.data()) + headerSize;
+    for (uint32_t y = 0; y < height; y++) {
+        convertScreenshotRow(layout, src + y * rowPitch, out, width);
+        out += rowSize;
+    }
+}
+
+// PNG
+//
+// The rows are filtered with the "Up" filter, which turns the parts of an
+// image that repeat the row above into runs of zeros, and compressed as a
+// single deflate block with the fixed Huffman codes.  Matches are found with
+// a single probe of a hash table.  This is several times faster than zlib's
+// fastest level, at the cost of larger files.
+
+static const uint32_t pngHashBits = 15;
+static const uint32_t deflateWindowSize = 32768;
+static const uint32_t deflateMaxMatch = 258;
+
+typedef struct {
+    uint16_t code;  // Huffman code and extra bits, in the order they're written
+    uint8_t bits;
+} DeflateCode;
+
+typedef struct {
+    DeflateCode literals[256];
+    DeflateCode endOfBlock;
+    DeflateCode lengths[deflateMaxMatch + 1];  // indexed by match length
+    uint8_t distanceSymbols[512];              // see distanceSymbol()
+    uint16_t distanceBase[30];
+    uint8_t distanceExtraBits[30];
+    uint32_t crcTable[256];
+} PNGTables;
+
+static uint32_t reverseBits(uint32_t code, uint32_t bits) {
+    uint32_t reversed = 0;
+    for (uint32_t i = 0; i < bits; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    return reversed;
+}
+
+// Fixed Huffman code of a literal/length symbol (RFC 1951 3.2.6), bit reversed
+// because deflate writes Huffman codes starting from their most significant bit
+static DeflateCode fixedLiteralCode(uint32_t symbol) {
+    DeflateCode code;
+    if (symbol < 144) {
+        code.bits = 8;
+        code.code = static_cast<uint16_t>(reverseBits(0x30 + symbol, 8));
+    } else if (symbol < 256) {
+        code.bits = 9;
+        code.code = static_cast<uint16_t>(reverseBits(0x190 + symbol - 144, 9));
+    } else if (symbol < 280) {
+        code.bits = 7;
+        code.code = static_cast<uint16_t>(reverseBits(symbol - 256, 7));
+    } else {
+        code.bits = 8;
+        code.code = static_cast<uint16_t>(reverseBits(0xc0 + symbol - 280, 8));
+    }
+    return code;
+}
+
+static PNGTables buildPNGTables() {
+    static const uint16_t lengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                            31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const uint8_t lengthExtraBits[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                                2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    PNGTables tables;
+
+    for (uint32_t symbol = 0; symbol < 256; symbol++) tables.literals[symbol] = fixedLiteralCode(symbol);
+    tables.endOfBlock = fixedLiteralCode(256);
+
+    // Length codes, with their extra bits after the Huffman code
+    for (uint32_t i = 0; i < 29; i++) {
+        uint32_t last = (i == 28) ? deflateMaxMatch : lengthBase[i] + (1u << lengthExtraBits[i]) - 1;
+        if (i == 27) last = 257;  // 258 has a code of its own
+        DeflateCode code = fixedLiteralCode(257 + i);
+        for (uint32_t length = lengthBase[i]; length <= last; length++) {
+            tables.lengths[length].code = static_cast<uint16_t>(code.code | ((length - lengthBase[i]) << code.bits));
+            tables.lengths[length].bits = static_cast<uint8_t>(code.bits + lengthExtraBits[i]);
+        }
+    }
+
+    // Distance symbols, looked up the way zlib does: distances up to 256 each
+    // have an entry, and larger ones have an entry per 128 distances.
+    uint32_t distance = 0;
+    uint32_t symbol = 0;
+    for (; symbol < 16; symbol++) {
+        tables.distanceExtraBits[symbol] = static_cast<uint8_t>(symbol < 4 ? 0 : symbol / 2 - 1);
+        tables.distanceBase[symbol] = static_cast<uint16_t>(distance + 1);
+        for (uint32_t i = 0; i < (1u << tables.distanceExtraBits[symbol]); i++) {
+            tables.distanceSymbols[distance++] = static_cast<uint8_t>(symbol);
+        }
+    }
+    distance >>= 7;
+    for (; symbol < 30; symbol++) {
+        tables.distanceExtraBits[symbol] = static_cast<uint8_t>(symbol / 2 - 1);
+        tables.distanceBase[symbol] = static_cast<uint16_t>((distance << 7) + 1);
+        for (uint32_t i = 0; i < (1u << (tables.distanceExtraBits[symbol] - 7)); i++) {
+            tables.distanceSymbols[256 + distance++] = static_cast<uint8_t>(symbol);
+        }
+    }
+
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t crc = n;
+        for (uint32_t k = 0; k < 8; k++) crc = (crc & 1) ? 0xedb88320u ^ (crc >> 1) : crc >> 1;
+        tables.crcTable[n] = crc;
+    }
+    return tables;
+}
+
+static const PNGTables &pngTables() {
+    static const PNGTables tables = buildPNGTables();
+    return tables;
+}
+
+static inline uint32_t distanceSymbol(const PNGTables &tables, uint32_t distance) {
+    return (distance <= 256) ? tables.distanceSymbols[distance - 1] : tables.distanceSymbols[256 + ((distance - 1) >> 7)];
+}
+
+// Writes the bits of a deflate stream, least significant bit first
+typedef struct {
+    uint8_t *out;
+    uint64_t bits;
+    uint32_t count;
+} BitWriter;
+
+static inline void putBits(BitWriter *writer, uint32_t value, uint32_t bits) {
+    writer->bits |= static_cast<uint64_t>(value) << writer->count;
+    writer->count += bits;
+    if (writer->count >= 32) {
+        writer->out[0] = static_cast<uint8_t>(writer->bits);
+        writer->out[1] = static_cast<uint8_t>(writer->bits >> 8);
+        writer->out[2] = static_cast<uint8_t>(writer->bits >> 16);
+        writer->out[3] = static_cast<uint8_t>(writer->bits >> 24);
+        writer->out += 4;
+        writer->bits >>= 32;
+        writer->count -= 32;
+    }
+}
+
+static uint8_t *flushBits(BitWriter *writer) {
+    while (writer->count > 0) {
+        *writer->out++ = static_cast<uint8_t>(writer->bits);
+        writer->bits >>= 8;
+        writer->count = (writer->count > 8) ? writer->count - 8 : 0;
+    }
+    return writer->out;
+}
+
+// Most bytes deflateFixed() can write for size bytes of data
+static size_t deflateFixedBound(size_t size) { return size + size / 8 + 16; }
+
+// Compress data as one final deflate block with the fixed Huffman codes.
+// table needs 1 << pngHashBits entries.  Returns the end of the output.
+static uint8_t *deflateFixed(const uint8_t *data, size_t size, uint8_t *out, uint32_t *table) {
+    const PNGTables &tables = pngTables();
+    BitWriter writer = {out, 0, 0};
+    putBits(&writer, 3, 3);  // BFINAL, and BTYPE 01 for the fixed codes
+
+    memset(table, 0, sizeof(uint32_t) << pngHashBits);
+    size_t pos = 0;
+    while (pos + 4 <= size) {
+        const uint32_t bytes = load32(data + pos);
+        const uint32_t hash = (bytes * 2654435761u) >> (32 - pngHashBits);
+        // Positions are stored as 32 bit offsets, which is plenty for a screenshot
+        const uint32_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(pos);
+        const uint32_t distance = static_cast<uint32_t>(pos) - candidate;
+        if (distance - 1 < deflateWindowSize && load32(data + candidate) == bytes) {
+            const size_t maxLength = std::min<size_t>(deflateMaxMatch, size - pos);
+            size_t length = 4;
+            while (length < maxLength && data[candidate + length] == data[pos + length]) length++;
+
+            const DeflateCode &lengthCode = tables.lengths[length];
+            putBits(&writer, lengthCode.code, lengthCode.bits);
+            const uint32_t symbol = distanceSymbol(tables, distance);
+            putBits(&writer, reverseBits(symbol, 5) | ((distance - tables.distanceBase[symbol]) << 5),
+                    5 + tables.distanceExtraBits[symbol]);
+            pos += length;
+        } else {
+            const DeflateCode &literal = tables.literals[data[pos]];
+            putBits(&writer, literal.code, literal.bits);
+            pos++;
+        }
+    }
+    for (; pos < size; pos++) {
+        const DeflateCode &literal = tables.literals[data[pos]];
+        putBits(&writer, literal.code, literal.bits);
+    }
+    putBits(&writer, tables.endOfBlock.code, tables.endOfBlock.bits);
+    return flushBits(&writer);
+}
+
+static uint32_t adler32(const uint8_t *data, size_t size) {
+    uint32_t a = 1, b = 0;
+    while (size > 0) {
+        // The most bytes that can be summed before b could overflow
+        size_t block = std::min<size_t>(size, 5552);
+        size -= block;
+        for (; block > 0; block--) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+static uint32_t crc32(const uint8_t *data, size_t size) {
+    const uint32_t *crcTable = pngTables().crcTable;
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < size; i++) crc = crcTable[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return crc ^ 0xffffffffu;
+}
+
+// Write the length and type of a chunk.  Returns where its data goes.
+static uint8_t *beginPNGChunk(uint8_t *out, uint32_t length, const char *type) {
+    out = putBigEndian32(out, length);
+    memcpy(out, type, 4);
+    return out + 4;
+}
+
+// Write the CRC of the chunk that starts at chunk and ends at end
+static uint8_t *endPNGChunk(uint8_t *chunk, uint8_t *end) { return putBigEndian32(end, crc32(chunk + 4, end - chunk - 4)); }
+
+static void encodePNG(ScreenshotPixelLayout layout, const uint8_t *src, uint32_t width, uint32_t height, uint64_t rowPitch,
+                      ScreenshotEncoderBuffers *buffers) {
+    // Each row of the image data is a filter type byte followed by the row
+    const size_t rowSize = 1 + 3 * static_cast<size_t>(width);
+    const size_t imageSize = rowSize * height;
+    buffers->rows.resize(imageSize);
+    uint8_t *rows = buffers->rows.data();
+    for (uint32_t y = 0; y < height; y++) {
+        convertScreenshotRow(layout, src + y * rowPitch, rows + y * rowSize + 1, width);
+    }
+    // Filter from the bottom up, so that the row above is still unfiltered
+    for (uint32_t y = height; y-- > 1;) {
+        uint8_t *row = rows + y * rowSize;
+        const uint8_t *above = row - rowSize;
+        row[0] = 2;  // Up
+        for (size_t i = 1; i < rowSize; i++) row[i] = static_cast<uint8_t>(row[i] - above[i]);
+    }
+    if (height > 0) rows[0] = 0;  // None
+
+    static const uint8_t signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    const size_t headerSize = sizeof(signature) + 25;
+    buffers->file.resize(headerSize + 12 + 2 + deflateFixedBound(imageSize) + 4 + 12);
+    buffers->table.resize(static_cast<size_t>(1) << pngHashBits);
+    uint8_t *const file = reinterpret_cast<uint8_t *>(buffers->file.data());
+
+    uint8_t *out = file;
+    memcpy(out, signature, sizeof(signature));
+    uint8_t *chunk = out + sizeof(signature);
+    out = beginPNGChunk(chunk, 13, "IHDR");
+    out = putBigEndian32(out, width);
+    out = putBigEndian32(out, height);
+    *out++ = 8;  // bits per channel
+    *out++ = 2;  // RGB
+    *out++ = 0;  // deflate
+    *out++ = 0;  // adaptive filtering
+    *out++ = 0;  // not interlaced
+    out = endPNGChunk(chunk, out);
+
+    // The length of IDAT is only known once its data has been compressed
+    chunk = out;
+    out = beginPNGChunk(chunk, 0, "IDAT");
+    uint8_t *const data = out;
+    *out++ = 0x78;  // zlib stream with a 32K window
+    *out++ = 0x01;  // fastest compression, no dictionary
+    out = deflateFixed(rows, imageSize, out, buffers->table.data());
+    out = putBigEndian32(out, adler32(rows, imageSize));
+    putBigEndian32(chunk, static_cast<uint32_t>(out - data));
+    out = endPNGChunk(chunk, out);
+
+    chunk = out;
+    out = endPNGChunk(chunk, beginPNGChunk(chunk, 0, "IEND"));
+    buffers->file.resize(out - file);
+}
+
+// QOI, as described at https://qoiformat.org.  Pixels are encoded as runs of
+// the previous pixel, references to recently seen pixels, small differences
+// to the previous pixel, or as they are.
+
+static void encodeQOI(ScreenshotPixelLayout layout, const uint8_t *src, uint32_t width, uint32_t height, uint64_t rowPitch,
+                      ScreenshotEncoderBuffers *buffers) {
+    const size_t rowSize = 3 * static_cast<size_t>(width);
+    const size_t headerSize = 14;
+    static const uint8_t endMarker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    // At worst every pixel takes 4 bytes
+    buffers->file.resize(headerSize + 4 * static_cast<size_t>(width) * height + sizeof(endMarker));
+    buffers->rows.resize(rowSize);
+    uint8_t *const file = reinterpret_cast<uint8_t *>(buffers->file.data());
+
+    uint8_t *out = file;
+    memcpy(out, "qoif", 4);
+    out = putBigEndian32(out + 4, width);
+    out = putBigEndian32(out, height);
+    *out++ = 3;  // RGB
+    *out++ = 0;  // sRGB
+
+    // Pixels are packed as 0xAABBGGRR, with an opaque alpha
+    uint32_t index[64] = {};
+    uint32_t previous = 0xff000000u;
+    uint32_t run = 0;
+    uint8_t *rgb = buffers->rows.data();
+    for (uint32_t y = 0; y < height; y++) {
+        convertScreenshotRow(layout, src + y * rowPitch, rgb, width);
+        for (uint32_t x = 0; x < width; x++) {
+            const uint8_t r = rgb[3 * x], g = rgb[3 * x + 1], b = rgb[3 * x + 2];
+            const uint32_t pixel = 0xff000000u | (b << 16) | (g << 8) | r;
+            if (pixel == previous) {
+                if (++run == 62) {
+                    *out++ = static_cast<uint8_t>(0xc0 | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *out++ = static_cast<uint8_t>(0xc0 | (run - 1));
+                run = 0;
+            }
+
+            const uint32_t hash = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+            if (index[hash] == pixel) {
+                *out++ = static_cast<uint8_t>(hash);
+            } else {
+                index[hash] = pixel;
+                // Differences wrap around, as the decoder adds them modulo 256
+                const int dr = static_cast<int8_t>(r - (previous & 0xff));
+                const int dg = static_cast<int8_t>(g - ((previous >> 8) & 0xff));
+                const int db = static_cast<int8_t>(b - ((previous >> 16) & 0xff));
+                const int drg = dr - dg, dbg = db - dg;
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    *out++ = static_cast<uint8_t>(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+                } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                    *out++ = static_cast<uint8_t>(0x80 | (dg + 32));
+                    *out++ = static_cast<uint8_t>(((drg + 8) << 4) | (dbg + 8));
+                } else {
+                    *out++ = 0xfe;
+                    *out++ = r;
+                    *out++ = g;
+                    *out++ = b;
+                }
+            }
+            previous = pixel;
+        }
+    }
+    if (run > 0) *out++ = static_cast<uint8_t>(0xc0 | (run - 1));
+    memcpy(out, endMarker, sizeof(endMarker));
+    out += sizeof(endMarker);
+    buffers->file.resize(out - file);
+}
+
+void encodeScreenshot(ScreenshotFileFormat fileFormat, ScreenshotPixelLayout layout, const uint8_t *src, uint32_t width,
+                      uint32_t height, uint64_t rowPitch, ScreenshotEncoderBuffers *buffers) {
+    switch (fileFormat) {
+        case SCREENSHOT_FILE_PNG:
+            encodePNG(layout, src, width, height, rowPitch, buffers);
+            break;
+        case SCREENSHOT_FILE_QOI:
+            encodeQOI(layout, src, width, height, rowPitch, buffers);
+            break;
+        default:
+            encodePPM(layout, src, width, height, rowPitch, buffers);
+            break;
+    }
+}
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2018 Valve Corporation
+ * Copyright (c) 2018 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+namespace screenshot {
+
+// File formats screenshots can be written in
+typedef enum ScreenshotFileFormat {
+    SCREENSHOT_FILE_PPM = 0,  // binary PPM, uncompressed
+    SCREENSHOT_FILE_PNG = 1,  // PNG, compressed for speed rather than size
+    SCREENSHOT_FILE_QOI = 2,  // QOI ("Quite OK Image"), fast lossless compression
+} ScreenshotFileFormat;
+
+// Order of the 8 bit channels of the pixels read back from a swapchain
+typedef enum ScreenshotPixelLayout {
+    SCREENSHOT_PIXELS_RGB = 0,
+    SCREENSHOT_PIXELS_BGR = 1,
+    SCREENSHOT_PIXELS_RGBA = 2,
+    SCREENSHOT_PIXELS_BGRA = 3,
+} ScreenshotPixelLayout;
+
+// Buffers an encoder reuses from one screenshot to the next.  Each thread that
+// encodes screenshots needs its own.
+typedef struct {
+    std::vector<char> file;       // the encoded file
+    std::vector<uint8_t> rows;    // RGB rows, and the filtered rows of a PNG
+    std::vector<uint32_t> table;  // match table of the PNG compressor
+} ScreenshotEncoderBuffers;
+
+// Parse the name of a file format ("PPM", "PNG" or "QOI").  Returns false if
+// the name isn't one of them.
+bool parseScreenshotFileFormat(const char *name, ScreenshotFileFormat *pFileFormat);
+
+// File name extension of a file format, including the dot
+const char *screenshotFileExtension(ScreenshotFileFormat fileFormat);
+
+// Convert width pixels of the given layout to tightly packed RGB.  The alpha
+// channel, if any, is dropped.
+void convertScreenshotRow(ScreenshotPixelLayout layout, const uint8_t *src, uint8_t *dst, uint32_t width);
+
+// Encode a screenshot in buffers->file.  Rows of src are rowPitch bytes apart.
+// Every format is written as RGB.
+void encodeScreenshot(ScreenshotFileFormat fileFormat, ScreenshotPixelLayout layout, const uint8_t *src, uint32_t width,
+                      uint32_t height, uint64_t rowPitch, ScreenshotEncoderBuffers *buffers);
+}
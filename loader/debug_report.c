@@ -443,24 +443,27 @@ VKAPI_ATTR void VKAPI_CALL terminator_DebugReportMessageEXT(VkInstance instance,
     loader_platform_thread_unlock_mutex(&loader_lock);
 }
 
-bool debug_report_instance_gpa(struct loader_instance *ptr_instance, const char *name, void **addr) {
+bool debug_report_instance_gpa(struct loader_instance *ptr_instance, enum loader_command_id command, void **addr) {
     // debug_report is currently advertised to be supported by the loader,
     // so always return the entry points if name matches and it's enabled
     *addr = NULL;
 
-    if (!strcmp("vkCreateDebugReportCallbackEXT", name)) {
-        *addr = (ptr_instance->enabled_known_extensions.ext_debug_report == 1) ? (void *)debug_report_CreateDebugReportCallbackEXT
-                                                                               : NULL;
-        return true;
+    switch (command) {
+        case LOADER_COMMAND_vkCreateDebugReportCallbackEXT:
+            *addr = (ptr_instance->enabled_known_extensions.ext_debug_report == 1)
+                        ? (void *)debug_report_CreateDebugReportCallbackEXT
+                        : NULL;
+            return true;
+        case LOADER_COMMAND_vkDestroyDebugReportCallbackEXT:
+            *addr = (ptr_instance->enabled_known_extensions.ext_debug_report == 1)
+                        ? (void *)debug_report_DestroyDebugReportCallbackEXT
+                        : NULL;
+            return true;
+        case LOADER_COMMAND_vkDebugReportMessageEXT:
+            *addr = (ptr_instance->enabled_known_extensions.ext_debug_report == 1) ? (void *)debug_report_DebugReportMessageEXT
+                                                                                   : NULL;
+            return true;
+        default:
+            return false;
     }
-    if (!strcmp("vkDestroyDebugReportCallbackEXT", name)) {
-        *addr = (ptr_instance->enabled_known_extensions.ext_debug_report == 1) ? (void *)debug_report_DestroyDebugReportCallbackEXT
-                                                                               : NULL;
-        return true;
-    }
-    if (!strcmp("vkDebugReportMessageEXT", name)) {
-        *addr = (ptr_instance->enabled_known_extensions.ext_debug_report == 1) ? (void *)debug_report_DebugReportMessageEXT : NULL;
-        return true;
-    }
-    return false;
 }
@@ -103,7 +103,7 @@ void debug_report_add_instance_extensions(const struct loader_instance *inst, st
 
 void debug_report_create_instance(struct loader_instance *ptr_instance, const VkInstanceCreateInfo *pCreateInfo);
 
-bool debug_report_instance_gpa(struct loader_instance *ptr_instance, const char *name, void **addr);
+bool debug_report_instance_gpa(struct loader_instance *ptr_instance, enum loader_command_id command, void **addr);
 
 VKAPI_ATTR VkResult VKAPI_CALL terminator_CreateDebugReportCallbackEXT(VkInstance instance,
                                                                        const VkDebugReportCallbackCreateInfoEXT *pCreateInfo,
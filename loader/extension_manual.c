@@ -812,13 +812,15 @@ VkResult setupLoaderTrampPhysDevGroups(VkInstance instance) {
         goto out;
     }
 
-    // Setup the trampoline loader physical devices.  This will actually
-    // call down and setup the terminator loader physical devices during the
-    // process.
-    VkResult setup_res = setupLoaderTrampPhysDevs(instance);
-    if (setup_res != VK_SUCCESS && setup_res != VK_INCOMPLETE) {
-        res = setup_res;
-        goto out;
+    // Setup the trampoline loader physical devices if they haven't been
+    // enumerated yet.  This will actually call down and setup the terminator
+    // loader physical devices during the process.
+    if (NULL == inst->phys_devs_tramp) {
+        VkResult setup_res = setupLoaderTrampPhysDevs(instance);
+        if (setup_res != VK_SUCCESS && setup_res != VK_INCOMPLETE) {
+            res = setup_res;
+            goto out;
+        }
     }
 
     // Query how many physical device groups there
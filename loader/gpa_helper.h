@@ -23,153 +23,288 @@
 #include "debug_report.h"
 #include "wsi.h"
 
-static inline void *trampolineGetProcAddr(struct loader_instance *inst, const char *funcName) {
+static inline void *trampolineGetProcAddr(struct loader_instance *inst, const char *funcName, enum loader_command_id command) {
     // Don't include or check global functions
-    if (!strcmp(funcName, "vkGetInstanceProcAddr")) return (PFN_vkVoidFunction)vkGetInstanceProcAddr;
-    if (!strcmp(funcName, "vkDestroyInstance")) return (PFN_vkVoidFunction)vkDestroyInstance;
-    if (!strcmp(funcName, "vkEnumeratePhysicalDevices")) return (PFN_vkVoidFunction)vkEnumeratePhysicalDevices;
-    if (!strcmp(funcName, "vkGetPhysicalDeviceFeatures")) return (PFN_vkVoidFunction)vkGetPhysicalDeviceFeatures;
-    if (!strcmp(funcName, "vkGetPhysicalDeviceFormatProperties")) return (PFN_vkVoidFunction)vkGetPhysicalDeviceFormatProperties;
-    if (!strcmp(funcName, "vkGetPhysicalDeviceImageFormatProperties"))
-        return (PFN_vkVoidFunction)vkGetPhysicalDeviceImageFormatProperties;
-    if (!strcmp(funcName, "vkGetPhysicalDeviceSparseImageFormatProperties"))
-        return (PFN_vkVoidFunction)vkGetPhysicalDeviceSparseImageFormatProperties;
-    if (!strcmp(funcName, "vkGetPhysicalDeviceProperties")) return (PFN_vkVoidFunction)vkGetPhysicalDeviceProperties;
-    if (!strcmp(funcName, "vkGetPhysicalDeviceQueueFamilyProperties"))
-        return (PFN_vkVoidFunction)vkGetPhysicalDeviceQueueFamilyProperties;
-    if (!strcmp(funcName, "vkGetPhysicalDeviceMemoryProperties")) return (PFN_vkVoidFunction)vkGetPhysicalDeviceMemoryProperties;
-    if (!strcmp(funcName, "vkEnumerateDeviceLayerProperties")) return (PFN_vkVoidFunction)vkEnumerateDeviceLayerProperties;
-    if (!strcmp(funcName, "vkEnumerateDeviceExtensionProperties")) return (PFN_vkVoidFunction)vkEnumerateDeviceExtensionProperties;
-    if (!strcmp(funcName, "vkCreateDevice")) return (PFN_vkVoidFunction)vkCreateDevice;
-    if (!strcmp(funcName, "vkGetDeviceProcAddr")) return (PFN_vkVoidFunction)vkGetDeviceProcAddr;
-    if (!strcmp(funcName, "vkDestroyDevice")) return (PFN_vkVoidFunction)vkDestroyDevice;
-    if (!strcmp(funcName, "vkGetDeviceQueue")) return (PFN_vkVoidFunction)vkGetDeviceQueue;
-    if (!strcmp(funcName, "vkQueueSubmit")) return (PFN_vkVoidFunction)vkQueueSubmit;
-    if (!strcmp(funcName, "vkQueueWaitIdle")) return (PFN_vkVoidFunction)vkQueueWaitIdle;
-    if (!strcmp(funcName, "vkDeviceWaitIdle")) return (PFN_vkVoidFunction)vkDeviceWaitIdle;
-    if (!strcmp(funcName, "vkAllocateMemory")) return (PFN_vkVoidFunction)vkAllocateMemory;
-    if (!strcmp(funcName, "vkFreeMemory")) return (PFN_vkVoidFunction)vkFreeMemory;
-    if (!strcmp(funcName, "vkMapMemory")) return (PFN_vkVoidFunction)vkMapMemory;
-    if (!strcmp(funcName, "vkUnmapMemory")) return (PFN_vkVoidFunction)vkUnmapMemory;
-    if (!strcmp(funcName, "vkFlushMappedMemoryRanges")) return (PFN_vkVoidFunction)vkFlushMappedMemoryRanges;
-    if (!strcmp(funcName, "vkInvalidateMappedMemoryRanges")) return (PFN_vkVoidFunction)vkInvalidateMappedMemoryRanges;
-    if (!strcmp(funcName, "vkGetDeviceMemoryCommitment")) return (PFN_vkVoidFunction)vkGetDeviceMemoryCommitment;
-    if (!strcmp(funcName, "vkGetImageSparseMemoryRequirements")) return (PFN_vkVoidFunction)vkGetImageSparseMemoryRequirements;
-    if (!strcmp(funcName, "vkGetImageMemoryRequirements")) return (PFN_vkVoidFunction)vkGetImageMemoryRequirements;
-    if (!strcmp(funcName, "vkGetBufferMemoryRequirements")) return (PFN_vkVoidFunction)vkGetBufferMemoryRequirements;
-    if (!strcmp(funcName, "vkBindImageMemory")) return (PFN_vkVoidFunction)vkBindImageMemory;
-    if (!strcmp(funcName, "vkBindBufferMemory")) return (PFN_vkVoidFunction)vkBindBufferMemory;
-    if (!strcmp(funcName, "vkQueueBindSparse")) return (PFN_vkVoidFunction)vkQueueBindSparse;
-    if (!strcmp(funcName, "vkCreateFence")) return (PFN_vkVoidFunction)vkCreateFence;
-    if (!strcmp(funcName, "vkDestroyFence")) return (PFN_vkVoidFunction)vkDestroyFence;
-    if (!strcmp(funcName, "vkGetFenceStatus")) return (PFN_vkVoidFunction)vkGetFenceStatus;
-    if (!strcmp(funcName, "vkResetFences")) return (PFN_vkVoidFunction)vkResetFences;
-    if (!strcmp(funcName, "vkWaitForFences")) return (PFN_vkVoidFunction)vkWaitForFences;
-    if (!strcmp(funcName, "vkCreateSemaphore")) return (PFN_vkVoidFunction)vkCreateSemaphore;
-    if (!strcmp(funcName, "vkDestroySemaphore")) return (PFN_vkVoidFunction)vkDestroySemaphore;
-    if (!strcmp(funcName, "vkCreateEvent")) return (PFN_vkVoidFunction)vkCreateEvent;
-    if (!strcmp(funcName, "vkDestroyEvent")) return (PFN_vkVoidFunction)vkDestroyEvent;
-    if (!strcmp(funcName, "vkGetEventStatus")) return (PFN_vkVoidFunction)vkGetEventStatus;
-    if (!strcmp(funcName, "vkSetEvent")) return (PFN_vkVoidFunction)vkSetEvent;
-    if (!strcmp(funcName, "vkResetEvent")) return (PFN_vkVoidFunction)vkResetEvent;
-    if (!strcmp(funcName, "vkCreateQueryPool")) return (PFN_vkVoidFunction)vkCreateQueryPool;
-    if (!strcmp(funcName, "vkDestroyQueryPool")) return (PFN_vkVoidFunction)vkDestroyQueryPool;
-    if (!strcmp(funcName, "vkGetQueryPoolResults")) return (PFN_vkVoidFunction)vkGetQueryPoolResults;
-    if (!strcmp(funcName, "vkCreateBuffer")) return (PFN_vkVoidFunction)vkCreateBuffer;
-    if (!strcmp(funcName, "vkDestroyBuffer")) return (PFN_vkVoidFunction)vkDestroyBuffer;
-    if (!strcmp(funcName, "vkCreateBufferView")) return (PFN_vkVoidFunction)vkCreateBufferView;
-    if (!strcmp(funcName, "vkDestroyBufferView")) return (PFN_vkVoidFunction)vkDestroyBufferView;
-    if (!strcmp(funcName, "vkCreateImage")) return (PFN_vkVoidFunction)vkCreateImage;
-    if (!strcmp(funcName, "vkDestroyImage")) return (PFN_vkVoidFunction)vkDestroyImage;
-    if (!strcmp(funcName, "vkGetImageSubresourceLayout")) return (PFN_vkVoidFunction)vkGetImageSubresourceLayout;
-    if (!strcmp(funcName, "vkCreateImageView")) return (PFN_vkVoidFunction)vkCreateImageView;
-    if (!strcmp(funcName, "vkDestroyImageView")) return (PFN_vkVoidFunction)vkDestroyImageView;
-    if (!strcmp(funcName, "vkCreateShaderModule")) return (PFN_vkVoidFunction)vkCreateShaderModule;
-    if (!strcmp(funcName, "vkDestroyShaderModule")) return (PFN_vkVoidFunction)vkDestroyShaderModule;
-    if (!strcmp(funcName, "vkCreatePipelineCache")) return (PFN_vkVoidFunction)vkCreatePipelineCache;
-    if (!strcmp(funcName, "vkDestroyPipelineCache")) return (PFN_vkVoidFunction)vkDestroyPipelineCache;
-    if (!strcmp(funcName, "vkGetPipelineCacheData")) return (PFN_vkVoidFunction)vkGetPipelineCacheData;
-    if (!strcmp(funcName, "vkMergePipelineCaches")) return (PFN_vkVoidFunction)vkMergePipelineCaches;
-    if (!strcmp(funcName, "vkCreateGraphicsPipelines")) return (PFN_vkVoidFunction)vkCreateGraphicsPipelines;
-    if (!strcmp(funcName, "vkCreateComputePipelines")) return (PFN_vkVoidFunction)vkCreateComputePipelines;
-    if (!strcmp(funcName, "vkDestroyPipeline")) return (PFN_vkVoidFunction)vkDestroyPipeline;
-    if (!strcmp(funcName, "vkCreatePipelineLayout")) return (PFN_vkVoidFunction)vkCreatePipelineLayout;
-    if (!strcmp(funcName, "vkDestroyPipelineLayout")) return (PFN_vkVoidFunction)vkDestroyPipelineLayout;
-    if (!strcmp(funcName, "vkCreateSampler")) return (PFN_vkVoidFunction)vkCreateSampler;
-    if (!strcmp(funcName, "vkDestroySampler")) return (PFN_vkVoidFunction)vkDestroySampler;
-    if (!strcmp(funcName, "vkCreateDescriptorSetLayout")) return (PFN_vkVoidFunction)vkCreateDescriptorSetLayout;
-    if (!strcmp(funcName, "vkDestroyDescriptorSetLayout")) return (PFN_vkVoidFunction)vkDestroyDescriptorSetLayout;
-    if (!strcmp(funcName, "vkCreateDescriptorPool")) return (PFN_vkVoidFunction)vkCreateDescriptorPool;
-    if (!strcmp(funcName, "vkDestroyDescriptorPool")) return (PFN_vkVoidFunction)vkDestroyDescriptorPool;
-    if (!strcmp(funcName, "vkResetDescriptorPool")) return (PFN_vkVoidFunction)vkResetDescriptorPool;
-    if (!strcmp(funcName, "vkAllocateDescriptorSets")) return (PFN_vkVoidFunction)vkAllocateDescriptorSets;
-    if (!strcmp(funcName, "vkFreeDescriptorSets")) return (PFN_vkVoidFunction)vkFreeDescriptorSets;
-    if (!strcmp(funcName, "vkUpdateDescriptorSets")) return (PFN_vkVoidFunction)vkUpdateDescriptorSets;
-    if (!strcmp(funcName, "vkCreateFramebuffer")) return (PFN_vkVoidFunction)vkCreateFramebuffer;
-    if (!strcmp(funcName, "vkDestroyFramebuffer")) return (PFN_vkVoidFunction)vkDestroyFramebuffer;
-    if (!strcmp(funcName, "vkCreateRenderPass")) return (PFN_vkVoidFunction)vkCreateRenderPass;
-    if (!strcmp(funcName, "vkDestroyRenderPass")) return (PFN_vkVoidFunction)vkDestroyRenderPass;
-    if (!strcmp(funcName, "vkGetRenderAreaGranularity")) return (PFN_vkVoidFunction)vkGetRenderAreaGranularity;
-    if (!strcmp(funcName, "vkCreateCommandPool")) return (PFN_vkVoidFunction)vkCreateCommandPool;
-    if (!strcmp(funcName, "vkDestroyCommandPool")) return (PFN_vkVoidFunction)vkDestroyCommandPool;
-    if (!strcmp(funcName, "vkResetCommandPool")) return (PFN_vkVoidFunction)vkResetCommandPool;
-    if (!strcmp(funcName, "vkAllocateCommandBuffers")) return (PFN_vkVoidFunction)vkAllocateCommandBuffers;
-    if (!strcmp(funcName, "vkFreeCommandBuffers")) return (PFN_vkVoidFunction)vkFreeCommandBuffers;
-    if (!strcmp(funcName, "vkBeginCommandBuffer")) return (PFN_vkVoidFunction)vkBeginCommandBuffer;
-    if (!strcmp(funcName, "vkEndCommandBuffer")) return (PFN_vkVoidFunction)vkEndCommandBuffer;
-    if (!strcmp(funcName, "vkResetCommandBuffer")) return (PFN_vkVoidFunction)vkResetCommandBuffer;
-    if (!strcmp(funcName, "vkCmdBindPipeline")) return (PFN_vkVoidFunction)vkCmdBindPipeline;
-    if (!strcmp(funcName, "vkCmdBindDescriptorSets")) return (PFN_vkVoidFunction)vkCmdBindDescriptorSets;
-    if (!strcmp(funcName, "vkCmdBindVertexBuffers")) return (PFN_vkVoidFunction)vkCmdBindVertexBuffers;
-    if (!strcmp(funcName, "vkCmdBindIndexBuffer")) return (PFN_vkVoidFunction)vkCmdBindIndexBuffer;
-    if (!strcmp(funcName, "vkCmdSetViewport")) return (PFN_vkVoidFunction)vkCmdSetViewport;
-    if (!strcmp(funcName, "vkCmdSetScissor")) return (PFN_vkVoidFunction)vkCmdSetScissor;
-    if (!strcmp(funcName, "vkCmdSetLineWidth")) return (PFN_vkVoidFunction)vkCmdSetLineWidth;
-    if (!strcmp(funcName, "vkCmdSetDepthBias")) return (PFN_vkVoidFunction)vkCmdSetDepthBias;
-    if (!strcmp(funcName, "vkCmdSetBlendConstants")) return (PFN_vkVoidFunction)vkCmdSetBlendConstants;
-    if (!strcmp(funcName, "vkCmdSetDepthBounds")) return (PFN_vkVoidFunction)vkCmdSetDepthBounds;
-    if (!strcmp(funcName, "vkCmdSetStencilCompareMask")) return (PFN_vkVoidFunction)vkCmdSetStencilCompareMask;
-    if (!strcmp(funcName, "vkCmdSetStencilWriteMask")) return (PFN_vkVoidFunction)vkCmdSetStencilWriteMask;
-    if (!strcmp(funcName, "vkCmdSetStencilReference")) return (PFN_vkVoidFunction)vkCmdSetStencilReference;
-    if (!strcmp(funcName, "vkCmdDraw")) return (PFN_vkVoidFunction)vkCmdDraw;
-    if (!strcmp(funcName, "vkCmdDrawIndexed")) return (PFN_vkVoidFunction)vkCmdDrawIndexed;
-    if (!strcmp(funcName, "vkCmdDrawIndirect")) return (PFN_vkVoidFunction)vkCmdDrawIndirect;
-    if (!strcmp(funcName, "vkCmdDrawIndexedIndirect")) return (PFN_vkVoidFunction)vkCmdDrawIndexedIndirect;
-    if (!strcmp(funcName, "vkCmdDispatch")) return (PFN_vkVoidFunction)vkCmdDispatch;
-    if (!strcmp(funcName, "vkCmdDispatchIndirect")) return (PFN_vkVoidFunction)vkCmdDispatchIndirect;
-    if (!strcmp(funcName, "vkCmdCopyBuffer")) return (PFN_vkVoidFunction)vkCmdCopyBuffer;
-    if (!strcmp(funcName, "vkCmdCopyImage")) return (PFN_vkVoidFunction)vkCmdCopyImage;
-    if (!strcmp(funcName, "vkCmdBlitImage")) return (PFN_vkVoidFunction)vkCmdBlitImage;
-    if (!strcmp(funcName, "vkCmdCopyBufferToImage")) return (PFN_vkVoidFunction)vkCmdCopyBufferToImage;
-    if (!strcmp(funcName, "vkCmdCopyImageToBuffer")) return (PFN_vkVoidFunction)vkCmdCopyImageToBuffer;
-    if (!strcmp(funcName, "vkCmdUpdateBuffer")) return (PFN_vkVoidFunction)vkCmdUpdateBuffer;
-    if (!strcmp(funcName, "vkCmdFillBuffer")) return (PFN_vkVoidFunction)vkCmdFillBuffer;
-    if (!strcmp(funcName, "vkCmdClearColorImage")) return (PFN_vkVoidFunction)vkCmdClearColorImage;
-    if (!strcmp(funcName, "vkCmdClearDepthStencilImage")) return (PFN_vkVoidFunction)vkCmdClearDepthStencilImage;
-    if (!strcmp(funcName, "vkCmdClearAttachments")) return (PFN_vkVoidFunction)vkCmdClearAttachments;
-    if (!strcmp(funcName, "vkCmdResolveImage")) return (PFN_vkVoidFunction)vkCmdResolveImage;
-    if (!strcmp(funcName, "vkCmdSetEvent")) return (PFN_vkVoidFunction)vkCmdSetEvent;
-    if (!strcmp(funcName, "vkCmdResetEvent")) return (PFN_vkVoidFunction)vkCmdResetEvent;
-    if (!strcmp(funcName, "vkCmdWaitEvents")) return (PFN_vkVoidFunction)vkCmdWaitEvents;
-    if (!strcmp(funcName, "vkCmdPipelineBarrier")) return (PFN_vkVoidFunction)vkCmdPipelineBarrier;
-    if (!strcmp(funcName, "vkCmdBeginQuery")) return (PFN_vkVoidFunction)vkCmdBeginQuery;
-    if (!strcmp(funcName, "vkCmdEndQuery")) return (PFN_vkVoidFunction)vkCmdEndQuery;
-    if (!strcmp(funcName, "vkCmdResetQueryPool")) return (PFN_vkVoidFunction)vkCmdResetQueryPool;
-    if (!strcmp(funcName, "vkCmdWriteTimestamp")) return (PFN_vkVoidFunction)vkCmdWriteTimestamp;
-    if (!strcmp(funcName, "vkCmdCopyQueryPoolResults")) return (PFN_vkVoidFunction)vkCmdCopyQueryPoolResults;
-    if (!strcmp(funcName, "vkCmdPushConstants")) return (PFN_vkVoidFunction)vkCmdPushConstants;
-    if (!strcmp(funcName, "vkCmdBeginRenderPass")) return (PFN_vkVoidFunction)vkCmdBeginRenderPass;
-    if (!strcmp(funcName, "vkCmdNextSubpass")) return (PFN_vkVoidFunction)vkCmdNextSubpass;
-    if (!strcmp(funcName, "vkCmdEndRenderPass")) return (PFN_vkVoidFunction)vkCmdEndRenderPass;
-    if (!strcmp(funcName, "vkCmdExecuteCommands")) return (PFN_vkVoidFunction)vkCmdExecuteCommands;
+    switch (command) {
+        case LOADER_COMMAND_vkGetInstanceProcAddr:
+            return (PFN_vkVoidFunction)vkGetInstanceProcAddr;
+        case LOADER_COMMAND_vkDestroyInstance:
+            return (PFN_vkVoidFunction)vkDestroyInstance;
+        case LOADER_COMMAND_vkEnumeratePhysicalDevices:
+            return (PFN_vkVoidFunction)vkEnumeratePhysicalDevices;
+        case LOADER_COMMAND_vkGetPhysicalDeviceFeatures:
+            return (PFN_vkVoidFunction)vkGetPhysicalDeviceFeatures;
+        case LOADER_COMMAND_vkGetPhysicalDeviceFormatProperties:
+            return (PFN_vkVoidFunction)vkGetPhysicalDeviceFormatProperties;
+        case LOADER_COMMAND_vkGetPhysicalDeviceImageFormatProperties:
+            return (PFN_vkVoidFunction)vkGetPhysicalDeviceImageFormatProperties;
+        case LOADER_COMMAND_vkGetPhysicalDeviceSparseImageFormatProperties:
+            return (PFN_vkVoidFunction)vkGetPhysicalDeviceSparseImageFormatProperties;
+        case LOADER_COMMAND_vkGetPhysicalDeviceProperties:
+            return (PFN_vkVoidFunction)vkGetPhysicalDeviceProperties;
+        case LOADER_COMMAND_vkGetPhysicalDeviceQueueFamilyProperties:
+            return (PFN_vkVoidFunction)vkGetPhysicalDeviceQueueFamilyProperties;
+        case LOADER_COMMAND_vkGetPhysicalDeviceMemoryProperties:
+            return (PFN_vkVoidFunction)vkGetPhysicalDeviceMemoryProperties;
+        case LOADER_COMMAND_vkEnumerateDeviceLayerProperties:
+            return (PFN_vkVoidFunction)vkEnumerateDeviceLayerProperties;
+        case LOADER_COMMAND_vkEnumerateDeviceExtensionProperties:
+            return (PFN_vkVoidFunction)vkEnumerateDeviceExtensionProperties;
+        case LOADER_COMMAND_vkCreateDevice:
+            return (PFN_vkVoidFunction)vkCreateDevice;
+        case LOADER_COMMAND_vkGetDeviceProcAddr:
+            return (PFN_vkVoidFunction)vkGetDeviceProcAddr;
+        case LOADER_COMMAND_vkDestroyDevice:
+            return (PFN_vkVoidFunction)vkDestroyDevice;
+        case LOADER_COMMAND_vkGetDeviceQueue:
+            return (PFN_vkVoidFunction)vkGetDeviceQueue;
+        case LOADER_COMMAND_vkQueueSubmit:
+            return (PFN_vkVoidFunction)vkQueueSubmit;
+        case LOADER_COMMAND_vkQueueWaitIdle:
+            return (PFN_vkVoidFunction)vkQueueWaitIdle;
+        case LOADER_COMMAND_vkDeviceWaitIdle:
+            return (PFN_vkVoidFunction)vkDeviceWaitIdle;
+        case LOADER_COMMAND_vkAllocateMemory:
+            return (PFN_vkVoidFunction)vkAllocateMemory;
+        case LOADER_COMMAND_vkFreeMemory:
+            return (PFN_vkVoidFunction)vkFreeMemory;
+        case LOADER_COMMAND_vkMapMemory:
+            return (PFN_vkVoidFunction)vkMapMemory;
+        case LOADER_COMMAND_vkUnmapMemory:
+            return (PFN_vkVoidFunction)vkUnmapMemory;
+        case LOADER_COMMAND_vkFlushMappedMemoryRanges:
+            return (PFN_vkVoidFunction)vkFlushMappedMemoryRanges;
+        case LOADER_COMMAND_vkInvalidateMappedMemoryRanges:
+            return (PFN_vkVoidFunction)vkInvalidateMappedMemoryRanges;
+        case LOADER_COMMAND_vkGetDeviceMemoryCommitment:
+            return (PFN_vkVoidFunction)vkGetDeviceMemoryCommitment;
+        case LOADER_COMMAND_vkGetImageSparseMemoryRequirements:
+            return (PFN_vkVoidFunction)vkGetImageSparseMemoryRequirements;
+        case LOADER_COMMAND_vkGetImageMemoryRequirements:
+            return (PFN_vkVoidFunction)vkGetImageMemoryRequirements;
+        case LOADER_COMMAND_vkGetBufferMemoryRequirements:
+            return (PFN_vkVoidFunction)vkGetBufferMemoryRequirements;
+        case LOADER_COMMAND_vkBindImageMemory:
+            return (PFN_vkVoidFunction)vkBindImageMemory;
+        case LOADER_COMMAND_vkBindBufferMemory:
+            return (PFN_vkVoidFunction)vkBindBufferMemory;
+        case LOADER_COMMAND_vkQueueBindSparse:
+            return (PFN_vkVoidFunction)vkQueueBindSparse;
+        case LOADER_COMMAND_vkCreateFence:
+            return (PFN_vkVoidFunction)vkCreateFence;
+        case LOADER_COMMAND_vkDestroyFence:
+            return (PFN_vkVoidFunction)vkDestroyFence;
+        case LOADER_COMMAND_vkGetFenceStatus:
+            return (PFN_vkVoidFunction)vkGetFenceStatus;
+        case LOADER_COMMAND_vkResetFences:
+            return (PFN_vkVoidFunction)vkResetFences;
+        case LOADER_COMMAND_vkWaitForFences:
+            return (PFN_vkVoidFunction)vkWaitForFences;
+        case LOADER_COMMAND_vkCreateSemaphore:
+            return (PFN_vkVoidFunction)vkCreateSemaphore;
+        case LOADER_COMMAND_vkDestroySemaphore:
+            return (PFN_vkVoidFunction)vkDestroySemaphore;
+        case LOADER_COMMAND_vkCreateEvent:
+            return (PFN_vkVoidFunction)vkCreateEvent;
+        case LOADER_COMMAND_vkDestroyEvent:
+            return (PFN_vkVoidFunction)vkDestroyEvent;
+        case LOADER_COMMAND_vkGetEventStatus:
+            return (PFN_vkVoidFunction)vkGetEventStatus;
+        case LOADER_COMMAND_vkSetEvent:
+            return (PFN_vkVoidFunction)vkSetEvent;
+        case LOADER_COMMAND_vkResetEvent:
+            return (PFN_vkVoidFunction)vkResetEvent;
+        case LOADER_COMMAND_vkCreateQueryPool:
+            return (PFN_vkVoidFunction)vkCreateQueryPool;
+        case LOADER_COMMAND_vkDestroyQueryPool:
+            return (PFN_vkVoidFunction)vkDestroyQueryPool;
+        case LOADER_COMMAND_vkGetQueryPoolResults:
+            return (PFN_vkVoidFunction)vkGetQueryPoolResults;
+        case LOADER_COMMAND_vkCreateBuffer:
+            return (PFN_vkVoidFunction)vkCreateBuffer;
+        case LOADER_COMMAND_vkDestroyBuffer:
+            return (PFN_vkVoidFunction)vkDestroyBuffer;
+        case LOADER_COMMAND_vkCreateBufferView:
+            return (PFN_vkVoidFunction)vkCreateBufferView;
+        case LOADER_COMMAND_vkDestroyBufferView:
+            return (PFN_vkVoidFunction)vkDestroyBufferView;
+        case LOADER_COMMAND_vkCreateImage:
+            return (PFN_vkVoidFunction)vkCreateImage;
+        case LOADER_COMMAND_vkDestroyImage:
+            return (PFN_vkVoidFunction)vkDestroyImage;
+        case LOADER_COMMAND_vkGetImageSubresourceLayout:
+            return (PFN_vkVoidFunction)vkGetImageSubresourceLayout;
+        case LOADER_COMMAND_vkCreateImageView:
+            return (PFN_vkVoidFunction)vkCreateImageView;
+        case LOADER_COMMAND_vkDestroyImageView:
+            return (PFN_vkVoidFunction)vkDestroyImageView;
+        case LOADER_COMMAND_vkCreateShaderModule:
+            return (PFN_vkVoidFunction)vkCreateShaderModule;
+        case LOADER_COMMAND_vkDestroyShaderModule:
+            return (PFN_vkVoidFunction)vkDestroyShaderModule;
+        case LOADER_COMMAND_vkCreatePipelineCache:
+            return (PFN_vkVoidFunction)vkCreatePipelineCache;
+        case LOADER_COMMAND_vkDestroyPipelineCache:
+            return (PFN_vkVoidFunction)vkDestroyPipelineCache;
+        case LOADER_COMMAND_vkGetPipelineCacheData:
+            return (PFN_vkVoidFunction)vkGetPipelineCacheData;
+        case LOADER_COMMAND_vkMergePipelineCaches:
+            return (PFN_vkVoidFunction)vkMergePipelineCaches;
+        case LOADER_COMMAND_vkCreateGraphicsPipelines:
+            return (PFN_vkVoidFunction)vkCreateGraphicsPipelines;
+        case LOADER_COMMAND_vkCreateComputePipelines:
+            return (PFN_vkVoidFunction)vkCreateComputePipelines;
+        case LOADER_COMMAND_vkDestroyPipeline:
+            return (PFN_vkVoidFunction)vkDestroyPipeline;
+        case LOADER_COMMAND_vkCreatePipelineLayout:
+            return (PFN_vkVoidFunction)vkCreatePipelineLayout;
+        case LOADER_COMMAND_vkDestroyPipelineLayout:
+            return (PFN_vkVoidFunction)vkDestroyPipelineLayout;
+        case LOADER_COMMAND_vkCreateSampler:
+            return (PFN_vkVoidFunction)vkCreateSampler;
+        case LOADER_COMMAND_vkDestroySampler:
+            return (PFN_vkVoidFunction)vkDestroySampler;
+        case LOADER_COMMAND_vkCreateDescriptorSetLayout:
+            return (PFN_vkVoidFunction)vkCreateDescriptorSetLayout;
+        case LOADER_COMMAND_vkDestroyDescriptorSetLayout:
+            return (PFN_vkVoidFunction)vkDestroyDescriptorSetLayout;
+        case LOADER_COMMAND_vkCreateDescriptorPool:
+            return (PFN_vkVoidFunction)vkCreateDescriptorPool;
+        case LOADER_COMMAND_vkDestroyDescriptorPool:
+            return (PFN_vkVoidFunction)vkDestroyDescriptorPool;
+        case LOADER_COMMAND_vkResetDescriptorPool:
+            return (PFN_vkVoidFunction)vkResetDescriptorPool;
+        case LOADER_COMMAND_vkAllocateDescriptorSets:
+            return (PFN_vkVoidFunction)vkAllocateDescriptorSets;
+        case LOADER_COMMAND_vkFreeDescriptorSets:
+            return (PFN_vkVoidFunction)vkFreeDescriptorSets;
+        case LOADER_COMMAND_vkUpdateDescriptorSets:
+            return (PFN_vkVoidFunction)vkUpdateDescriptorSets;
+        case LOADER_COMMAND_vkCreateFramebuffer:
+            return (PFN_vkVoidFunction)vkCreateFramebuffer;
+        case LOADER_COMMAND_vkDestroyFramebuffer:
+            return (PFN_vkVoidFunction)vkDestroyFramebuffer;
+        case LOADER_COMMAND_vkCreateRenderPass:
+            return (PFN_vkVoidFunction)vkCreateRenderPass;
+        case LOADER_COMMAND_vkDestroyRenderPass:
+            return (PFN_vkVoidFunction)vkDestroyRenderPass;
+        case LOADER_COMMAND_vkGetRenderAreaGranularity:
+            return (PFN_vkVoidFunction)vkGetRenderAreaGranularity;
+        case LOADER_COMMAND_vkCreateCommandPool:
+            return (PFN_vkVoidFunction)vkCreateCommandPool;
+        case LOADER_COMMAND_vkDestroyCommandPool:
+            return (PFN_vkVoidFunction)vkDestroyCommandPool;
+        case LOADER_COMMAND_vkResetCommandPool:
+            return (PFN_vkVoidFunction)vkResetCommandPool;
+        case LOADER_COMMAND_vkAllocateCommandBuffers:
+            return (PFN_vkVoidFunction)vkAllocateCommandBuffers;
+        case LOADER_COMMAND_vkFreeCommandBuffers:
+            return (PFN_vkVoidFunction)vkFreeCommandBuffers;
+        case LOADER_COMMAND_vkBeginCommandBuffer:
+            return (PFN_vkVoidFunction)vkBeginCommandBuffer;
+        case LOADER_COMMAND_vkEndCommandBuffer:
+            return (PFN_vkVoidFunction)vkEndCommandBuffer;
+        case LOADER_COMMAND_vkResetCommandBuffer:
+            return (PFN_vkVoidFunction)vkResetCommandBuffer;
+        case LOADER_COMMAND_vkCmdBindPipeline:
+            return (PFN_vkVoidFunction)vkCmdBindPipeline;
+        case LOADER_COMMAND_vkCmdBindDescriptorSets:
+            return (PFN_vkVoidFunction)vkCmdBindDescriptorSets;
+        case LOADER_COMMAND_vkCmdBindVertexBuffers:
+            return (PFN_vkVoidFunction)vkCmdBindVertexBuffers;
+        case LOADER_COMMAND_vkCmdBindIndexBuffer:
+            return (PFN_vkVoidFunction)vkCmdBindIndexBuffer;
+        case LOADER_COMMAND_vkCmdSetViewport:
+            return (PFN_vkVoidFunction)vkCmdSetViewport;
+        case LOADER_COMMAND_vkCmdSetScissor:
+            return (PFN_vkVoidFunction)vkCmdSetScissor;
+        case LOADER_COMMAND_vkCmdSetLineWidth:
+            return (PFN_vkVoidFunction)vkCmdSetLineWidth;
+        case LOADER_COMMAND_vkCmdSetDepthBias:
+            return (PFN_vkVoidFunction)vkCmdSetDepthBias;
+        case LOADER_COMMAND_vkCmdSetBlendConstants:
+            return (PFN_vkVoidFunction)vkCmdSetBlendConstants;
+        case LOADER_COMMAND_vkCmdSetDepthBounds:
+            return (PFN_vkVoidFunction)vkCmdSetDepthBounds;
+        case LOADER_COMMAND_vkCmdSetStencilCompareMask:
+            return (PFN_vkVoidFunction)vkCmdSetStencilCompareMask;
+        case LOADER_COMMAND_vkCmdSetStencilWriteMask:
+            return (PFN_vkVoidFunction)vkCmdSetStencilWriteMask;
+        case LOADER_COMMAND_vkCmdSetStencilReference:
+            return (PFN_vkVoidFunction)vkCmdSetStencilReference;
+        case LOADER_COMMAND_vkCmdDraw:
+            return (PFN_vkVoidFunction)vkCmdDraw;
+        case LOADER_COMMAND_vkCmdDrawIndexed:
+            return (PFN_vkVoidFunction)vkCmdDrawIndexed;
+        case LOADER_COMMAND_vkCmdDrawIndirect:
+            return (PFN_vkVoidFunction)vkCmdDrawIndirect;
+        case LOADER_COMMAND_vkCmdDrawIndexedIndirect:
+            return (PFN_vkVoidFunction)vkCmdDrawIndexedIndirect;
+        case LOADER_COMMAND_vkCmdDispatch:
+            return (PFN_vkVoidFunction)vkCmdDispatch;
+        case LOADER_COMMAND_vkCmdDispatchIndirect:
+            return (PFN_vkVoidFunction)vkCmdDispatchIndirect;
+        case LOADER_COMMAND_vkCmdCopyBuffer:
+            return (PFN_vkVoidFunction)vkCmdCopyBuffer;
+        case LOADER_COMMAND_vkCmdCopyImage:
+            return (PFN_vkVoidFunction)vkCmdCopyImage;
+        case LOADER_COMMAND_vkCmdBlitImage:
+            return (PFN_vkVoidFunction)vkCmdBlitImage;
+        case LOADER_COMMAND_vkCmdCopyBufferToImage:
+            return (PFN_vkVoidFunction)vkCmdCopyBufferToImage;
+        case LOADER_COMMAND_vkCmdCopyImageToBuffer:
+            return (PFN_vkVoidFunction)vkCmdCopyImageToBuffer;
+        case LOADER_COMMAND_vkCmdUpdateBuffer:
+            return (PFN_vkVoidFunction)vkCmdUpdateBuffer;
+        case LOADER_COMMAND_vkCmdFillBuffer:
+            return (PFN_vkVoidFunction)vkCmdFillBuffer;
+        case LOADER_COMMAND_vkCmdClearColorImage:
+            return (PFN_vkVoidFunction)vkCmdClearColorImage;
+        case LOADER_COMMAND_vkCmdClearDepthStencilImage:
+            return (PFN_vkVoidFunction)vkCmdClearDepthStencilImage;
+        case LOADER_COMMAND_vkCmdClearAttachments:
+            return (PFN_vkVoidFunction)vkCmdClearAttachments;
+        case LOADER_COMMAND_vkCmdResolveImage:
+            return (PFN_vkVoidFunction)vkCmdResolveImage;
+        case LOADER_COMMAND_vkCmdSetEvent:
+            return (PFN_vkVoidFunction)vkCmdSetEvent;
+        case LOADER_COMMAND_vkCmdResetEvent:
+            return (PFN_vkVoidFunction)vkCmdResetEvent;
+        case LOADER_COMMAND_vkCmdWaitEvents:
+            return (PFN_vkVoidFunction)vkCmdWaitEvents;
+        case LOADER_COMMAND_vkCmdPipelineBarrier:
+            return (PFN_vkVoidFunction)vkCmdPipelineBarrier;
+        case LOADER_COMMAND_vkCmdBeginQuery:
+            return (PFN_vkVoidFunction)vkCmdBeginQuery;
+        case LOADER_COMMAND_vkCmdEndQuery:
+            return (PFN_vkVoidFunction)vkCmdEndQuery;
+        case LOADER_COMMAND_vkCmdResetQueryPool:
+            return (PFN_vkVoidFunction)vkCmdResetQueryPool;
+        case LOADER_COMMAND_vkCmdWriteTimestamp:
+            return (PFN_vkVoidFunction)vkCmdWriteTimestamp;
+        case LOADER_COMMAND_vkCmdCopyQueryPoolResults:
+            return (PFN_vkVoidFunction)vkCmdCopyQueryPoolResults;
+        case LOADER_COMMAND_vkCmdPushConstants:
+            return (PFN_vkVoidFunction)vkCmdPushConstants;
+        case LOADER_COMMAND_vkCmdBeginRenderPass:
+            return (PFN_vkVoidFunction)vkCmdBeginRenderPass;
+        case LOADER_COMMAND_vkCmdNextSubpass:
+            return (PFN_vkVoidFunction)vkCmdNextSubpass;
+        case LOADER_COMMAND_vkCmdEndRenderPass:
+            return (PFN_vkVoidFunction)vkCmdEndRenderPass;
+        case LOADER_COMMAND_vkCmdExecuteCommands:
+            return (PFN_vkVoidFunction)vkCmdExecuteCommands;
+        default:
+            break;
+    }
 
     // Instance extensions
     void *addr;
-    if (debug_report_instance_gpa(inst, funcName, &addr)) return addr;
+    if (debug_report_instance_gpa(inst, command, &addr)) return addr;
 
-    if (wsi_swapchain_instance_gpa(inst, funcName, &addr)) return addr;
+    if (wsi_swapchain_instance_gpa(inst, command, &addr)) return addr;
 
-    if (extension_instance_gpa(inst, funcName, &addr)) return addr;
+    if (extension_instance_gpa(inst, command, &addr)) return addr;
 
     // Unknown physical device extensions
     if (loader_phys_dev_ext_gpa(inst, funcName, true, &addr, NULL)) return addr;
@@ -179,26 +314,30 @@ static inline void *trampolineGetProcAddr(struct loader_instance *inst, const ch
     return addr;
 }
 
-static inline void *globalGetProcAddr(const char *name) {
-    if (!name || name[0] != 'v' || name[1] != 'k') return NULL;
-
-    name += 2;
-    if (!strcmp(name, "CreateInstance")) return (void *)vkCreateInstance;
-    if (!strcmp(name, "EnumerateInstanceExtensionProperties")) return (void *)vkEnumerateInstanceExtensionProperties;
-    if (!strcmp(name, "EnumerateInstanceLayerProperties")) return (void *)vkEnumerateInstanceLayerProperties;
-
-    return NULL;
+static inline void *globalGetProcAddr(enum loader_command_id command) {
+    switch (command) {
+        case LOADER_COMMAND_vkCreateInstance:
+            return (void *)vkCreateInstance;
+        case LOADER_COMMAND_vkEnumerateInstanceExtensionProperties:
+            return (void *)vkEnumerateInstanceExtensionProperties;
+        case LOADER_COMMAND_vkEnumerateInstanceLayerProperties:
+            return (void *)vkEnumerateInstanceLayerProperties;
+        default:
+            return NULL;
+    }
 }
 
-static inline void *loader_non_passthrough_gdpa(const char *name) {
-    if (!name || name[0] != 'v' || name[1] != 'k') return NULL;
-
-    name += 2;
-
-    if (!strcmp(name, "GetDeviceProcAddr")) return (void *)vkGetDeviceProcAddr;
-    if (!strcmp(name, "DestroyDevice")) return (void *)vkDestroyDevice;
-    if (!strcmp(name, "GetDeviceQueue")) return (void *)vkGetDeviceQueue;
-    if (!strcmp(name, "AllocateCommandBuffers")) return (void *)vkAllocateCommandBuffers;
-
-    return NULL;
+static inline void *loader_non_passthrough_gdpa(enum loader_command_id command) {
+    switch (command) {
+        case LOADER_COMMAND_vkGetDeviceProcAddr:
+            return (void *)vkGetDeviceProcAddr;
+        case LOADER_COMMAND_vkDestroyDevice:
+            return (void *)vkDestroyDevice;
+        case LOADER_COMMAND_vkGetDeviceQueue:
+            return (void *)vkGetDeviceQueue;
+        case LOADER_COMMAND_vkAllocateCommandBuffers:
+            return (void *)vkAllocateCommandBuffers;
+        default:
+            return NULL;
+    }
 }
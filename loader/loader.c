@@ -33,6 +33,7 @@
 #include <stddef.h>
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #if defined(_WIN32)
 #include "dirent_on_windows.h"
 #else  // _WIN32
@@ -88,8 +89,76 @@ loader_platform_thread_mutex loader_json_lock;
 
 LOADER_PLATFORM_THREAD_ONCE_DECLARATION(once_init);
 
+// vkCreateInstance makes many small instance scope allocations for the layer, extension and ICD lists,
+// most of which live until vkDestroyInstance while the rest are replaced as the lists grow. Unless the
+// app gave allocation callbacks, the ones up to LOADER_ARENA_MAX_ALLOCATION_SIZE are carved out of one
+// contiguous arena that is freed when the instance is destroyed, and freeing one of them does nothing.
+// The arena is a single range so that telling its allocations apart on free is one compare. It takes
+// about 7 KB with 4 ICDs and 41 layers; once it is full, allocations fall back to the heap. Larger lists
+// still use the heap, which can reuse their memory across instances. Allocations made after
+// vkCreateInstance returns use the heap too, so an instance that lives long doesn't keep growing its arena.
+#define LOADER_ARENA_SIZE (16 * 1024)
+#define LOADER_ARENA_MAX_ALLOCATION_SIZE 1024
+#define LOADER_ARENA_ALIGNMENT sizeof(uint64_t)
+
+struct loader_instance_arena {
+    uint8_t *data;  // LOADER_ARENA_SIZE bytes, allocated with the arena
+    size_t used;
+    bool open;
+};
+
+void loader_instance_arena_begin(struct loader_instance *instance) {
+    instance->arena = NULL;
+    if (NULL == instance->alloc_callbacks.pfnAllocation) {
+        size_t header_size =
+            (sizeof(struct loader_instance_arena) + LOADER_ARENA_ALIGNMENT - 1) & ~(LOADER_ARENA_ALIGNMENT - 1);
+        instance->arena = malloc(header_size + LOADER_ARENA_SIZE);
+        if (NULL != instance->arena) {
+            instance->arena->data = (uint8_t *)instance->arena + header_size;
+            instance->arena->used = 0;
+            instance->arena->open = true;
+        }
+    }
+}
+
+void loader_instance_arena_end(struct loader_instance *instance) {
+    if (NULL != instance->arena) {
+        instance->arena->open = false;
+    }
+}
+
+void loader_instance_arena_destroy(struct loader_instance *instance) {
+    if (NULL != instance->arena) {
+        free(instance->arena);
+        instance->arena = NULL;
+    }
+}
+
+static void *loader_instance_arena_alloc(struct loader_instance_arena *arena, size_t size) {
+    size = (size + LOADER_ARENA_ALIGNMENT - 1) & ~(LOADER_ARENA_ALIGNMENT - 1);
+    if (LOADER_ARENA_SIZE - arena->used < size) {
+        return NULL;
+    }
+
+    void *pMemory = arena->data + arena->used;
+    arena->used += size;
+    return pMemory;
+}
+
+static bool loader_instance_arena_owns(const struct loader_instance *instance, const void *pMemory) {
+    return NULL != instance && NULL != instance->arena && (const uint8_t *)pMemory >= instance->arena->data &&
+           (const uint8_t *)pMemory < instance->arena->data + LOADER_ARENA_SIZE;
+}
+
 void *loader_instance_heap_alloc(const struct loader_instance *instance, size_t size, VkSystemAllocationScope alloc_scope) {
     void *pMemory = NULL;
+    if (instance && instance->arena && instance->arena->open && alloc_scope == VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE &&
+        size <= LOADER_ARENA_MAX_ALLOCATION_SIZE) {
+        pMemory = loader_instance_arena_alloc(instance->arena, size);
+        if (NULL != pMemory) {
+            return pMemory;
+        }
+    }
 #if (DEBUG_DISABLE_APP_ALLOCATORS == 1)
     {
 #else
@@ -106,7 +175,7 @@ void *loader_instance_heap_alloc(const struct loader_instance *instance, size_t
 }
 
 void loader_instance_heap_free(const struct loader_instance *instance, void *pMemory) {
-    if (pMemory != NULL) {
+    if (pMemory != NULL && !loader_instance_arena_owns(instance, pMemory)) {
 #if (DEBUG_DISABLE_APP_ALLOCATORS == 1)
         {
 #else
@@ -126,6 +195,12 @@ void *loader_instance_heap_realloc(const struct loader_instance *instance, void
         pNewMem = loader_instance_heap_alloc(instance, size, alloc_scope);
     } else if (size == 0) {
         loader_instance_heap_free(instance, pMemory);
+    } else if (loader_instance_arena_owns(instance, pMemory)) {
+        // Arena allocations can't grow in place, so move them
+        pNewMem = loader_instance_heap_alloc(instance, size, alloc_scope);
+        if (NULL != pNewMem) {
+            memcpy(pNewMem, pMemory, orig_size < size ? orig_size : size);
+        }
 #if (DEBUG_DISABLE_APP_ALLOCATORS == 1)
 #else
     } else if (instance && instance->alloc_callbacks.pfnReallocation) {
@@ -1474,100 +1549,232 @@ static VkResult loader_scanned_icd_init(const struct loader_instance *inst, stru
     return err;
 }
 
-static VkResult loader_scanned_icd_add(const struct loader_instance *inst, struct loader_icd_tramp_list *icd_tramp_list,
-                                       const char *filename, uint32_t api_version) {
+// ICD libraries are probed on at most this many threads by loader_icd_scan
+#define LOADER_MAX_ICD_PROBE_THREADS 4
+
+enum loader_icd_probe_status {
+    LOADER_ICD_PROBE_SUCCESS,
+    LOADER_ICD_PROBE_OPEN_FAILED,
+    LOADER_ICD_PROBE_INCOMPATIBLE_INTERFACE,
+    LOADER_ICD_PROBE_NO_GET_INSTANCE_PROC_ADDR,
+    LOADER_ICD_PROBE_NO_CREATE_INSTANCE,
+    LOADER_ICD_PROBE_NO_ENUMERATE_INSTANCE_EXTENSION_PROPERTIES,
+};
+
+// An ICD library listed by a manifest file, and what opening it found
+struct loader_icd_probe {
+    char filename[MAX_STRING_SIZE];
+    uint32_t api_version;
+    enum loader_icd_probe_status status;
+    char open_error[MAX_STRING_SIZE];
+    bool deprecated_interface;
+    loader_platform_dl_handle handle;
+    uint32_t interface_version;
+    PFN_vkGetInstanceProcAddr GetInstanceProcAddr;
+    PFN_GetPhysicalDeviceProcAddr GetPhysicalDeviceProcAddr;
+    PFN_vkEnumerateInstanceExtensionProperties EnumerateInstanceExtensionProperties;
+    PFN_vkCreateInstance CreateInstance;
+    bool added;  // handed to loader_scanned_icd_add, which keeps the library open
+};
+
+// Open an ICD library found by loader_icd_scan and query the entry points the loader needs from it.
+// Several libraries are probed at once, so nothing is logged here; loader_scanned_icd_add logs what
+// the probe found when loader_icd_scan reaches its manifest file, in manifest order.
+static void loader_probe_scanned_icd(struct loader_icd_probe *probe) {
     loader_platform_dl_handle handle;
-    PFN_vkCreateInstance fp_create_inst;
-    PFN_vkEnumerateInstanceExtensionProperties fp_get_inst_ext_props;
-    PFN_vkGetInstanceProcAddr fp_get_proc_addr;
-    PFN_GetPhysicalDeviceProcAddr fp_get_phys_dev_proc_addr = NULL;
     PFN_vkNegotiateLoaderICDInterfaceVersion fp_negotiate_icd_version;
-    struct loader_scanned_icd *new_scanned_icd;
-    uint32_t interface_vers;
-    VkResult res = VK_SUCCESS;
+    PFN_vkGetInstanceProcAddr fp_get_proc_addr;
 
     // TODO implement smarter opening/closing of libraries. For now this
     // function leaves libraries open and the scanned_icd_clear closes them
-    handle = loader_platform_open_library(filename);
+    handle = loader_platform_open_library(probe->filename);
     if (NULL == handle) {
-        loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, loader_platform_open_library_error(filename));
-        goto out;
+        const char *error = loader_platform_open_library_error(probe->filename);
+        (void)snprintf(probe->open_error, sizeof(probe->open_error), "%s", error ? error : "");
+        probe->status = LOADER_ICD_PROBE_OPEN_FAILED;
+        return;
     }
+    probe->handle = handle;
 
     // Get and settle on an ICD interface version
     fp_negotiate_icd_version = loader_platform_get_proc_address(handle, "vk_icdNegotiateLoaderICDInterfaceVersion");
 
-    if (!loader_get_icd_interface_version(fp_negotiate_icd_version, &interface_vers)) {
-        loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-                   "loader_scanned_icd_add: ICD %s doesn't support interface"
-                   " version compatible with loader, skip this ICD.",
-                   filename);
-        goto out;
+    if (!loader_get_icd_interface_version(fp_negotiate_icd_version, &probe->interface_version)) {
+        probe->status = LOADER_ICD_PROBE_INCOMPATIBLE_INTERFACE;
+        return;
     }
 
     fp_get_proc_addr = loader_platform_get_proc_address(handle, "vk_icdGetInstanceProcAddr");
     if (NULL == fp_get_proc_addr) {
-        assert(interface_vers == 0);
+        assert(probe->interface_version == 0);
         // Use deprecated interface from version 0
         fp_get_proc_addr = loader_platform_get_proc_address(handle, "vkGetInstanceProcAddr");
         if (NULL == fp_get_proc_addr) {
-            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-                       "loader_scanned_icd_add: Attempt to retrieve either "
-                       "\'vkGetInstanceProcAddr\' or "
-                       "\'vk_icdGetInstanceProcAddr\' from ICD %s failed.",
-                       filename);
-            goto out;
-        } else {
-            loader_log(inst, VK_DEBUG_REPORT_WARNING_BIT_EXT, 0,
-                       "loader_scanned_icd_add: Using deprecated ICD "
-                       "interface of \'vkGetInstanceProcAddr\' instead of "
-                       "\'vk_icdGetInstanceProcAddr\' for ICD %s",
-                       filename);
-        }
-        fp_create_inst = loader_platform_get_proc_address(handle, "vkCreateInstance");
-        if (NULL == fp_create_inst) {
-            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-                       "loader_scanned_icd_add:  Failed querying "
-                       "\'vkCreateInstance\' via dlsym/loadlibrary for "
-                       "ICD %s",
-                       filename);
-            goto out;
-        }
-        fp_get_inst_ext_props = loader_platform_get_proc_address(handle, "vkEnumerateInstanceExtensionProperties");
-        if (NULL == fp_get_inst_ext_props) {
-            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-                       "loader_scanned_icd_add: Could not get \'vkEnumerate"
-                       "InstanceExtensionProperties\' via dlsym/loadlibrary "
-                       "for ICD %s",
-                       filename);
-            goto out;
+            probe->status = LOADER_ICD_PROBE_NO_GET_INSTANCE_PROC_ADDR;
+            return;
+        }
+        probe->deprecated_interface = true;
+        probe->GetInstanceProcAddr = fp_get_proc_addr;
+        probe->CreateInstance = loader_platform_get_proc_address(handle, "vkCreateInstance");
+        if (NULL == probe->CreateInstance) {
+            probe->status = LOADER_ICD_PROBE_NO_CREATE_INSTANCE;
+            return;
+        }
+        probe->EnumerateInstanceExtensionProperties =
+            loader_platform_get_proc_address(handle, "vkEnumerateInstanceExtensionProperties");
+        if (NULL == probe->EnumerateInstanceExtensionProperties) {
+            probe->status = LOADER_ICD_PROBE_NO_ENUMERATE_INSTANCE_EXTENSION_PROPERTIES;
+            return;
         }
     } else {
         // Use newer interface version 1 or later
-        if (interface_vers == 0) {
-            interface_vers = 1;
+        if (probe->interface_version == 0) {
+            probe->interface_version = 1;
+        }
+
+        probe->GetInstanceProcAddr = fp_get_proc_addr;
+        probe->CreateInstance = (PFN_vkCreateInstance)fp_get_proc_addr(NULL, "vkCreateInstance");
+        if (NULL == probe->CreateInstance) {
+            probe->status = LOADER_ICD_PROBE_NO_CREATE_INSTANCE;
+            return;
+        }
+        probe->EnumerateInstanceExtensionProperties =
+            (PFN_vkEnumerateInstanceExtensionProperties)fp_get_proc_addr(NULL, "vkEnumerateInstanceExtensionProperties");
+        if (NULL == probe->EnumerateInstanceExtensionProperties) {
+            probe->status = LOADER_ICD_PROBE_NO_ENUMERATE_INSTANCE_EXTENSION_PROPERTIES;
+            return;
+        }
+        probe->GetPhysicalDeviceProcAddr = loader_platform_get_proc_address(handle, "vk_icdGetPhysicalDeviceProcAddr");
+    }
+
+    probe->status = LOADER_ICD_PROBE_SUCCESS;
+}
+
+struct loader_icd_probe_queue {
+    loader_platform_thread_mutex lock;
+    struct loader_icd_probe *probes;
+    uint32_t count;
+    uint32_t next;
+};
+
+static LOADER_PLATFORM_THREAD_PROC(loader_icd_probe_worker, param) {
+    struct loader_icd_probe_queue *queue = (struct loader_icd_probe_queue *)param;
+
+    for (;;) {
+        loader_platform_thread_lock_mutex(&queue->lock);
+        uint32_t index = queue->next;
+        if (index < queue->count) {
+            queue->next++;
         }
+        loader_platform_thread_unlock_mutex(&queue->lock);
 
-        fp_create_inst = (PFN_vkCreateInstance)fp_get_proc_addr(NULL, "vkCreateInstance");
-        if (NULL == fp_create_inst) {
+        if (index >= queue->count) {
+            break;
+        }
+        if (queue->probes[index].filename[0] != '\0') {
+            loader_probe_scanned_icd(&queue->probes[index]);
+        }
+    }
+    return LOADER_PLATFORM_THREAD_PROC_RETURN;
+}
+
+// Probe the ICD libraries on up to LOADER_MAX_ICD_PROBE_THREADS threads, the calling thread being
+// one of them. Drivers often do much of their setup when negotiating the interface version or
+// answering the first vk_icdGetInstanceProcAddr queries, which overlaps across drivers this way.
+// Library constructors don't overlap, as the dynamic linker runs them under its own lock.
+// Probes without a filename are skipped, library_count is the number of the others.
+static void loader_probe_scanned_icds(struct loader_icd_probe *probes, uint32_t count, uint32_t library_count) {
+    loader_platform_thread threads[LOADER_MAX_ICD_PROBE_THREADS - 1];
+    uint32_t thread_count = 0;
+    struct loader_icd_probe_queue queue;
+
+    if (library_count == 0) {
+        return;
+    }
+
+    queue.probes = probes;
+    queue.count = count;
+    queue.next = 0;
+    loader_platform_thread_create_mutex(&queue.lock);
+
+    while (thread_count < library_count - 1 && thread_count < LOADER_MAX_ICD_PROBE_THREADS - 1) {
+        // If a thread can't be started, the ones that did (or this one) probe its share
+        if (!loader_platform_thread_create(&threads[thread_count], loader_icd_probe_worker, &queue)) {
+            break;
+        }
+        thread_count++;
+    }
+    loader_icd_probe_worker(&queue);
+    for (uint32_t i = 0; i < thread_count; i++) {
+        loader_platform_thread_join(threads[i]);
+    }
+
+    loader_platform_thread_delete_mutex(&queue.lock);
+}
+
+static VkResult loader_scanned_icd_add(const struct loader_instance *inst, struct loader_icd_tramp_list *icd_tramp_list,
+                                       const struct loader_icd_probe *probe) {
+    const char *filename = probe->filename;
+    struct loader_scanned_icd *new_scanned_icd;
+    VkResult res = VK_SUCCESS;
+
+    if (probe->deprecated_interface) {
+        loader_log(inst, VK_DEBUG_REPORT_WARNING_BIT_EXT, 0,
+                   "loader_scanned_icd_add: Using deprecated ICD "
+                   "interface of \'vkGetInstanceProcAddr\' instead of "
+                   "\'vk_icdGetInstanceProcAddr\' for ICD %s",
+                   filename);
+    }
+
+    switch (probe->status) {
+        case LOADER_ICD_PROBE_SUCCESS:
+            break;
+        case LOADER_ICD_PROBE_OPEN_FAILED:
+            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, "%s", probe->open_error);
+            goto out;
+        case LOADER_ICD_PROBE_INCOMPATIBLE_INTERFACE:
             loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-                       "loader_scanned_icd_add: Could not get "
-                       "\'vkCreateInstance\' via \'vk_icdGetInstanceProcAddr\'"
-                       " for ICD %s",
+                       "loader_scanned_icd_add: ICD %s doesn't support interface"
+                       " version compatible with loader, skip this ICD.",
                        filename);
             goto out;
-        }
-        fp_get_inst_ext_props =
-            (PFN_vkEnumerateInstanceExtensionProperties)fp_get_proc_addr(NULL, "vkEnumerateInstanceExtensionProperties");
-        if (NULL == fp_get_inst_ext_props) {
+        case LOADER_ICD_PROBE_NO_GET_INSTANCE_PROC_ADDR:
             loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-                       "loader_scanned_icd_add: Could not get \'vkEnumerate"
-                       "InstanceExtensionProperties\' via "
-                       "\'vk_icdGetInstanceProcAddr\' for ICD %s",
+                       "loader_scanned_icd_add: Attempt to retrieve either "
+                       "\'vkGetInstanceProcAddr\' or "
+                       "\'vk_icdGetInstanceProcAddr\' from ICD %s failed.",
                        filename);
             goto out;
-        }
-        fp_get_phys_dev_proc_addr = loader_platform_get_proc_address(handle, "vk_icdGetPhysicalDeviceProcAddr");
+        case LOADER_ICD_PROBE_NO_CREATE_INSTANCE:
+            if (probe->deprecated_interface) {
+                loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
+                           "loader_scanned_icd_add:  Failed querying "
+                           "\'vkCreateInstance\' via dlsym/loadlibrary for "
+                           "ICD %s",
+                           filename);
+            } else {
+                loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
+                           "loader_scanned_icd_add: Could not get "
+                           "\'vkCreateInstance\' via \'vk_icdGetInstanceProcAddr\'"
+                           " for ICD %s",
+                           filename);
+            }
+            goto out;
+        case LOADER_ICD_PROBE_NO_ENUMERATE_INSTANCE_EXTENSION_PROPERTIES:
+            if (probe->deprecated_interface) {
+                loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
+                           "loader_scanned_icd_add: Could not get \'vkEnumerate"
+                           "InstanceExtensionProperties\' via dlsym/loadlibrary "
+                           "for ICD %s",
+                           filename);
+            } else {
+                loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
+                           "loader_scanned_icd_add: Could not get \'vkEnumerate"
+                           "InstanceExtensionProperties\' via "
+                           "\'vk_icdGetInstanceProcAddr\' for ICD %s",
+                           filename);
+            }
+            goto out;
     }
 
     // check for enough capacity
@@ -1587,13 +1794,13 @@ static VkResult loader_scanned_icd_add(const struct loader_instance *inst, struc
     }
 
     new_scanned_icd = &(icd_tramp_list->scanned_list[icd_tramp_list->count]);
-    new_scanned_icd->handle = handle;
-    new_scanned_icd->api_version = api_version;
-    new_scanned_icd->GetInstanceProcAddr = fp_get_proc_addr;
-    new_scanned_icd->GetPhysicalDeviceProcAddr = fp_get_phys_dev_proc_addr;
-    new_scanned_icd->EnumerateInstanceExtensionProperties = fp_get_inst_ext_props;
-    new_scanned_icd->CreateInstance = fp_create_inst;
-    new_scanned_icd->interface_version = interface_vers;
+    new_scanned_icd->handle = probe->handle;
+    new_scanned_icd->api_version = probe->api_version;
+    new_scanned_icd->GetInstanceProcAddr = probe->GetInstanceProcAddr;
+    new_scanned_icd->GetPhysicalDeviceProcAddr = probe->GetPhysicalDeviceProcAddr;
+    new_scanned_icd->EnumerateInstanceExtensionProperties = probe->EnumerateInstanceExtensionProperties;
+    new_scanned_icd->CreateInstance = probe->CreateInstance;
+    new_scanned_icd->interface_version = probe->interface_version;
 
     new_scanned_icd->lib_name = (char *)loader_instance_heap_alloc(inst, strlen(filename) + 1, VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
     if (NULL == new_scanned_icd->lib_name) {
@@ -1737,27 +1944,100 @@ static void loader_get_fullpath(const char *file, const char *dirs, size_t out_s
     (void)snprintf(out_fullpath, out_size, "%s", file);
 }
 
+// Parsed manifest files are kept for the life of the process, so creating instances and enumerating layers and
+// extensions again doesn't read and parse every manifest again.  An entry is reused while the file's modification
+// time and size are unchanged.  Which files are read still depends on the directory listings and environment
+// variables at the time of each scan, those are not cached.  Protected by loader_json_lock.
+struct loader_file_stamp {
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    int64_t size;
+};
+
+struct loader_json_cache_entry {
+    struct loader_json_cache_entry *next;
+    char *filename;
+    struct loader_file_stamp stamp;
+    cJSON *json;
+};
+
+static struct loader_json_cache_entry *loader_json_cache = NULL;
+
+static bool loader_get_file_stamp(const char *filename, struct loader_file_stamp *stamp) {
+#if defined(_WIN32)
+    struct _stat64 file_stat;
+    if (_stat64(filename, &file_stat) != 0) {
+        return false;
+    }
+    stamp->mtime_sec = (int64_t)file_stat.st_mtime;
+    stamp->mtime_nsec = 0;
+#else
+    struct stat file_stat;
+    if (stat(filename, &file_stat) != 0) {
+        return false;
+    }
+    stamp->mtime_sec = (int64_t)file_stat.st_mtim.tv_sec;
+    stamp->mtime_nsec = (int64_t)file_stat.st_mtim.tv_nsec;
+#endif
+    stamp->size = (int64_t)file_stat.st_size;
+    return true;
+}
+
+// Cached trees outlive the instance that read them, so they must not come from its allocation callbacks.
+static void loader_json_cache_delete_tree(cJSON *json) {
+    struct loader_instance *saved_tls_instance = tls_instance;
+    tls_instance = NULL;
+    cJSON_Delete(json);
+    tls_instance = saved_tls_instance;
+}
+
+static struct loader_json_cache_entry *loader_json_cache_find(const char *filename) {
+    for (struct loader_json_cache_entry *entry = loader_json_cache; entry != NULL; entry = entry->next) {
+        if (!strcmp(entry->filename, filename)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
 // Read a JSON file into a buffer.
 //
 // @return -  A pointer to a cJSON object representing the JSON parse tree.
-//            This returned buffer should be freed by caller.
-static VkResult loader_get_json(const struct loader_instance *inst, const char *filename, cJSON **json) {
+//            The tree belongs to the manifest cache, the caller must not modify or
+//            free it and must hold loader_json_lock while using it.
+//            Errors are only logged if log_errors is set.
+static VkResult loader_parse_json_file(const struct loader_instance *inst, const char *filename, cJSON **json, bool log_errors) {
     FILE *file = NULL;
     char *json_buf;
     size_t len;
     VkResult res = VK_SUCCESS;
+    struct loader_file_stamp stamp;
+    struct loader_json_cache_entry *entry = NULL;
+    struct loader_instance *saved_tls_instance = tls_instance;
 
     if (NULL == json) {
-        loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, "loader_get_json: Received invalid JSON file");
+        if (log_errors) {
+            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, "loader_get_json: Received invalid JSON file");
+        }
         res = VK_ERROR_INITIALIZATION_FAILED;
         goto out;
     }
 
     *json = NULL;
 
+    entry = loader_json_cache_find(filename);
+    if (!loader_get_file_stamp(filename, &stamp)) {
+        memset(&stamp, 0, sizeof(stamp));
+    } else if (NULL != entry && !memcmp(&entry->stamp, &stamp, sizeof(stamp))) {
+        *json = entry->json;
+        goto out;
+    }
+
     file = fopen(filename, "rb");
     if (!file) {
-        loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, "loader_get_json: Failed to open JSON file %s", filename);
+        if (log_errors) {
+            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, "loader_get_json: Failed to open JSON file %s", filename);
+        }
         res = VK_ERROR_INITIALIZATION_FAILED;
         goto out;
     }
@@ -1766,32 +2046,72 @@ static VkResult loader_get_json(const struct loader_instance *inst, const char *
     fseek(file, 0, SEEK_SET);
     json_buf = (char *)loader_stack_alloc(len + 1);
     if (json_buf == NULL) {
-        loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-                   "loader_get_json: Failed to allocate space for "
-                   "JSON file %s buffer of length %d",
-                   filename, len);
+        if (log_errors) {
+            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
+                       "loader_get_json: Failed to allocate space for "
+                       "JSON file %s buffer of length %d",
+                       filename, len);
+        }
         res = VK_ERROR_OUT_OF_HOST_MEMORY;
         goto out;
     }
     if (fread(json_buf, sizeof(char), len, file) != len) {
-        loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, "loader_get_json: Failed to read JSON file %s.", filename);
+        if (log_errors) {
+            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, "loader_get_json: Failed to read JSON file %s.", filename);
+        }
         res = VK_ERROR_INITIALIZATION_FAILED;
         goto out;
     }
     json_buf[len] = '\0';
 
     // Parse text from file
+    tls_instance = NULL;
     *json = cJSON_Parse(json_buf);
+    tls_instance = saved_tls_instance;
     if (*json == NULL) {
-        loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-                   "loader_get_json: Failed to parse JSON file %s, "
-                   "this is usually because something ran out of "
-                   "memory.",
-                   filename);
+        if (log_errors) {
+            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
+                       "loader_get_json: Failed to parse JSON file %s, "
+                       "this is usually because something ran out of "
+                       "memory.",
+                       filename);
+        }
         res = VK_ERROR_OUT_OF_HOST_MEMORY;
         goto out;
     }
 
+    // Replace the stale tree, or remember the new one
+    if (NULL == entry) {
+        entry = malloc(sizeof(struct loader_json_cache_entry));
+        if (NULL != entry) {
+            entry->filename = malloc(strlen(filename) + 1);
+            if (NULL == entry->filename) {
+                free(entry);
+                entry = NULL;
+            } else {
+                strcpy(entry->filename, filename);
+                entry->json = NULL;
+                entry->next = loader_json_cache;
+                loader_json_cache = entry;
+            }
+        }
+        if (NULL == entry) {
+            loader_json_cache_delete_tree(*json);
+            *json = NULL;
+            if (log_errors) {
+                loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, "loader_get_json: Failed to allocate space for JSON file %s",
+                           filename);
+            }
+            res = VK_ERROR_OUT_OF_HOST_MEMORY;
+            goto out;
+        }
+    }
+    if (NULL != entry->json) {
+        loader_json_cache_delete_tree(entry->json);
+    }
+    entry->json = *json;
+    entry->stamp = stamp;
+
 out:
     if (NULL != file) {
         fclose(file);
@@ -1800,6 +2120,11 @@ out:
     return res;
 }
 
+// Read a JSON file and log any error doing so, see loader_parse_json_file
+static VkResult loader_get_json(const struct loader_instance *inst, const char *filename, cJSON **json) {
+    return loader_parse_json_file(inst, filename, json, true);
+}
+
 // Do a deep copy of the loader_layer_properties structure.
 VkResult loader_copy_layer_properties(const struct loader_instance *inst, struct loader_layer_properties *dst,
                                       struct loader_layer_properties *src) {
@@ -3007,6 +3332,57 @@ void loader_init_icd_lib_list() {}
 
 void loader_destroy_icd_lib_list() {}
 
+// Get the full path of the library an ICD manifest file names, library_path being the unquoted
+// \'library_path\' value
+static void loader_icd_library_fullpath(const char *manifest_file, const char *library_path, size_t out_size, char *out_fullpath) {
+    if (loader_platform_is_path(library_path)) {
+        // a relative or absolute path
+        char *name_copy = loader_stack_alloc(strlen(manifest_file) + 1);
+        char *rel_base;
+        strcpy(name_copy, manifest_file);
+        rel_base = loader_platform_dirname(name_copy);
+        loader_expand_path(library_path, rel_base, out_size, out_fullpath);
+    } else {
+        // a filename which is assumed in a system directory
+        loader_get_fullpath(library_path, DEFAULT_VK_DRIVERS_PATH, out_size, out_fullpath);
+    }
+}
+
+// Find the library each ICD manifest file names, so loader_icd_scan can open them all at once before it
+// reads the manifest files again in order. Nothing is logged here, loader_icd_scan reports what is wrong
+// with a manifest file when it gets to it. probes has an entry per manifest file, those without a library
+// have an empty filename. Returns the number of libraries found.
+static uint32_t loader_find_icd_libraries(const struct loader_instance *inst, const struct loader_manifest_files *manifest_files,
+                                          struct loader_icd_probe *probes) {
+    uint32_t library_count = 0;
+
+    for (uint32_t i = 0; i < manifest_files->count; i++) {
+        const char *file_str = manifest_files->filename_list[i];
+        cJSON *json = NULL;
+        cJSON *item;
+
+        memset(&probes[i], 0, sizeof(struct loader_icd_probe));
+        if (NULL == file_str || VK_SUCCESS != loader_parse_json_file(inst, file_str, &json, false) || NULL == json) {
+            continue;
+        }
+        item = cJSON_GetObjectItem(json, "ICD");
+        item = (NULL != item) ? cJSON_GetObjectItem(item, "library_path") : NULL;
+        if (NULL == item) {
+            continue;
+        }
+
+        // The same unquoted value loader_icd_scan gets
+        char *temp = cJSON_Print(item);
+        if (NULL != temp && strlen(temp) > 2) {
+            temp[strlen(temp) - 1] = '\0';
+            loader_icd_library_fullpath(file_str, &temp[1], sizeof(probes[i].filename), probes[i].filename);
+            library_count++;
+        }
+        cJSON_Free(temp);
+    }
+    return library_count;
+}
+
 // Try to find the Vulkan ICD driver(s).
 //
 // This function scans the default system loader path(s) or path
@@ -3028,6 +3404,8 @@ VkResult loader_icd_scan(const struct loader_instance *inst, struct loader_icd_t
     bool lockedMutex = false;
     cJSON *json = NULL;
     uint32_t num_good_icds = 0;
+    struct loader_icd_probe *probes = NULL;
+    struct loader_icd_probe local_probe;
 
     memset(&manifest_files, 0, sizeof(struct loader_manifest_files));
 
@@ -3045,6 +3423,17 @@ VkResult loader_icd_scan(const struct loader_instance *inst, struct loader_icd_t
 
     loader_platform_thread_lock_mutex(&loader_json_lock);
     lockedMutex = true;
+
+    // Open all the libraries first, see loader_probe_scanned_icds. The manifest files are then read
+    // again in order, and each library is added and what opening it found is logged when its manifest
+    // file is reached, so the ICD list and the messages are the same as if they were opened one by one.
+    // Without the memory for that, each library is opened when its manifest file is reached.
+    probes = loader_instance_heap_alloc(inst, manifest_files.count * sizeof(struct loader_icd_probe),
+                                        VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+    if (NULL != probes) {
+        loader_probe_scanned_icds(probes, manifest_files.count, loader_find_icd_libraries(inst, &manifest_files, probes));
+    }
+
     for (uint32_t i = 0; i < manifest_files.count; i++) {
         file_str = manifest_files.filename_list[i];
         if (file_str == NULL) {
@@ -3053,10 +3442,7 @@ VkResult loader_icd_scan(const struct loader_instance *inst, struct loader_icd_t
 
         VkResult temp_res = loader_get_json(inst, file_str, &json);
         if (NULL == json || temp_res != VK_SUCCESS) {
-            if (NULL != json) {
-                cJSON_Delete(json);
-                json = NULL;
-            }
+            json = NULL;
             // If we haven't already found an ICD, copy this result to
             // the returned result.
             if (num_good_icds == 0) {
@@ -3080,7 +3466,6 @@ VkResult loader_icd_scan(const struct loader_instance *inst, struct loader_icd_t
                        "loader_icd_scan: ICD JSON %s does not have a"
                        " \'file_format_version\' field. Skipping ICD JSON.",
                        file_str);
-            cJSON_Delete(json);
             json = NULL;
             continue;
         }
@@ -3095,7 +3480,6 @@ VkResult loader_icd_scan(const struct loader_instance *inst, struct loader_icd_t
                        "loader_icd_scan: Failed retrieving ICD JSON %s"
                        " \'file_format_version\' field.  Skipping ICD JSON",
                        file_str);
-            cJSON_Delete(json);
             json = NULL;
             continue;
         }
@@ -3136,7 +3520,6 @@ VkResult loader_icd_scan(const struct loader_instance *inst, struct loader_icd_t
                                " \'library_path\' field.  Skipping ICD JSON.",
                                file_str);
                     cJSON_Free(temp);
-                    cJSON_Delete(json);
                     json = NULL;
                     continue;
                 }
@@ -3151,7 +3534,6 @@ VkResult loader_icd_scan(const struct loader_instance *inst, struct loader_icd_t
                                file_str);
                     res = VK_ERROR_OUT_OF_HOST_MEMORY;
                     cJSON_Free(temp);
-                    cJSON_Delete(json);
                     json = NULL;
                     goto out;
                 }
@@ -3162,7 +3544,6 @@ VkResult loader_icd_scan(const struct loader_instance *inst, struct loader_icd_t
                                "loader_icd_scan: ICD JSON %s \'library_path\'"
                                " field is empty.  Skipping ICD JSON.",
                                file_str);
-                    cJSON_Delete(json);
                     json = NULL;
                     continue;
                 }
@@ -3170,17 +3551,7 @@ VkResult loader_icd_scan(const struct loader_instance *inst, struct loader_icd_t
                 // Print out the paths being searched if debugging is enabled
                 loader_log(inst, VK_DEBUG_REPORT_DEBUG_BIT_EXT, 0, "Searching for ICD drivers named %s, using default dir %s",
                            library_path, DEFAULT_VK_DRIVERS_PATH);
-                if (loader_platform_is_path(library_path)) {
-                    // a relative or absolute path
-                    char *name_copy = loader_stack_alloc(strlen(file_str) + 1);
-                    char *rel_base;
-                    strcpy(name_copy, file_str);
-                    rel_base = loader_platform_dirname(name_copy);
-                    loader_expand_path(library_path, rel_base, sizeof(fullpath), fullpath);
-                } else {
-                    // a filename which is assumed in a system directory
-                    loader_get_fullpath(library_path, DEFAULT_VK_DRIVERS_PATH, sizeof(fullpath), fullpath);
-                }
+                loader_icd_library_fullpath(file_str, library_path, sizeof(fullpath), fullpath);
 
                 uint32_t vers = 0;
                 item = cJSON_GetObjectItem(itemICD, "api_version");
@@ -3199,7 +3570,6 @@ VkResult loader_icd_scan(const struct loader_instance *inst, struct loader_icd_t
                         }
 
                         cJSON_Free(temp);
-                        cJSON_Delete(json);
                         json = NULL;
                         continue;
                     }
@@ -3212,13 +3582,24 @@ VkResult loader_icd_scan(const struct loader_instance *inst, struct loader_icd_t
                                file_str);
                 }
 
-                res = loader_scanned_icd_add(inst, icd_tramp_list, fullpath, vers);
+                struct loader_icd_probe *probe = (NULL != probes) ? &probes[i] : &local_probe;
+                if (NULL == probes || strcmp(probe->filename, fullpath)) {
+                    // Not opened yet, or the manifest file changed since
+                    if (NULL != probes && NULL != probe->handle) {
+                        loader_platform_close_library(probe->handle);
+                    }
+                    memset(probe, 0, sizeof(struct loader_icd_probe));
+                    strcpy(probe->filename, fullpath);
+                    loader_probe_scanned_icd(probe);
+                }
+                probe->api_version = vers;
+                probe->added = true;
+                res = loader_scanned_icd_add(inst, icd_tramp_list, probe);
                 if (VK_SUCCESS != res) {
                     loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
                                "loader_icd_scan: Failed to add ICD JSON %s. "
                                " Skipping ICD JSON.",
                                fullpath);
-                    cJSON_Delete(json);
                     json = NULL;
                     continue;
                 }
@@ -3236,16 +3617,20 @@ VkResult loader_icd_scan(const struct loader_instance *inst, struct loader_icd_t
                        file_str);
         }
 
-        cJSON_Delete(json);
         json = NULL;
     }
 
 out:
 
-    if (NULL != json) {
-        cJSON_Delete(json);
+    if (NULL != probes) {
+        // Libraries whose manifest file turned out to be unusable, or that weren't reached
+        for (uint32_t i = 0; i < manifest_files.count; i++) {
+            if (!probes[i].added && NULL != probes[i].handle) {
+                loader_platform_close_library(probes[i].handle);
+            }
+        }
+        loader_instance_heap_free(inst, probes);
     }
-
     if (NULL != manifest_files.filename_list) {
         for (uint32_t i = 0; i < manifest_files.count; i++) {
             if (NULL != manifest_files.filename_list[i]) {
@@ -3308,7 +3693,6 @@ void loader_layer_scan(const struct loader_instance *inst, struct loader_layer_l
             }
 
             VkResult local_res = loader_add_layer_properties(inst, instance_layers, json, (implicit == 1), file_str);
-            cJSON_Delete(json);
 
             if (VK_SUCCESS != local_res) {
                 goto out;
@@ -3390,7 +3774,6 @@ void loader_implicit_layer_scan(const struct loader_instance *inst, struct loade
         res = loader_add_layer_properties(inst, instance_layers, json, true, file_str);
 
         loader_instance_heap_free(inst, file_str);
-        cJSON_Delete(json);
 
         if (VK_ERROR_OUT_OF_HOST_MEMORY == res) {
             break;
@@ -3411,7 +3794,7 @@ static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL loader_gpdpa_instance_internal(V
     if (disp_table == NULL) return NULL;
 
     bool found_name;
-    addr = loader_lookup_instance_dispatch_table(disp_table, pName, &found_name);
+    addr = loader_lookup_instance_dispatch_table(disp_table, loader_get_command_id(pName), &found_name);
     if (found_name) {
         return addr;
     }
@@ -3434,7 +3817,7 @@ static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL loader_gpdpa_instance_terminator
     if (disp_table == NULL) return NULL;
 
     bool found_name;
-    addr = loader_lookup_instance_dispatch_table(disp_table, pName, &found_name);
+    addr = loader_lookup_instance_dispatch_table(disp_table, loader_get_command_id(pName), &found_name);
     if (found_name) {
         return addr;
     }
@@ -3474,7 +3857,7 @@ static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL loader_gpa_instance_internal(VkI
     if (disp_table == NULL) return NULL;
 
     bool found_name;
-    addr = loader_lookup_instance_dispatch_table(disp_table, pName, &found_name);
+    addr = loader_lookup_instance_dispatch_table(disp_table, loader_get_command_id(pName), &found_name);
     if (found_name) {
         return addr;
     }
@@ -3540,9 +3923,8 @@ static void loader_init_dispatch_dev_ext_entry(struct loader_instance *inst, str
 // Find all dev extension in the hash table  and initialize the dispatch table
 // for dev  for each of those extension entrypoints found in hash table.
 void loader_init_dispatch_dev_ext(struct loader_instance *inst, struct loader_device *dev) {
-    for (uint32_t i = 0; i < MAX_NUM_UNKNOWN_EXTS; i++) {
-        if (inst->dev_ext_disp_hash[i].func_name != NULL)
-            loader_init_dispatch_dev_ext_entry(inst, dev, i, inst->dev_ext_disp_hash[i].func_name);
+    for (uint32_t i = 0; i < inst->dev_ext_table.count; i++) {
+        loader_init_dispatch_dev_ext_entry(inst, dev, i, inst->dev_ext_table.func_names[i]);
     }
 }
 
@@ -3578,101 +3960,76 @@ static bool loader_check_layer_list_for_dev_ext_address(const struct loader_laye
     return false;
 }
 
-static void loader_free_dev_ext_table(struct loader_instance *inst) {
-    for (uint32_t i = 0; i < MAX_NUM_UNKNOWN_EXTS; i++) {
-        loader_instance_heap_free(inst, inst->dev_ext_disp_hash[i].func_name);
-        loader_instance_heap_free(inst, inst->dev_ext_disp_hash[i].list.index);
+// Find funcName in an unknown extension table, hash is the murmurhash of funcName.
+static bool loader_find_unknown_ext(const struct loader_unknown_ext_table *table, const char *funcName, uint32_t hash,
+                                    uint32_t *ptr_idx) {
+    if (table->slot_count == 0) return false;
+
+    for (uint32_t slot = hash & (table->slot_count - 1);; slot = (slot + 1) & (table->slot_count - 1)) {
+        uint32_t entry = table->slots[slot];
+        if (entry == 0) return false;
+        if (table->func_name_hashes[entry - 1] == hash && !strcmp(table->func_names[entry - 1], funcName)) {
+            *ptr_idx = entry - 1;
+            return true;
+        }
     }
-    memset(inst->dev_ext_disp_hash, 0, sizeof(inst->dev_ext_disp_hash));
 }
 
-static bool loader_add_dev_ext_table(struct loader_instance *inst, uint32_t *ptr_idx, const char *funcName) {
-    uint32_t i;
-    uint32_t idx = *ptr_idx;
-    struct loader_dispatch_hash_list *list = &inst->dev_ext_disp_hash[idx].list;
-
-    if (!inst->dev_ext_disp_hash[idx].func_name) {
-        // no entry here at this idx, so use it
-        assert(list->capacity == 0);
-        inst->dev_ext_disp_hash[idx].func_name =
-            (char *)loader_instance_heap_alloc(inst, strlen(funcName) + 1, VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
-        if (inst->dev_ext_disp_hash[idx].func_name == NULL) {
-            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-                       "loader_add_dev_ext_table: Failed to allocate memory "
-                       "for func_name %s",
-                       funcName);
-            return false;
-        }
-        strncpy(inst->dev_ext_disp_hash[idx].func_name, funcName, strlen(funcName) + 1);
-        return true;
+static void loader_insert_unknown_ext_slot(struct loader_unknown_ext_table *table, uint32_t idx) {
+    uint32_t slot = table->func_name_hashes[idx] & (table->slot_count - 1);
+    while (table->slots[slot] != 0) slot = (slot + 1) & (table->slot_count - 1);
+    table->slots[slot] = idx + 1;
+}
+
+// Give funcName the next free index of an unknown extension table.  The slots are rebuilt at
+// twice the size before they get more than half full, so finding a name stays about one probe
+// however many names are added.  The indices themselves never move.
+static bool loader_add_unknown_ext(struct loader_instance *inst, struct loader_unknown_ext_table *table, const char *funcName,
+                                   uint32_t hash, uint32_t *ptr_idx) {
+    if (table->count == MAX_NUM_UNKNOWN_EXTS) {
+        loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
+                   "loader_add_unknown_ext: All %d unknown extension entry points are in use, can't add %s", MAX_NUM_UNKNOWN_EXTS,
+                   funcName);
+        return false;
     }
 
-    // check for enough capacity
-    if (list->capacity == 0) {
-        list->index = loader_instance_heap_alloc(inst, 8 * sizeof(*(list->index)), VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
-        if (list->index == NULL) {
-            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, "loader_add_dev_ext_table: Failed to allocate memory for list index",
-                       funcName);
+    if ((table->count + 1) * 2 > table->slot_count) {
+        uint32_t slot_count = table->slot_count == 0 ? 16 : table->slot_count * 2;
+        uint32_t *slots =
+            (uint32_t *)loader_instance_heap_alloc(inst, slot_count * sizeof(uint32_t), VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
+        if (slots == NULL) {
+            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, "loader_add_unknown_ext: Failed to allocate memory for hash table");
             return false;
         }
-        list->capacity = 8 * sizeof(*(list->index));
-    } else if (list->capacity < (list->count + 1) * sizeof(*(list->index))) {
-        void *new_ptr = loader_instance_heap_realloc(inst, list->index, list->capacity, list->capacity * 2,
-                                                     VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
-        if (NULL == new_ptr) {
-            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-                       "loader_add_dev_ext_table: Failed to reallocate memory for list index", funcName);
-            return false;
-        }
-        list->index = new_ptr;
-        list->capacity *= 2;
+        memset(slots, 0, slot_count * sizeof(uint32_t));
+        loader_instance_heap_free(inst, table->slots);
+        table->slots = slots;
+        table->slot_count = slot_count;
+        for (uint32_t i = 0; i < table->count; i++) loader_insert_unknown_ext_slot(table, i);
     }
 
-    // find an unused index in the hash table and use it
-    i = (idx + 1) % MAX_NUM_UNKNOWN_EXTS;
-    do {
-        if (!inst->dev_ext_disp_hash[i].func_name) {
-            assert(inst->dev_ext_disp_hash[i].list.capacity == 0);
-            inst->dev_ext_disp_hash[i].func_name =
-                (char *)loader_instance_heap_alloc(inst, strlen(funcName) + 1, VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
-            if (inst->dev_ext_disp_hash[i].func_name == NULL) {
-                loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-                           "loader_add_dev_ext_table: Failed to allocate memory "
-                           "for func_name %s",
-                           funcName);
-                return false;
-            }
-            strncpy(inst->dev_ext_disp_hash[i].func_name, funcName, strlen(funcName) + 1);
-            list->index[list->count] = i;
-            list->count++;
-            *ptr_idx = i;
-            return true;
-        }
-        i = (i + 1) % MAX_NUM_UNKNOWN_EXTS;
-    } while (i != idx);
-
-    loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-               "loader_add_dev_ext_table:  Could not insert into hash table; is "
-               "it full?");
+    size_t name_size = strlen(funcName) + 1;
+    char *func_name = (char *)loader_instance_heap_alloc(inst, name_size, VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
+    if (func_name == NULL) {
+        loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, "loader_add_unknown_ext: Failed to allocate memory for func_name %s",
+                   funcName);
+        return false;
+    }
+    memcpy(func_name, funcName, name_size);
 
-    return false;
+    *ptr_idx = table->count++;
+    table->func_names[*ptr_idx] = func_name;
+    table->func_name_hashes[*ptr_idx] = hash;
+    loader_insert_unknown_ext_slot(table, *ptr_idx);
+    return true;
 }
 
-static bool loader_name_in_dev_ext_table(struct loader_instance *inst, uint32_t *idx, const char *funcName) {
-    uint32_t alt_idx;
-    if (inst->dev_ext_disp_hash[*idx].func_name && !strcmp(inst->dev_ext_disp_hash[*idx].func_name, funcName)) return true;
-
-    // funcName wasn't at the primary spot in the hash table
-    // search the list of secondary locations (shallow search, not deep search)
-    for (uint32_t i = 0; i < inst->dev_ext_disp_hash[*idx].list.count; i++) {
-        alt_idx = inst->dev_ext_disp_hash[*idx].list.index[i];
-        if (!strcmp(inst->dev_ext_disp_hash[*idx].func_name, funcName)) {
-            *idx = alt_idx;
-            return true;
-        }
+static void loader_free_unknown_ext_table(struct loader_instance *inst, struct loader_unknown_ext_table *table) {
+    for (uint32_t i = 0; i < table->count; i++) {
+        loader_instance_heap_free(inst, table->func_names[i]);
     }
-
-    return false;
+    loader_instance_heap_free(inst, table->slots);
+    memset(table, 0, sizeof(*table));
 }
 
 // This function returns generic trampoline code address for unknown entry
@@ -3689,15 +4046,14 @@ static bool loader_name_in_dev_ext_table(struct loader_instance *inst, uint32_t
 // has not been seen yet. Next check if a layer or ICD supports it.  If so then
 // a
 // new entry in the hash table is initialized and that trampoline address for
-// the new entry is returned. Null is returned if the hash table is full or
+// the new entry is returned. Null is returned if all trampolines are in use or
 // if no discovered layer or ICD returns a non-NULL GetProcAddr for it.
 void *loader_dev_ext_gpa(struct loader_instance *inst, const char *funcName) {
     uint32_t idx;
     uint32_t seed = 0;
+    uint32_t hash = murmurhash(funcName, strlen(funcName), seed);
 
-    idx = murmurhash(funcName, strlen(funcName), seed) % MAX_NUM_UNKNOWN_EXTS;
-
-    if (loader_name_in_dev_ext_table(inst, &idx, funcName))
+    if (loader_find_unknown_ext(&inst->dev_ext_table, funcName, hash, &idx))
         // found funcName already in hash
         return loader_get_dev_ext_trampoline(idx);
 
@@ -3708,7 +4064,7 @@ void *loader_dev_ext_gpa(struct loader_instance *inst, const char *funcName) {
         return NULL;
     }
 
-    if (loader_add_dev_ext_table(inst, &idx, funcName)) {
+    if (loader_add_unknown_ext(inst, &inst->dev_ext_table, funcName, hash, &idx)) {
         // successfully added new table entry
         // init any dev dispatch table entries as needed
         loader_init_dispatch_dev_ext_entry(inst, NULL, idx, funcName);
@@ -3749,99 +4105,6 @@ static bool loader_check_layer_list_for_phys_dev_ext_address(struct loader_insta
     return false;
 }
 
-static void loader_free_phys_dev_ext_table(struct loader_instance *inst) {
-    for (uint32_t i = 0; i < MAX_NUM_UNKNOWN_EXTS; i++) {
-        loader_instance_heap_free(inst, inst->phys_dev_ext_disp_hash[i].func_name);
-        loader_instance_heap_free(inst, inst->phys_dev_ext_disp_hash[i].list.index);
-    }
-    memset(inst->phys_dev_ext_disp_hash, 0, sizeof(inst->phys_dev_ext_disp_hash));
-}
-
-static bool loader_add_phys_dev_ext_table(struct loader_instance *inst, uint32_t *ptr_idx, const char *funcName) {
-    uint32_t i;
-    uint32_t idx = *ptr_idx;
-    struct loader_dispatch_hash_list *list = &inst->phys_dev_ext_disp_hash[idx].list;
-
-    if (!inst->phys_dev_ext_disp_hash[idx].func_name) {
-        // no entry here at this idx, so use it
-        assert(list->capacity == 0);
-        inst->phys_dev_ext_disp_hash[idx].func_name =
-            (char *)loader_instance_heap_alloc(inst, strlen(funcName) + 1, VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
-        if (inst->phys_dev_ext_disp_hash[idx].func_name == NULL) {
-            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-                       "loader_add_phys_dev_ext_table() can't allocate memory for "
-                       "func_name");
-            return false;
-        }
-        strncpy(inst->phys_dev_ext_disp_hash[idx].func_name, funcName, strlen(funcName) + 1);
-        return true;
-    }
-
-    // check for enough capacity
-    if (list->capacity == 0) {
-        list->index = loader_instance_heap_alloc(inst, 8 * sizeof(*(list->index)), VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
-        if (list->index == NULL) {
-            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, "loader_add_phys_dev_ext_table() can't allocate list memory");
-            return false;
-        }
-        list->capacity = 8 * sizeof(*(list->index));
-    } else if (list->capacity < (list->count + 1) * sizeof(*(list->index))) {
-        void *new_ptr = loader_instance_heap_realloc(inst, list->index, list->capacity, list->capacity * 2,
-                                                     VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
-        if (NULL == new_ptr) {
-            loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, "loader_add_phys_dev_ext_table() can't reallocate list memory");
-            return false;
-        }
-        list->index = new_ptr;
-        list->capacity *= 2;
-    }
-
-    // find an unused index in the hash table and use it
-    i = (idx + 1) % MAX_NUM_UNKNOWN_EXTS;
-    do {
-        if (!inst->phys_dev_ext_disp_hash[i].func_name) {
-            assert(inst->phys_dev_ext_disp_hash[i].list.capacity == 0);
-            inst->phys_dev_ext_disp_hash[i].func_name =
-                (char *)loader_instance_heap_alloc(inst, strlen(funcName) + 1, VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
-            if (inst->phys_dev_ext_disp_hash[i].func_name == NULL) {
-                loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-                           "loader_add_dev_ext_table() can't reallocate "
-                           "func_name memory");
-                return false;
-            }
-            strncpy(inst->phys_dev_ext_disp_hash[i].func_name, funcName, strlen(funcName) + 1);
-            list->index[list->count] = i;
-            list->count++;
-            *ptr_idx = i;
-            return true;
-        }
-        i = (i + 1) % MAX_NUM_UNKNOWN_EXTS;
-    } while (i != idx);
-
-    loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
-               "loader_add_phys_dev_ext_table() couldn't insert into hash table; is "
-               "it full?");
-    return false;
-}
-
-static bool loader_name_in_phys_dev_ext_table(struct loader_instance *inst, uint32_t *idx, const char *funcName) {
-    uint32_t alt_idx;
-    if (inst->phys_dev_ext_disp_hash[*idx].func_name && !strcmp(inst->phys_dev_ext_disp_hash[*idx].func_name, funcName))
-        return true;
-
-    // funcName wasn't at the primary spot in the hash table
-    // search the list of secondary locations (shallow search, not deep search)
-    for (uint32_t i = 0; i < inst->phys_dev_ext_disp_hash[*idx].list.count; i++) {
-        alt_idx = inst->phys_dev_ext_disp_hash[*idx].list.index[i];
-        if (!strcmp(inst->phys_dev_ext_disp_hash[*idx].func_name, funcName)) {
-            *idx = alt_idx;
-            return true;
-        }
-    }
-
-    return false;
-}
-
 // This function returns a generic trampoline and/or terminator function
 // address for any unknown physical device extension commands.  A hash
 // table is used to keep a list of unknown entry points and their
@@ -3856,7 +4119,7 @@ static bool loader_name_in_phys_dev_ext_table(struct loader_instance *inst, uint
 // check if a layer or and ICD supports it.  If so then a new entry in
 // the hash table is initialized and the trampoline and/or terminator
 // addresses are returned.
-// Null is returned if the hash table is full or if no discovered layer or
+// Null is returned if all trampolines are in use or if no discovered layer or
 // ICD returns a non-NULL GetProcAddr for it.
 bool loader_phys_dev_ext_gpa(struct loader_instance *inst, const char *funcName, bool perform_checking, void **tramp_addr,
                              void **term_addr) {
@@ -3884,15 +4147,14 @@ bool loader_phys_dev_ext_gpa(struct loader_instance *inst, const char *funcName,
         }
     }
 
-    idx = murmurhash(funcName, strlen(funcName), seed) % MAX_NUM_UNKNOWN_EXTS;
-    if (perform_checking && !loader_name_in_phys_dev_ext_table(inst, &idx, funcName)) {
+    uint32_t hash = murmurhash(funcName, strlen(funcName), seed);
+    if (!loader_find_unknown_ext(&inst->phys_dev_ext_table, funcName, hash, &idx)) {
         uint32_t i;
-        bool added = false;
 
         // Only need to add first one to get index in Instance.  Others will use
-        // the same index.
-        if (!added && loader_add_phys_dev_ext_table(inst, &idx, funcName)) {
-            added = true;
+        // the same index.  Without checking there is no entry to return yet.
+        if (!perform_checking || !loader_add_unknown_ext(inst, &inst->phys_dev_ext_table, funcName, hash, &idx)) {
+            goto out;
         }
 
         // Setup the ICD function pointers
@@ -3958,19 +4220,68 @@ struct loader_instance *loader_get_instance(const VkInstance instance) {
     return ptr_instance;
 }
 
+// Find a layer library that was already loaded, and add it to the loaded libraries otherwise.
+// Callers hold loader_lock.
 static loader_platform_dl_handle loader_open_layer_lib(const struct loader_instance *inst, const char *chain_type,
                                                        struct loader_layer_properties *prop) {
+    struct loader_layer_library *library = NULL;
+
+    for (uint32_t i = 0; i < loader.layer_library_count; i++) {
+        if (!strcmp(loader.layer_libraries[i].lib_name, prop->lib_name)) {
+            library = &loader.layer_libraries[i];
+            break;
+        }
+    }
+    if (NULL != library) {
+        library->ref_count++;
+        prop->lib_handle = library->handle;
+        loader_log(inst, VK_DEBUG_REPORT_DEBUG_BIT_EXT, 0, "Using loaded layer library %s", prop->lib_name);
+        return prop->lib_handle;
+    }
+
     if ((prop->lib_handle = loader_platform_open_library(prop->lib_name)) == NULL) {
         loader_log(inst, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0, loader_platform_open_library_error(prop->lib_name));
-    } else {
-        loader_log(inst, VK_DEBUG_REPORT_DEBUG_BIT_EXT, 0, "Loading layer library %s", prop->lib_name);
+        return NULL;
     }
+    loader_log(inst, VK_DEBUG_REPORT_DEBUG_BIT_EXT, 0, "Loading layer library %s", prop->lib_name);
+
+    // The libraries belong to the process rather than to an instance, so they don't use its
+    // allocator. If there is no memory to keep track of one, it is closed with the chain using it.
+    if (loader.layer_library_count == loader.layer_library_capacity) {
+        uint32_t capacity = loader.layer_library_capacity ? loader.layer_library_capacity * 2 : 8;
+        void *new_ptr = realloc(loader.layer_libraries, capacity * sizeof(struct loader_layer_library));
+        if (NULL == new_ptr) {
+            return prop->lib_handle;
+        }
+        loader.layer_libraries = new_ptr;
+        loader.layer_library_capacity = capacity;
+    }
+    library = &loader.layer_libraries[loader.layer_library_count];
+    library->lib_name = malloc(strlen(prop->lib_name) + 1);
+    if (NULL == library->lib_name) {
+        return prop->lib_handle;
+    }
+    strcpy(library->lib_name, prop->lib_name);
+    library->handle = prop->lib_handle;
+    library->ref_count = 1;
+    loader.layer_library_count++;
 
     return prop->lib_handle;
 }
 
+// Callers hold loader_lock.
 static void loader_close_layer_lib(const struct loader_instance *inst, struct loader_layer_properties *prop) {
     if (prop->lib_handle) {
+        for (uint32_t i = 0; i < loader.layer_library_count; i++) {
+            struct loader_layer_library *library = &loader.layer_libraries[i];
+            if (library->handle == prop->lib_handle && library->ref_count > 0) {
+                // The library stays loaded for the next chain that includes it
+                library->ref_count--;
+                prop->lib_handle = NULL;
+                return;
+            }
+        }
+
         loader_platform_close_library(prop->lib_handle);
         loader_log(inst, VK_DEBUG_REPORT_DEBUG_BIT_EXT, 0, "Unloading layer library %s", prop->lib_name);
         prop->lib_handle = NULL;
@@ -4794,8 +5105,8 @@ VKAPI_ATTR void VKAPI_CALL terminator_DestroyInstance(VkInstance instance, const
         }
         loader_instance_heap_free(ptr_instance, ptr_instance->phys_dev_groups_term);
     }
-    loader_free_dev_ext_table(ptr_instance);
-    loader_free_phys_dev_ext_table(ptr_instance);
+    loader_free_unknown_ext_table(ptr_instance, &ptr_instance->dev_ext_table);
+    loader_free_unknown_ext_table(ptr_instance, &ptr_instance->phys_dev_ext_table);
 }
 
 VKAPI_ATTR VkResult VKAPI_CALL terminator_CreateDevice(VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo *pCreateInfo,
@@ -5284,11 +5595,14 @@ VKAPI_ATTR VkResult VKAPI_CALL terminator_EnumeratePhysicalDevices(VkInstance in
     struct loader_instance *inst = (struct loader_instance *)instance;
     VkResult res = VK_SUCCESS;
 
-    // Always call the setup loader terminator physical devices because they may
-    // have changed at any point.
-    res = setupLoaderTermPhysDevs(inst);
-    if (VK_SUCCESS != res) {
-        goto out;
+    // Only query the ICDs the first time, or again when the application asked
+    // for the physical devices to be refreshed.
+    if (NULL == inst->phys_devs_term || inst->refresh_phys_devs_term) {
+        res = setupLoaderTermPhysDevs(inst);
+        if (VK_SUCCESS != res) {
+            goto out;
+        }
+        inst->refresh_phys_devs_term = false;
     }
 
     uint32_t copy_count = inst->total_gpu_count;
@@ -148,19 +148,17 @@ struct loader_layer_list {
     struct loader_layer_properties *list;
 };
 
-struct loader_dispatch_hash_list {
-    size_t capacity;
+// Unknown extension commands of an instance.  Each command name is given the next free
+// index, which is also its entry in loader_dev_ext_dispatch_table.dev_ext (or the phys_dev_ext
+// tables) and its function in dev_ext_trampoline.c (or phys_dev_ext.c), so an index never
+// changes once given out.  Names are found through an open addressing table of indices, which
+// grows so it is never more than half full.
+struct loader_unknown_ext_table {
     uint32_t count;
-    uint32_t *index;  // index into the dev_ext dispatch table
-};
-
-// loader_dispatch_hash_entry and loader_dev_ext_dispatch_table.dev_ext have
-// one to one correspondence; one loader_dispatch_hash_entry for one dev_ext
-// dispatch entry.
-// Also have a one to one correspondence with functions in dev_ext_trampoline.c
-struct loader_dispatch_hash_entry {
-    char *func_name;
-    struct loader_dispatch_hash_list list;  // to handle hashing collisions
+    char *func_names[MAX_NUM_UNKNOWN_EXTS];
+    uint32_t func_name_hashes[MAX_NUM_UNKNOWN_EXTS];
+    uint32_t slot_count;  // power of two
+    uint32_t *slots;      // index + 1 of the name hashed to each slot, 0 if the slot is empty
 };
 
 typedef void(VKAPI_PTR *PFN_vkDevExt)(VkDevice device);
@@ -229,7 +227,10 @@ struct loader_instance {
 
     // We need to manually track physical devices over time.  If the user
     // re-queries the information, we don't want to delete old data or
-    // create new data unless necessary.
+    // create new data unless necessary.  Once enumerated, the physical
+    // devices are only queried again when the application asks for a
+    // refresh, which sets refresh_phys_devs_term for the terminator.
+    bool refresh_phys_devs_term;
     uint32_t total_gpu_count;
     uint32_t phys_dev_count_term;
     struct loader_physical_device_term **phys_devs_term;
@@ -250,8 +251,8 @@ struct loader_instance {
     struct loader_icd_term *icd_terms;
     struct loader_icd_tramp_list icd_tramp_list;
 
-    struct loader_dispatch_hash_entry dev_ext_disp_hash[MAX_NUM_UNKNOWN_EXTS];
-    struct loader_dispatch_hash_entry phys_dev_ext_disp_hash[MAX_NUM_UNKNOWN_EXTS];
+    struct loader_unknown_ext_table dev_ext_table;
+    struct loader_unknown_ext_table phys_dev_ext_table;
 
     struct loader_msg_callback_map_entry *icd_msg_callback_map;
 
@@ -276,6 +277,8 @@ struct loader_instance {
     VkDebugReportCallbackEXT *tmp_callbacks;
 
     VkAllocationCallbacks alloc_callbacks;
+    // Instance scope allocations made by vkCreateInstance, NULL if the app gave allocation callbacks
+    struct loader_instance_arena *arena;
 
     bool wsi_surface_enabled;
 #ifdef VK_USE_PLATFORM_WIN32_KHR
@@ -327,8 +330,20 @@ struct loader_physical_device_term {
     VkPhysicalDevice phys_dev;  // object from ICD
 };
 
+// A layer library opened for an instance or device chain. Layer libraries are shared by every chain
+// that includes them, and stay loaded once no chain uses them so that short-lived instances don't
+// load them again.
+struct loader_layer_library {
+    char *lib_name;
+    loader_platform_dl_handle handle;
+    uint32_t ref_count;
+};
+
 struct loader_struct {
     struct loader_instance *instances;
+    struct loader_layer_library *layer_libraries;
+    uint32_t layer_library_count;
+    uint32_t layer_library_capacity;
 };
 
 struct loader_scanned_icd {
@@ -392,6 +407,9 @@ void *loader_instance_heap_alloc(const struct loader_instance *instance, size_t
 void loader_instance_heap_free(const struct loader_instance *instance, void *pMemory);
 void *loader_instance_heap_realloc(const struct loader_instance *instance, void *pMemory, size_t orig_size, size_t size,
                                    VkSystemAllocationScope alloc_scope);
+void loader_instance_arena_begin(struct loader_instance *instance);
+void loader_instance_arena_end(struct loader_instance *instance);
+void loader_instance_arena_destroy(struct loader_instance *instance);
 void *loader_instance_tls_heap_alloc(size_t size);
 void loader_instance_tls_heap_free(void *pMemory);
 void *loader_device_heap_alloc(const struct loader_device *device, size_t size, VkSystemAllocationScope allocationScope);
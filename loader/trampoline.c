@@ -35,6 +35,8 @@
 
 // Trampoline entrypoints are in this file for core Vulkan commands
 
+static VKAPI_ATTR VkResult VKAPI_CALL vkRefreshPhysicalDevicesLUNARG(VkInstance instance);
+
 // Get an instance level or global level entry point address.
 // @param instance
 // @param pName
@@ -44,8 +46,9 @@
 //    functions both core and extensions.
 LOADER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkInstance instance, const char *pName) {
     void *addr;
+    enum loader_command_id command = loader_get_command_id(pName);
 
-    addr = globalGetProcAddr(pName);
+    addr = globalGetProcAddr(command);
     if (instance == VK_NULL_HANDLE) {
         // Get entrypoint addresses that are global (no dispatchable object)
 
@@ -57,11 +60,12 @@ LOADER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkI
 
     struct loader_instance *ptr_instance = loader_get_instance(instance);
     if (ptr_instance == NULL) return NULL;
+    if (command == LOADER_COMMAND_vkRefreshPhysicalDevicesLUNARG) return (PFN_vkVoidFunction)vkRefreshPhysicalDevicesLUNARG;
     // Return trampoline code for non-global entrypoints including any extensions.
     // Device extensions are returned if a layer or ICD supports the extension.
     // Instance extensions are returned if the extension is enabled and the
     // loader or someone else supports the extension
-    return trampolineGetProcAddr(ptr_instance, pName);
+    return trampolineGetProcAddr(ptr_instance, pName, command);
 }
 
 // Get a device level or global level entry point address.
@@ -73,10 +77,11 @@ LOADER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkI
 //    Device relative means call down the device chain.
 LOADER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice device, const char *pName) {
     void *addr;
+    enum loader_command_id command = loader_get_command_id(pName);
 
     // For entrypoints that loader must handle (ie non-dispatchable or create object)
     // make sure the loader entrypoint is returned
-    addr = loader_non_passthrough_gdpa(pName);
+    addr = loader_non_passthrough_gdpa(command);
     if (addr) {
         return addr;
     }
@@ -89,7 +94,7 @@ LOADER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDev
     const VkLayerDispatchTable *disp_table = *(VkLayerDispatchTable **)device;
     if (disp_table == NULL) return NULL;
 
-    addr = loader_lookup_device_dispatch_table(disp_table, pName);
+    addr = loader_lookup_device_dispatch_table(disp_table, command);
     if (addr) return addr;
 
     if (disp_table->GetDeviceProcAddr == NULL) return NULL;
@@ -252,6 +257,7 @@ LOADER_EXPORT VKAPI_ATTR VkResult VKAPI_CALL vkCreateInstance(const VkInstanceCr
     if (pAllocator) {
         ptr_instance->alloc_callbacks = *pAllocator;
     }
+    loader_instance_arena_begin(ptr_instance);
 
     // Look for one or more debug report create info structures
     // and setup a callback(s) for each one found.
@@ -307,8 +313,8 @@ LOADER_EXPORT VKAPI_ATTR VkResult VKAPI_CALL vkCreateInstance(const VkInstanceCr
         goto out;
     }
 
-    ptr_instance->disp =
-        loader_instance_heap_alloc(ptr_instance, sizeof(VkLayerInstanceDispatchTable), VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
+    ptr_instance->disp = loader_instance_heap_alloc(ptr_instance, sizeof(struct loader_instance_dispatch_table),
+                                                    VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
     if (ptr_instance->disp == NULL) {
         loader_log(ptr_instance, VK_DEBUG_REPORT_ERROR_BIT_EXT, 0,
                    "vkCreateInstance:  Failed to allocate Instance dispatch"
@@ -372,11 +378,13 @@ out:
             loader_scanned_icd_clear(ptr_instance, &ptr_instance->icd_tramp_list);
             loader_destroy_generic_list(ptr_instance, (struct loader_generic_list *)&ptr_instance->ext_list);
 
+            loader_instance_arena_destroy(ptr_instance);
             loader_instance_heap_free(ptr_instance, ptr_instance);
         } else {
             // Remove temporary debug_report callback
             util_DestroyDebugReportCallbacks(ptr_instance, pAllocator, ptr_instance->num_tmp_callbacks,
                                              ptr_instance->tmp_callbacks);
+            loader_instance_arena_end(ptr_instance);
         }
 
         if (loaderLocked) {
@@ -442,6 +450,7 @@ LOADER_EXPORT VKAPI_ATTR void VKAPI_CALL vkDestroyInstance(VkInstance instance,
         util_FreeDebugReportCreateInfos(pAllocator, ptr_instance->tmp_dbg_create_infos, ptr_instance->tmp_callbacks);
     }
     loader_instance_heap_free(ptr_instance, ptr_instance->disp);
+    loader_instance_arena_destroy(ptr_instance);
     loader_instance_heap_free(ptr_instance, ptr_instance);
     loader_platform_thread_unlock_mutex(&loader_lock);
 }
@@ -468,13 +477,16 @@ LOADER_EXPORT VKAPI_ATTR VkResult VKAPI_CALL vkEnumeratePhysicalDevices(VkInstan
         goto out;
     }
 
-    // Setup the trampoline loader physical devices.  This will actually
-    // call down and setup the terminator loader physical devices during the
-    // process.
-    VkResult setup_res = setupLoaderTrampPhysDevs(instance);
-    if (setup_res != VK_SUCCESS && setup_res != VK_INCOMPLETE) {
-        res = setup_res;
-        goto out;
+    // Setup the trampoline loader physical devices the first time they are
+    // enumerated.  This will actually call down and setup the terminator loader
+    // physical devices during the process.  Later calls return the same
+    // physical devices until vkRefreshPhysicalDevicesLUNARG is called.
+    if (NULL == inst->phys_devs_tramp) {
+        VkResult setup_res = setupLoaderTrampPhysDevs(instance);
+        if (setup_res != VK_SUCCESS && setup_res != VK_INCOMPLETE) {
+            res = setup_res;
+            goto out;
+        }
     }
 
     count = inst->phys_dev_count_tramp;
@@ -502,6 +514,34 @@ out:
     return res;
 }
 
+// Loader command, returned by vkGetInstanceProcAddr, that queries the layers and
+// ICDs for the physical devices of an instance again.  Physical devices that are
+// still reported keep their handles.
+static VKAPI_ATTR VkResult VKAPI_CALL vkRefreshPhysicalDevicesLUNARG(VkInstance instance) {
+    VkResult res = VK_SUCCESS;
+    struct loader_instance *inst;
+
+    loader_platform_thread_lock_mutex(&loader_lock);
+
+    inst = loader_get_instance(instance);
+    if (NULL == inst) {
+        res = VK_ERROR_INITIALIZATION_FAILED;
+        goto out;
+    }
+
+    inst->refresh_phys_devs_term = true;
+    res = setupLoaderTrampPhysDevs(instance);
+    if (res == VK_INCOMPLETE) {
+        res = VK_SUCCESS;
+    }
+    inst->refresh_phys_devs_term = false;
+
+out:
+
+    loader_platform_thread_unlock_mutex(&loader_lock);
+    return res;
+}
+
 LOADER_EXPORT VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFeatures(VkPhysicalDevice physicalDevice,
                                                                      VkPhysicalDeviceFeatures *pFeatures) {
     const VkLayerInstanceDispatchTable *disp;
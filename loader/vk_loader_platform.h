@@ -123,6 +123,13 @@ static inline void loader_platform_thread_once(pthread_once_t *ctl, void (*func)
     assert(ctl != NULL);
     pthread_once(ctl, func);
 }
+#define LOADER_PLATFORM_THREAD_PROC(name, param) void *name(void *param)
+#define LOADER_PLATFORM_THREAD_PROC_RETURN NULL
+typedef void *(*loader_platform_thread_proc)(void *);
+static inline bool loader_platform_thread_create(loader_platform_thread *pThread, loader_platform_thread_proc proc, void *param) {
+    return pthread_create(pThread, NULL, proc, param) == 0;
+}
+static inline void loader_platform_thread_join(loader_platform_thread thread) { pthread_join(thread, NULL); }
 
 // Thread IDs:
 typedef pthread_t loader_platform_thread_id;
@@ -253,7 +260,8 @@ static loader_platform_dl_handle loader_platform_open_library(const char *lib_pa
     return lib_handle;
 }
 static char *loader_platform_open_library_error(const char *libPath) {
-    static char errorMsg[164];
+    // ICD libraries are opened on several threads at once, see loader_icd_scan
+    static __declspec(thread) char errorMsg[164];
     (void)snprintf(errorMsg, 163, "Failed to open dynamic library \"%s\" with error %d", libPath, GetLastError());
     return errorMsg;
 }
@@ -285,6 +293,17 @@ static void loader_platform_thread_once(void *ctl, void (*func)(void)) {
     assert(ctl != NULL);
     InitOnceExecuteOnce((PINIT_ONCE)ctl, InitFuncWrapper, func, NULL);
 }
+#define LOADER_PLATFORM_THREAD_PROC(name, param) DWORD WINAPI name(LPVOID param)
+#define LOADER_PLATFORM_THREAD_PROC_RETURN 0
+typedef LPTHREAD_START_ROUTINE loader_platform_thread_proc;
+static bool loader_platform_thread_create(loader_platform_thread *pThread, loader_platform_thread_proc proc, void *param) {
+    *pThread = CreateThread(NULL, 0, proc, param, 0, NULL);
+    return *pThread != NULL;
+}
+static void loader_platform_thread_join(loader_platform_thread thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
 
 // Thread IDs:
 typedef DWORD loader_platform_thread_id;
@@ -1386,162 +1386,135 @@ VKAPI_ATTR VkResult VKAPI_CALL terminator_CreateSharedSwapchainsKHR(VkDevice dev
     return VK_SUCCESS;
 }
 
-bool wsi_swapchain_instance_gpa(struct loader_instance *ptr_instance, const char *name, void **addr) {
+bool wsi_swapchain_instance_gpa(struct loader_instance *ptr_instance, enum loader_command_id command, void **addr) {
     *addr = NULL;
 
-    // Functions for the VK_KHR_surface extension:
-    if (!strcmp("vkDestroySurfaceKHR", name)) {
-        *addr = ptr_instance->wsi_surface_enabled ? (void *)vkDestroySurfaceKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkGetPhysicalDeviceSurfaceSupportKHR", name)) {
-        *addr = ptr_instance->wsi_surface_enabled ? (void *)vkGetPhysicalDeviceSurfaceSupportKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkGetPhysicalDeviceSurfaceCapabilitiesKHR", name)) {
-        *addr = ptr_instance->wsi_surface_enabled ? (void *)vkGetPhysicalDeviceSurfaceCapabilitiesKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkGetPhysicalDeviceSurfaceFormatsKHR", name)) {
-        *addr = ptr_instance->wsi_surface_enabled ? (void *)vkGetPhysicalDeviceSurfaceFormatsKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkGetPhysicalDeviceSurfacePresentModesKHR", name)) {
-        *addr = ptr_instance->wsi_surface_enabled ? (void *)vkGetPhysicalDeviceSurfacePresentModesKHR : NULL;
-        return true;
-    }
-
-    // Functions for the VK_KHR_swapchain extension:
-
-    // Note: This is a device extension, and its functions are statically
-    // exported from the loader.  Per Khronos decisions, the loader's GIPA
-    // function will return the trampoline function for such device-extension
-    // functions, regardless of whether the extension has been enabled.
-    if (!strcmp("vkCreateSwapchainKHR", name)) {
-        *addr = (void *)vkCreateSwapchainKHR;
-        return true;
-    }
-    if (!strcmp("vkDestroySwapchainKHR", name)) {
-        *addr = (void *)vkDestroySwapchainKHR;
-        return true;
-    }
-    if (!strcmp("vkGetSwapchainImagesKHR", name)) {
-        *addr = (void *)vkGetSwapchainImagesKHR;
-        return true;
-    }
-    if (!strcmp("vkAcquireNextImageKHR", name)) {
-        *addr = (void *)vkAcquireNextImageKHR;
-        return true;
-    }
-    if (!strcmp("vkQueuePresentKHR", name)) {
-        *addr = (void *)vkQueuePresentKHR;
-        return true;
-    }
+    switch (command) {
+        // Functions for the VK_KHR_surface extension:
+        case LOADER_COMMAND_vkDestroySurfaceKHR:
+            *addr = ptr_instance->wsi_surface_enabled ? (void *)vkDestroySurfaceKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkGetPhysicalDeviceSurfaceSupportKHR:
+            *addr = ptr_instance->wsi_surface_enabled ? (void *)vkGetPhysicalDeviceSurfaceSupportKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkGetPhysicalDeviceSurfaceCapabilitiesKHR:
+            *addr = ptr_instance->wsi_surface_enabled ? (void *)vkGetPhysicalDeviceSurfaceCapabilitiesKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkGetPhysicalDeviceSurfaceFormatsKHR:
+            *addr = ptr_instance->wsi_surface_enabled ? (void *)vkGetPhysicalDeviceSurfaceFormatsKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkGetPhysicalDeviceSurfacePresentModesKHR:
+            *addr = ptr_instance->wsi_surface_enabled ? (void *)vkGetPhysicalDeviceSurfacePresentModesKHR : NULL;
+            return true;
+
+        // Functions for the VK_KHR_swapchain extension:
+
+        // Note: This is a device extension, and its functions are statically
+        // exported from the loader.  Per Khronos decisions, the loader's GIPA
+        // function will return the trampoline function for such device-extension
+        // functions, regardless of whether the extension has been enabled.
+        case LOADER_COMMAND_vkCreateSwapchainKHR:
+            *addr = (void *)vkCreateSwapchainKHR;
+            return true;
+        case LOADER_COMMAND_vkDestroySwapchainKHR:
+            *addr = (void *)vkDestroySwapchainKHR;
+            return true;
+        case LOADER_COMMAND_vkGetSwapchainImagesKHR:
+            *addr = (void *)vkGetSwapchainImagesKHR;
+            return true;
+        case LOADER_COMMAND_vkAcquireNextImageKHR:
+            *addr = (void *)vkAcquireNextImageKHR;
+            return true;
+        case LOADER_COMMAND_vkQueuePresentKHR:
+            *addr = (void *)vkQueuePresentKHR;
+            return true;
 
 #ifdef VK_USE_PLATFORM_WIN32_KHR
 
-    // Functions for the VK_KHR_win32_surface extension:
-    if (!strcmp("vkCreateWin32SurfaceKHR", name)) {
-        *addr = ptr_instance->wsi_win32_surface_enabled ? (void *)vkCreateWin32SurfaceKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkGetPhysicalDeviceWin32PresentationSupportKHR", name)) {
-        *addr = ptr_instance->wsi_win32_surface_enabled ? (void *)vkGetPhysicalDeviceWin32PresentationSupportKHR : NULL;
-        return true;
-    }
+        // Functions for the VK_KHR_win32_surface extension:
+        case LOADER_COMMAND_vkCreateWin32SurfaceKHR:
+            *addr = ptr_instance->wsi_win32_surface_enabled ? (void *)vkCreateWin32SurfaceKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkGetPhysicalDeviceWin32PresentationSupportKHR:
+            *addr = ptr_instance->wsi_win32_surface_enabled ? (void *)vkGetPhysicalDeviceWin32PresentationSupportKHR : NULL;
+            return true;
 #endif  // VK_USE_PLATFORM_WIN32_KHR
 #ifdef VK_USE_PLATFORM_MIR_KHR
 
-    // Functions for the VK_KHR_mir_surface extension:
-    if (!strcmp("vkCreateMirSurfaceKHR", name)) {
-        *addr = ptr_instance->wsi_mir_surface_enabled ? (void *)vkCreateMirSurfaceKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkGetPhysicalDeviceMirPresentationSupportKHR", name)) {
-        *addr = ptr_instance->wsi_mir_surface_enabled ? (void *)vkGetPhysicalDeviceMirPresentationSupportKHR : NULL;
-        return true;
-    }
+        // Functions for the VK_KHR_mir_surface extension:
+        case LOADER_COMMAND_vkCreateMirSurfaceKHR:
+            *addr = ptr_instance->wsi_mir_surface_enabled ? (void *)vkCreateMirSurfaceKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkGetPhysicalDeviceMirPresentationSupportKHR:
+            *addr = ptr_instance->wsi_mir_surface_enabled ? (void *)vkGetPhysicalDeviceMirPresentationSupportKHR : NULL;
+            return true;
 #endif  // VK_USE_PLATFORM_MIR_KHR
 #ifdef VK_USE_PLATFORM_WAYLAND_KHR
 
-    // Functions for the VK_KHR_wayland_surface extension:
-    if (!strcmp("vkCreateWaylandSurfaceKHR", name)) {
-        *addr = ptr_instance->wsi_wayland_surface_enabled ? (void *)vkCreateWaylandSurfaceKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkGetPhysicalDeviceWaylandPresentationSupportKHR", name)) {
-        *addr = ptr_instance->wsi_wayland_surface_enabled ? (void *)vkGetPhysicalDeviceWaylandPresentationSupportKHR : NULL;
-        return true;
-    }
+        // Functions for the VK_KHR_wayland_surface extension:
+        case LOADER_COMMAND_vkCreateWaylandSurfaceKHR:
+            *addr = ptr_instance->wsi_wayland_surface_enabled ? (void *)vkCreateWaylandSurfaceKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkGetPhysicalDeviceWaylandPresentationSupportKHR:
+            *addr = ptr_instance->wsi_wayland_surface_enabled ? (void *)vkGetPhysicalDeviceWaylandPresentationSupportKHR : NULL;
+            return true;
 #endif  // VK_USE_PLATFORM_WAYLAND_KHR
 #ifdef VK_USE_PLATFORM_XCB_KHR
 
-    // Functions for the VK_KHR_xcb_surface extension:
-    if (!strcmp("vkCreateXcbSurfaceKHR", name)) {
-        *addr = ptr_instance->wsi_xcb_surface_enabled ? (void *)vkCreateXcbSurfaceKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkGetPhysicalDeviceXcbPresentationSupportKHR", name)) {
-        *addr = ptr_instance->wsi_xcb_surface_enabled ? (void *)vkGetPhysicalDeviceXcbPresentationSupportKHR : NULL;
-        return true;
-    }
+        // Functions for the VK_KHR_xcb_surface extension:
+        case LOADER_COMMAND_vkCreateXcbSurfaceKHR:
+            *addr = ptr_instance->wsi_xcb_surface_enabled ? (void *)vkCreateXcbSurfaceKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkGetPhysicalDeviceXcbPresentationSupportKHR:
+            *addr = ptr_instance->wsi_xcb_surface_enabled ? (void *)vkGetPhysicalDeviceXcbPresentationSupportKHR : NULL;
+            return true;
 #endif  // VK_USE_PLATFORM_XCB_KHR
 #ifdef VK_USE_PLATFORM_XLIB_KHR
 
-    // Functions for the VK_KHR_xlib_surface extension:
-    if (!strcmp("vkCreateXlibSurfaceKHR", name)) {
-        *addr = ptr_instance->wsi_xlib_surface_enabled ? (void *)vkCreateXlibSurfaceKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkGetPhysicalDeviceXlibPresentationSupportKHR", name)) {
-        *addr = ptr_instance->wsi_xlib_surface_enabled ? (void *)vkGetPhysicalDeviceXlibPresentationSupportKHR : NULL;
-        return true;
-    }
+        // Functions for the VK_KHR_xlib_surface extension:
+        case LOADER_COMMAND_vkCreateXlibSurfaceKHR:
+            *addr = ptr_instance->wsi_xlib_surface_enabled ? (void *)vkCreateXlibSurfaceKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkGetPhysicalDeviceXlibPresentationSupportKHR:
+            *addr = ptr_instance->wsi_xlib_surface_enabled ? (void *)vkGetPhysicalDeviceXlibPresentationSupportKHR : NULL;
+            return true;
 #endif  // VK_USE_PLATFORM_XLIB_KHR
 #ifdef VK_USE_PLATFORM_ANDROID_KHR
 
-    // Functions for the VK_KHR_android_surface extension:
-    if (!strcmp("vkCreateAndroidSurfaceKHR", name)) {
-        *addr = ptr_instance->wsi_xlib_surface_enabled ? (void *)vkCreateAndroidSurfaceKHR : NULL;
-        return true;
-    }
+        // Functions for the VK_KHR_android_surface extension:
+        case LOADER_COMMAND_vkCreateAndroidSurfaceKHR:
+            *addr = ptr_instance->wsi_xlib_surface_enabled ? (void *)vkCreateAndroidSurfaceKHR : NULL;
+            return true;
 #endif  // VK_USE_PLATFORM_ANDROID_KHR
 
-    // Functions for VK_KHR_display extension:
-    if (!strcmp("vkGetPhysicalDeviceDisplayPropertiesKHR", name)) {
-        *addr = ptr_instance->wsi_display_enabled ? (void *)vkGetPhysicalDeviceDisplayPropertiesKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkGetPhysicalDeviceDisplayPlanePropertiesKHR", name)) {
-        *addr = ptr_instance->wsi_display_enabled ? (void *)vkGetPhysicalDeviceDisplayPlanePropertiesKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkGetDisplayPlaneSupportedDisplaysKHR", name)) {
-        *addr = ptr_instance->wsi_display_enabled ? (void *)vkGetDisplayPlaneSupportedDisplaysKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkGetDisplayModePropertiesKHR", name)) {
-        *addr = ptr_instance->wsi_display_enabled ? (void *)vkGetDisplayModePropertiesKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkCreateDisplayModeKHR", name)) {
-        *addr = ptr_instance->wsi_display_enabled ? (void *)vkCreateDisplayModeKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkGetDisplayPlaneCapabilitiesKHR", name)) {
-        *addr = ptr_instance->wsi_display_enabled ? (void *)vkGetDisplayPlaneCapabilitiesKHR : NULL;
-        return true;
-    }
-    if (!strcmp("vkCreateDisplayPlaneSurfaceKHR", name)) {
-        *addr = ptr_instance->wsi_display_enabled ? (void *)vkCreateDisplayPlaneSurfaceKHR : NULL;
-        return true;
-    }
-
-    // Functions for KHR_display_swapchain extension:
-    if (!strcmp("vkCreateSharedSwapchainsKHR", name)) {
-        *addr = (void *)vkCreateSharedSwapchainsKHR;
-        return true;
+        // Functions for VK_KHR_display extension:
+        case LOADER_COMMAND_vkGetPhysicalDeviceDisplayPropertiesKHR:
+            *addr = ptr_instance->wsi_display_enabled ? (void *)vkGetPhysicalDeviceDisplayPropertiesKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkGetPhysicalDeviceDisplayPlanePropertiesKHR:
+            *addr = ptr_instance->wsi_display_enabled ? (void *)vkGetPhysicalDeviceDisplayPlanePropertiesKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkGetDisplayPlaneSupportedDisplaysKHR:
+            *addr = ptr_instance->wsi_display_enabled ? (void *)vkGetDisplayPlaneSupportedDisplaysKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkGetDisplayModePropertiesKHR:
+            *addr = ptr_instance->wsi_display_enabled ? (void *)vkGetDisplayModePropertiesKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkCreateDisplayModeKHR:
+            *addr = ptr_instance->wsi_display_enabled ? (void *)vkCreateDisplayModeKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkGetDisplayPlaneCapabilitiesKHR:
+            *addr = ptr_instance->wsi_display_enabled ? (void *)vkGetDisplayPlaneCapabilitiesKHR : NULL;
+            return true;
+        case LOADER_COMMAND_vkCreateDisplayPlaneSurfaceKHR:
+            *addr = ptr_instance->wsi_display_enabled ? (void *)vkCreateDisplayPlaneSurfaceKHR : NULL;
+            return true;
+
+        // Functions for KHR_display_swapchain extension:
+        case LOADER_COMMAND_vkCreateSharedSwapchainsKHR:
+            *addr = (void *)vkCreateSharedSwapchainsKHR;
+            return true;
+        default:
+            return false;
     }
-
-    return false;
 }
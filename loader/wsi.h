@@ -51,7 +51,7 @@ typedef struct {
     VkSurfaceKHR *real_icd_surfaces;
 } VkIcdSurface;
 
-bool wsi_swapchain_instance_gpa(struct loader_instance *ptr_instance, const char *name, void **addr);
+bool wsi_swapchain_instance_gpa(struct loader_instance *ptr_instance, enum loader_command_id command, void **addr);
 
 void wsi_create_instance(struct loader_instance *ptr_instance, const VkInstanceCreateInfo *pCreateInfo);
 bool wsi_unsupported_instance_extension(const VkExtensionProperties *ext_prop);
@@ -44,6 +44,27 @@ DEVICE_CMDS_NEED_TERM = ['vkGetDeviceProcAddr',
                          'vkDebugMarkerSetObjectTagEXT',
                          'vkDebugMarkerSetObjectNameEXT']
 
+# Commands the loader implements itself that aren't in the registry, they still get
+# a command id so vkGetInstanceProcAddr finds them with the same lookup
+LOADER_PRIVATE_CMDS = ['vkRefreshPhysicalDevicesLUNARG']
+
+#
+# Hashes of the command name perfect hash, these must match loader_get_command_id()
+def CommandNameHash(name):
+    hash = 2166136261
+    for c in name.encode():
+        hash = ((hash ^ c) * 16777619) & 0xFFFFFFFF
+    return hash
+
+def CommandSlotHash(hash, displacement):
+    slot = hash ^ displacement
+    slot ^= slot >> 16
+    slot = (slot * 0x85ebca6b) & 0xFFFFFFFF
+    slot ^= slot >> 13
+    slot = (slot * 0xc2b2ae35) & 0xFFFFFFFF
+    slot ^= slot >> 16
+    return slot
+
 #
 # LoaderExtensionGeneratorOptions - subclass of GeneratorOptions.
 class LoaderExtensionGeneratorOptions(GeneratorOptions):
@@ -100,6 +121,8 @@ class LoaderExtensionOutputGenerator(OutputGenerator):
         self.ext_device_dispatch_list = []    # List of extension entries for device dispatch list
         self.core_commands = []               # List of CommandData records for core Vulkan commands
         self.ext_commands = []                # List of CommandData records for extension Vulkan commands
+        self.command_slots = None             # Command names in perfect hash slot order
+        self.command_displacements = None     # Perfect hash displacement of each bucket
         self.CommandParam = namedtuple('CommandParam', ['type', 'name', 'cdecl'])
         self.CommandData = namedtuple('CommandData', ['name', 'ext_name', 'ext_type', 'protect', 'return_type', 'handle_type', 'params', 'cdecl'])
         self.instanceExtensions = []
@@ -174,6 +197,7 @@ class LoaderExtensionOutputGenerator(OutputGenerator):
         file_data = ''
 
         if self.genOpts.filename == 'vk_loader_extensions.h':
+            file_data += self.OutputCommandIdsInHeader()
             file_data += self.OutputPrototypesInHeader()
             file_data += self.OutputLoaderTerminators()
             file_data += self.OutputIcdDispatchTable()
@@ -183,6 +207,7 @@ class LoaderExtensionOutputGenerator(OutputGenerator):
             file_data += self.OutputUtilitiesInSource()
             file_data += self.OutputIcdDispatchTableInit()
             file_data += self.OutputLoaderDispatchTables()
+            file_data += self.OutputCommandIdLookupFunc()
             file_data += self.OutputLoaderLookupFunc()
             file_data += self.CreateTrampTermFuncs()
             file_data += self.InstExtensionGPA()
@@ -359,7 +384,7 @@ class LoaderExtensionOutputGenerator(OutputGenerator):
         protos += '\n'
         protos += '// Extension interception for vkGetInstanceProcAddr function, so we can return\n'
         protos += '// the appropriate information for any instance extensions we know about.\n'
-        protos += 'bool extension_instance_gpa(struct loader_instance *ptr_instance, const char *name, void **addr);\n'
+        protos += 'bool extension_instance_gpa(struct loader_instance *ptr_instance, enum loader_command_id command, void **addr);\n'
         protos += '\n'
         protos += '// Extension interception for vkCreateInstance function, so we can properly\n'
         protos += '// detect and enable any instance extension information for extensions we know\n'
@@ -398,11 +423,12 @@ class LoaderExtensionOutputGenerator(OutputGenerator):
         protos += '                                                                         VkInstance inst);\n'
         protos += '\n'
         protos += '// Device command lookup function\n'
-        protos += 'VKAPI_ATTR void* VKAPI_CALL loader_lookup_device_dispatch_table(const VkLayerDispatchTable *table, const char *name);\n'
+        protos += 'VKAPI_ATTR void* VKAPI_CALL loader_lookup_device_dispatch_table(const VkLayerDispatchTable *table,\n'
+        protos += '                                                                enum loader_command_id command);\n'
         protos += '\n'
         protos += '// Instance command lookup function\n'
-        protos += 'VKAPI_ATTR void* VKAPI_CALL loader_lookup_instance_dispatch_table(const VkLayerInstanceDispatchTable *table, const char *name,\n'
-        protos += '                                                                  bool *found_name);\n'
+        protos += 'VKAPI_ATTR void* VKAPI_CALL loader_lookup_instance_dispatch_table(const VkLayerInstanceDispatchTable *table,\n'
+        protos += '                                                                  enum loader_command_id command, bool *found_name);\n'
         protos += '\n'
         protos += 'VKAPI_ATTR bool VKAPI_CALL loader_icd_init_entries(struct loader_icd_term *icd_term, VkInstance inst,\n'
         protos += '                                                   const PFN_vkGetInstanceProcAddr fp_gipa);\n'
@@ -753,6 +779,110 @@ class LoaderExtensionOutputGenerator(OutputGenerator):
             tables += '}\n\n'
         return tables
 
+    #
+    # Return the names of all commands the loader knows about, in slot order of
+    # the perfect hash built over them
+    def CommandNamesBySlot(self):
+        if self.command_slots is not None:
+            return self.command_slots
+
+        names = []
+        for cur_cmd in self.core_commands + self.ext_commands:
+            if cur_cmd.name not in names:
+                names.append(cur_cmd.name)
+        names += LOADER_PRIVATE_CMDS
+
+        # Hash and displace: every name is hashed once, the hash picks a bucket and the
+        # displacement of that bucket moves all names in it into free slots.  Filling the
+        # largest buckets first keeps the displacements small.
+        hashes = [CommandNameHash(name) for name in names]
+        if len(set(hashes)) != len(hashes):
+            raise Exception('Command name hash collision, change CommandNameHash()')
+        size = len(names)
+        bucket_count = (size + 1) // 2
+        buckets = [[] for i in range(bucket_count)]
+        for index, hash in enumerate(hashes):
+            buckets[hash % bucket_count].append(index)
+
+        slots = [None] * size
+        displacements = [0] * bucket_count
+        for bucket in sorted(range(bucket_count), key=lambda b: len(buckets[b]), reverse=True):
+            if len(buckets[bucket]) == 0:
+                break
+            displacement = 0
+            while True:
+                positions = [CommandSlotHash(hashes[index], displacement) % size for index in buckets[bucket]]
+                if len(set(positions)) == len(positions) and all(slots[pos] is None for pos in positions):
+                    break
+                displacement += 1
+                if displacement > 0xFFFF:
+                    raise Exception('No command name hash displacement found for %s' % names[buckets[bucket][0]])
+            for index, pos in zip(buckets[bucket], positions):
+                slots[pos] = names[index]
+            displacements[bucket] = displacement
+
+        self.command_slots = slots
+        self.command_displacements = displacements
+        return self.command_slots
+
+    #
+    # Create the command id enumeration and lookup prototype
+    def OutputCommandIdsInHeader(self):
+        ids = ''
+        ids += '// Ids of the commands the loader knows about, in hash slot order\n'
+        ids += 'enum loader_command_id {\n'
+        for name in self.CommandNamesBySlot():
+            ids += '    LOADER_COMMAND_%s,\n' % name
+        ids += '    LOADER_COMMAND_COUNT,\n'
+        ids += '    LOADER_COMMAND_UNKNOWN = LOADER_COMMAND_COUNT\n'
+        ids += '};\n\n'
+        ids += '// Command name lookup function, returns LOADER_COMMAND_UNKNOWN for names the loader doesn\'t know\n'
+        ids += 'VKAPI_ATTR enum loader_command_id VKAPI_CALL loader_get_command_id(const char *name);\n\n'
+        return ids
+
+    #
+    # Create the command name lookup function.  The names are placed with a perfect hash
+    # so a lookup is one hash of the name and one string compare.
+    def OutputCommandIdLookupFunc(self):
+        names = self.CommandNamesBySlot()
+        displacements = self.command_displacements
+
+        lookup = ''
+        lookup += '// Command names indexed by command id\n'
+        lookup += 'static const char *const loader_command_names[LOADER_COMMAND_COUNT] = {\n'
+        for name in names:
+            lookup += '    "%s",\n' % name
+        lookup += '};\n\n'
+        lookup += '// Perfect hash displacements, indexed by the name hash modulo the table size\n'
+        lookup += 'static const uint16_t loader_command_hash_displacements[%d] = {' % len(displacements)
+        for index, displacement in enumerate(displacements):
+            lookup += '\n    ' if index % 16 == 0 else ' '
+            lookup += '%d,' % displacement
+        lookup += '\n};\n\n'
+        lookup += '// Command name lookup function\n'
+        lookup += 'VKAPI_ATTR enum loader_command_id VKAPI_CALL loader_get_command_id(const char *name) {\n'
+        lookup += '    if (!name) return LOADER_COMMAND_UNKNOWN;\n'
+        lookup += '\n'
+        lookup += '    // FNV-1a hash of the name\n'
+        lookup += '    uint32_t hash = 2166136261u;\n'
+        lookup += '    for (const char *c = name; *c != \'\\0\'; c++) {\n'
+        lookup += '        hash = (hash ^ (uint8_t)*c) * 16777619u;\n'
+        lookup += '    }\n'
+        lookup += '\n'
+        lookup += '    // Displace the hash and mix it, which selects the only slot the name can be in\n'
+        lookup += '    uint32_t slot = hash ^ loader_command_hash_displacements[hash %% %d];\n' % len(displacements)
+        lookup += '    slot ^= slot >> 16;\n'
+        lookup += '    slot *= 0x85ebca6bu;\n'
+        lookup += '    slot ^= slot >> 13;\n'
+        lookup += '    slot *= 0xc2b2ae35u;\n'
+        lookup += '    slot ^= slot >> 16;\n'
+        lookup += '    slot %= LOADER_COMMAND_COUNT;\n'
+        lookup += '\n'
+        lookup += '    if (strcmp(loader_command_names[slot], name)) return LOADER_COMMAND_UNKNOWN;\n'
+        lookup += '    return (enum loader_command_id)slot;\n'
+        lookup += '}\n\n'
+        return lookup
+
     #
     # Create a lookup table function from the appropriate list of entrypoints and
     # return it as a string
@@ -767,23 +897,17 @@ class LoaderExtensionOutputGenerator(OutputGenerator):
                 cur_type = 'device'
 
                 tables += '// Device command lookup function\n'
-                tables += 'VKAPI_ATTR void* VKAPI_CALL loader_lookup_device_dispatch_table(const VkLayerDispatchTable *table, const char *name) {\n'
-                tables += '    if (!name || name[0] != \'v\' || name[1] != \'k\') return NULL;\n'
-                tables += '\n'
-                tables += '    name += 2;\n'
+                tables += 'VKAPI_ATTR void* VKAPI_CALL loader_lookup_device_dispatch_table(const VkLayerDispatchTable *table,\n'
+                tables += '                                                                enum loader_command_id command) {\n'
+                tables += '    switch (command) {'
             else:
                 cur_type = 'instance'
 
                 tables += '// Instance command lookup function\n'
-                tables += 'VKAPI_ATTR void* VKAPI_CALL loader_lookup_instance_dispatch_table(const VkLayerInstanceDispatchTable *table, const char *name,\n'
-                tables += '                                                                 bool *found_name) {\n'
-                tables += '    if (!name || name[0] != \'v\' || name[1] != \'k\') {\n'
-                tables += '        *found_name = false;\n'
-                tables += '        return NULL;\n'
-                tables += '    }\n'
-                tables += '\n'
+                tables += 'VKAPI_ATTR void* VKAPI_CALL loader_lookup_instance_dispatch_table(const VkLayerInstanceDispatchTable *table,\n'
+                tables += '                                                                  enum loader_command_id command, bool *found_name) {\n'
                 tables += '    *found_name = true;\n'
-                tables += '    name += 2;\n'
+                tables += '    switch (command) {'
 
             for y in range(0, 2):
                 if y == 0:
@@ -797,9 +921,9 @@ class LoaderExtensionOutputGenerator(OutputGenerator):
 
                         if cur_cmd.ext_name != cur_extension_name:
                             if 'VK_VERSION_' in cur_cmd.ext_name:
-                                tables += '\n    // ---- Core %s commands\n' % cur_cmd.ext_name[11:]
+                                tables += '\n        // ---- Core %s commands\n' % cur_cmd.ext_name[11:]
                             else:
-                                tables += '\n    // ---- %s extension commands\n' % cur_cmd.ext_name
+                                tables += '\n        // ---- %s extension commands\n' % cur_cmd.ext_name
                             cur_extension_name = cur_cmd.ext_name
 
                         # Remove 'vk' from proto name
@@ -813,11 +937,16 @@ class LoaderExtensionOutputGenerator(OutputGenerator):
                         if cur_cmd.protect is not None:
                             tables += '#ifdef %s\n' % cur_cmd.protect
 
-                        tables += '    if (!strcmp(name, "%s")) return (void *)table->%s;\n' % (base_name, base_name)
+                        tables += '        case LOADER_COMMAND_%s:\n' % cur_cmd.name
+                        tables += '            return (void *)table->%s;\n' % base_name
 
                         if cur_cmd.protect is not None:
                             tables += '#endif // %s\n' % cur_cmd.protect
 
+            tables += '\n'
+            tables += '        default:\n'
+            tables += '            break;\n'
+            tables += '    }\n'
             tables += '\n'
             if x == 1:
                 tables += '    *found_name = false;\n'
@@ -1137,8 +1266,9 @@ class LoaderExtensionOutputGenerator(OutputGenerator):
         cur_extension_name = ''
 
         gpa_func += '// GPA helpers for extensions\n'
-        gpa_func += 'bool extension_instance_gpa(struct loader_instance *ptr_instance, const char *name, void **addr) {\n'
+        gpa_func += 'bool extension_instance_gpa(struct loader_instance *ptr_instance, enum loader_command_id command, void **addr) {\n'
         gpa_func += '    *addr = NULL;\n\n'
+        gpa_func += '    switch (command) {'
 
         for cur_cmd in self.ext_commands:
             if ('VK_VERSION_' in cur_cmd.ext_name or
@@ -1147,7 +1277,7 @@ class LoaderExtensionOutputGenerator(OutputGenerator):
                 continue
 
             if cur_cmd.ext_name != cur_extension_name:
-                gpa_func += '\n    // ---- %s extension commands\n' % cur_cmd.ext_name
+                gpa_func += '\n        // ---- %s extension commands\n' % cur_cmd.ext_name
                 cur_extension_name = cur_cmd.ext_name
 
             if cur_cmd.protect is not None:
@@ -1156,24 +1286,25 @@ class LoaderExtensionOutputGenerator(OutputGenerator):
             base_name = cur_cmd.name[2:]
 
             if (cur_cmd.ext_type == 'instance'):
-                gpa_func += '    if (!strcmp("%s", name)) {\n' % (cur_cmd.name)
-                gpa_func += '        *addr = (ptr_instance->enabled_known_extensions.'
+                gpa_func += '        case LOADER_COMMAND_%s:\n' % (cur_cmd.name)
+                gpa_func += '            *addr = (ptr_instance->enabled_known_extensions.'
                 gpa_func += cur_cmd.ext_name[3:].lower()
                 gpa_func += ' == 1)\n'
-                gpa_func += '                     ? (void *)%s\n' % (base_name)
-                gpa_func += '                     : NULL;\n'
-                gpa_func += '        return true;\n'
-                gpa_func += '    }\n'
+                gpa_func += '                        ? (void *)%s\n' % (base_name)
+                gpa_func += '                        : NULL;\n'
+                gpa_func += '            return true;\n'
             else:
-                gpa_func += '    if (!strcmp("%s", name)) {\n' % (cur_cmd.name)
-                gpa_func += '        *addr = (void *)%s;\n' % (base_name)
-                gpa_func += '        return true;\n'
-                gpa_func += '    }\n'
+                gpa_func += '        case LOADER_COMMAND_%s:\n' % (cur_cmd.name)
+                gpa_func += '            *addr = (void *)%s;\n' % (base_name)
+                gpa_func += '            return true;\n'
 
             if cur_cmd.protect is not None:
                 gpa_func += '#endif // %s\n' % cur_cmd.protect
 
-        gpa_func += '    return false;\n'
+        gpa_func += '\n'
+        gpa_func += '        default:\n'
+        gpa_func += '            return false;\n'
+        gpa_func += '    }\n'
         gpa_func += '}\n\n'
 
         return gpa_func
@@ -499,6 +499,7 @@ class VkTraceFileOutputGenerator(OutputGenerator):
         replay_funcptr_header  = '\n'
         replay_funcptr_header += 'struct vkFuncs {'
         replay_funcptr_header += '    void init_funcs(void * libHandle);'
+        replay_funcptr_header += '    void init_null_funcs();\n'
         replay_funcptr_header += '    void *m_libHandle;\n'
         cmd_member_dict = dict(self.cmdMembers)
         cmd_info_dict = dict(self.cmd_info_data)
@@ -519,6 +520,104 @@ class VkTraceFileOutputGenerator(OutputGenerator):
         replay_funcptr_header += '};\n'
         return replay_funcptr_header
     #
+    # Construct the generated part of the vkreplay null driver (see vkreplay_null_driver.h): a stub
+    # for every command that returns success and new handles, and vkFuncs::init_null_funcs()
+    def GenerateReplayNullDriver(self):
+        cmd_member_dict = dict(self.cmdMembers)
+        cmd_info_dict = dict(self.cmd_info_data)
+        cmd_protect_dict = dict(self.cmd_feature_protect)
+        struct_member_dict = dict((struct.name, struct.members) for struct in self.structMembers)
+        # Implemented in vkreplay_null_driver.cpp
+        null_driver_manual_funcs = ['vkEnumeratePhysicalDevices',
+                                    'vkGetPhysicalDeviceFeatures',
+                                    'vkGetPhysicalDeviceFormatProperties',
+                                    'vkGetPhysicalDeviceImageFormatProperties',
+                                    'vkGetPhysicalDeviceProperties',
+                                    'vkGetPhysicalDeviceQueueFamilyProperties',
+                                    'vkGetPhysicalDeviceMemoryProperties',
+                                    'vkAllocateMemory',
+                                    'vkFreeMemory',
+                                    'vkMapMemory',
+                                    'vkGetBufferMemoryRequirements',
+                                    'vkGetImageMemoryRequirements',
+                                    'vkCreateEvent',
+                                    'vkDestroyEvent',
+                                    'vkGetEventStatus',
+                                    'vkSetEvent',
+                                    'vkResetEvent',
+                                    'vkGetPhysicalDeviceSurfaceSupportKHR',
+                                    'vkGetPhysicalDeviceSurfaceCapabilitiesKHR',
+                                    'vkGetPhysicalDeviceSurfaceFormatsKHR',
+                                    'vkGetPhysicalDeviceSurfacePresentModesKHR',
+                                    'vkDestroySwapchainKHR',
+                                    'vkGetSwapchainImagesKHR',
+                                    ]
+        null_funcs = [api.name for api in self.cmdMembers if api.name not in temporary_script_porting_exclusions]
+        param_names = dict((name, [p.name for p in cmd_member_dict[name]]) for name in null_funcs)
+
+        # vkGet*ProcAddr return every other stub, so they are generated last
+        proc_addr_funcs = [name for name in null_funcs if cmd_info_dict[name].elem.find('proto/type').text == 'PFN_vkVoidFunction']
+        null_driver = ''
+        for cmdname in proc_addr_funcs:
+            null_driver += 'static %s\n' % self.makeCDecls(cmd_info_dict[cmdname].elem)[0].replace('VKAPI_CALL %s(' % cmdname, 'VKAPI_CALL null_%s(' % cmdname).rstrip()
+        for cmdname in [name for name in null_funcs if name not in proc_addr_funcs] + proc_addr_funcs:
+            if cmdname in null_driver_manual_funcs:
+                continue
+            cmdinfo = cmd_info_dict[cmdname]
+            # cmdMembers also lists implicitly synchronized parameters that aren't in the prototype
+            xml_param_names = [name.text for name in cmdinfo.elem.findall('param/name')]
+            params = [p for p in cmd_member_dict[cmdname] if p.name in xml_param_names]
+            protect = cmd_protect_dict[cmdname]
+            resulttype = cmdinfo.elem.find('proto/type').text
+            decl = self.makeCDecls(cmdinfo.elem)[0].replace('VKAPI_CALL %s(' % cmdname, 'VKAPI_CALL null_%s(' % cmdname)
+            if protect is not None:
+                null_driver += '#ifdef %s\n' % protect
+            null_driver += 'static %s {\n' % decl.rstrip().rstrip(';')
+            for p in params:
+                if not p.ispointer or p.isconst or p.type == 'void':
+                    continue
+                if p.iscount:
+                    null_driver += '    *%s = 0;\n' % p.name
+                elif p.type in self.object_types:
+                    if p.len is None:
+                        null_driver += '    if (%s != NULL) *%s = (%s)(uintptr_t)null_driver_new_handle();\n' % (p.name, p.name, p.type)
+                    elif '->' in p.len or (p.len in param_names[cmdname] and not next(q for q in params if q.name == p.len).ispointer):
+                        null_driver += '    for (uint32_t i = 0; i < %s; i++) %s[i] = (%s)(uintptr_t)null_driver_new_handle();\n' % (p.len, p.name, p.type)
+                elif p.len is None and p.type in struct_member_dict and 'sType' not in [m.name for m in struct_member_dict[p.type]]:
+                    null_driver += '    memset(%s, 0, sizeof(%s));\n' % (p.name, p.type)
+                elif p.len is None and p.type in ['uint32_t', 'uint64_t', 'size_t', 'VkBool32', 'VkDeviceSize'] and p.cdecl.count('*') == 1:
+                    null_driver += '    *%s = 0;\n' % p.name
+            if resulttype == 'VkResult':
+                null_driver += '    return VK_SUCCESS;\n'
+            elif resulttype == 'VkBool32':
+                null_driver += '    return VK_TRUE;\n'
+            elif resulttype == 'PFN_vkVoidFunction':
+                for name in null_funcs:
+                    name_protect = cmd_protect_dict[name]
+                    if name_protect is not None:
+                        null_driver += '#ifdef %s\n' % name_protect
+                    null_driver += '    if (strcmp(%s, "%s") == 0) return (PFN_vkVoidFunction)null_%s;\n' % (params[-1].name, name, name)
+                    if name_protect is not None:
+                        null_driver += '#endif // %s\n' % name_protect
+                null_driver += '    return NULL;\n'
+            elif resulttype != 'void':
+                null_driver += '    return 0;\n'
+            null_driver += '}\n'
+            if protect is not None:
+                null_driver += '#endif // %s\n' % protect
+        null_driver += '\n'
+        null_driver += 'void vkFuncs::init_null_funcs() {\n'
+        null_driver += '    m_libHandle = NULL;\n'
+        for cmdname in null_funcs:
+            protect = cmd_protect_dict[cmdname]
+            if protect is not None:
+                null_driver += '#ifdef %s\n' % protect
+            null_driver += '    real_%s = null_%s;\n' % (cmdname, cmdname)
+            if protect is not None:
+                null_driver += '#endif // %s\n' % protect
+        null_driver += '}\n\n'
+        return null_driver
+    #
     # Construct vkreplay replay gen source file
     def GenerateReplayGenSource(self):
         cmd_member_dict = dict(self.cmdMembers)
@@ -601,6 +700,7 @@ class VkTraceFileOutputGenerator(OutputGenerator):
         replay_gen_source += '#include "vkreplay_main.h"\n'
         replay_gen_source += '#include <algorithm>\n'
         replay_gen_source += '#include <queue>\n'
+        replay_gen_source += '#include "vkreplay_null_driver.h"\n'
         replay_gen_source += '\n'
         replay_gen_source += 'extern "C" {\n'
         replay_gen_source += '#include "vktrace_vk_vk_packets.h"\n'
@@ -623,6 +723,7 @@ class VkTraceFileOutputGenerator(OutputGenerator):
             if protect is not None:
                 replay_gen_source += '#endif // %s\n' % protect
         replay_gen_source += '}\n\n'
+        replay_gen_source += self.GenerateReplayNullDriver()
         replay_gen_source += 'vktrace_replay::VKTRACE_REPLAY_RESULT vkReplay::replay(vktrace_trace_packet_header *packet) { \n'
         replay_gen_source += '    vktrace_replay::VKTRACE_REPLAY_RESULT returnValue = vktrace_replay::VKTRACE_REPLAY_SUCCESS;\n'
         replay_gen_source += '    VkResult replayResult = VK_ERROR_VALIDATION_FAILED_EXT;\n'
@@ -742,6 +843,10 @@ class VkTraceFileOutputGenerator(OutputGenerator):
                     replay_gen_source += '            if (m_vkFuncs.real_vkDestroyDebugReportCallbackEXT != NULL) {\n'
                     replay_gen_source += '                m_vkFuncs.real_vkDestroyDebugReportCallbackEXT(remappedinstance, m_dbgMsgCallbackObj, pPacket->pAllocator);\n'
                     replay_gen_source += '            }\n'
+                elif cmdname == 'DestroyDevice':
+                    replay_gen_source += '            if (m_pGpuFrameTimer != NULL) m_pGpuFrameTimer->destroy_device(remappeddevice);\n'
+                    replay_gen_source += '            if (m_pPipelineCacheFile != NULL) m_pPipelineCacheFile->destroy_device(remappeddevice);\n'
+                    replay_gen_source += '            if (m_pMemoryAllocator != NULL) m_pMemoryAllocator->destroy_device(remappeddevice);\n'
                 # TODO: need a better way to indicate which extensions should be mapped to which Get*ProcAddr
                 elif cmdname == 'GetInstanceProcAddr':
                     for command in self.cmdMembers:
@@ -755,7 +860,7 @@ class VkTraceFileOutputGenerator(OutputGenerator):
                                 replay_gen_source += '#ifdef %s\n' % gipa_protect
                             if (gipa_params[0].type == 'VkInstance'):
                                 replay_gen_source += '            if (strcmp(pPacket->pName, "%s") == 0) {\n' % (command.name)
-                                replay_gen_source += '               m_vkFuncs.real_%s = (PFN_%s)vk%s(remappedinstance, pPacket->pName);\n' % (command.name, command.name, cmdname)
+                                replay_gen_source += '               m_vkFuncs.real_%s = (PFN_%s)m_vkFuncs.real_vk%s(remappedinstance, pPacket->pName);\n' % (command.name, command.name, cmdname)
                                 replay_gen_source += '            }\n'
                             if gipa_protect is not None:
                                 replay_gen_source += '#endif // %s\n' % gipa_protect
@@ -771,7 +876,7 @@ class VkTraceFileOutputGenerator(OutputGenerator):
                                 replay_gen_source += '#ifdef %s\n' % gdpa_protect
                             if gdpa_params[0].type != 'VkInstance' and gdpa_params[0].type != 'VkPhysicalDevice':
                                 replay_gen_source += '            if (strcmp(pPacket->pName, "%s") == 0) {\n' % (command.name)
-                                replay_gen_source += '               m_vkFuncs.real_%s = (PFN_%s)vk%s(remappeddevice, pPacket->pName);\n' % (command.name, command.name, cmdname)
+                                replay_gen_source += '               m_vkFuncs.real_%s = (PFN_%s)m_vkFuncs.real_vk%s(remappeddevice, pPacket->pName);\n' % (command.name, command.name, cmdname)
                                 replay_gen_source += '            }\n'
                             if gdpa_protect is not None:
                                 replay_gen_source += '#endif // %s\n' % gdpa_protect
@@ -870,6 +975,8 @@ class VkTraceFileOutputGenerator(OutputGenerator):
                         replay_gen_source += '            if (replayResult == VK_SUCCESS) {\n'
                     clean_type = params[-1].type.strip('*').replace('const ', '')
                     replay_gen_source += '                m_objMapper.add_to_%ss_map(*(pPacket->%s), local_%s);\n' % (clean_type.lower()[2:], params[-1].name, params[-1].name)
+                    if 'GetDeviceQueue' == cmdname:
+                        replay_gen_source += '                if (m_pGpuFrameTimer != NULL) add_gpu_frame_timer_queue(remappeddevice, pPacket->queueFamilyIndex, local_pQueue);\n'
                     if 'AllocateMemory' == cmdname:
                         replay_gen_source += '                m_objMapper.add_entry_to_mapData(local_%s, pPacket->pAllocateInfo->allocationSize);\n' % (params[-1].name)
                     if ret_value:
@@ -896,6 +1003,9 @@ class VkTraceFileOutputGenerator(OutputGenerator):
     # Parameter remapping utility function
     def RemapPacketParam(self, funcName, param, lastName):
         param_exclude_list = ['pDescriptorSets', 'pFences']
+        # Sub-allocated memory starts at an offset in its replay memory
+        if funcName in ['BindBufferMemory', 'BindImageMemory'] and param.name == 'memoryOffset':
+            return '            VkDeviceSize remappedmemoryOffset = pPacket->memoryOffset + replay_memory_offset(pPacket->memory);\n'
         cleanParamType = param.type.strip('*').replace('const ', '')
         for obj in self.object_types:
             if obj == cleanParamType and param.name not in param_exclude_list:
@@ -940,6 +1050,8 @@ class VkTraceFileOutputGenerator(OutputGenerator):
     def GetPacketParam(self, funcName, paramType, paramName):
         # List of types that require remapping
         param_exclude_list = ['pDescriptorSets', 'pFences']
+        if funcName in ['BindBufferMemory', 'BindImageMemory'] and paramName == 'memoryOffset':
+            return 'remappedmemoryOffset'
         cleanParamType = paramType.strip('*').replace('const ', '')
         for obj in self.object_types:
             if obj == cleanParamType and paramName not in param_exclude_list:
@@ -959,7 +1071,7 @@ class VkTraceFileOutputGenerator(OutputGenerator):
         cb_body.append('                    break;')
         cb_body.append('                }')
         cb_body.append('                VkFlags reportFlags = VK_DEBUG_REPORT_INFORMATION_BIT_EXT | VK_DEBUG_REPORT_WARNING_BIT_EXT | VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT | VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_DEBUG_BIT_EXT;')
-        cb_body.append('                PFN_vkCreateDebugReportCallbackEXT callback = (PFN_vkCreateDebugReportCallbackEXT)vkGetInstanceProcAddr(remappedInstance, "vkCreateDebugReportCallbackEXT");')
+        cb_body.append('                PFN_vkCreateDebugReportCallbackEXT callback = (PFN_vkCreateDebugReportCallbackEXT)m_vkFuncs.real_vkGetInstanceProcAddr(remappedInstance, "vkCreateDebugReportCallbackEXT");')
         cb_body.append('                if (callback != NULL) {')
         cb_body.append('                    VkDebugReportCallbackCreateInfoEXT dbgCreateInfo;')
         cb_body.append('                    memset(&dbgCreateInfo, 0, sizeof(dbgCreateInfo));')
@@ -1063,6 +1175,29 @@ class VkTraceFileOutputGenerator(OutputGenerator):
         trace_pkt_id_hdr += '}\n'
         trace_pkt_id_hdr += '\n'
         #
+        # Construct packet id name helper function that also covers the tracer-level packets
+        tracer_packet_names = [('VKTRACE_TPI_MESSAGE', 'message'),
+                               ('VKTRACE_TPI_MARKER_CHECKPOINT', 'marker_checkpoint'),
+                               ('VKTRACE_TPI_MARKER_API_BOUNDARY', 'marker_api_boundary'),
+                               ('VKTRACE_TPI_MARKER_API_GROUP_BEGIN', 'marker_api_group_begin'),
+                               ('VKTRACE_TPI_MARKER_API_GROUP_END', 'marker_api_group_end'),
+                               ('VKTRACE_TPI_MARKER_TERMINATE_PROCESS', 'marker_terminate_process'),
+                               ('VKTRACE_TPI_PORTABILITY_TABLE', 'portability_table'),
+                               ('VKTRACE_TPI_BLOB', 'blob')]
+        trace_pkt_id_hdr += '// Name of any packet id, tracer-level or Vulkan entrypoint; "unknown" if the id is neither\n'
+        trace_pkt_id_hdr += 'static const char *vktrace_packet_id_name(const uint16_t packet_id) {\n'
+        trace_pkt_id_hdr += '    switch(packet_id) {\n'
+        for tracer_id, name in tracer_packet_names:
+            trace_pkt_id_hdr += '        case %s:\n' % tracer_id
+            trace_pkt_id_hdr += '            return "%s";\n' % name
+        trace_pkt_id_hdr += '        default: {\n'
+        trace_pkt_id_hdr += '            const char *pName = vktrace_vk_packet_id_name((VKTRACE_TRACE_PACKET_ID_VK)packet_id);\n'
+        trace_pkt_id_hdr += '            return (pName != NULL) ? pName : "unknown";\n'
+        trace_pkt_id_hdr += '        }\n'
+        trace_pkt_id_hdr += '    }\n'
+        trace_pkt_id_hdr += '}\n'
+        trace_pkt_id_hdr += '\n'
+        #
         # Construct packet id stringify helper function
         trace_pkt_id_hdr += 'static const char *vktrace_stringify_vk_packet_id(const VKTRACE_TRACE_PACKET_ID_VK id, const vktrace_trace_packet_header* pHeader) {\n'
         trace_pkt_id_hdr += '    static char str[1024];\n'
@@ -1344,7 +1479,7 @@ class VkTraceFileOutputGenerator(OutputGenerator):
                                                         'finalize_txt': 'vktrace_finalize_buffer_address(pHeader, (void**)&(pPacket->pCreateInfo->pQueueFamilyIndices));\n'
                                                                         '    vktrace_finalize_buffer_address(pHeader, (void**)&(pPacket->pCreateInfo))'},
                            'VkShaderModuleCreateInfo': {'add_txt':      'vktrace_add_buffer_to_trace_packet(pHeader, (void**)&(pPacket->pCreateInfo), sizeof(VkShaderModuleCreateInfo), pCreateInfo);\n'
-                                                                        '    vktrace_add_buffer_to_trace_packet(pHeader, (void**)&(pPacket->pCreateInfo->pCode), pPacket->pCreateInfo->codeSize, pCreateInfo->pCode)',
+                                                                        '    vktrace_add_blob_to_trace_packet(pHeader, (void**)&(pPacket->pCreateInfo->pCode), pPacket->pCreateInfo->codeSize, pCreateInfo->pCode)',
                                                         'finalize_txt': 'vktrace_finalize_buffer_address(pHeader, (void**)&(pPacket->pCreateInfo->pCode));\n'
                                                                         '    vktrace_finalize_buffer_address(pHeader, (void**)&(pPacket->pCreateInfo))'},
                           }
@@ -1358,6 +1493,9 @@ class VkTraceFileOutputGenerator(OutputGenerator):
                         multiplier = ' * sizeof(%s)' % p.type
                     if p.len[0] == 'p': # Count parameter is itself a pointer
                         pp_dict['add_txt'] = 'vktrace_add_buffer_to_trace_packet(pHeader, (void**)&(pPacket->%s), (*%s)%s, %s)' % (p.name, p.len, multiplier, p.name)
+                    elif p.type == 'void' and p.name == 'pData' and p.len == 'dataSize' and params[0].type == 'VkCommandBuffer':
+                        # vkCmdUpdateBuffer payloads are opaque, so they can be stored as deduplicated blobs
+                        pp_dict['add_txt'] = 'vktrace_add_blob_to_trace_packet(pHeader, (void**)&(pPacket->%s), %s, %s)' % (p.name, p.len, p.name)
                     else:
                         pp_dict['add_txt'] = 'vktrace_add_buffer_to_trace_packet(pHeader, (void**)&(pPacket->%s), %s%s, %s)' % (p.name, p.len, multiplier, p.name)
                 elif p.type in custom_ptr_dict:
@@ -2163,6 +2301,10 @@ class VkTraceFileOutputGenerator(OutputGenerator):
         trace_vk_src += '    vktrace_tracelog_set_tracer_id(VKTRACE_TID_VULKAN);\n'
         trace_vk_src += '    trim::initialize();\n'
         trace_vk_src += '    vktrace_initialize_trace_packet_utils();\n'
+        trace_vk_src += '    if (!g_trimEnabled) {\n'
+        trace_vk_src += '        // Trim reorders and drops packets, so blob packets could end up missing or after their first reference\n'
+        trace_vk_src += '        vktrace_trace_packet_init_blob_dedup();\n'
+        trace_vk_src += '    }\n'
         trace_vk_src += '    vktrace_create_critical_section(&g_memInfoLock);\n'
         trace_vk_src += '#ifdef WIN32\n'
         trace_vk_src += '    return true;\n}\n'
@@ -0,0 +1,421 @@
+/*
+ * Copyright (c) 2018 The Khronos Group Inc.
+ * Copyright (c) 2018 Valve Corporation
+ * Copyright (c) 2018 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Loader micro-benchmarks.
+//
+//   vk_loader_benchmark [iterations]
+//   vk_loader_benchmark --startup [max_count] [iterations]
+//   vk_loader_benchmark --cold-start [driver_count] [delay_ms] [iterations]
+//
+// The proc address benchmark runs against whichever driver the loader finds. It resolves every
+// command a layer's dispatch table init resolves, the way engines and layers do at startup, and
+// reports lookups per second for vkGetInstanceProcAddr and vkGetDeviceProcAddr.
+//
+// The startup benchmark needs no driver. It writes N driver and N layer manifests to a temporary
+// directory, with copies of the benchmark driver and of the test layer as their libraries,
+// and points VK_ICD_FILENAMES and VK_LAYER_PATH at them. For N = 1, 2, 4, ... max_count it reports
+// the median and 95th percentile latency of the calls an application makes at startup, and the
+// vkGetInstanceProcAddr throughput of an instance with all N layers enabled. Time per call should
+// grow linearly with N; faster growth means a scan has become quadratic. On that instance it also
+// reports how many times per second the physical devices can be enumerated again, with a count
+// query and a fill query each time, and the latency of vkRefreshPhysicalDevicesLUNARG, which
+// queries the layers and drivers again. The test layer prints a line
+// for each instance it sees, which "grep -v VK_LAYER_LUNARG_test" leaves out.
+//
+// The cold start benchmark writes driver_count driver manifests the same way, and has every driver
+// sleep delay_ms milliseconds while the loader negotiates with it, like real drivers that take time
+// to initialize. Every vkEnumerateInstanceExtensionProperties and vkCreateInstance loads and
+// negotiates with all the drivers again, so their latency shows how much of the driver_count *
+// delay_ms it would take to probe the drivers one by one is spent waiting.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#include <vulkan/vulkan.h>
+#include "vk_dispatch_table_helper.h"
+
+namespace {
+
+std::vector<const char *> instance_command_names;
+std::vector<const char *> device_command_names;
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL RecordInstanceCommandName(VkInstance, const char *pName) {
+    instance_command_names.push_back(pName);
+    return nullptr;
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL RecordDeviceCommandName(VkDevice, const char *pName) {
+    device_command_names.push_back(pName);
+    return nullptr;
+}
+
+template <typename Handle, typename GetProcAddr>
+void BenchmarkProcAddr(const char *label, GetProcAddr get_proc_addr, Handle handle, const std::vector<const char *> &names,
+                       unsigned iterations) {
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < iterations; i++) {
+        for (const char *name : names) {
+            if (get_proc_addr(handle, name) != nullptr) found++;
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    double lookups = static_cast<double>(names.size()) * iterations;
+    printf("%-24s %6zu names %12.0f lookups/s %8.1f ns/lookup %6zu found\n", label, names.size(), lookups / elapsed.count(),
+           elapsed.count() * 1e9 / lookups, found / iterations);
+}
+
+int BenchmarkProcAddrs(unsigned iterations) {
+    VkLayerInstanceDispatchTable instance_table;
+    VkLayerDispatchTable device_table;
+    layer_init_instance_dispatch_table(VK_NULL_HANDLE, &instance_table, RecordInstanceCommandName);
+    layer_init_device_dispatch_table(VK_NULL_HANDLE, &device_table, RecordDeviceCommandName);
+
+    VkInstanceCreateInfo instance_info = {};
+    instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    VkInstance instance;
+    if (vkCreateInstance(&instance_info, nullptr, &instance) != VK_SUCCESS) {
+        fprintf(stderr, "vkCreateInstance failed\n");
+        return 1;
+    }
+
+    uint32_t gpu_count = 1;
+    VkPhysicalDevice gpu;
+    VkResult result = vkEnumeratePhysicalDevices(instance, &gpu_count, &gpu);
+    if ((result != VK_SUCCESS && result != VK_INCOMPLETE) || gpu_count == 0) {
+        fprintf(stderr, "No physical device found\n");
+        vkDestroyInstance(instance, nullptr);
+        return 1;
+    }
+
+    float priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_info = {};
+    queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_info.queueCount = 1;
+    queue_info.pQueuePriorities = &priority;
+    VkDeviceCreateInfo device_info = {};
+    device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    device_info.queueCreateInfoCount = 1;
+    device_info.pQueueCreateInfos = &queue_info;
+    VkDevice device;
+    if (vkCreateDevice(gpu, &device_info, nullptr, &device) != VK_SUCCESS) {
+        fprintf(stderr, "vkCreateDevice failed\n");
+        vkDestroyInstance(instance, nullptr);
+        return 1;
+    }
+
+    std::vector<const char *> all_command_names(instance_command_names);
+    all_command_names.insert(all_command_names.end(), device_command_names.begin(), device_command_names.end());
+
+    BenchmarkProcAddr("vkGetInstanceProcAddr", vkGetInstanceProcAddr, instance, all_command_names, iterations);
+    BenchmarkProcAddr("vkGetDeviceProcAddr", vkGetDeviceProcAddr, device, device_command_names, iterations);
+
+    vkDestroyDevice(device, nullptr);
+    vkDestroyInstance(instance, nullptr);
+    return 0;
+}
+
+#if !defined(_WIN32)
+
+// Times one call of a startup command, and keeps the times of all its calls
+class StartupTimer {
+   public:
+    template <typename Call>
+    void Time(Call call) {
+        auto start = std::chrono::steady_clock::now();
+        call();
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        times_.push_back(elapsed.count());
+    }
+
+    // Median and 95th percentile of the times, in microseconds
+    std::string Summary() {
+        if (times_.empty()) return "-";
+        std::sort(times_.begin(), times_.end());
+        char summary[64];
+        snprintf(summary, sizeof(summary), "%.0f/%.0f", times_[times_.size() / 2], times_[(times_.size() * 95) / 100]);
+        return summary;
+    }
+
+   private:
+    std::vector<double> times_;
+};
+
+bool CopyFile(const std::string &from, const std::string &to) {
+    std::ifstream in(from, std::ios::binary);
+    std::ofstream out(to, std::ios::binary);
+    out << in.rdbuf();
+    return in.good() && out.good();
+}
+
+bool WriteFile(const std::string &path, const std::string &contents) {
+    std::ofstream out(path);
+    out << contents;
+    return out.good();
+}
+
+// The driver and layer manifests and libraries of one benchmark run
+class StartupEnvironment {
+   public:
+    ~StartupEnvironment() {
+        for (auto it = paths_.rbegin(); it != paths_.rend(); ++it) {
+            remove(it->c_str());
+        }
+    }
+
+    bool Create(unsigned max_count) {
+        const char *tmp = getenv("TMPDIR");
+        std::string dir_template = std::string(tmp ? tmp : "/tmp") + "/vk_loader_benchmark_XXXXXX";
+        std::vector<char> dir(dir_template.begin(), dir_template.end());
+        dir.push_back('\0');
+        if (mkdtemp(dir.data()) == nullptr) return false;
+        dir_ = dir.data();
+        paths_.push_back(dir_);
+
+        // Every library is a copy, so each one is loaded the way a different driver or layer would be
+        for (unsigned i = 0; i < max_count; i++) {
+            std::string icd_library = dir_ + "/libVkICD_loader_benchmark_" + std::to_string(i) + ".so";
+            std::string layer_library = dir_ + "/libVkLayer_loader_benchmark_" + std::to_string(i) + ".so";
+            paths_.push_back(icd_library);
+            paths_.push_back(layer_library);
+            if (!CopyFile(LOADER_BENCHMARK_ICD_LIBRARY, icd_library) || !CopyFile(LOADER_BENCHMARK_LAYER_LIBRARY, layer_library)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Point the loader at the first count drivers and layers
+    bool Select(unsigned count) {
+        std::string count_dir = dir_ + "/" + std::to_string(count);
+        std::string layer_dir = count_dir + "/layers";
+        paths_.push_back(count_dir);
+        paths_.push_back(layer_dir);
+        if (mkdir(count_dir.c_str(), 0700) != 0 || mkdir(layer_dir.c_str(), 0700) != 0) return false;
+
+        std::string icd_filenames;
+        layer_names_.clear();
+        for (unsigned i = 0; i < count; i++) {
+            std::string index = std::to_string(i);
+            std::string icd_manifest = count_dir + "/VkICD_loader_benchmark_" + index + ".json";
+            paths_.push_back(icd_manifest);
+            if (!WriteFile(icd_manifest, "{\"file_format_version\": \"1.0.0\", \"ICD\": {\"library_path\": \"" + dir_ +
+                                             "/libVkICD_loader_benchmark_" + index + ".so\", \"api_version\": \"1.0.51\"}}\n")) {
+                return false;
+            }
+            icd_filenames += (i == 0 ? "" : ":") + icd_manifest;
+
+            std::string layer_name = "VK_LAYER_LUNARG_loader_benchmark_" + index;
+            std::string layer_manifest = layer_dir + "/VkLayer_loader_benchmark_" + index + ".json";
+            paths_.push_back(layer_manifest);
+            if (!WriteFile(layer_manifest, "{\"file_format_version\": \"1.0.0\", \"layer\": {\"name\": \"" + layer_name +
+                                               "\", \"type\": \"GLOBAL\", \"library_path\": \"" + dir_ +
+                                               "/libVkLayer_loader_benchmark_" + index +
+                                               ".so\", \"api_version\": \"1.0.51\", \"implementation_version\": \"1\", "
+                                               "\"description\": \"Loader benchmark layer\"}}\n")) {
+                return false;
+            }
+            layer_names_.push_back(layer_name);
+        }
+
+        setenv("VK_ICD_FILENAMES", icd_filenames.c_str(), 1);
+        setenv("VK_LAYER_PATH", layer_dir.c_str(), 1);
+        return true;
+    }
+
+    const std::vector<std::string> &LayerNames() const { return layer_names_; }
+
+   private:
+    std::string dir_;
+    std::vector<std::string> paths_;  // in creation order
+    std::vector<std::string> layer_names_;
+};
+
+int BenchmarkStartup(unsigned max_count, unsigned iterations) {
+    StartupEnvironment environment;
+    if (!environment.Create(max_count)) {
+        fprintf(stderr, "Failed to write the benchmark drivers and layers\n");
+        return 1;
+    }
+
+    // Record the instance commands to look up, without a driver
+    VkLayerInstanceDispatchTable instance_table;
+    layer_init_instance_dispatch_table(VK_NULL_HANDLE, &instance_table, RecordInstanceCommandName);
+
+    printf("Median/95th percentile microseconds per call, %u calls each\n", iterations);
+    printf("%5s %12s %12s %12s %12s %12s %12s %16s %16s\n", "N", "EnumExts", "EnumLayers", "Create", "CreateLayers",
+           "EnumPhysDevs", "Refresh", "GIPA lookups/s", "Re-enums/s");
+    for (unsigned count = 1; count <= max_count; count *= 2) {
+        if (!environment.Select(count)) {
+            fprintf(stderr, "Failed to write the benchmark manifests\n");
+            return 1;
+        }
+        std::vector<const char *> layer_names;
+        for (const auto &name : environment.LayerNames()) layer_names.push_back(name.c_str());
+
+        StartupTimer enumerate_extensions, enumerate_layers, create, create_layers, enumerate_physical_devices, refresh;
+        double lookups_per_second = 0;
+        double enumerations_per_second = 0;
+        for (unsigned i = 0; i < iterations; i++) {
+            uint32_t property_count = 0;
+            enumerate_extensions.Time([&] { vkEnumerateInstanceExtensionProperties(nullptr, &property_count, nullptr); });
+            enumerate_layers.Time([&] { vkEnumerateInstanceLayerProperties(&property_count, nullptr); });
+
+            VkInstanceCreateInfo instance_info = {};
+            instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+            VkInstance instance = VK_NULL_HANDLE;
+            VkResult result;
+            create.Time([&] { result = vkCreateInstance(&instance_info, nullptr, &instance); });
+            if (result != VK_SUCCESS) {
+                fprintf(stderr, "vkCreateInstance failed with %u drivers\n", count);
+                return 1;
+            }
+            uint32_t gpu_count = 0;
+            enumerate_physical_devices.Time([&] { vkEnumeratePhysicalDevices(instance, &gpu_count, nullptr); });
+            if (gpu_count != count) {
+                fprintf(stderr, "Found %u physical devices with %u drivers\n", gpu_count, count);
+                vkDestroyInstance(instance, nullptr);
+                return 1;
+            }
+            vkDestroyInstance(instance, nullptr);
+
+            instance_info.enabledLayerCount = static_cast<uint32_t>(layer_names.size());
+            instance_info.ppEnabledLayerNames = layer_names.data();
+            create_layers.Time([&] { result = vkCreateInstance(&instance_info, nullptr, &instance); });
+            if (result != VK_SUCCESS) {
+                fprintf(stderr, "vkCreateInstance failed with %u layers\n", count);
+                return 1;
+            }
+            std::vector<VkPhysicalDevice> physical_devices(count);
+            gpu_count = count;
+            vkEnumeratePhysicalDevices(instance, &gpu_count, physical_devices.data());
+            auto refresh_physical_devices = reinterpret_cast<VkResult(VKAPI_PTR *)(VkInstance)>(
+                vkGetInstanceProcAddr(instance, "vkRefreshPhysicalDevicesLUNARG"));
+            if (refresh_physical_devices != nullptr) {
+                refresh.Time([&] { refresh_physical_devices(instance); });
+            }
+            if (i == iterations - 1) {
+                const unsigned rounds = 100;
+                auto start = std::chrono::steady_clock::now();
+                for (unsigned round = 0; round < rounds; round++) {
+                    for (const char *name : instance_command_names) vkGetInstanceProcAddr(instance, name);
+                }
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                lookups_per_second = static_cast<double>(instance_command_names.size()) * rounds / elapsed.count();
+
+                const unsigned enumerations = 10000;
+                start = std::chrono::steady_clock::now();
+                for (unsigned enumeration = 0; enumeration < enumerations; enumeration++) {
+                    vkEnumeratePhysicalDevices(instance, &gpu_count, nullptr);
+                    vkEnumeratePhysicalDevices(instance, &gpu_count, physical_devices.data());
+                }
+                elapsed = std::chrono::steady_clock::now() - start;
+                enumerations_per_second = enumerations / elapsed.count();
+            }
+            vkDestroyInstance(instance, nullptr);
+        }
+
+        printf("%5u %12s %12s %12s %12s %12s %12s %16.0f %16.0f\n", count, enumerate_extensions.Summary().c_str(),
+               enumerate_layers.Summary().c_str(), create.Summary().c_str(), create_layers.Summary().c_str(),
+               enumerate_physical_devices.Summary().c_str(), refresh.Summary().c_str(), lookups_per_second,
+               enumerations_per_second);
+    }
+    return 0;
+}
+
+int BenchmarkColdStart(unsigned driver_count, unsigned delay_ms, unsigned iterations) {
+    StartupEnvironment environment;
+    if (!environment.Create(driver_count) || !environment.Select(driver_count)) {
+        fprintf(stderr, "Failed to write the benchmark drivers\n");
+        return 1;
+    }
+    setenv("VK_LOADER_BENCHMARK_ICD_DELAY_MS", std::to_string(delay_ms).c_str(), 1);
+
+    StartupTimer enumerate_extensions, create;
+    for (unsigned i = 0; i < iterations; i++) {
+        uint32_t property_count = 0;
+        enumerate_extensions.Time([&] { vkEnumerateInstanceExtensionProperties(nullptr, &property_count, nullptr); });
+
+        VkInstanceCreateInfo instance_info = {};
+        instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        VkInstance instance = VK_NULL_HANDLE;
+        VkResult result;
+        create.Time([&] { result = vkCreateInstance(&instance_info, nullptr, &instance); });
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "vkCreateInstance failed with %u drivers\n", driver_count);
+            return 1;
+        }
+        vkDestroyInstance(instance, nullptr);
+    }
+    unsetenv("VK_LOADER_BENCHMARK_ICD_DELAY_MS");
+
+    printf("Median/95th percentile microseconds per call, %u calls each\n", iterations);
+    printf("%5s %8s %12s %12s %12s\n", "N", "Delay", "Serial", "EnumExts", "Create");
+    printf("%5u %8u %12u %12s %12s\n", driver_count, delay_ms * 1000, driver_count * delay_ms * 1000,
+           enumerate_extensions.Summary().c_str(), create.Summary().c_str());
+    return 0;
+}
+
+#endif  // !defined(_WIN32)
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--startup") == 0) {
+#if defined(_WIN32)
+        fprintf(stderr, "The startup benchmark is not supported on Windows\n");
+        return 1;
+#else
+        unsigned max_count = argc > 2 ? static_cast<unsigned>(atoi(argv[2])) : 64;
+        unsigned iterations = argc > 3 ? static_cast<unsigned>(atoi(argv[3])) : 20;
+        if (max_count == 0) max_count = 1;
+        if (iterations == 0) iterations = 1;
+        return BenchmarkStartup(max_count, iterations);
+#endif
+    }
+    if (argc > 1 && strcmp(argv[1], "--cold-start") == 0) {
+#if defined(_WIN32)
+        fprintf(stderr, "The cold start benchmark is not supported on Windows\n");
+        return 1;
+#else
+        unsigned driver_count = argc > 2 ? static_cast<unsigned>(atoi(argv[2])) : 8;
+        unsigned delay_ms = argc > 3 ? static_cast<unsigned>(atoi(argv[3])) : 20;
+        unsigned iterations = argc > 4 ? static_cast<unsigned>(atoi(argv[4])) : 10;
+        if (driver_count == 0) driver_count = 1;
+        if (iterations == 0) iterations = 1;
+        return BenchmarkColdStart(driver_count, delay_ms, iterations);
+#endif
+    }
+
+    unsigned iterations = argc > 1 ? static_cast<unsigned>(atoi(argv[1])) : 1000;
+    if (iterations == 0) iterations = 1;
+    return BenchmarkProcAddrs(iterations);
+}
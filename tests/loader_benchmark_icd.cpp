@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2018 The Khronos Group Inc.
+ * Copyright (c) 2018 Valve Corporation
+ * Copyright (c) 2018 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A driver that does nothing, for the loader startup benchmark. It reports one physical device and
+// implements the instance commands the loader requires of a driver, with just enough behind them for
+// instances to be created and physical devices to be queried. It can't create devices.
+//
+// When VK_LOADER_BENCHMARK_ICD_DELAY_MS is set, it sleeps that many milliseconds each time the loader
+// negotiates its interface version, to stand in for the initialization time of a real driver.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+
+#include <vulkan/vulkan.h>
+#include <vulkan/vk_icd.h>
+
+#if defined(_WIN32)
+#define BENCHMARK_ICD_EXPORT __declspec(dllexport)
+#else
+#define BENCHMARK_ICD_EXPORT __attribute__((visibility("default")))
+#endif
+
+namespace {
+
+struct DispatchableObject {
+    VK_LOADER_DATA loader_data;
+};
+
+DispatchableObject physical_device;
+
+VKAPI_ATTR VkResult VKAPI_CALL CreateInstance(const VkInstanceCreateInfo *, const VkAllocationCallbacks *, VkInstance *pInstance) {
+    DispatchableObject *instance = new DispatchableObject;
+    set_loader_magic_value(instance);
+    *pInstance = reinterpret_cast<VkInstance>(instance);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL DestroyInstance(VkInstance instance, const VkAllocationCallbacks *) {
+    delete reinterpret_cast<DispatchableObject *>(instance);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL EnumerateInstanceExtensionProperties(const char *, uint32_t *pPropertyCount,
+                                                                    VkExtensionProperties *) {
+    *pPropertyCount = 0;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL EnumerateDeviceExtensionProperties(VkPhysicalDevice, const char *, uint32_t *pPropertyCount,
+                                                                  VkExtensionProperties *) {
+    *pPropertyCount = 0;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL EnumeratePhysicalDevices(VkInstance, uint32_t *pPhysicalDeviceCount,
+                                                        VkPhysicalDevice *pPhysicalDevices) {
+    if (pPhysicalDevices == nullptr) {
+        *pPhysicalDeviceCount = 1;
+        return VK_SUCCESS;
+    }
+    if (*pPhysicalDeviceCount == 0) {
+        return VK_INCOMPLETE;
+    }
+    set_loader_magic_value(&physical_device);
+    pPhysicalDevices[0] = reinterpret_cast<VkPhysicalDevice>(&physical_device);
+    *pPhysicalDeviceCount = 1;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceProperties(VkPhysicalDevice, VkPhysicalDeviceProperties *pProperties) {
+    memset(pProperties, 0, sizeof(*pProperties));
+    pProperties->apiVersion = VK_API_VERSION_1_0;
+    pProperties->deviceType = VK_PHYSICAL_DEVICE_TYPE_CPU;
+    strcpy(pProperties->deviceName, "Loader benchmark device");
+}
+
+VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice, uint32_t *pQueueFamilyPropertyCount,
+                                                                  VkQueueFamilyProperties *pQueueFamilyProperties) {
+    if (pQueueFamilyProperties != nullptr && *pQueueFamilyPropertyCount > 0) {
+        memset(pQueueFamilyProperties, 0, sizeof(*pQueueFamilyProperties));
+        pQueueFamilyProperties->queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+        pQueueFamilyProperties->queueCount = 1;
+    }
+    *pQueueFamilyPropertyCount = 1;
+}
+
+VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceFeatures(VkPhysicalDevice, VkPhysicalDeviceFeatures *pFeatures) {
+    memset(pFeatures, 0, sizeof(*pFeatures));
+}
+
+VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceFormatProperties(VkPhysicalDevice, VkFormat, VkFormatProperties *pFormatProperties) {
+    memset(pFormatProperties, 0, sizeof(*pFormatProperties));
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL GetPhysicalDeviceImageFormatProperties(VkPhysicalDevice, VkFormat, VkImageType, VkImageTiling,
+                                                                      VkImageUsageFlags, VkImageCreateFlags,
+                                                                      VkImageFormatProperties *) {
+    return VK_ERROR_FORMAT_NOT_SUPPORTED;
+}
+
+VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceSparseImageFormatProperties(VkPhysicalDevice, VkFormat, VkImageType,
+                                                                        VkSampleCountFlagBits, VkImageUsageFlags, VkImageTiling,
+                                                                        uint32_t *pPropertyCount, VkSparseImageFormatProperties *) {
+    *pPropertyCount = 0;
+}
+
+VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceMemoryProperties(VkPhysicalDevice,
+                                                              VkPhysicalDeviceMemoryProperties *pMemoryProperties) {
+    memset(pMemoryProperties, 0, sizeof(*pMemoryProperties));
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL CreateDevice(VkPhysicalDevice, const VkDeviceCreateInfo *, const VkAllocationCallbacks *,
+                                            VkDevice *) {
+    return VK_ERROR_INITIALIZATION_FAILED;
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL GetDeviceProcAddr(VkDevice, const char *) { return nullptr; }
+
+}  // namespace
+
+extern "C" {
+
+BENCHMARK_ICD_EXPORT VKAPI_ATTR VkResult VKAPI_CALL vk_icdNegotiateLoaderICDInterfaceVersion(uint32_t *pSupportedVersion) {
+    const char *delay = getenv("VK_LOADER_BENCHMARK_ICD_DELAY_MS");
+    if (delay != nullptr) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(atoi(delay)));
+    }
+    if (*pSupportedVersion > 4) {
+        *pSupportedVersion = 4;
+    }
+    return VK_SUCCESS;
+}
+
+BENCHMARK_ICD_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vk_icdGetInstanceProcAddr(VkInstance, const char *pName) {
+    static const struct {
+        const char *name;
+        PFN_vkVoidFunction function;
+    } functions[] = {
+        {"vkCreateInstance", reinterpret_cast<PFN_vkVoidFunction>(CreateInstance)},
+        {"vkDestroyInstance", reinterpret_cast<PFN_vkVoidFunction>(DestroyInstance)},
+        {"vkEnumerateInstanceExtensionProperties", reinterpret_cast<PFN_vkVoidFunction>(EnumerateInstanceExtensionProperties)},
+        {"vkEnumerateDeviceExtensionProperties", reinterpret_cast<PFN_vkVoidFunction>(EnumerateDeviceExtensionProperties)},
+        {"vkEnumeratePhysicalDevices", reinterpret_cast<PFN_vkVoidFunction>(EnumeratePhysicalDevices)},
+        {"vkGetPhysicalDeviceProperties", reinterpret_cast<PFN_vkVoidFunction>(GetPhysicalDeviceProperties)},
+        {"vkGetPhysicalDeviceQueueFamilyProperties", reinterpret_cast<PFN_vkVoidFunction>(GetPhysicalDeviceQueueFamilyProperties)},
+        {"vkGetPhysicalDeviceFeatures", reinterpret_cast<PFN_vkVoidFunction>(GetPhysicalDeviceFeatures)},
+        {"vkGetPhysicalDeviceFormatProperties", reinterpret_cast<PFN_vkVoidFunction>(GetPhysicalDeviceFormatProperties)},
+        {"vkGetPhysicalDeviceImageFormatProperties", reinterpret_cast<PFN_vkVoidFunction>(GetPhysicalDeviceImageFormatProperties)},
+        {"vkGetPhysicalDeviceSparseImageFormatProperties",
+         reinterpret_cast<PFN_vkVoidFunction>(GetPhysicalDeviceSparseImageFormatProperties)},
+        {"vkGetPhysicalDeviceMemoryProperties", reinterpret_cast<PFN_vkVoidFunction>(GetPhysicalDeviceMemoryProperties)},
+        {"vkCreateDevice", reinterpret_cast<PFN_vkVoidFunction>(CreateDevice)},
+        {"vkGetDeviceProcAddr", reinterpret_cast<PFN_vkVoidFunction>(GetDeviceProcAddr)},
+    };
+    for (const auto &function : functions) {
+        if (strcmp(pName, function.name) == 0) {
+            return function.function;
+        }
+    }
+    return nullptr;
+}
+
+BENCHMARK_ICD_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vk_icdGetPhysicalDeviceProcAddr(VkInstance, const char *) {
+    return nullptr;
+}
+
+}  // extern "C"
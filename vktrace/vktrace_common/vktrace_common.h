@@ -106,3 +106,14 @@
 // communicate verbosity level to the trace layer. It is set to
 // one of "quiet", "errors", "warnings", "full", or "debug".
 #define _VKTRACE_VERBOSITY_ENV "_VKTRACE_VERBOSITY"
+
+// VKTRACE_BLOB_DEDUP_ENABLE env var controls deduplication of large
+// payloads (shader code, pipeline cache data, buffer updates and mapped
+// memory uploads) in the trace file. Dedup is enabled if the env var is
+// undefined or set to 1; any other value disables it. Dedup is always
+// disabled when trimming with --TraceTrigger.
+#define VKTRACE_BLOB_DEDUP_ENABLE_ENV "VKTRACE_BLOB_DEDUP_ENABLE"
+
+// _VKTRACE_BLOB_DEDUP_MIN_SIZE env var specifies the minimum payload size
+// in bytes that is considered for deduplication. The default is 4096.
+#define _VKTRACE_BLOB_DEDUP_MIN_SIZE_ENV "_VKTRACE_BLOB_DEDUP_MIN_SIZE"
@@ -83,6 +83,39 @@ void vktrace_sem_post(vktrace_sem_id sid) {
 #endif  // USE_PAGEGUARD_SPEEDUP
 }
 
+// prefetch a destination for writing. Mapped memory is often write-combined, then the hint does nothing.
+#if defined(__GNUC__) || defined(__clang__)
+#define PAGEGUARD_PREFETCH_WRITE(p) __builtin_prefetch((p), 1)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define PAGEGUARD_PREFETCH_WRITE(p) _mm_prefetch((const char *)(p), _MM_HINT_T0)
+#else
+#define PAGEGUARD_PREFETCH_WRITE(p)
+#endif
+
+typedef void *(*vktrace_pageguard_copy_function)(void *dest, const void *src, size_t n);
+
+// copy count changed blocks to dest, src is the data of the first block and the data of the others follows it. Blocks
+// which are adjacent in dest are adjacent in src too, so each run of adjacent blocks is copied with one call.
+static void vktrace_pageguard_copy_changed_blocks(uint8_t *dest, const PageGuardChangedBlockInfo *pBlocks, uint32_t count,
+                                                  const uint8_t *src, vktrace_pageguard_copy_function copy) {
+    uint32_t i = 0;
+    while (i < count) {
+        size_t run_offset = pBlocks[i].offset;
+        size_t run_length = pBlocks[i].length;
+        for (i++; i < count && pBlocks[i].offset == run_offset + run_length; i++) {
+            run_length += pBlocks[i].length;
+        }
+        if (i < count) {
+            PAGEGUARD_PREFETCH_WRITE(dest + pBlocks[i].offset);
+        }
+        if (run_length) {
+            copy(dest + run_offset, src, run_length);
+        }
+        src += run_length;
+    }
+}
+
 #if defined(PAGEGUARD_MEMCPY_USE_PPL_LIB)
 
 #if defined(WIN32)
@@ -147,35 +180,123 @@ extern "C" void *vktrace_pageguard_memcpy(void *destination, const void *source,
 }
 #endif
 
+// large runs are still split by vktrace_pageguard_memcpy.
+static void vktrace_pageguard_memcpy_changed_blocks_multithread(uint8_t *dest, const PageGuardChangedBlockInfo *pBlocks,
+                                                                uint32_t count, const uint8_t *src, size_t total_size) {
+    vktrace_pageguard_copy_changed_blocks(dest, pBlocks, count, src, vktrace_pageguard_memcpy);
+}
+
 #else  //! defined(PAGEGUARD_MEMCPY_USE_PPL_LIB), use cross-platform memcpy multithread which exclude PPL
 
-typedef void (*vktrace_pageguard_ptr_task_unit_function)(void *pTaskUnitParaInput);
+// Upper bound of worker threads in the pool. memcpy bandwidth is bound by the memory controllers, not by the cores,
+// so beyond a handful of threads more workers only add wake-up latency and compete with the traced application.
+static const int PAGEGUARD_MEMCPY_MAX_THREAD_NUM = 8;
+
+// Each thread gets at least this many bytes, otherwise waking it costs more than the copy it does.
+static const size_t PAGEGUARD_MEMCPY_MIN_SIZE_PER_THREAD = 256 * 1024;
+
+// Slab boundaries are aligned to destination pages so that no two threads write to the same page (or cache line),
+// and each thread streams through one contiguous range which keeps its pages local to the node it runs on.
+static const size_t PAGEGUARD_MEMCPY_SLAB_ALIGNMENT = 0x1000;
+
+// Copies above this size would evict the whole last level cache, so the destination is written with non-temporal
+// stores. Mapped memory written here is read by the GPU or written to file, not by the CPU, so it's not
+// worth keeping in cache.
+static const size_t SIZE_LIMIT_TO_USE_NON_TEMPORAL_STORE = 8 * 1024 * 1024;
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define PAGEGUARD_MEMCPY_USE_NON_TEMPORAL_STORE
+#endif
 
 typedef struct {
     void *src, *dest;
     size_t size;
+    bool non_temporal;
+    // if not null, src holds the data of block_count changed blocks and dest is the base they're copied to.
+    const PageGuardChangedBlockInfo *blocks;
+    uint32_t block_count;
 } vktrace_pageguard_task_unit_parameters;
 
-typedef struct {
-    int index;
-    vktrace_pageguard_task_unit_parameters *ptask_units;
-    int amount;
-    vktrace_sem_id sem_id_access;
-} vktrace_pageguard_task_queue;
-
 typedef struct {
     int index;
     vktrace_pageguard_thread_id thread_id;
     vktrace_sem_id sem_id_task_start;
     vktrace_sem_id sem_id_task_end;
-    // vktrace_pageguard_task_unit_parameters *ptask_para;
+    vktrace_pageguard_task_unit_parameters *ptask_para;
+    bool stop;
 } vktrace_pageguard_task_control_block;
 
+typedef struct {
+    int thread_number;  // worker threads only, the calling thread always copies one slab itself
+    vktrace_pageguard_task_control_block *ptcb;
+    bool ready;
+} vktrace_pageguard_thread_pool;
+
 #if defined(WIN32)
 typedef uint32_t (*vktrace_pageguard_thread_function_ptr)(void *parameters);
 #else
 typedef void *(*vktrace_pageguard_thread_function_ptr)(void *parameters);
 #endif
+
+// copy with non-temporal stores, the destination bypasses the cache.
+static void *vktrace_pageguard_memcpy_non_temporal(void *dest, const void *src, size_t n) {
+#if defined(PAGEGUARD_MEMCPY_USE_NON_TEMPORAL_STORE)
+    uint8_t *pdest = reinterpret_cast<uint8_t *>(dest);
+    const uint8_t *psrc = reinterpret_cast<const uint8_t *>(src);
+    size_t head = (16 - (reinterpret_cast<uintptr_t>(pdest) & 0xf)) & 0xf;
+    if (head > n) {
+        head = n;
+    }
+    memcpy(pdest, psrc, head);
+    pdest += head;
+    psrc += head;
+    n -= head;
+
+    size_t blocks = n / 64;
+    for (size_t i = 0; i < blocks; i++) {
+        __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(psrc));
+        __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(psrc + 16));
+        __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(psrc + 32));
+        __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(psrc + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i *>(pdest), r0);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(pdest + 16), r1);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(pdest + 32), r2);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(pdest + 48), r3);
+        pdest += 64;
+        psrc += 64;
+    }
+    memcpy(pdest, psrc, n - blocks * 64);
+
+    // streaming stores are weakly ordered, they must be visible before this thread signals completion.
+    _mm_sfence();
+#else
+    memcpy(dest, src, n);
+#endif
+    return dest;
+}
+
+// the fence after non-temporal stores costs more than a small copy, so runs of changed blocks shorter than a page are
+// copied through the cache.
+static void *vktrace_pageguard_memcpy_run_non_temporal(void *dest, const void *src, size_t n) {
+    if (n < PAGEGUARD_MEMCPY_SLAB_ALIGNMENT) {
+        return memcpy(dest, src, n);
+    }
+    return vktrace_pageguard_memcpy_non_temporal(dest, src, n);
+}
+
+static void vktrace_pageguard_run_task_unit(const vktrace_pageguard_task_unit_parameters *parameters) {
+    if (parameters->blocks != nullptr) {
+        vktrace_pageguard_copy_changed_blocks(reinterpret_cast<uint8_t *>(parameters->dest), parameters->blocks,
+                                              parameters->block_count, reinterpret_cast<const uint8_t *>(parameters->src),
+                                              parameters->non_temporal ? vktrace_pageguard_memcpy_run_non_temporal : memcpy);
+    } else if (parameters->non_temporal) {
+        vktrace_pageguard_memcpy_non_temporal(parameters->dest, parameters->src, parameters->size);
+    } else {
+        memcpy(parameters->dest, parameters->src, parameters->size);
+    }
+}
+
 bool vktrace_pageguard_create_thread(vktrace_pageguard_thread_id *ptid, vktrace_pageguard_thread_function_ptr pfunc,
                                      vktrace_pageguard_task_control_block *ptaskpara) {
     bool create_thread_ok = false;
@@ -184,31 +305,27 @@ bool vktrace_pageguard_create_thread(vktrace_pageguard_thread_id *ptid, vktrace_
     HANDLE thread_handle;
     thread_handle = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)pfunc, ptaskpara, 0, &dwThreadID);
 
-    if (thread_handle != INVALID_HANDLE_VALUE) {
+    if (thread_handle != NULL) {
         *ptid = thread_handle;
         create_thread_ok = true;
     }
 
 #else
     pthread_t thread;
-    int state = PTHREAD_CANCEL_ENABLE, oldtype;
-    state = PTHREAD_CANCEL_ASYNCHRONOUS;
-    pthread_setcanceltype(state, &oldtype);
     if (pthread_create(&thread, NULL, pfunc, (void *)ptaskpara) == 0) {
         *ptid = thread;
         create_thread_ok = true;
     }
-    pthread_setcanceltype(oldtype, &state);
 #endif
     return create_thread_ok;
 }
 
-void vktrace_pageguard_delete_thread(vktrace_pageguard_thread_id tid) {
+// wait for a worker which has been asked to stop and release it.
+void vktrace_pageguard_join_thread(vktrace_pageguard_thread_id tid) {
 #if defined(WIN32)
-    DWORD dwExitCode = 0;
-    TerminateThread((HANDLE)tid, dwExitCode);
+    WaitForSingleObject((HANDLE)tid, INFINITE);
+    CloseHandle((HANDLE)tid);
 #else
-    pthread_cancel((pthread_t)tid);
     pthread_join((pthread_t)tid, NULL);
 #endif
 }
@@ -225,200 +342,186 @@ int vktrace_pageguard_get_cpu_core_count() {
     return iret;
 }
 
-vktrace_pageguard_task_queue *vktrace_pageguard_get_task_queue() {
-    static vktrace_pageguard_task_queue *pvktrace_pageguard_task_queue_multi_thread_memcpy = nullptr;
-    if (!pvktrace_pageguard_task_queue_multi_thread_memcpy) {
-        pvktrace_pageguard_task_queue_multi_thread_memcpy = new vktrace_pageguard_task_queue;
-        memset(reinterpret_cast<void *>(pvktrace_pageguard_task_queue_multi_thread_memcpy), 0,
-               sizeof(vktrace_pageguard_task_queue));
-        vktrace_sem_create(&pvktrace_pageguard_task_queue_multi_thread_memcpy->sem_id_access, 1);
-    }
-    return pvktrace_pageguard_task_queue_multi_thread_memcpy;
-}
-
-vktrace_pageguard_task_unit_parameters *vktrace_pageguard_get_task_unit_parameters() {
-    vktrace_pageguard_task_unit_parameters *pret = nullptr;
-    vktrace_pageguard_task_queue *ptaskqueue = vktrace_pageguard_get_task_queue();
-    vktrace_sem_wait(ptaskqueue->sem_id_access);
-    if (ptaskqueue->index < ptaskqueue->amount) {
-        pret = &ptaskqueue->ptask_units[ptaskqueue->index];
-        ptaskqueue->index++;
-    }
-    vktrace_sem_post(ptaskqueue->sem_id_access);
-    return pret;
-}
-
-vktrace_pageguard_task_control_block *vktrace_pageguard_get_task_control_block() {
-    static vktrace_pageguard_task_control_block *ptask_control_block = nullptr;
-    if (!ptask_control_block) {
-        int thread_number = vktrace_pageguard_get_cpu_core_count();
-        ptask_control_block = reinterpret_cast<vktrace_pageguard_task_control_block *>(
-            new uint8_t[thread_number * sizeof(vktrace_pageguard_task_control_block)]);
-        memset((void *)ptask_control_block, 0, thread_number * sizeof(vktrace_pageguard_task_control_block));
-    }
-    return ptask_control_block;
+vktrace_pageguard_thread_pool *vktrace_pageguard_get_thread_pool() {
+    static vktrace_pageguard_thread_pool thread_pool = {0, nullptr, false};
+    return &thread_pool;
 }
 
+#if defined(WIN32)
 uint32_t vktrace_pageguard_thread_function(void *ptcbpara) {
+#else
+void *vktrace_pageguard_thread_function(void *ptcbpara) {
+#endif
     vktrace_pageguard_task_control_block *ptasktcb = reinterpret_cast<vktrace_pageguard_task_control_block *>(ptcbpara);
-    vktrace_pageguard_task_unit_parameters *parameters;
-    bool stop_loop;
     while (1) {
         vktrace_sem_wait(ptasktcb->sem_id_task_start);
-        stop_loop = false;
-        while (!stop_loop) {
-            parameters = vktrace_pageguard_get_task_unit_parameters();
-            if (parameters != nullptr) {
-                memcpy(parameters->dest, parameters->src, parameters->size);
-            } else {
-                stop_loop = true;
-            }
+        if (ptasktcb->stop) {
+            break;
+        }
+        if (ptasktcb->ptask_para != nullptr) {
+            vktrace_pageguard_run_task_unit(ptasktcb->ptask_para);
         }
         vktrace_sem_post(ptasktcb->sem_id_task_end);
     }
+    return 0;
+}
+
+// serializes dispatching work to the pool, the pool only runs one copy at a time.
+static vktrace_sem_id pool_access_sem_id;
+static bool pool_access_sem_id_create_success = vktrace_sem_create(&pool_access_sem_id, 1);
+
+void vktrace_pageguard_stop_threads(vktrace_pageguard_task_control_block *ptcb, int thread_number) {
+    for (int i = 0; i < thread_number; i++) {
+        ptcb[i].stop = true;
+        vktrace_sem_post(ptcb[i].sem_id_task_start);
+        vktrace_pageguard_join_thread(ptcb[i].thread_id);
+        vktrace_sem_delete(ptcb[i].sem_id_task_start);
+        vktrace_sem_delete(ptcb[i].sem_id_task_end);
+    }
 }
 
 bool vktrace_pageguard_init_multi_threads_memcpy_custom(vktrace_pageguard_thread_function_ptr pfunc) {
-    bool init_multi_threads_memcpy_custom_ok = false, success_sem_start = false, success_sem_end = false, success_thread = false;
-    vktrace_pageguard_task_control_block *ptcb = vktrace_pageguard_get_task_control_block();
-    int thread_number = vktrace_pageguard_get_cpu_core_count();
+    vktrace_pageguard_thread_pool *ppool = vktrace_pageguard_get_thread_pool();
+    int thread_number = vktrace_pageguard_get_cpu_core_count() - 1;
+    if (thread_number > PAGEGUARD_MEMCPY_MAX_THREAD_NUM) {
+        thread_number = PAGEGUARD_MEMCPY_MAX_THREAD_NUM;
+    }
+    if (thread_number < 1) {
+        return false;
+    }
+
+    vktrace_pageguard_task_control_block *ptcb = new vktrace_pageguard_task_control_block[thread_number];
+    memset(reinterpret_cast<void *>(ptcb), 0, thread_number * sizeof(vktrace_pageguard_task_control_block));
+    int created_number = 0;
     for (int i = 0; i < thread_number; i++) {
-        success_sem_start = vktrace_sem_create(&ptcb[i].sem_id_task_start, 0);
-        success_sem_end = vktrace_sem_create(&ptcb[i].sem_id_task_end, 0);
         ptcb[i].index = i;
-        success_thread =
-            vktrace_pageguard_create_thread(&ptcb[i].thread_id, (vktrace_pageguard_thread_function_ptr)pfunc, &ptcb[i]);
-        if (success_sem_start && success_sem_end && success_thread) {
-            init_multi_threads_memcpy_custom_ok = true;
-        } else {
-            init_multi_threads_memcpy_custom_ok = false;
+        if (!vktrace_sem_create(&ptcb[i].sem_id_task_start, 0)) {
+            break;
+        }
+        if (!vktrace_sem_create(&ptcb[i].sem_id_task_end, 0)) {
+            vktrace_sem_delete(ptcb[i].sem_id_task_start);
+            break;
+        }
+        if (!vktrace_pageguard_create_thread(&ptcb[i].thread_id, pfunc, &ptcb[i])) {
+            vktrace_sem_delete(ptcb[i].sem_id_task_start);
+            vktrace_sem_delete(ptcb[i].sem_id_task_end);
             break;
         }
+        created_number++;
+    }
+    if (created_number != thread_number) {
+        vktrace_pageguard_stop_threads(ptcb, created_number);
+        delete[] ptcb;
+        return false;
     }
-    return init_multi_threads_memcpy_custom_ok;
+
+    vktrace_sem_wait(pool_access_sem_id);
+    ppool->thread_number = thread_number;
+    ppool->ptcb = ptcb;
+    ppool->ready = true;
+    vktrace_sem_post(pool_access_sem_id);
+    return true;
 }
 
 static vktrace_sem_id glocal_sem_id;
 static bool glocal_sem_id_create_success = vktrace_sem_create(&glocal_sem_id, 1);
+static int pool_ref_count = 0;
 
-int vktrace_pageguard_ref_count(bool release) {
-    static int ref_count = 0;
-    int curr_ref_count;
-    if (!release) {
-        vktrace_sem_wait(glocal_sem_id);
-        curr_ref_count = ref_count;
-        ++ref_count;
-        vktrace_sem_post(glocal_sem_id);
-        return curr_ref_count;
-    } else {
-        vktrace_sem_wait(glocal_sem_id);
-        --ref_count;
-        curr_ref_count = ref_count;
-        vktrace_sem_post(glocal_sem_id);
-        return curr_ref_count;
-    }
-}
-
+// The pool is created by the first init call and destroyed by the matching last done call. Both the tracer and the
+// replayer may hold a reference, vktrace_pageguard_memcpy falls back to a single thread copy while no pool exists.
 extern "C" BOOL vktrace_pageguard_init_multi_threads_memcpy() {
-    int refnum = vktrace_pageguard_ref_count(false);
     BOOL init_multi_threads_memcpy_ok = TRUE;
     vktrace_pageguard_thread_function_ptr pfunc = (vktrace_pageguard_thread_function_ptr)vktrace_pageguard_thread_function;
-    if (!refnum) {
+    vktrace_sem_wait(glocal_sem_id);
+    if (!vktrace_pageguard_get_thread_pool()->ready) {
         init_multi_threads_memcpy_ok = vktrace_pageguard_init_multi_threads_memcpy_custom(pfunc);
     }
+    pool_ref_count++;
+    vktrace_sem_post(glocal_sem_id);
     return init_multi_threads_memcpy_ok;
 }
 
-void vktrace_pageguard_delete_task_control_block() { delete[] vktrace_pageguard_get_task_control_block(); }
-
-void vktrace_pageguard_delete_task_queue() { delete vktrace_pageguard_get_task_queue(); }
-
 extern "C" void vktrace_pageguard_done_multi_threads_memcpy() {
-    int refnum = vktrace_pageguard_ref_count(true);
-    if (!refnum) {
-        vktrace_pageguard_task_control_block *task_control_block = vktrace_pageguard_get_task_control_block();
-        if (task_control_block != nullptr) {
-            int thread_number = vktrace_pageguard_get_cpu_core_count();
-
-            for (int i = 0; i < thread_number; i++) {
-                vktrace_pageguard_delete_thread(task_control_block[i].thread_id);
-                vktrace_sem_delete(task_control_block[i].sem_id_task_start);
-                vktrace_sem_delete(task_control_block[i].sem_id_task_end);
-            }
-            vktrace_pageguard_delete_task_control_block();
-            vktrace_sem_delete(vktrace_pageguard_get_task_queue()->sem_id_access);
-            vktrace_pageguard_delete_task_queue();
+    vktrace_sem_wait(glocal_sem_id);
+    if (pool_ref_count > 0 && --pool_ref_count == 0) {
+        vktrace_pageguard_thread_pool *ppool = vktrace_pageguard_get_thread_pool();
+        if (ppool->ready) {
+            // wait for a copy in flight, then hide the pool from new copies before stopping the workers.
+            vktrace_sem_wait(pool_access_sem_id);
+            ppool->ready = false;
+            vktrace_sem_post(pool_access_sem_id);
+
+            vktrace_pageguard_stop_threads(ppool->ptcb, ppool->thread_number);
+            delete[] ppool->ptcb;
+            ppool->ptcb = nullptr;
+            ppool->thread_number = 0;
         }
     }
-}
-
-// must keep units until vktrace_pageguard_multi_threads_memcpy_run finished
-void vktrace_pageguard_set_task_queue(vktrace_pageguard_task_unit_parameters *units, int unitamount) {
-    vktrace_sem_wait(glocal_sem_id);
-    vktrace_pageguard_task_queue *pqueue = vktrace_pageguard_get_task_queue();
-    pqueue->amount = unitamount;
-    pqueue->ptask_units = units;
-    pqueue->index = 0;
-}
-
-void vktrace_pageguard_clear_task_queue() {
-    vktrace_pageguard_task_queue *pqueue = vktrace_pageguard_get_task_queue();
-    pqueue->amount = 0;
-    pqueue->ptask_units = nullptr;
-    pqueue->index = 0;
     vktrace_sem_post(glocal_sem_id);
 }
 
 // The steps for using multithreading copy:
-//<1>init_multi_threads_memcpy
+//<1>vktrace_pageguard_init_multi_threads_memcpy
 //   it should be put at beginning of the app
 
-//<2>vktrace_pageguard_set_task_queue
-//<3>vktrace_pageguard_multi_threads_memcpy_run
+//<2>vktrace_pageguard_memcpy, for any size, small copies never touch the pool
 
-//<4>done_multi_threads_memcpy()
+//<3>vktrace_pageguard_done_multi_threads_memcpy
 //   it should be putted at end of the app
-void vktrace_pageguard_multi_threads_memcpy_run() {
-    vktrace_pageguard_task_control_block *ptcb = vktrace_pageguard_get_task_control_block();
-    int thread_number = vktrace_pageguard_get_cpu_core_count();
+void vktrace_pageguard_memcpy_multithread(void *dest, const void *src, size_t n) {
+    bool non_temporal = (n >= SIZE_LIMIT_TO_USE_NON_TEMPORAL_STORE);
+
+    vktrace_sem_wait(pool_access_sem_id);
+    vktrace_pageguard_thread_pool *ppool = vktrace_pageguard_get_thread_pool();
+    if (!ppool->ready) {
+        vktrace_sem_post(pool_access_sem_id);
+        vktrace_pageguard_task_unit_parameters unit = {const_cast<void *>(src), dest, n, non_temporal, nullptr, 0};
+        vktrace_pageguard_run_task_unit(&unit);
+        return;
+    }
 
-    for (int i = 0; i < thread_number; i++) {
-        vktrace_sem_post(ptcb[i].sem_id_task_start);
+    // one slab per thread, the calling thread takes slab 0 and the workers the rest.
+    size_t slab_number = n / PAGEGUARD_MEMCPY_MIN_SIZE_PER_THREAD;
+    if (slab_number > (size_t)ppool->thread_number + 1) {
+        slab_number = ppool->thread_number + 1;
+    }
+    if (slab_number < 1) {
+        slab_number = 1;
     }
 
-    for (int i = 0; i < thread_number; i++) {
-        vktrace_sem_wait(ptcb[i].sem_id_task_end);
+    vktrace_pageguard_task_unit_parameters units[PAGEGUARD_MEMCPY_MAX_THREAD_NUM + 1];
+    uintptr_t dest_start = reinterpret_cast<uintptr_t>(dest);
+    size_t slab_start = 0;
+    for (size_t i = 0; i < slab_number; i++) {
+        size_t slab_end = n;
+        if ((i + 1) < slab_number) {
+            uintptr_t boundary = dest_start + (n / slab_number) * (i + 1);
+            boundary = (boundary + PAGEGUARD_MEMCPY_SLAB_ALIGNMENT - 1) & ~(uintptr_t)(PAGEGUARD_MEMCPY_SLAB_ALIGNMENT - 1);
+            slab_end = boundary - dest_start;
+            if (slab_end > n) {
+                slab_end = n;
+            }
+        }
+        units[i].src = (void *)((uint8_t *)src + slab_start);
+        units[i].dest = (void *)((uint8_t *)dest + slab_start);
+        units[i].size = slab_end - slab_start;
+        units[i].non_temporal = non_temporal;
+        units[i].blocks = nullptr;
+        units[i].block_count = 0;
+        slab_start = slab_end;
     }
-}
 
-void vktrace_pageguard_memcpy_multithread(void *dest, const void *src, size_t n) {
-    static const size_t PAGEGUARD_MEMCPY_MULTITHREAD_UNIT_SIZE = 0x10000;
-    int thread_number = vktrace_pageguard_get_cpu_core_count();
-
-    // taskunitamount should be >=thread_number, but should not >= a value which make the unit too small and the cost of switch
-    // thread > memcpy that unit, on the other side, too small is also not best if consider last task will determine the memcpy
-    // speed.
-    int taskunitamount = n / PAGEGUARD_MEMCPY_MULTITHREAD_UNIT_SIZE;
-    if (taskunitamount < thread_number) {
-        taskunitamount = thread_number;
+    vktrace_pageguard_task_control_block *ptcb = ppool->ptcb;
+    for (size_t i = 1; i < slab_number; i++) {
+        ptcb[i - 1].ptask_para = &units[i];
+        vktrace_sem_post(ptcb[i - 1].sem_id_task_start);
     }
-    size_t size_per_unit = n / taskunitamount, size_left = n % taskunitamount, size;
-    vktrace_pageguard_task_unit_parameters *units = reinterpret_cast<vktrace_pageguard_task_unit_parameters *>(
-        new uint8_t[taskunitamount * sizeof(vktrace_pageguard_task_unit_parameters)]);
-    assert(units);
-    for (int i = 0; i < taskunitamount; i++) {
-        size = size_per_unit;
-        if ((i + 1) == taskunitamount) {
-            size += size_left;
-        }
-        units[i].src = (void *)((uint8_t *)src + i * size_per_unit);
-        units[i].dest = (void *)((uint8_t *)dest + i * size_per_unit);
-        units[i].size = size;
+    vktrace_pageguard_run_task_unit(&units[0]);
+    for (size_t i = 1; i < slab_number; i++) {
+        vktrace_sem_wait(ptcb[i - 1].sem_id_task_end);
+        ptcb[i - 1].ptask_para = nullptr;
     }
-    vktrace_pageguard_set_task_queue(units, taskunitamount);
-    vktrace_pageguard_multi_threads_memcpy_run();
-    delete[] units;
-    vktrace_pageguard_clear_task_queue();
+    vktrace_sem_post(pool_access_sem_id);
 }
 
 extern "C" void *vktrace_pageguard_memcpy(void *destination, const void *source, size_t size) {
@@ -431,4 +534,79 @@ extern "C" void *vktrace_pageguard_memcpy(void *destination, const void *source,
     }
     return pRet;
 }
+
+// the blocks are split into one slab per thread at block boundaries, each slab with about the same number of bytes.
+static void vktrace_pageguard_memcpy_changed_blocks_multithread(uint8_t *dest, const PageGuardChangedBlockInfo *pBlocks,
+                                                                uint32_t count, const uint8_t *src, size_t total_size) {
+    bool non_temporal = (total_size >= SIZE_LIMIT_TO_USE_NON_TEMPORAL_STORE);
+    vktrace_pageguard_task_unit_parameters units[PAGEGUARD_MEMCPY_MAX_THREAD_NUM + 1];
+    size_t slab_number = 0;
+
+    vktrace_sem_wait(pool_access_sem_id);
+    vktrace_pageguard_thread_pool *ppool = vktrace_pageguard_get_thread_pool();
+    if (ppool->ready) {
+        size_t max_slab_number = total_size / PAGEGUARD_MEMCPY_MIN_SIZE_PER_THREAD;
+        if (max_slab_number > (size_t)ppool->thread_number + 1) {
+            max_slab_number = ppool->thread_number + 1;
+        }
+        if (max_slab_number > 1) {
+            size_t slab_share = total_size / max_slab_number;
+            uint32_t slab_first = 0;
+            size_t slab_size = 0;
+            const uint8_t *slab_src = src;
+            for (uint32_t i = 0; i < count; i++) {
+                slab_size += pBlocks[i].length;
+                if ((i + 1) == count || (slab_size >= slab_share && (slab_number + 1) < max_slab_number)) {
+                    units[slab_number].src = const_cast<uint8_t *>(slab_src);
+                    units[slab_number].dest = dest;
+                    units[slab_number].size = slab_size;
+                    units[slab_number].non_temporal = non_temporal;
+                    units[slab_number].blocks = pBlocks + slab_first;
+                    units[slab_number].block_count = i + 1 - slab_first;
+                    slab_number++;
+                    slab_src += slab_size;
+                    slab_first = i + 1;
+                    slab_size = 0;
+                }
+            }
+        }
+    }
+    if (slab_number < 2) {
+        // a few large blocks, each large run is split across the pool by vktrace_pageguard_memcpy instead.
+        vktrace_sem_post(pool_access_sem_id);
+        vktrace_pageguard_copy_changed_blocks(dest, pBlocks, count, src, vktrace_pageguard_memcpy);
+        return;
+    }
+
+    vktrace_pageguard_task_control_block *ptcb = ppool->ptcb;
+    for (size_t i = 1; i < slab_number; i++) {
+        ptcb[i - 1].ptask_para = &units[i];
+        vktrace_sem_post(ptcb[i - 1].sem_id_task_start);
+    }
+    vktrace_pageguard_run_task_unit(&units[0]);
+    for (size_t i = 1; i < slab_number; i++) {
+        vktrace_sem_wait(ptcb[i - 1].sem_id_task_end);
+        ptcb[i - 1].ptask_para = nullptr;
+    }
+    vktrace_sem_post(pool_access_sem_id);
+}
 #endif
+
+// The package is the header block info (offset is the number of blocks, length the total size of their data), then
+// one block info per changed block, then the data of all blocks. The common case of many small blocks and a small
+// total is a single pass of memcpy calls, one per run of adjacent blocks.
+extern "C" void vktrace_pageguard_memcpy_changed_blocks(void *destination, const void *pChangedDataPackage) {
+    const PageGuardChangedBlockInfo *pInfo = reinterpret_cast<const PageGuardChangedBlockInfo *>(pChangedDataPackage);
+    uint32_t count = pInfo[0].offset;
+    size_t total_size = pInfo[0].length;
+    if (total_size == 0) {
+        return;
+    }
+    const uint8_t *src = reinterpret_cast<const uint8_t *>(pInfo + count + 1);
+    uint8_t *dest = reinterpret_cast<uint8_t *>(destination);
+    if (total_size < SIZE_LIMIT_TO_USE_OPTIMIZATION) {
+        vktrace_pageguard_copy_changed_blocks(dest, pInfo + 1, count, src, memcpy);
+    } else {
+        vktrace_pageguard_memcpy_changed_blocks_multithread(dest, pInfo + 1, count, src, total_size);
+    }
+}
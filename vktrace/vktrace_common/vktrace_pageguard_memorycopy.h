@@ -67,8 +67,17 @@ void vktrace_sem_wait(vktrace_sem_id sid);
 void vktrace_sem_post(vktrace_sem_id sid);
 void vktrace_pageguard_memcpy_multithread(void *dest, const void *src, size_t n);
 extern "C" void *vktrace_pageguard_memcpy(void *destination, const void *source, size_t size);
+// copy the blocks of a changed block package (see PageGuardChangedBlockInfo) to destination, adjacent blocks are
+// coalesced and large packages are split across the memcpy worker pool.
+extern "C" void vktrace_pageguard_memcpy_changed_blocks(void *destination, const void *pChangedDataPackage);
+#if defined(USE_PAGEGUARD_SPEEDUP) && !defined(PAGEGUARD_MEMCPY_USE_PPL_LIB)
+// start/stop the persistent worker pool used by vktrace_pageguard_memcpy for large copies, calls are reference counted.
+extern "C" BOOL vktrace_pageguard_init_multi_threads_memcpy();
+extern "C" void vktrace_pageguard_done_multi_threads_memcpy();
+#endif
 #else
 void* vktrace_pageguard_memcpy(void* destination, const void* source, size_t size);
+void vktrace_pageguard_memcpy_changed_blocks(void* destination, const void* pChangedDataPackage);
 #endif
 
 #define PAGEGUARD_SPECIAL_FORMAT_PACKET_FOR_VKFLUSHMAPPEDMEMORYRANGES 0X00000001
@@ -0,0 +1,103 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#include "vktrace_trace_header_reader.h"
+
+#include <string.h>
+
+extern "C" {
+#include "vktrace_tracelog.h"
+}
+
+bool vktrace_fseek64(FILE* pFile, uint64_t offset) {
+#if defined(WIN32)
+    return _fseeki64(pFile, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(pFile, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+bool vktrace_fskip64(FILE* pFile, uint64_t size) {
+#if defined(WIN32)
+    return _fseeki64(pFile, (__int64)size, SEEK_CUR) == 0;
+#else
+    return fseeko(pFile, (off_t)size, SEEK_CUR) == 0;
+#endif
+}
+
+uint64_t vktrace_file_size64(FILE* pFile) {
+#if defined(WIN32)
+    if (_fseeki64(pFile, 0, SEEK_END) != 0) return 0;
+    return (uint64_t)_ftelli64(pFile);
+#else
+    if (fseeko(pFile, 0, SEEK_END) != 0) return 0;
+    return (uint64_t)ftello(pFile);
+#endif
+}
+
+vktrace_trace_header_reader::vktrace_trace_header_reader(size_t bufferSize) : m_buffer(bufferSize) {
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+bool vktrace_trace_header_reader::open(FILE* pFile, uint64_t firstPacketOffset) {
+    m_pFile = pFile;
+    m_fileSize = vktrace_file_size64(pFile);
+    m_bufferOffset = 0;
+    m_bufferSize = 0;
+    m_offset = firstPacketOffset;
+    m_failed = (m_fileSize == 0);
+    if (m_failed) vktrace_LogError("Failed to determine the size of the trace file.");
+    return !m_failed;
+}
+
+const vktrace_trace_packet_header* vktrace_trace_header_reader::next() {
+    if (m_failed || m_offset + sizeof(vktrace_trace_packet_header) > m_fileSize) return NULL;
+
+    if (m_offset < m_bufferOffset || m_offset + sizeof(vktrace_trace_packet_header) > m_bufferOffset + m_bufferSize) {
+        // Refill from the next header, anything between the end of the buffer and here is skipped
+        if (m_offset != m_bufferOffset + m_bufferSize && !vktrace_fseek64(m_pFile, m_offset)) {
+            vktrace_LogError("Failed to seek to packet at offset %llu.", (unsigned long long)m_offset);
+            m_failed = true;
+            return NULL;
+        }
+        m_bufferOffset = m_offset;
+        size_t readSize = (m_fileSize - m_offset < m_buffer.size()) ? (size_t)(m_fileSize - m_offset) : m_buffer.size();
+        m_bufferSize = fread(m_buffer.data(), 1, readSize, m_pFile);
+        if (m_bufferSize < sizeof(vktrace_trace_packet_header)) {
+            vktrace_LogError("Failed to read packet at offset %llu.", (unsigned long long)m_offset);
+            m_failed = true;
+            return NULL;
+        }
+    }
+
+    memcpy(&m_header, m_buffer.data() + (m_offset - m_bufferOffset), sizeof(m_header));
+    if (m_header.size < sizeof(m_header) || m_header.size > m_fileSize - m_offset) {
+        vktrace_LogError("Packet at offset %llu has an invalid size of %llu bytes.", (unsigned long long)m_offset,
+                         (unsigned long long)m_header.size);
+        m_failed = true;
+        return NULL;
+    }
+
+    // The portability table is always the last packet, and is not part of the capture
+    if (m_header.packet_id == VKTRACE_TPI_PORTABILITY_TABLE) return NULL;
+
+    m_packetOffset = m_offset;
+    m_offset += m_header.size;
+    return &m_header;
+}
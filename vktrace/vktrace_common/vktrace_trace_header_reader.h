@@ -0,0 +1,65 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+
+extern "C" {
+#include "vktrace_trace_packet_identifiers.h"
+}
+
+// Trace files are routinely larger than 2GB, so these are used instead of fseek/ftell
+bool vktrace_fseek64(FILE* pFile, uint64_t offset);
+// Moves the file position forward by size bytes
+bool vktrace_fskip64(FILE* pFile, uint64_t size);
+uint64_t vktrace_file_size64(FILE* pFile);
+
+// Walks the packet headers of a trace file without reading packet bodies.
+// Headers are read through a large buffer; a body that extends past the buffer is seeked
+// over rather than read, so the cost of a walk depends on the number of packets much more
+// than on the size of the file.
+class vktrace_trace_header_reader {
+   public:
+    vktrace_trace_header_reader(size_t bufferSize = 16 * 1024 * 1024);
+
+    // firstPacketOffset is vktrace_trace_file_header::first_packet_offset
+    bool open(FILE* pFile, uint64_t firstPacketOffset);
+
+    // Returns the next packet header, or NULL at the end of the capture (the portability table
+    // or the end of the file) and on errors.  The header is valid until the next call.
+    const vktrace_trace_packet_header* next();
+
+    bool failed() const { return m_failed; }
+    uint64_t file_size() const { return m_fileSize; }
+    // File offset of the header last returned by next()
+    uint64_t packet_offset() const { return m_packetOffset; }
+
+   private:
+    FILE* m_pFile = NULL;
+    std::vector<uint8_t> m_buffer;
+    uint64_t m_bufferOffset = 0;  // file offset of m_buffer[0]
+    size_t m_bufferSize = 0;      // bytes of m_buffer holding file data
+    uint64_t m_offset = 0;        // file offset of the next header
+    uint64_t m_packetOffset = 0;
+    uint64_t m_fileSize = 0;
+    bool m_failed = false;
+    vktrace_trace_packet_header m_header;
+};
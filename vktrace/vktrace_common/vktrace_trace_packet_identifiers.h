@@ -28,7 +28,8 @@
 #define VKTRACE_TRACE_FILE_VERSION_4 0x0004
 #define VKTRACE_TRACE_FILE_VERSION_5 0x0005
 #define VKTRACE_TRACE_FILE_VERSION_6 0x0006
-#define VKTRACE_TRACE_FILE_VERSION VKTRACE_TRACE_FILE_VERSION_6
+#define VKTRACE_TRACE_FILE_VERSION_7 0x0007  // Adds VKTRACE_TPI_BLOB packets and blob references
+#define VKTRACE_TRACE_FILE_VERSION VKTRACE_TRACE_FILE_VERSION_7
 #define VKTRACE_TRACE_FILE_VERSION_MINIMUM_COMPATIBLE VKTRACE_TRACE_FILE_VERSION_6
 
 #define VKTRACE_FILE_MAGIC 0xABADD068ADEAFD0C
@@ -79,6 +80,9 @@ typedef enum _VKTRACE_TRACE_PACKET_ID_VK {
     VKTRACE_TPI_MARKER_API_GROUP_END = 4,
     VKTRACE_TPI_MARKER_TERMINATE_PROCESS = 5,
     VKTRACE_TPI_PORTABILITY_TABLE = 6,
+    // Tracer-level packets added after the Vulkan entrypoints are numbered down from the top of the id range, so that
+    // entrypoints appended to the end of this enum never collide with them
+    VKTRACE_TPI_BLOB = 0xFFFF,
     VKTRACE_TPI_VK_vkApiVersion = 7,
     VKTRACE_TPI_VK_vkGetPhysicalDeviceExternalImageFormatPropertiesNV = 8,
     VKTRACE_TPI_VK_vkCmdDrawIndirectCountAMD = 9,
@@ -249,6 +253,10 @@ typedef enum _VKTRACE_TRACE_PACKET_ID_VK {
     VKTRACE_TPI_VK_vkGetMemoryWin32HandleNV = 174,
 } VKTRACE_TRACE_PACKET_ID_VK;
 
+// One past the last Vulkan entrypoint id, update it when appending entrypoints.  Tables indexed by packet id only
+// cover ids below this and handle VKTRACE_TPI_BLOB and other larger ids before indexing.
+#define VKTRACE_TPI_VK_END (VKTRACE_TPI_VK_vkGetMemoryWin32HandleNV + 1)
+
 #define VKTRACE_BIG_ENDIAN 0
 #define VKTRACE_LITTLE_ENDIAN 1
 
@@ -325,6 +333,13 @@ typedef struct {
     char* label;
 } vktrace_trace_packet_marker_checkpoint;
 
+// A VKTRACE_TPI_BLOB packet holds a payload that later packets reference by blob_id
+// instead of embedding a copy. The payload follows this struct in the packet body.
+typedef struct {
+    ALIGN8 uint64_t blob_id;
+    ALIGN8 uint64_t size;
+} vktrace_trace_packet_blob;
+
 typedef vktrace_trace_packet_marker_checkpoint vktrace_trace_packet_marker_api_boundary;
 typedef vktrace_trace_packet_marker_checkpoint vktrace_trace_packet_marker_api_group_begin;
 typedef vktrace_trace_packet_marker_checkpoint vktrace_trace_packet_marker_api_group_end;
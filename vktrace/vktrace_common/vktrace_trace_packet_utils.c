@@ -45,9 +45,14 @@
 
 static VKTRACE_CRITICAL_SECTION s_packet_index_lock;
 
+static void vktrace_blob_writer_deinitialize();
+
 void vktrace_initialize_trace_packet_utils() { vktrace_create_critical_section(&s_packet_index_lock); }
 
-void vktrace_deinitialize_trace_packet_utils() { vktrace_delete_critical_section(&s_packet_index_lock); }
+void vktrace_deinitialize_trace_packet_utils() {
+    vktrace_blob_writer_deinitialize();
+    vktrace_delete_critical_section(&s_packet_index_lock);
+}
 
 uint64_t vktrace_get_unique_packet_index() {
     // Keep the s_packet_index scope to within this method, to ensure this method is always used to get a unique packet index.
@@ -243,6 +248,200 @@ void vktrace_add_buffer_to_trace_packet(vktrace_trace_packet_header* pHeader, vo
     }
 }
 
+//=============================================================================
+// Blob deduplication (writer side)
+//
+// Payloads added with vktrace_add_blob_to_trace_packet are hashed after they are copied
+// into the packet. The first time a payload is seen it is moved out into its own
+// VKTRACE_TPI_BLOB packet, which is written to the trace file before the packet that
+// references it; every packet (including the first one) then only stores a blob reference.
+// The blob table is keyed on (hash, size) and keeps a copy of each blob, so a payload only
+// reuses a blob whose bytes are the same; payloads whose hash collides with a different
+// blob get a blob of their own. Blob ids are handed out sequentially so the reader can index
+// its store directly.
+
+typedef struct {
+    uint64_t hash;
+    uint64_t size;
+    uint64_t id;  // VKTRACE_BLOB_INVALID_ID marks an empty slot
+    void* pData;
+} vktrace_blob_entry;
+
+#define VKTRACE_BLOB_INVALID_ID ((uint64_t)-1)
+
+// Payloads smaller than this are cheaper to store inline than to hash
+#define VKTRACE_BLOB_DEDUP_DEFAULT_MIN_SIZE 4096
+
+// Replay keeps every blob resident, and so does the tracer to compare payloads with, so stop
+// creating new blobs once this many unique bytes have been stored; larger payloads are then
+// written inline as before.
+#define VKTRACE_BLOB_DEDUP_MAX_UNIQUE_BYTES ((uint64_t)512 * 1024 * 1024)
+
+static BOOL s_blob_dedup_enabled = FALSE;
+static uint64_t s_blob_min_size = 0;
+static uint64_t s_blob_unique_bytes = 0;
+static uint64_t s_blob_count = 0;
+static vktrace_blob_entry* s_blob_table = NULL;
+static uint64_t s_blob_table_capacity = 0;  // always a power of two
+static VKTRACE_CRITICAL_SECTION s_blob_lock;
+
+// 64-bit MurmurHash2 (MurmurHash64A), consumes 8 bytes per step
+static uint64_t vktrace_blob_hash(const void* pData, uint64_t size) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    const unsigned char* pBytes = (const unsigned char*)pData;
+    const unsigned char* pEnd = pBytes + (size & ~(uint64_t)7);
+    uint64_t h = 0x8445d61a4e774912ULL ^ (size * m);
+
+    for (; pBytes != pEnd; pBytes += 8) {
+        uint64_t k;
+        memcpy(&k, pBytes, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    if (size & 7) {
+        for (uint64_t i = size & 7; i > 0; i--) {
+            h ^= (uint64_t)pBytes[i - 1] << (8 * (i - 1));
+        }
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+// returns the slot holding the blob with these bytes, or the empty slot where it should be inserted
+static vktrace_blob_entry* vktrace_blob_table_find(vktrace_blob_entry* pTable, uint64_t capacity, uint64_t hash, uint64_t size,
+                                                   const void* pData) {
+    uint64_t i = hash & (capacity - 1);
+    while (pTable[i].id != VKTRACE_BLOB_INVALID_ID &&
+           (pTable[i].hash != hash || pTable[i].size != size || memcmp(pTable[i].pData, pData, (size_t)size) != 0)) {
+        i = (i + 1) & (capacity - 1);
+    }
+    return &pTable[i];
+}
+
+static BOOL vktrace_blob_table_grow() {
+    uint64_t newCapacity = (s_blob_table_capacity == 0) ? 1024 : s_blob_table_capacity * 2;
+    vktrace_blob_entry* pNewTable = (vktrace_blob_entry*)vktrace_malloc((size_t)(newCapacity * sizeof(vktrace_blob_entry)));
+    if (pNewTable == NULL) {
+        return FALSE;
+    }
+    memset(pNewTable, 0xff, (size_t)(newCapacity * sizeof(vktrace_blob_entry)));
+
+    // The blobs are all different, so each one only needs an empty slot
+    for (uint64_t i = 0; i < s_blob_table_capacity; i++) {
+        if (s_blob_table[i].id != VKTRACE_BLOB_INVALID_ID) {
+            uint64_t j = s_blob_table[i].hash & (newCapacity - 1);
+            while (pNewTable[j].id != VKTRACE_BLOB_INVALID_ID) {
+                j = (j + 1) & (newCapacity - 1);
+            }
+            pNewTable[j] = s_blob_table[i];
+        }
+    }
+
+    vktrace_free(s_blob_table);
+    s_blob_table = pNewTable;
+    s_blob_table_capacity = newCapacity;
+    return TRUE;
+}
+
+void vktrace_trace_packet_init_blob_dedup() {
+    const char* pEnable = vktrace_get_global_var(VKTRACE_BLOB_DEDUP_ENABLE_ENV);
+    const char* pMinSize = vktrace_get_global_var(_VKTRACE_BLOB_DEDUP_MIN_SIZE_ENV);
+
+    if (pEnable != NULL && strcmp(pEnable, "1") != 0) {
+        return;
+    }
+
+    s_blob_min_size = VKTRACE_BLOB_DEDUP_DEFAULT_MIN_SIZE;
+    if (pMinSize != NULL && atoll(pMinSize) > 0) {
+        s_blob_min_size = (uint64_t)atoll(pMinSize);
+    }
+
+    vktrace_create_critical_section(&s_blob_lock);
+    s_blob_dedup_enabled = TRUE;
+}
+
+static void vktrace_blob_writer_deinitialize() {
+    if (!s_blob_dedup_enabled) {
+        return;
+    }
+    s_blob_dedup_enabled = FALSE;
+    vktrace_delete_critical_section(&s_blob_lock);
+    for (uint64_t i = 0; i < s_blob_table_capacity; i++) {
+        if (s_blob_table[i].id != VKTRACE_BLOB_INVALID_ID) {
+            vktrace_free(s_blob_table[i].pData);
+        }
+    }
+    vktrace_free(s_blob_table);
+    s_blob_table = NULL;
+    s_blob_table_capacity = 0;
+    s_blob_count = 0;
+    s_blob_unique_bytes = 0;
+}
+
+static void vktrace_write_blob_packet(uint64_t blob_id, uint64_t size, const void* pData) {
+    vktrace_trace_packet_header* pHeader =
+        vktrace_create_trace_packet(VKTRACE_TID_VULKAN, VKTRACE_TPI_BLOB, sizeof(vktrace_trace_packet_blob), ROUNDUP_TO_4(size));
+    vktrace_trace_packet_blob* pPacket = (vktrace_trace_packet_blob*)pHeader->pBody;
+    pPacket->blob_id = blob_id;
+    pPacket->size = size;
+    memcpy(pPacket + 1, pData, (size_t)size);
+    vktrace_finalize_trace_packet(pHeader);
+    vktrace_write_trace_packet(pHeader, vktrace_trace_get_trace_file());
+    vktrace_delete_trace_packet(&pHeader);
+}
+
+void vktrace_add_blob_to_trace_packet(vktrace_trace_packet_header* pHeader, void** ptr_address, uint64_t size,
+                                      const void* pBuffer) {
+    vktrace_add_buffer_to_trace_packet(pHeader, ptr_address, size, pBuffer);
+    if (!s_blob_dedup_enabled || *ptr_address == NULL || size < s_blob_min_size) {
+        return;
+    }
+
+    uint64_t hash = vktrace_blob_hash(*ptr_address, size);
+    uint64_t blob_id = VKTRACE_BLOB_INVALID_ID;
+
+    vktrace_enter_critical_section(&s_blob_lock);
+    if ((s_blob_count + 1) * 2 > s_blob_table_capacity && !vktrace_blob_table_grow()) {
+        vktrace_leave_critical_section(&s_blob_lock);
+        return;
+    }
+    vktrace_blob_entry* pEntry = vktrace_blob_table_find(s_blob_table, s_blob_table_capacity, hash, size, *ptr_address);
+    if (pEntry->id != VKTRACE_BLOB_INVALID_ID) {
+        blob_id = pEntry->id;
+    } else if (s_blob_unique_bytes + size <= VKTRACE_BLOB_DEDUP_MAX_UNIQUE_BYTES &&
+               (pEntry->pData = vktrace_malloc((size_t)size)) != NULL) {
+        // The blob packet must reach the trace file before any packet referencing it,
+        // so it is written while other threads are still blocked on the lookup.
+        memcpy(pEntry->pData, *ptr_address, (size_t)size);
+        pEntry->hash = hash;
+        pEntry->size = size;
+        pEntry->id = blob_id = s_blob_count++;
+        s_blob_unique_bytes += size;
+        vktrace_write_blob_packet(blob_id, size, *ptr_address);
+    }
+    vktrace_leave_critical_section(&s_blob_lock);
+
+    if (blob_id != VKTRACE_BLOB_INVALID_ID) {
+        // The payload was the last buffer added to the packet; give its space back.
+        // Shrinking size along with next_buffers_offset keeps the remaining capacity unchanged.
+        assert((char*)*ptr_address + ROUNDUP_TO_4(size) == (char*)pHeader + pHeader->next_buffers_offset);
+        pHeader->next_buffers_offset -= ROUNDUP_TO_4(size);
+        pHeader->size -= ROUNDUP_TO_4(size);
+
+        // vktrace_finalize_buffer_address will turn this into the blob reference
+        *ptr_address = (void*)(pHeader->pBody + (VKTRACE_BLOB_REFERENCE_BIT | (uintptr_t)blob_id));
+    }
+}
+
 void vktrace_finalize_buffer_address(vktrace_trace_packet_header* pHeader, void** ptr_address) {
     assert(ptr_address != NULL);
 
@@ -306,6 +505,65 @@ vktrace_trace_packet_header* vktrace_read_trace_packet(FileLike* pFile) {
     return pHeader;
 }
 
+//=============================================================================
+// Blob store (reader side), indexed by blob id
+
+typedef struct {
+    void* pData;
+    uint64_t size;
+} vktrace_blob_store_entry;
+
+static vktrace_blob_store_entry* s_blob_store = NULL;
+static uint64_t s_blob_store_capacity = 0;
+
+BOOL vktrace_trace_packet_register_blob(const vktrace_trace_packet_header* pHeader) {
+    const vktrace_trace_packet_blob* pPacket = (const vktrace_trace_packet_blob*)pHeader->pBody;
+    assert(pHeader->packet_id == VKTRACE_TPI_BLOB);
+
+    if (pHeader->size < sizeof(vktrace_trace_packet_header) + sizeof(vktrace_trace_packet_blob) + pPacket->size) {
+        vktrace_LogError("Blob packet %llu is truncated.", (unsigned long long)pHeader->global_packet_index);
+        return FALSE;
+    }
+
+    if (pPacket->blob_id >= s_blob_store_capacity) {
+        uint64_t newCapacity = (s_blob_store_capacity == 0) ? 1024 : s_blob_store_capacity;
+        while (newCapacity <= pPacket->blob_id) newCapacity *= 2;
+        vktrace_blob_store_entry* pNewStore =
+            (vktrace_blob_store_entry*)vktrace_realloc(s_blob_store, (size_t)(newCapacity * sizeof(vktrace_blob_store_entry)));
+        if (pNewStore == NULL) {
+            vktrace_LogError("Failed to grow blob store to %llu entries.", (unsigned long long)newCapacity);
+            return FALSE;
+        }
+        memset(pNewStore + s_blob_store_capacity, 0,
+               (size_t)((newCapacity - s_blob_store_capacity) * sizeof(vktrace_blob_store_entry)));
+        s_blob_store = pNewStore;
+        s_blob_store_capacity = newCapacity;
+    }
+
+    // Blobs are seen again when a trace is looped; the first copy is kept.
+    vktrace_blob_store_entry* pEntry = &s_blob_store[pPacket->blob_id];
+    if (pEntry->pData == NULL) {
+        pEntry->pData = vktrace_malloc((size_t)pPacket->size);
+        if (pEntry->pData == NULL) {
+            vktrace_LogError("Malloc failed for blob %llu of size %llu.", (unsigned long long)pPacket->blob_id,
+                             (unsigned long long)pPacket->size);
+            return FALSE;
+        }
+        memcpy(pEntry->pData, pPacket + 1, (size_t)pPacket->size);
+        pEntry->size = pPacket->size;
+    }
+    return TRUE;
+}
+
+void vktrace_trace_packet_clear_blobs() {
+    for (uint64_t i = 0; i < s_blob_store_capacity; i++) {
+        vktrace_free(s_blob_store[i].pData);
+    }
+    vktrace_free(s_blob_store);
+    s_blob_store = NULL;
+    s_blob_store_capacity = 0;
+}
+
 void* vktrace_trace_packet_interpret_buffer_pointer(vktrace_trace_packet_header* pHeader, intptr_t ptr_variable) {
     // the pointer variable actually contains a byte offset from the packet body to the start of the buffer.
     uint64_t offset = ptr_variable;
@@ -314,6 +572,17 @@ void* vktrace_trace_packet_interpret_buffer_pointer(vktrace_trace_packet_header*
     // if the offset is 0, then we know the pointer to the buffer was NULL, so no buffer exists and we return NULL.
     if (offset == 0) return NULL;
 
+    // a blob reference resolves to the payload of a previously registered VKTRACE_TPI_BLOB packet
+    if ((uintptr_t)ptr_variable & VKTRACE_BLOB_REFERENCE_BIT) {
+        uint64_t blob_id = (uintptr_t)ptr_variable & ~VKTRACE_BLOB_REFERENCE_BIT;
+        if (blob_id >= s_blob_store_capacity || s_blob_store[blob_id].pData == NULL) {
+            vktrace_LogError("Packet %llu references unknown blob %llu.", (unsigned long long)pHeader->global_packet_index,
+                             (unsigned long long)blob_id);
+            return NULL;
+        }
+        return s_blob_store[blob_id].pData;
+    }
+
     buffer_location = (char*)(pHeader->pBody) + offset;
     return buffer_location;
 }
@@ -62,6 +62,9 @@ static FILE* vktrace_open_trace_file(vktrace_process_info* pProcInfo) {
     return tracefp;
 };
 
+// Offsets stored in a packet with this bit set are blob ids rather than offsets from the packet body
+#define VKTRACE_BLOB_REFERENCE_BIT ((uintptr_t)1 << (sizeof(uintptr_t) * 8 - 1))
+
 //=============================================================================
 // trace packets
 // There is a trace_packet_header before every trace_packet_body.
@@ -87,6 +90,17 @@ void* vktrace_trace_packet_get_new_buffer_address(vktrace_trace_packet_header* p
 void vktrace_add_buffer_to_trace_packet(vktrace_trace_packet_header* pHeader, void** ptr_address, uint64_t size,
                                         const void* pBuffer);
 
+// same as vktrace_add_buffer_to_trace_packet, but if blob dedup is enabled and the buffer is large enough,
+// the payload is stored once in a VKTRACE_TPI_BLOB packet and *ptr_address becomes a blob reference.
+// Only use this for opaque payloads that are the last buffer added so far and that nothing
+// is written into afterwards (the reader may hand the same memory to several packets).
+void vktrace_add_blob_to_trace_packet(vktrace_trace_packet_header* pHeader, void** ptr_address, uint64_t size,
+                                      const void* pBuffer);
+
+// enables blob dedup for packets written to vktrace_trace_get_trace_file(), unless disabled
+// through VKTRACE_BLOB_DEDUP_ENABLE_ENV
+void vktrace_trace_packet_init_blob_dedup();
+
 // converts buffer pointers into byte offset so that pointer can be interpretted after being read into memory
 void vktrace_finalize_buffer_address(vktrace_trace_packet_header* pHeader, void** ptr_address);
 
@@ -107,9 +121,17 @@ void vktrace_write_trace_packet(const vktrace_trace_packet_header* pHeader, File
 // Reads in the trace packet header, the body of the packet, and additional buffers
 vktrace_trace_packet_header* vktrace_read_trace_packet(FileLike* pFile);
 
-// converts a pointer variable that is currently byte offset into a pointer to the actual offset location
+// converts a pointer variable that is currently byte offset into a pointer to the actual offset location.
+// blob references are resolved against the blobs registered so far.
 void* vktrace_trace_packet_interpret_buffer_pointer(vktrace_trace_packet_header* pHeader, intptr_t ptr_variable);
 
+// copies the payload of a VKTRACE_TPI_BLOB packet into the blob store so later packets can reference it.
+// Readers must call this for every blob packet, in file order.
+BOOL vktrace_trace_packet_register_blob(const vktrace_trace_packet_header* pHeader);
+
+// frees all registered blobs
+void vktrace_trace_packet_clear_blobs();
+
 //=============================================================================
 // trace packet message
 // Interpretting a trace_packet_message should be done only when:
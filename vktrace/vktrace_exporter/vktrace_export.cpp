@@ -0,0 +1,530 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#include "vktrace_export.h"
+
+extern "C" {
+#include "vktrace_common.h"
+#include "vktrace_trace_packet_identifiers.h"
+}
+
+#include "vktrace_trace_header_reader.h"
+#include "vktrace_vk_packet_id.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// vktrace_export converts the packet headers of a trace file into a timeline that standard tools
+// can open: Chrome Trace Event JSON (chrome://tracing, Perfetto UI) or a Perfetto protobuf trace.
+// Every traced call becomes a slice on the track of the thread that made it, spanning the whole
+// traced call (vktrace_begin_time to vktrace_end_time); optionally a nested "driver" slice shows
+// the part spent in the driver.  Each vkQueuePresentKHR ends a frame, which is marked with an
+// instant event and a counter holding the number of packet bytes recorded during the frame.
+// The conversion streams: memory use does not depend on the size of the trace.
+
+vktrace_export_settings g_settings;
+vktrace_export_settings g_default_settings;
+
+vktrace_SettingInfo g_settings_info[] = {
+    {"i", "InputTrace", VKTRACE_SETTING_STRING, {&g_settings.input_trace}, {&g_default_settings.input_trace}, TRUE,
+     "The trace file to export."},
+    {"o", "Output", VKTRACE_SETTING_STRING, {&g_settings.output_file}, {&g_default_settings.output_file}, TRUE,
+     "File to write, default is the input file name with a .json or .perfetto-trace extension."},
+    {"f", "Format", VKTRACE_SETTING_STRING, {&g_settings.format}, {&g_default_settings.format}, TRUE,
+     "Output format. Formats are \"chrome\" (Chrome Trace Event JSON), \"perfetto\" (Perfetto protobuf)."},
+    {"d", "DriverSlices", VKTRACE_SETTING_BOOL, {&g_settings.driver_slices}, {&g_default_settings.driver_slices}, TRUE,
+     "Add a nested slice for the time each call spent in the driver."},
+#if _DEBUG
+    {"v", "Verbosity", VKTRACE_SETTING_STRING, {&g_settings.verbosity}, {&g_default_settings.verbosity}, TRUE,
+     "Verbosity mode. Modes are \"quiet\", \"errors\", \"warnings\", \"full\", \"debug\"."},
+#else
+    {"v", "Verbosity", VKTRACE_SETTING_STRING, {&g_settings.verbosity}, {&g_default_settings.verbosity}, TRUE,
+     "Verbosity mode. Modes are \"quiet\", \"errors\", \"warnings\", \"full\"."},
+#endif
+};
+
+vktrace_SettingGroup g_settingGroup = {"vktrace_export", sizeof(g_settings_info) / sizeof(g_settings_info[0]), &g_settings_info[0]};
+
+// ------------------------------------------------------------------------------------------------
+void loggingCallback(VktraceLogLevel level, const char* pMessage) {
+    if (level == VKTRACE_LOG_NONE) return;
+
+    switch (level) {
+        case VKTRACE_LOG_DEBUG:
+            fprintf(stderr, "vktrace_export debug: %s\n", pMessage);
+            break;
+        case VKTRACE_LOG_ERROR:
+            fprintf(stderr, "vktrace_export error: %s\n", pMessage);
+            break;
+        case VKTRACE_LOG_WARNING:
+            fprintf(stderr, "vktrace_export warning: %s\n", pMessage);
+            break;
+        case VKTRACE_LOG_VERBOSE:
+            fprintf(stderr, "vktrace_export info: %s\n", pMessage);
+            break;
+        default:
+            fprintf(stderr, "%s\n", pMessage);
+            break;
+    }
+    fflush(stderr);
+
+#if defined(WIN32)
+#if _DEBUG
+    OutputDebugString(pMessage);
+#endif
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------
+// Interface of the output formats, events are passed in trace file order
+class TimelineWriter {
+   public:
+    virtual ~TimelineWriter() {}
+
+    virtual void begin(const char* pProcessName) = 0;
+    // Called before the first slice of a thread
+    virtual void thread(uint32_t thread_id) = 0;
+    // A traced call; driver times are 0 unless driver slices were requested
+    virtual void slice(const vktrace_trace_packet_header& hdr, bool driverSlice) = 0;
+    // End of a frame, with the packet bytes recorded during the frame
+    virtual void frame(uint32_t frame, uint64_t timestamp, uint64_t bytes) = 0;
+    virtual void end() = 0;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Chrome Trace Event JSON, timestamps are in microseconds
+class ChromeJsonWriter : public TimelineWriter {
+   public:
+    ChromeJsonWriter(FILE* pOut) : m_pOut(pOut) {}
+
+    void begin(const char* pProcessName) override {
+        fprintf(m_pOut, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        fprintf(m_pOut, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":");
+        write_string(pProcessName);
+        fprintf(m_pOut, "}}");
+    }
+
+    void thread(uint32_t thread_id) override {
+        fprintf(m_pOut, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}", thread_id,
+                thread_id);
+    }
+
+    void slice(const vktrace_trace_packet_header& hdr, bool driverSlice) override {
+        fprintf(m_pOut, ",\n{\"name\":\"%s\",\"cat\":\"vulkan\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,",
+                vktrace_packet_id_name(hdr.packet_id), hdr.thread_id, timestamp(hdr.vktrace_begin_time),
+                (hdr.vktrace_end_time - hdr.vktrace_begin_time) / 1000.0);
+        fprintf(m_pOut, "\"args\":{\"index\":%llu,\"bytes\":%llu}}", (unsigned long long)hdr.global_packet_index,
+                (unsigned long long)hdr.size);
+        if (driverSlice) {
+            fprintf(m_pOut, ",\n{\"name\":\"driver\",\"cat\":\"driver\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    hdr.thread_id, timestamp(hdr.entrypoint_begin_time), (hdr.entrypoint_end_time - hdr.entrypoint_begin_time) / 1000.0);
+        }
+    }
+
+    void frame(uint32_t frame, uint64_t ts, uint64_t bytes) override {
+        fprintf(m_pOut, ",\n{\"name\":\"Frame %u\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f}", frame,
+                timestamp(ts));
+        fprintf(m_pOut, ",\n{\"name\":\"Packet bytes\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"bytes\":%llu}}", timestamp(ts),
+                (unsigned long long)bytes);
+    }
+
+    void end() override { fprintf(m_pOut, "\n]}\n"); }
+
+   private:
+    // Relative to the first event so that microsecond doubles keep nanosecond precision
+    double timestamp(uint64_t ns) {
+        if (m_base == 0) m_base = ns;
+        return (ns >= m_base) ? (ns - m_base) / 1000.0 : -((m_base - ns) / 1000.0);
+    }
+
+    void write_string(const char* pString) {
+        fputc('"', m_pOut);
+        for (const char* p = pString; *p; p++) {
+            if (*p == '"' || *p == '\\')
+                fprintf(m_pOut, "\\%c", *p);
+            else if ((unsigned char)*p < 0x20)
+                fprintf(m_pOut, "\\u%04x", (unsigned int)*p);
+            else
+                fputc(*p, m_pOut);
+        }
+        fputc('"', m_pOut);
+    }
+
+    FILE* m_pOut;
+    uint64_t m_base = 0;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Minimal protobuf encoder, just what the Perfetto trace format needs
+class ProtoMessage {
+   public:
+    void varint(uint32_t field, uint64_t value) {
+        tag(field, 0);
+        put_varint(value);
+    }
+    void bytes(uint32_t field, const void* pData, size_t size) {
+        tag(field, 2);
+        put_varint(size);
+        m_data.insert(m_data.end(), (const uint8_t*)pData, (const uint8_t*)pData + size);
+    }
+    void string(uint32_t field, const char* pString) { bytes(field, pString, strlen(pString)); }
+    void message(uint32_t field, const ProtoMessage& msg) { bytes(field, msg.m_data.data(), msg.m_data.size()); }
+
+    const std::vector<uint8_t>& data() const { return m_data; }
+
+   private:
+    void tag(uint32_t field, uint32_t wireType) { put_varint((field << 3) | wireType); }
+    void put_varint(uint64_t value) {
+        while (value >= 0x80) {
+            m_data.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        m_data.push_back((uint8_t)value);
+    }
+
+    std::vector<uint8_t> m_data;
+};
+
+// Perfetto protobuf trace (perfetto/trace/trace.proto), written with track events on one packet
+// sequence.  Entrypoint names are interned, so each name is written once.
+class PerfettoWriter : public TimelineWriter {
+   public:
+    PerfettoWriter(FILE* pOut) : m_pOut(pOut) {}
+
+    void begin(const char* pProcessName) override {
+        ProtoMessage process;
+        process.varint(ProcessDescriptor_pid, kPid);
+        process.string(ProcessDescriptor_process_name, pProcessName);
+        ProtoMessage track;
+        track.varint(TrackDescriptor_uuid, kProcessTrack);
+        track.message(TrackDescriptor_process, process);
+        write_descriptor(track, SEQ_INCREMENTAL_STATE_CLEARED);
+
+        ProtoMessage frames;
+        frames.varint(TrackDescriptor_uuid, kFrameTrack);
+        frames.varint(TrackDescriptor_parent_uuid, kProcessTrack);
+        frames.string(TrackDescriptor_name, "Frames");
+        write_descriptor(frames, 0);
+
+        ProtoMessage counter;
+        ProtoMessage bytes;
+        bytes.varint(TrackDescriptor_uuid, kBytesTrack);
+        bytes.varint(TrackDescriptor_parent_uuid, kProcessTrack);
+        bytes.string(TrackDescriptor_name, "Packet bytes");
+        bytes.message(TrackDescriptor_counter, counter);
+        write_descriptor(bytes, 0);
+    }
+
+    void thread(uint32_t thread_id) override {
+        std::string name = "Thread " + std::to_string(thread_id);
+        ProtoMessage thread;
+        thread.varint(ThreadDescriptor_pid, kPid);
+        thread.varint(ThreadDescriptor_tid, thread_id);
+        thread.string(ThreadDescriptor_thread_name, name.c_str());
+        ProtoMessage track;
+        track.varint(TrackDescriptor_uuid, thread_track(thread_id));
+        track.varint(TrackDescriptor_parent_uuid, kProcessTrack);
+        track.message(TrackDescriptor_thread, thread);
+        write_descriptor(track, 0);
+    }
+
+    void slice(const vktrace_trace_packet_header& hdr, bool driverSlice) override {
+        uint64_t track = thread_track(hdr.thread_id);
+
+        ProtoMessage index;
+        index.string(DebugAnnotation_name, "index");
+        index.varint(DebugAnnotation_uint_value, hdr.global_packet_index);
+        ProtoMessage bytes;
+        bytes.string(DebugAnnotation_name, "bytes");
+        bytes.varint(DebugAnnotation_uint_value, hdr.size);
+
+        ProtoMessage begin;
+        begin.varint(TrackEvent_type, TYPE_SLICE_BEGIN);
+        begin.varint(TrackEvent_track_uuid, track);
+        begin.varint(TrackEvent_name_iid, intern(hdr.packet_id, vktrace_packet_id_name(hdr.packet_id)));
+        begin.message(TrackEvent_debug_annotations, index);
+        begin.message(TrackEvent_debug_annotations, bytes);
+        write_event(hdr.vktrace_begin_time, begin);
+
+        if (driverSlice) {
+            ProtoMessage driverBegin;
+            driverBegin.varint(TrackEvent_type, TYPE_SLICE_BEGIN);
+            driverBegin.varint(TrackEvent_track_uuid, track);
+            driverBegin.varint(TrackEvent_name_iid, intern(kDriverNameId, "driver"));
+            write_event(hdr.entrypoint_begin_time, driverBegin);
+            write_slice_end(hdr.entrypoint_end_time, track);
+        }
+        write_slice_end(hdr.vktrace_end_time, track);
+    }
+
+    void frame(uint32_t frame, uint64_t timestamp, uint64_t bytes) override {
+        std::string name = "Frame " + std::to_string(frame);
+        ProtoMessage marker;
+        marker.varint(TrackEvent_type, TYPE_INSTANT);
+        marker.varint(TrackEvent_track_uuid, kFrameTrack);
+        marker.string(TrackEvent_name, name.c_str());
+        write_event(timestamp, marker);
+
+        ProtoMessage counter;
+        counter.varint(TrackEvent_type, TYPE_COUNTER);
+        counter.varint(TrackEvent_track_uuid, kBytesTrack);
+        counter.varint(TrackEvent_counter_value, bytes);
+        write_event(timestamp, counter);
+    }
+
+    void end() override {}
+
+   private:
+    // Field numbers from the Perfetto protos
+    enum {
+        Trace_packet = 1,
+        TracePacket_timestamp = 8,
+        TracePacket_trusted_packet_sequence_id = 10,
+        TracePacket_track_event = 11,
+        TracePacket_interned_data = 12,
+        TracePacket_sequence_flags = 13,
+        TracePacket_track_descriptor = 60,
+        TrackDescriptor_uuid = 1,
+        TrackDescriptor_name = 2,
+        TrackDescriptor_process = 3,
+        TrackDescriptor_thread = 4,
+        TrackDescriptor_parent_uuid = 5,
+        TrackDescriptor_counter = 8,
+        ProcessDescriptor_pid = 1,
+        ProcessDescriptor_process_name = 6,
+        ThreadDescriptor_pid = 1,
+        ThreadDescriptor_tid = 2,
+        ThreadDescriptor_thread_name = 5,
+        TrackEvent_debug_annotations = 4,
+        TrackEvent_type = 9,
+        TrackEvent_name_iid = 10,
+        TrackEvent_track_uuid = 11,
+        TrackEvent_name = 23,
+        TrackEvent_counter_value = 30,
+        DebugAnnotation_uint_value = 3,
+        DebugAnnotation_name = 10,
+        InternedData_event_names = 2,
+        EventName_iid = 1,
+        EventName_name = 2,
+    };
+    enum { TYPE_SLICE_BEGIN = 1, TYPE_SLICE_END = 2, TYPE_INSTANT = 3, TYPE_COUNTER = 4 };
+    enum { SEQ_INCREMENTAL_STATE_CLEARED = 1, SEQ_NEEDS_INCREMENTAL_STATE = 2 };
+
+    static const uint32_t kSequenceId = 1;
+    static const uint32_t kPid = 1;
+    static const uint64_t kProcessTrack = 1;
+    static const uint64_t kFrameTrack = 2;
+    static const uint64_t kBytesTrack = 3;
+    // Name ids are packet ids + 1, the driver slice name comes after all packet ids
+    static const uint32_t kDriverNameId = 0x10000;
+
+    static uint64_t thread_track(uint32_t thread_id) { return (1ull << 32) | thread_id; }
+
+    uint64_t intern(uint32_t id, const char* pName) {
+        uint64_t iid = id + 1;
+        if (m_interned.insert(iid).second) {
+            ProtoMessage eventName;
+            eventName.varint(EventName_iid, iid);
+            eventName.string(EventName_name, pName);
+            m_pendingInterned.message(InternedData_event_names, eventName);
+            m_hasPendingInterned = true;
+        }
+        return iid;
+    }
+
+    void write_descriptor(const ProtoMessage& track, uint32_t flags) {
+        ProtoMessage packet;
+        packet.varint(TracePacket_trusted_packet_sequence_id, kSequenceId);
+        if (flags) packet.varint(TracePacket_sequence_flags, flags);
+        packet.message(TracePacket_track_descriptor, track);
+        write_packet(packet);
+    }
+
+    void write_event(uint64_t timestamp, const ProtoMessage& event) {
+        ProtoMessage packet;
+        packet.varint(TracePacket_timestamp, timestamp);
+        packet.varint(TracePacket_trusted_packet_sequence_id, kSequenceId);
+        packet.varint(TracePacket_sequence_flags, SEQ_NEEDS_INCREMENTAL_STATE);
+        if (m_hasPendingInterned) {
+            packet.message(TracePacket_interned_data, m_pendingInterned);
+            m_pendingInterned = ProtoMessage();
+            m_hasPendingInterned = false;
+        }
+        packet.message(TracePacket_track_event, event);
+        write_packet(packet);
+    }
+
+    void write_slice_end(uint64_t timestamp, uint64_t track) {
+        ProtoMessage end;
+        end.varint(TrackEvent_type, TYPE_SLICE_END);
+        end.varint(TrackEvent_track_uuid, track);
+        write_event(timestamp, end);
+    }
+
+    void write_packet(const ProtoMessage& packet) {
+        ProtoMessage trace;
+        trace.message(Trace_packet, packet);
+        fwrite(trace.data().data(), 1, trace.data().size(), m_pOut);
+    }
+
+    FILE* m_pOut;
+    std::unordered_set<uint64_t> m_interned;
+    ProtoMessage m_pendingInterned;
+    bool m_hasPendingInterned = false;
+};
+
+// ------------------------------------------------------------------------------------------------
+static bool export_trace(FILE* pIn, uint64_t firstPacketOffset, TimelineWriter* pWriter, bool driverSlices) {
+    vktrace_trace_header_reader reader;
+    if (!reader.open(pIn, firstPacketOffset)) return false;
+
+    std::unordered_set<uint32_t> threads;
+    uint32_t frame = 0;
+    uint64_t frameBytes = 0;
+    uint64_t lastTime = 0;
+    uint64_t packetCount = 0;
+
+    pWriter->begin(g_settings.input_trace);
+    while (const vktrace_trace_packet_header* pHeader = reader.next()) {
+        if (threads.insert(pHeader->thread_id).second) pWriter->thread(pHeader->thread_id);
+
+        // Packets without timestamps (e.g. blobs) only count towards the frame's bytes
+        if (pHeader->vktrace_end_time >= pHeader->vktrace_begin_time && pHeader->vktrace_begin_time != 0) {
+            bool driverSlice = driverSlices && pHeader->entrypoint_begin_time >= pHeader->vktrace_begin_time &&
+                               pHeader->entrypoint_end_time >= pHeader->entrypoint_begin_time &&
+                               pHeader->entrypoint_end_time <= pHeader->vktrace_end_time;
+            pWriter->slice(*pHeader, driverSlice);
+            lastTime = std::max(lastTime, pHeader->vktrace_end_time);
+        }
+        frameBytes += pHeader->size;
+        packetCount++;
+
+        if (pHeader->packet_id == VKTRACE_TPI_VK_vkQueuePresentKHR) {
+            pWriter->frame(frame++, pHeader->vktrace_end_time, frameBytes);
+            frameBytes = 0;
+        }
+    }
+
+    // Packets after the last present form a partial frame
+    if (frameBytes != 0 && lastTime != 0) pWriter->frame(frame, lastTime, frameBytes);
+    pWriter->end();
+
+    vktrace_LogVerbose("Exported %llu packets in %u frames on %u threads.", (unsigned long long)packetCount, frame,
+                       (unsigned int)threads.size());
+    return !reader.failed();
+}
+
+int main(int argc, char* argv[]) {
+    int exitval = 0;
+    memset(&g_settings, 0, sizeof(vktrace_export_settings));
+
+    vktrace_LogSetCallback(loggingCallback);
+    vktrace_LogSetLevel(VKTRACE_LOG_ERROR);
+
+    // setup defaults
+    memset(&g_default_settings, 0, sizeof(vktrace_export_settings));
+    g_default_settings.format = "chrome";
+    g_default_settings.driver_slices = FALSE;
+    g_default_settings.verbosity = "errors";
+
+    if (vktrace_SettingGroup_init(&g_settingGroup, NULL, argc, argv, NULL) != 0) {
+        // invalid cmd-line parameters
+        vktrace_SettingGroup_delete(&g_settingGroup);
+        return -1;
+    }
+
+    BOOL validArgs = TRUE;
+    if (strcmp(g_settings.verbosity, "quiet") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_NONE);
+    else if (strcmp(g_settings.verbosity, "errors") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_ERROR);
+    else if (strcmp(g_settings.verbosity, "warnings") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_WARNING);
+    else if (strcmp(g_settings.verbosity, "full") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_VERBOSE);
+#if _DEBUG
+    else if (strcmp(g_settings.verbosity, "debug") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_DEBUG);
+#endif
+    else
+        validArgs = FALSE;
+
+    bool perfetto = (strcmp(g_settings.format, "perfetto") == 0);
+    if (g_settings.input_trace == NULL || strlen(g_settings.input_trace) == 0) validArgs = FALSE;
+    if (!perfetto && strcmp(g_settings.format, "chrome") != 0) {
+        vktrace_LogError("Unknown output format \"%s\".", g_settings.format);
+        validArgs = FALSE;
+    }
+
+    if (!validArgs) {
+        vktrace_SettingGroup_print(&g_settingGroup);
+        vktrace_SettingGroup_delete(&g_settingGroup);
+        return -1;
+    }
+
+    std::string outputFile;
+    if (g_settings.output_file != NULL && strlen(g_settings.output_file) != 0) {
+        outputFile = g_settings.output_file;
+    } else {
+        outputFile = g_settings.input_trace;
+        size_t extension = outputFile.find_last_of('.');
+        if (extension != std::string::npos && outputFile.find_first_of("/\\", extension) == std::string::npos)
+            outputFile.erase(extension);
+        outputFile += perfetto ? ".perfetto-trace" : ".json";
+    }
+
+    FILE* pIn = fopen(g_settings.input_trace, "rb");
+    FILE* pOut = NULL;
+    vktrace_trace_file_header fileHeader;
+    if (pIn == NULL) {
+        vktrace_LogError("Cannot open trace file: '%s'.", g_settings.input_trace);
+        exitval = -1;
+    } else if (fread(&fileHeader, sizeof(fileHeader), 1, pIn) != 1) {
+        vktrace_LogError("Unable to read header from file.");
+        exitval = -1;
+    } else if (fileHeader.magic != VKTRACE_FILE_MAGIC) {
+        vktrace_LogError("%s does not appear to be a valid Vulkan trace file.", g_settings.input_trace);
+        exitval = -1;
+    } else if (fileHeader.trace_file_version < VKTRACE_TRACE_FILE_VERSION_MINIMUM_COMPATIBLE) {
+        vktrace_LogError("Trace file version %u is older than minimum compatible version (%u).", fileHeader.trace_file_version,
+                         VKTRACE_TRACE_FILE_VERSION_MINIMUM_COMPATIBLE);
+        exitval = -1;
+    } else if ((pOut = fopen(outputFile.c_str(), perfetto ? "wb" : "w")) == NULL) {
+        vktrace_LogError("Cannot create output file: '%s'.", outputFile.c_str());
+        exitval = -1;
+    } else {
+        ChromeJsonWriter chromeWriter(pOut);
+        PerfettoWriter perfettoWriter(pOut);
+        TimelineWriter* pWriter = perfetto ? (TimelineWriter*)&perfettoWriter : (TimelineWriter*)&chromeWriter;
+        if (!export_trace(pIn, fileHeader.first_packet_offset, pWriter, g_settings.driver_slices == TRUE)) {
+            vktrace_LogError("Failed to export trace file '%s'.", g_settings.input_trace);
+            exitval = -1;
+        } else if (ferror(pOut)) {
+            vktrace_LogError("Failed to write '%s'.", outputFile.c_str());
+            exitval = -1;
+        }
+    }
+
+    if (pIn != NULL) fclose(pIn);
+    if (pOut != NULL) fclose(pOut);
+    vktrace_SettingGroup_delete(&g_settingGroup);
+    return exitval;
+}
@@ -0,0 +1,38 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#pragma once
+#pragma once
+
+extern "C" {
+#include "vktrace_settings.h"
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// globals
+//----------------------------------------------------------------------------------------------------------------------
+typedef struct vktrace_export_settings {
+    char* input_trace;
+    char* output_file;
+    const char* format;
+    BOOL driver_slices;
+    const char* verbosity;
+} vktrace_export_settings;
+
+extern vktrace_export_settings g_settings;
@@ -483,16 +483,7 @@ bool PageGuardMappedMemory::vkFlushMappedMemoryRangePageGuardHandle(VkDevice dev
 
 // if use copy of real mapped memory, need copy back to real mapped memory
 #ifndef PAGEGUARD_ADD_PAGEGUARD_ON_REAL_MAPPED_MEMORY
-    PageGuardChangedBlockInfo *pChangedInfoArray = (PageGuardChangedBlockInfo *)pChangedDataPackage;
-    if (pChangedInfoArray[0].length) {
-        PBYTE pChangedData = (PBYTE)pChangedDataPackage + sizeof(PageGuardChangedBlockInfo) * (pChangedInfoArray[0].offset + 1);
-        DWORD CurrentOffset = 0;
-        for (DWORD i = 0; i < pChangedInfoArray[0].offset; i++) {
-            vktrace_pageguard_memcpy(pRealMappedData + pChangedInfoArray[i + 1].offset, pChangedData + CurrentOffset,
-                                     (size_t)pChangedInfoArray[i + 1].length);
-            CurrentOffset += pChangedInfoArray[i + 1].length;
-        }
-    }
+    vktrace_pageguard_memcpy_changed_blocks(pRealMappedData, pChangedDataPackage);
 #endif
 
     if (ppChangedDataPackage) {
@@ -483,7 +483,7 @@ VKTRACER_EXPORT VKAPI_ATTR void VKAPI_CALL __HOOKED_vkUnmapMemory(VkDevice devic
     pPacket = interpret_body_as_vkUnmapMemory(pHeader);
     if (siz) {
         assert(entry->handle == memory);
-        vktrace_add_buffer_to_trace_packet(pHeader, (void**)&(pPacket->pData), siz, entry->pData);
+        vktrace_add_blob_to_trace_packet(pHeader, (void**)&(pPacket->pData), siz, entry->pData);
         vktrace_finalize_buffer_address(pHeader, (void**)&(pPacket->pData));
     }
     entry->pData = NULL;
@@ -613,8 +613,8 @@ VKTRACER_EXPORT VKAPI_ATTR VkResult VKAPI_CALL __HOOKED_vkInvalidateMappedMemory
             assert(pEntry->totalSize >= pRange->size);
             assert(pRange->offset >= pEntry->rangeOffset &&
                    (pRange->offset + pRange->size) <= (pEntry->rangeOffset + pEntry->rangeSize));
-            vktrace_add_buffer_to_trace_packet(pHeader, (void**)&(pPacket->ppData[iter]), pRange->size,
-                                               pEntry->pData + pRange->offset);
+            vktrace_add_blob_to_trace_packet(pHeader, (void**)&(pPacket->ppData[iter]), pRange->size,
+                                             pEntry->pData + pRange->offset);
             vktrace_finalize_buffer_address(pHeader, (void**)&(pPacket->ppData[iter]));
             pEntry->didFlush = TRUE;  // Do we need didInvalidate?
         } else {
@@ -722,20 +722,20 @@ VKTRACER_EXPORT VKAPI_ATTR VkResult VKAPI_CALL __HOOKED_vkFlushMappedMemoryRange
             VkDeviceSize OPTPackageSizeTemp = 0;
             if (pOPTMemoryTemp) {
                 PBYTE pOPTDataTemp = pOPTMemoryTemp->getChangedDataPackage(&OPTPackageSizeTemp);
-                vktrace_add_buffer_to_trace_packet(pHeader, (void**)&(pPacket->ppData[iter]), ROUNDUP_TO_4(OPTPackageSizeTemp),
-                                                   pOPTDataTemp);
+                vktrace_add_blob_to_trace_packet(pHeader, (void**)&(pPacket->ppData[iter]), ROUNDUP_TO_4(OPTPackageSizeTemp),
+                                                 pOPTDataTemp);
                 pOPTMemoryTemp->clearChangedDataPackage();
                 pOPTMemoryTemp->resetMemoryObjectAllChangedFlagAndPageGuard();
             } else {
                 PBYTE pOPTDataTemp =
                     getPageGuardControlInstance().getChangedDataPackageOutOfMap(ppPackageData, iter, &OPTPackageSizeTemp);
-                vktrace_add_buffer_to_trace_packet(pHeader, (void**)&(pPacket->ppData[iter]), ROUNDUP_TO_4(OPTPackageSizeTemp),
-                                                   pOPTDataTemp);
+                vktrace_add_blob_to_trace_packet(pHeader, (void**)&(pPacket->ppData[iter]), ROUNDUP_TO_4(OPTPackageSizeTemp),
+                                                 pOPTDataTemp);
                 getPageGuardControlInstance().clearChangedDataPackageOutOfMap(ppPackageData, iter);
             }
 #else
-            vktrace_add_buffer_to_trace_packet(pHeader, (void**)&(pPacket->ppData[iter]), ROUNDUP_TO_4(rangeSize),
-                                               pEntry->pData + pRange->offset);
+            vktrace_add_blob_to_trace_packet(pHeader, (void**)&(pPacket->ppData[iter]), ROUNDUP_TO_4(rangeSize),
+                                             pEntry->pData + pRange->offset);
 #endif
             vktrace_finalize_buffer_address(pHeader, (void**)&(pPacket->ppData[iter]));
             pEntry->didFlush = TRUE;
@@ -1084,11 +1084,6 @@ VkLayerInstanceCreateInfo* get_chain_info(const VkInstanceCreateInfo* pCreateInf
     return chain_info;
 }
 
-#if defined(USE_PAGEGUARD_SPEEDUP) && !defined(PAGEGUARD_MEMCPY_USE_PPL_LIB)
-extern "C" BOOL vktrace_pageguard_init_multi_threads_memcpy();
-extern "C" void vktrace_pageguard_done_multi_threads_memcpy();
-#endif
-
 static bool send_vk_trace_file_header(VkInstance instance) {
     bool rval = false;
     uint64_t packet_size;
@@ -2539,8 +2534,8 @@ VKTRACER_EXPORT VKAPI_ATTR VkResult VKAPI_CALL __HOOKED_vkCreatePipelineCache(Vk
     pPacket = interpret_body_as_vkCreatePipelineCache(pHeader);
     pPacket->device = device;
     vktrace_add_buffer_to_trace_packet(pHeader, (void**)&(pPacket->pCreateInfo), sizeof(VkPipelineCacheCreateInfo), pCreateInfo);
-    vktrace_add_buffer_to_trace_packet(pHeader, (void**)&(pPacket->pCreateInfo->pInitialData),
-                                       ROUNDUP_TO_4(pPacket->pCreateInfo->initialDataSize), pCreateInfo->pInitialData);
+    vktrace_add_blob_to_trace_packet(pHeader, (void**)&(pPacket->pCreateInfo->pInitialData),
+                                     ROUNDUP_TO_4(pPacket->pCreateInfo->initialDataSize), pCreateInfo->pInitialData);
     vktrace_add_buffer_to_trace_packet(pHeader, (void**)&(pPacket->pAllocator), sizeof(VkAllocationCallbacks), NULL);
     vktrace_add_buffer_to_trace_packet(pHeader, (void**)&(pPacket->pPipelineCache), sizeof(VkPipelineCache), pPipelineCache);
     pPacket->result = result;
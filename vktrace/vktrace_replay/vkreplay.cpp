@@ -26,7 +26,8 @@
 #include "vktrace_vk_packet_id.h"
 #include "vktrace_tracelog.h"
 
-static vkreplayer_settings s_defaultVkReplaySettings = {NULL, 1, -1, -1, NULL, NULL, NULL};
+static vkreplayer_settings s_defaultVkReplaySettings = {NULL, 1, -1, -1, NULL, NULL, NULL, FALSE, FALSE, NULL, 1, NULL, FALSE, 0, 0,
+                                                         NULL, 0, FALSE, NULL, NULL, NULL, NULL};
 
 vkReplay* g_pReplayer = NULL;
 VKTRACE_CRITICAL_SECTION g_handlerLock;
@@ -130,7 +131,12 @@ vktrace_replay::VKTRACE_REPLAY_RESULT VKTRACER_CDECL VkReplayReplay(vktrace_trac
     if (g_pReplayer != NULL) {
         result = g_pReplayer->replay(pPacket);
 
-        if (result == vktrace_replay::VKTRACE_REPLAY_SUCCESS) result = g_pReplayer->pop_validation_msgs();
+        // Recording packets may be replayed on several threads, see RecordingThreads
+        if (result == vktrace_replay::VKTRACE_REPLAY_SUCCESS) {
+            vktrace_enter_critical_section(&g_handlerLock);
+            result = g_pReplayer->pop_validation_msgs();
+            vktrace_leave_critical_section(&g_handlerLock);
+        }
     }
     return result;
 }
@@ -155,3 +161,17 @@ void VKTRACER_CDECL VkReplayResetFrameNumber() {
         g_pReplayer->reset_frame_number();
     }
 }
+
+unsigned int VKTRACER_CDECL VkReplayGetGpuFrameTimes(double* pFrameTimes, unsigned int maxCount, BOOL wait) {
+    if (g_pReplayer != NULL) {
+        return g_pReplayer->get_gpu_frame_times(pFrameTimes, maxCount, wait == TRUE);
+    }
+    return 0;
+}
+
+unsigned int VKTRACER_CDECL VkReplayGetChecksumMismatches() {
+    if (g_pReplayer != NULL) {
+        return g_pReplayer->get_checksum_mismatches();
+    }
+    return 0;
+}
@@ -37,5 +37,7 @@ extern vktrace_replay::VKTRACE_REPLAY_RESULT VKTRACER_CDECL VkReplayReplay(vktra
 extern int VKTRACER_CDECL VkReplayDump();
 extern int VKTRACER_CDECL VkReplayGetFrameNumber();
 extern void VKTRACER_CDECL VkReplayResetFrameNumber();
+extern unsigned int VKTRACER_CDECL VkReplayGetGpuFrameTimes(double* pFrameTimes, unsigned int maxCount, BOOL wait);
+extern unsigned int VKTRACER_CDECL VkReplayGetChecksumMismatches();
 
 extern PFN_vkDebugReportCallbackEXT g_fpDbgMsgCallback;
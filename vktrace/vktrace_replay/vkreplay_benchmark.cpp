@@ -0,0 +1,203 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#include "vkreplay_benchmark.h"
+
+extern "C" {
+#include "vktrace_common.h"
+#include "vktrace_trace_packet_utils.h"
+}
+
+#include "vktrace_vk_packet_id.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+namespace vktrace_replay {
+
+static const char* const kCategoryNames[BENCHMARK_CATEGORY_COUNT] = {"commands", "submit",  "present", "sync",
+                                                                     "memory",   "descriptors", "objects", "other"};
+
+static bool starts_with(const char* pName, const char* pPrefix) { return strncmp(pName, pPrefix, strlen(pPrefix)) == 0; }
+
+static BenchmarkCategory packet_category(uint16_t packet_id) {
+    const char* pName = vktrace_vk_packet_id_name((VKTRACE_TRACE_PACKET_ID_VK)packet_id);
+    if (pName == NULL) return BENCHMARK_OTHER;
+    if (starts_with(pName, "vkCmd")) return BENCHMARK_COMMANDS;
+    if (!strcmp(pName, "vkQueuePresentKHR") || !strcmp(pName, "vkAcquireNextImageKHR")) return BENCHMARK_PRESENT;
+    if (starts_with(pName, "vkQueue")) return BENCHMARK_SUBMIT;
+    if (strstr(pName, "Fence") || strstr(pName, "Event") || strstr(pName, "Semaphore") || strstr(pName, "QueryPool") ||
+        !strcmp(pName, "vkDeviceWaitIdle"))
+        return BENCHMARK_SYNC;
+    if (strstr(pName, "Memory")) return BENCHMARK_MEMORY;
+    if (strstr(pName, "Descriptor")) return BENCHMARK_DESCRIPTORS;
+    if (starts_with(pName, "vkCreate") || starts_with(pName, "vkDestroy") || starts_with(pName, "vkAllocate") ||
+        starts_with(pName, "vkFree") || starts_with(pName, "vkReset"))
+        return BENCHMARK_OBJECTS;
+    return BENCHMARK_OTHER;
+}
+
+Benchmark::Benchmark() : m_frameStartTime(0), m_loop(0), m_measuring(false) {
+    // Categorize every packet id up front so that add_packet() is an array lookup
+    m_categories.resize(VKTRACE_TPI_VK_END);
+    for (uint32_t id = 0; id < VKTRACE_TPI_VK_END; id++) m_categories[id] = (uint8_t)packet_category((uint16_t)id);
+    memset(&m_currentFrame, 0, sizeof(m_currentFrame));
+}
+
+void Benchmark::begin_loop(bool measure) {
+    if (m_measuring) m_loop++;
+    m_measuring = measure;
+    memset(&m_currentFrame, 0, sizeof(m_currentFrame));
+    m_currentFrame.loop = m_loop;
+    m_frameStartTime = vktrace_get_time();
+}
+
+void Benchmark::end_frame() {
+    uint64_t now = vktrace_get_time();
+    if (m_measuring) {
+        m_currentFrame.cpuTime = now - m_frameStartTime;
+        m_frames.push_back(m_currentFrame);
+    }
+    memset(&m_currentFrame, 0, sizeof(m_currentFrame));
+    m_currentFrame.loop = m_loop;
+    m_frameStartTime = now;
+}
+
+void Benchmark::add_gpu_frame_times(const double* pFrameTimes, unsigned int count) {
+    m_gpuFrameTimes.insert(m_gpuFrameTimes.end(), pFrameTimes, pFrameTimes + count);
+}
+
+Benchmark::Summary Benchmark::summarize(std::vector<double> values) {
+    Summary summary = {};
+    if (values.empty()) return summary;
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    double total = 0.0;
+    for (double value : values) total += value;
+    // Nearest-rank percentiles
+    auto percentile = [&values, n](double p) { return values[std::max((size_t)ceil(p * n), (size_t)1) - 1]; };
+    summary.mean = total / n;
+    summary.median = (n % 2) ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+    summary.p95 = percentile(0.95);
+    summary.p99 = percentile(0.99);
+    summary.min = values.front();
+    summary.max = values.back();
+    return summary;
+}
+
+static void write_json_summary(FILE* pOut, const char* pName, size_t count, double mean, double median, double p95, double p99,
+                               double min, double max) {
+    fprintf(pOut,
+            "    \"%s\": {\"count\": %zu, \"mean\": %.6f, \"median\": %.6f, \"p95\": %.6f, \"p99\": %.6f, \"min\": %.6f, \"max\": "
+            "%.6f}",
+            pName, count, mean, median, p95, p99, min, max);
+}
+
+static void write_json_string(FILE* pOut, const char* pString) {
+    fputc('"', pOut);
+    for (const char* p = pString; *p; p++) {
+        if (*p == '"' || *p == '\\')
+            fprintf(pOut, "\\%c", *p);
+        else if ((unsigned char)*p < 0x20)
+            fprintf(pOut, "\\u%04x", (unsigned int)*p);
+        else
+            fputc(*p, pOut);
+    }
+    fputc('"', pOut);
+}
+
+bool Benchmark::write(const char* pFileName, const char* pFormat, const char* pTraceFile, unsigned int warmupLoops,
+                      unsigned int measuredLoops) const {
+    FILE* pOut = fopen(pFileName, "w");
+    if (pOut == NULL) {
+        vktrace_LogError("Cannot open benchmark results file '%s' for writing.", pFileName);
+        return false;
+    }
+
+    // All times are reported in milliseconds
+    std::vector<std::string> names;
+    std::vector<Summary> summaries;
+    std::vector<size_t> counts;
+    std::vector<double> values(m_frames.size());
+    for (size_t i = 0; i < m_frames.size(); i++) values[i] = m_frames[i].cpuTime / 1e6;
+    names.push_back("cpu_frame_time_ms");
+    summaries.push_back(summarize(values));
+    counts.push_back(values.size());
+    names.push_back("gpu_frame_time_ms");
+    summaries.push_back(summarize(m_gpuFrameTimes));
+    counts.push_back(m_gpuFrameTimes.size());
+    for (uint32_t category = 0; category < BENCHMARK_CATEGORY_COUNT; category++) {
+        for (size_t i = 0; i < m_frames.size(); i++) values[i] = m_frames[i].categoryTimes[category] / 1e6;
+        names.push_back(std::string(kCategoryNames[category]) + "_ms");
+        summaries.push_back(summarize(values));
+        counts.push_back(values.size());
+    }
+
+    if (strcmp(pFormat, "csv") == 0) {
+        fprintf(pOut, "metric,count,mean,median,p95,p99,min,max\n");
+        for (size_t i = 0; i < names.size(); i++) {
+            const Summary& s = summaries[i];
+            fprintf(pOut, "%s,%zu,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n", names[i].c_str(), counts[i], s.mean, s.median, s.p95, s.p99,
+                    s.min, s.max);
+        }
+    } else {
+        fprintf(pOut, "{\n  \"trace_file\": ");
+        write_json_string(pOut, pTraceFile);
+        fprintf(pOut, ",\n  \"warmup_loops\": %u,\n  \"measured_loops\": %u,\n  \"frames\": %zu,\n  \"summary\": {\n", warmupLoops,
+                measuredLoops, m_frames.size());
+        for (size_t i = 0; i < names.size(); i++) {
+            const Summary& s = summaries[i];
+            write_json_summary(pOut, names[i].c_str(), counts[i], s.mean, s.median, s.p95, s.p99, s.min, s.max);
+            fprintf(pOut, "%s\n", (i + 1 < names.size()) ? "," : "");
+        }
+        fprintf(pOut, "  },\n  \"frame_times\": [");
+        const char* pSeparator = "\n";
+        for (const Frame& frame : m_frames) {
+            fprintf(pOut, "%s    {\"loop\": %u, \"cpu_ms\": %.6f", pSeparator, frame.loop, frame.cpuTime / 1e6);
+            for (uint32_t category = 0; category < BENCHMARK_CATEGORY_COUNT; category++)
+                fprintf(pOut, ", \"%s_ms\": %.6f", kCategoryNames[category], frame.categoryTimes[category] / 1e6);
+            fprintf(pOut, "}");
+            pSeparator = ",\n";
+        }
+        fprintf(pOut, "\n  ],\n  \"gpu_frame_times_ms\": [");
+        for (size_t i = 0; i < m_gpuFrameTimes.size(); i++) fprintf(pOut, "%s%.6f", i ? ", " : "", m_gpuFrameTimes[i]);
+        fprintf(pOut, "]\n}\n");
+    }
+
+    bool success = ferror(pOut) == 0;
+    if (fclose(pOut) != 0) success = false;
+    if (!success) vktrace_LogError("Failed to write benchmark results file '%s'.", pFileName);
+    return success;
+}
+
+void Benchmark::log_summary() const {
+    std::vector<double> values(m_frames.size());
+    for (size_t i = 0; i < m_frames.size(); i++) values[i] = m_frames[i].cpuTime / 1e6;
+    Summary s = summarize(values);
+    vktrace_LogAlways("Benchmark: %zu frames, CPU frame time mean %.3f ms, median %.3f ms, p95 %.3f ms, p99 %.3f ms", m_frames.size(),
+                      s.mean, s.median, s.p95, s.p99);
+    if (!m_gpuFrameTimes.empty()) {
+        s = summarize(m_gpuFrameTimes);
+        vktrace_LogAlways("Benchmark: %zu frames, GPU frame time mean %.3f ms, median %.3f ms, p95 %.3f ms, p99 %.3f ms",
+                          m_gpuFrameTimes.size(), s.mean, s.median, s.p95, s.p99);
+    }
+}
+
+}  // namespace vktrace_replay
@@ -0,0 +1,90 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace vktrace_replay {
+
+// Groups of packets whose replay time the benchmark reports separately
+enum BenchmarkCategory {
+    BENCHMARK_COMMANDS = 0,  // vkCmd*
+    BENCHMARK_SUBMIT,        // vkQueueSubmit, vkQueueBindSparse, vkQueueWaitIdle
+    BENCHMARK_PRESENT,       // vkAcquireNextImageKHR, vkQueuePresentKHR
+    BENCHMARK_SYNC,          // fences, events, semaphores, queries, vkDeviceWaitIdle
+    BENCHMARK_MEMORY,        // allocating, binding, mapping and flushing memory
+    BENCHMARK_DESCRIPTORS,   // allocating and updating descriptor sets
+    BENCHMARK_OBJECTS,       // creating and destroying everything else
+    BENCHMARK_OTHER,
+    BENCHMARK_CATEGORY_COUNT
+};
+
+// Collects per-frame replay times over the measured loops of a benchmark run and writes
+// their statistics.  Frames are delimited by vkQueuePresentKHR, so frame times are the CPU
+// time from one present to the next; packets replayed after the last present of a loop are
+// not counted.
+class Benchmark {
+   public:
+    Benchmark();
+
+    // Starts a loop over the trace or loop range; frames are only recorded while measuring
+    void begin_loop(bool measure);
+    // Adds the time spent reading, interpreting and replaying a packet to the current frame
+    void add_packet(uint16_t packet_id, uint64_t time) {
+        if (!m_measuring) return;
+        m_currentFrame.categoryTimes[packet_id < m_categories.size() ? m_categories[packet_id] : BENCHMARK_OTHER] += time;
+    }
+    // Ends the current frame; called after the packet that presented it was replayed
+    void end_frame();
+    // Adds GPU frame times, in milliseconds, measured with timestamp queries
+    void add_gpu_frame_times(const double* pFrameTimes, unsigned int count);
+
+    bool is_measuring() const { return m_measuring; }
+    size_t frame_count() const { return m_frames.size(); }
+
+    // Writes the results as "json" or "csv"; returns false if the file can't be written
+    bool write(const char* pFileName, const char* pFormat, const char* pTraceFile, unsigned int warmupLoops,
+               unsigned int measuredLoops) const;
+    // Logs a one line summary of the CPU frame times
+    void log_summary() const;
+
+   private:
+    struct Frame {
+        uint32_t loop;
+        uint64_t cpuTime;
+        uint64_t categoryTimes[BENCHMARK_CATEGORY_COUNT];
+    };
+    struct Summary {
+        double mean, median, p95, p99, min, max;
+    };
+    static Summary summarize(std::vector<double> values);
+
+    std::vector<uint8_t> m_categories;
+    std::vector<Frame> m_frames;
+    std::vector<double> m_gpuFrameTimes;
+    Frame m_currentFrame;
+    uint64_t m_frameStartTime;
+    uint32_t m_loop;
+    bool m_measuring;
+};
+
+}  // namespace vktrace_replay
@@ -0,0 +1,240 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#include "vkreplay_frame_checksums.h"
+
+extern "C" {
+#include "vktrace_platform.h"
+#include "vktrace_trace_packet_utils.h"
+}
+
+#include <stdio.h>
+#include <string.h>
+
+namespace vktrace_replay {
+
+static const char kManifestHeader[] = "# vkreplay frame checksums: frame swapchain width height format xxh64\n";
+
+static const uint64_t kPrime1 = 11400714785074694791ull;
+static const uint64_t kPrime2 = 14029467366897019727ull;
+static const uint64_t kPrime3 = 1609587929392839161ull;
+static const uint64_t kPrime4 = 9650029242287828579ull;
+static const uint64_t kPrime5 = 2870177450012600261ull;
+
+static uint64_t rotl64(uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+
+static uint64_t read64(const uint8_t* pBytes) {
+    uint64_t value;
+    memcpy(&value, pBytes, sizeof(value));
+    return value;
+}
+
+static uint64_t xxh64_round(uint64_t acc, uint64_t input) { return rotl64(acc + input * kPrime2, 31) * kPrime1; }
+
+static uint64_t xxh64_merge(uint64_t acc, uint64_t value) { return (acc ^ xxh64_round(0, value)) * kPrime1 + kPrime4; }
+
+uint64_t FrameChecksums::hash(const void* pData, size_t size) {
+    // xxHash64 with a seed of 0.  The four lanes are independent, so the compiler keeps them in
+    // registers and the loop runs at close to memory bandwidth.
+    const uint8_t* pCur = (const uint8_t*)pData;
+    const uint8_t* pEnd = pCur + size;
+    uint64_t h;
+    if (size >= 32) {
+        uint64_t v1 = kPrime1 + kPrime2;
+        uint64_t v2 = kPrime2;
+        uint64_t v3 = 0;
+        uint64_t v4 = 0 - kPrime1;
+        for (; pCur + 32 <= pEnd; pCur += 32) {
+            v1 = xxh64_round(v1, read64(pCur));
+            v2 = xxh64_round(v2, read64(pCur + 8));
+            v3 = xxh64_round(v3, read64(pCur + 16));
+            v4 = xxh64_round(v4, read64(pCur + 24));
+        }
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh64_merge(h, v1);
+        h = xxh64_merge(h, v2);
+        h = xxh64_merge(h, v3);
+        h = xxh64_merge(h, v4);
+    } else {
+        h = kPrime5;
+    }
+    h += size;
+    for (; pCur + 8 <= pEnd; pCur += 8) h = rotl64(h ^ xxh64_round(0, read64(pCur)), 27) * kPrime1 + kPrime4;
+    if (pCur + 4 <= pEnd) {
+        uint32_t value;
+        memcpy(&value, pCur, sizeof(value));
+        h = rotl64(h ^ (value * kPrime1), 23) * kPrime2 + kPrime3;
+        pCur += 4;
+    }
+    for (; pCur < pEnd; pCur++) h = rotl64(h ^ (*pCur * kPrime5), 11) * kPrime1;
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+FrameChecksums::FrameChecksums(const char* pManifestPath, const char* pGoldenPath, const char* pMismatchDir)
+    : m_manifestPath((pManifestPath != NULL) ? pManifestPath : ""),
+      m_goldenPath((pGoldenPath != NULL) ? pGoldenPath : ""),
+      m_mismatchDir((pMismatchDir != NULL) ? pMismatchDir : "."),
+      m_compareCount(0),
+      m_mismatchCount(0) {
+    if (!m_goldenPath.empty()) load_golden();
+}
+
+FrameChecksums::~FrameChecksums() {
+    write();
+    if (!m_goldenPath.empty()) {
+        uint32_t missing = mismatch_count() - m_mismatchCount;
+        vktrace_LogAlways("Frame checksums: %u compared, %u mismatched, %u golden checksums of frames not presented.",
+                          m_compareCount, m_mismatchCount, missing);
+    }
+}
+
+void FrameChecksums::load_golden() {
+    FILE* pFile = fopen(m_goldenPath.c_str(), "r");
+    if (pFile == NULL) {
+        vktrace_LogError("Failed to open the golden checksum manifest %s.", m_goldenPath.c_str());
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), pFile) != NULL) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        unsigned int frame, swapchain, width, height;
+        int format;
+        unsigned long long checksum;
+        if (sscanf(line, "%u %u %u %u %d %llx", &frame, &swapchain, &width, &height, &format, &checksum) != 6) {
+            vktrace_LogError("Invalid line in the golden checksum manifest %s: %s", m_goldenPath.c_str(), line);
+            continue;
+        }
+        Entry entry = {width, height, (VkFormat)format, checksum};
+        m_golden[Key(frame, swapchain)] = entry;
+    }
+    fclose(pFile);
+    vktrace_LogVerbose("Loaded %u golden checksums from %s.", (uint32_t)m_golden.size(), m_goldenPath.c_str());
+}
+
+uint32_t FrameChecksums::mismatch_count() const {
+    uint32_t missing = 0;
+    for (auto& golden : m_golden) missing += (m_checksums.count(golden.first) == 0) ? 1 : 0;
+    return m_mismatchCount + missing;
+}
+
+bool FrameChecksums::is_golden_frame(uint32_t frame) const {
+    auto it = m_golden.lower_bound(Key(frame, 0));
+    return it != m_golden.end() && it->first.first == frame;
+}
+
+void FrameChecksums::add(uint32_t frame, uint32_t swapchain, const VkExtent3D& extent, VkFormat format, const void* pData,
+                         size_t size) {
+    Entry entry = {extent.width, extent.height, format, hash(pData, size)};
+    Key key(frame, swapchain);
+
+    auto it = m_checksums.find(key);
+    if (it != m_checksums.end()) {
+        // Frames of later loops are checked against the first loop
+        if (it->second.checksum != entry.checksum) {
+            vktrace_LogWarning("Frame %u checksum %016llx differs from %016llx in the first loop.", frame,
+                               (unsigned long long)entry.checksum, (unsigned long long)it->second.checksum);
+        }
+        return;
+    }
+    m_checksums[key] = entry;
+
+    auto golden_it = m_golden.find(key);
+    if (golden_it != m_golden.end()) {
+        m_compareCount++;
+        const Entry& golden = golden_it->second;
+        if (golden.checksum != entry.checksum || golden.width != entry.width || golden.height != entry.height ||
+            golden.format != entry.format) {
+            m_mismatchCount++;
+            vktrace_LogError("Frame %u checksum %016llx (%ux%u, format %d) doesn't match the golden checksum %016llx "
+                             "(%ux%u, format %d).",
+                             frame, (unsigned long long)entry.checksum, entry.width, entry.height, entry.format,
+                             (unsigned long long)golden.checksum, golden.width, golden.height, golden.format);
+            write_image(frame, swapchain, entry, pData, size);
+        }
+    } else if (m_manifestPath.empty() && m_goldenPath.empty()) {
+        vktrace_LogAlways("Frame %u checksum %016llx (%ux%u, format %d)", frame, (unsigned long long)entry.checksum, entry.width,
+                          entry.height, entry.format);
+    }
+}
+
+void FrameChecksums::write_image(uint32_t frame, uint32_t swapchain, const Entry& entry, const void* pData, size_t size) {
+    // Formats with 8-bit RGBA channels are written as PPM, anything else as the raw readback
+    bool bgra = entry.format == VK_FORMAT_B8G8R8A8_UNORM || entry.format == VK_FORMAT_B8G8R8A8_SRGB;
+    bool rgba = entry.format == VK_FORMAT_R8G8B8A8_UNORM || entry.format == VK_FORMAT_R8G8B8A8_SRGB ||
+                entry.format == VK_FORMAT_A8B8G8R8_UNORM_PACK32 || entry.format == VK_FORMAT_A8B8G8R8_SRGB_PACK32;
+    char name[64];
+    snprintf(name, sizeof(name), "/frame%u_%u.%s", frame, swapchain, (bgra || rgba) ? "ppm" : "raw");
+    std::string path = m_mismatchDir + name;
+
+    FILE* pFile = fopen(path.c_str(), "wb");
+    if (pFile == NULL) {
+        vktrace_LogError("Failed to open %s to write the image of frame %u.", path.c_str(), frame);
+        return;
+    }
+    bool ok;
+    if (bgra || rgba) {
+        fprintf(pFile, "P6\n%u %u\n255\n", entry.width, entry.height);
+        const uint8_t* pPixels = (const uint8_t*)pData;
+        std::string row(entry.width * 3, '\0');
+        ok = true;
+        for (uint32_t y = 0; y < entry.height && ok; y++) {
+            const uint8_t* pPixel = pPixels + (size_t)y * entry.width * 4;
+            for (uint32_t x = 0; x < entry.width; x++, pPixel += 4) {
+                row[x * 3 + 0] = (char)pPixel[bgra ? 2 : 0];
+                row[x * 3 + 1] = (char)pPixel[1];
+                row[x * 3 + 2] = (char)pPixel[bgra ? 0 : 2];
+            }
+            ok = fwrite(row.data(), row.size(), 1, pFile) == 1;
+        }
+    } else {
+        ok = fwrite(pData, size, 1, pFile) == 1;
+    }
+    ok = (fclose(pFile) == 0) && ok;
+    if (!ok) vktrace_LogError("Failed to write the image of frame %u to %s.", frame, path.c_str());
+}
+
+bool FrameChecksums::write() {
+    if (m_manifestPath.empty()) return true;
+
+    FILE* pFile = fopen(m_manifestPath.c_str(), "w");
+    if (pFile == NULL) {
+        vktrace_LogError("Failed to open %s to write the checksum manifest.", m_manifestPath.c_str());
+        return false;
+    }
+    bool ok = fputs(kManifestHeader, pFile) >= 0;
+    for (auto& checksum : m_checksums) {
+        const Entry& entry = checksum.second;
+        ok = ok && fprintf(pFile, "%u %u %u %u %d %016llx\n", checksum.first.first, checksum.first.second, entry.width,
+                           entry.height, entry.format, (unsigned long long)entry.checksum) > 0;
+    }
+    ok = (fclose(pFile) == 0) && ok;
+    if (!ok) {
+        vktrace_LogError("Failed to write the checksum manifest %s.", m_manifestPath.c_str());
+        return false;
+    }
+    vktrace_LogVerbose("Wrote %u frame checksums to %s.", (uint32_t)m_checksums.size(), m_manifestPath.c_str());
+    return true;
+}
+
+}  // namespace vktrace_replay
@@ -0,0 +1,77 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "vulkan/vulkan.h"
+
+namespace vktrace_replay {
+
+// Hashes of presented images, for regression runs that compare a replay against a known good
+// one without writing every frame to disk.  Checksums are written to a manifest file and
+// compared against a golden manifest; only the images that don't match are written out.
+//
+// A manifest is a text file with one line per presented image:
+//     <frame> <swapchain> <width> <height> <format> <xxh64>
+// where swapchain is the index of the swapchain in its vkQueuePresentKHR call.
+class FrameChecksums {
+   public:
+    // Any of the paths may be NULL: no manifest is written, nothing is compared, or mismatching
+    // images are written to the current directory
+    FrameChecksums(const char* pManifestPath, const char* pGoldenPath, const char* pMismatchDir);
+    ~FrameChecksums();
+
+    // True if the golden manifest has a checksum for a frame
+    bool is_golden_frame(uint32_t frame) const;
+    // Hashes a tightly packed image read back from a presented image
+    void add(uint32_t frame, uint32_t swapchain, const VkExtent3D& extent, VkFormat format, const void* pData, size_t size);
+    // Checksums that differ from the golden manifest, including golden checksums of frames that
+    // were never presented
+    uint32_t mismatch_count() const;
+
+    // 64-bit xxHash of a buffer
+    static uint64_t hash(const void* pData, size_t size);
+
+   private:
+    struct Entry {
+        uint32_t width;
+        uint32_t height;
+        VkFormat format;
+        uint64_t checksum;
+    };
+    typedef std::pair<uint32_t, uint32_t> Key;  // frame, swapchain
+
+    void load_golden();
+    bool write();
+    void write_image(uint32_t frame, uint32_t swapchain, const Entry& entry, const void* pData, size_t size);
+
+    std::string m_manifestPath;
+    std::string m_goldenPath;
+    std::string m_mismatchDir;
+    std::map<Key, Entry> m_checksums;
+    std::map<Key, Entry> m_golden;
+    uint32_t m_compareCount;
+    uint32_t m_mismatchCount;
+};
+
+}  // namespace vktrace_replay
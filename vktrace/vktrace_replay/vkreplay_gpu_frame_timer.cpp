@@ -0,0 +1,184 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#include "vkreplay_gpu_frame_timer.h"
+
+extern "C" {
+#include "vktrace_platform.h"
+#include "vktrace_trace_packet_utils.h"
+}
+
+#include "vkreplay_vk_func_ptrs.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace vktrace_replay {
+
+void GpuFrameTimer::add_queue(VkDevice device, VkQueue queue, uint32_t queueFamilyIndex, uint32_t timestampValidBits,
+                              float timestampPeriod) {
+    if (timestampValidBits == 0) {
+        vktrace_LogWarning("Queue family %u does not support timestamps, GPU frame times will not be measured on it.",
+                           queueFamilyIndex);
+        return;
+    }
+    if (m_queues.find(queue) != m_queues.end()) return;
+
+    QueueTimer& timer = m_queues[queue];
+    memset(&timer, 0, sizeof(timer));
+    timer.device = device;
+    timer.queueFamilyIndex = queueFamilyIndex;
+    timer.timestampMask = (timestampValidBits >= 64) ? UINT64_MAX : ((1ULL << timestampValidBits) - 1);
+    timer.timestampPeriod = timestampPeriod;
+}
+
+bool GpuFrameTimer::create(QueueTimer& timer) {
+    timer.created = true;
+
+    VkQueryPoolCreateInfo queryPoolInfo = {};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = kSlotCount;
+    VkCommandPoolCreateInfo commandPoolInfo = {};
+    commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolInfo.queueFamilyIndex = timer.queueFamilyIndex;
+    if (m_vkFuncs.real_vkCreateQueryPool(timer.device, &queryPoolInfo, NULL, &timer.queryPool) != VK_SUCCESS ||
+        m_vkFuncs.real_vkCreateCommandPool(timer.device, &commandPoolInfo, NULL, &timer.commandPool) != VK_SUCCESS) {
+        return false;
+    }
+
+    VkCommandBuffer commandBuffers[kSlotCount];
+    VkCommandBufferAllocateInfo allocateInfo = {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocateInfo.commandPool = timer.commandPool;
+    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocateInfo.commandBufferCount = kSlotCount;
+    if (m_vkFuncs.real_vkAllocateCommandBuffers(timer.device, &allocateInfo, commandBuffers) != VK_SUCCESS) return false;
+
+    // Each slot owns one query, so its command buffer is recorded once and resubmitted
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    for (uint32_t i = 0; i < kSlotCount; i++) {
+        Slot& slot = timer.slots[i];
+        slot.commandBuffer = commandBuffers[i];
+        if (m_vkFuncs.real_vkCreateFence(timer.device, &fenceInfo, NULL, &slot.fence) != VK_SUCCESS ||
+            m_vkFuncs.real_vkBeginCommandBuffer(slot.commandBuffer, &beginInfo) != VK_SUCCESS) {
+            return false;
+        }
+        m_vkFuncs.real_vkCmdResetQueryPool(slot.commandBuffer, timer.queryPool, i, 1);
+        m_vkFuncs.real_vkCmdWriteTimestamp(slot.commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timer.queryPool, i);
+        if (m_vkFuncs.real_vkEndCommandBuffer(slot.commandBuffer) != VK_SUCCESS) return false;
+    }
+    return true;
+}
+
+void GpuFrameTimer::collect(QueueTimer& timer, uint32_t waitCount) {
+    // Slots complete in submission order, so stop at the first one that isn't done
+    while (timer.slots[timer.oldest].inFlight) {
+        Slot& slot = timer.slots[timer.oldest];
+        VkResult result;
+        if (waitCount > 0) {
+            result = m_vkFuncs.real_vkWaitForFences(timer.device, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+            waitCount--;
+        } else {
+            result = m_vkFuncs.real_vkGetFenceStatus(timer.device, slot.fence);
+        }
+        if (result == VK_NOT_READY || result == VK_TIMEOUT) break;
+
+        uint64_t timestamp = 0;
+        if (result == VK_SUCCESS &&
+            m_vkFuncs.real_vkGetQueryPoolResults(timer.device, timer.queryPool, timer.oldest, 1, sizeof(timestamp), &timestamp,
+                                                 sizeof(timestamp),
+                                                 VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) == VK_SUCCESS) {
+            timestamp &= timer.timestampMask;
+            if (timer.haveLastTimestamp) {
+                uint64_t ticks = (timestamp - timer.lastTimestamp) & timer.timestampMask;
+                m_frameTimes.push_back(ticks * timer.timestampPeriod / 1e6);
+            }
+            timer.lastTimestamp = timestamp;
+            timer.haveLastTimestamp = true;
+        } else {
+            // Don't report a frame time across a lost timestamp
+            timer.haveLastTimestamp = false;
+        }
+        slot.inFlight = false;
+        timer.oldest = (timer.oldest + 1) % kSlotCount;
+    }
+}
+
+void GpuFrameTimer::frame_boundary(VkQueue queue) {
+    auto it = m_queues.find(queue);
+    if (it == m_queues.end()) return;
+    QueueTimer& timer = it->second;
+    if (!timer.created && !create(timer)) {
+        vktrace_LogWarning("Failed to create GPU frame timer resources, GPU frame times will not be measured.");
+        timer.failed = true;
+    }
+    if (timer.failed) return;
+
+    collect(timer, timer.slots[timer.next].inFlight ? 1 : 0);
+
+    Slot& slot = timer.slots[timer.next];
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &slot.commandBuffer;
+    if (m_vkFuncs.real_vkResetFences(timer.device, 1, &slot.fence) != VK_SUCCESS ||
+        m_vkFuncs.real_vkQueueSubmit(queue, 1, &submitInfo, slot.fence) != VK_SUCCESS) {
+        timer.haveLastTimestamp = false;
+        return;
+    }
+    slot.inFlight = true;
+    timer.next = (timer.next + 1) % kSlotCount;
+}
+
+unsigned int GpuFrameTimer::take_frame_times(double* pFrameTimes, unsigned int maxCount, bool wait) {
+    for (auto& entry : m_queues) {
+        if (entry.second.created && !entry.second.failed) collect(entry.second, wait ? kSlotCount : 0);
+    }
+    unsigned int count = (unsigned int)std::min((size_t)maxCount, m_frameTimes.size());
+    std::copy(m_frameTimes.begin(), m_frameTimes.begin() + count, pFrameTimes);
+    m_frameTimes.erase(m_frameTimes.begin(), m_frameTimes.begin() + count);
+    return count;
+}
+
+void GpuFrameTimer::destroy(QueueTimer& timer) {
+    if (!timer.failed) collect(timer, kSlotCount);
+    for (uint32_t i = 0; i < kSlotCount; i++) {
+        if (timer.slots[i].fence != VK_NULL_HANDLE) m_vkFuncs.real_vkDestroyFence(timer.device, timer.slots[i].fence, NULL);
+    }
+    // Destroying the pool frees its command buffers
+    if (timer.commandPool != VK_NULL_HANDLE) m_vkFuncs.real_vkDestroyCommandPool(timer.device, timer.commandPool, NULL);
+    if (timer.queryPool != VK_NULL_HANDLE) m_vkFuncs.real_vkDestroyQueryPool(timer.device, timer.queryPool, NULL);
+}
+
+void GpuFrameTimer::destroy_device(VkDevice device) {
+    for (auto it = m_queues.begin(); it != m_queues.end();) {
+        if (it->second.device == device) {
+            if (it->second.created) destroy(it->second);
+            it = m_queues.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+}  // namespace vktrace_replay
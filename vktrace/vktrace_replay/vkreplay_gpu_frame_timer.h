@@ -0,0 +1,83 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+struct vkFuncs;
+
+namespace vktrace_replay {
+
+// Measures GPU frame times with timestamp queries.  At every present a small command buffer
+// that writes a bottom of pipe timestamp is submitted to the presenting queue, so a frame
+// time is the GPU time between the end of the work submitted before two consecutive presents.
+// Completed timestamps are collected without stalling the queue unless all slots are in flight.
+class GpuFrameTimer {
+   public:
+    GpuFrameTimer(vkFuncs& funcs) : m_vkFuncs(funcs) {}
+
+    // Registers a replayed queue; queues whose family has no timestamp bits are ignored
+    void add_queue(VkDevice device, VkQueue queue, uint32_t queueFamilyIndex, uint32_t timestampValidBits,
+                   float timestampPeriod);
+    // Called right before a present on queue
+    void frame_boundary(VkQueue queue);
+    // Moves up to maxCount collected frame times, in milliseconds, into pFrameTimes; with
+    // wait set, waits for every timestamp in flight first
+    unsigned int take_frame_times(double* pFrameTimes, unsigned int maxCount, bool wait);
+    // Collects outstanding timestamps and frees everything created on device
+    void destroy_device(VkDevice device);
+
+   private:
+    static const uint32_t kSlotCount = 16;
+
+    struct Slot {
+        VkCommandBuffer commandBuffer;
+        VkFence fence;
+        bool inFlight;
+    };
+    struct QueueTimer {
+        VkDevice device;
+        uint32_t queueFamilyIndex;
+        uint64_t timestampMask;
+        double timestampPeriod;
+        VkCommandPool commandPool;
+        VkQueryPool queryPool;
+        Slot slots[kSlotCount];
+        uint32_t next;
+        uint32_t oldest;
+        uint64_t lastTimestamp;
+        bool haveLastTimestamp;
+        bool created;
+        bool failed;
+    };
+
+    bool create(QueueTimer& timer);
+    void collect(QueueTimer& timer, uint32_t waitCount);
+    void destroy(QueueTimer& timer);
+
+    vkFuncs& m_vkFuncs;
+    std::unordered_map<VkQueue, QueueTimer> m_queues;
+    std::vector<double> m_frameTimes;
+};
+
+}  // namespace vktrace_replay
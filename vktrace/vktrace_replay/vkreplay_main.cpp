@@ -21,8 +21,11 @@
  * Author: David Pinedo <david@lunarg.com>
  **************************************************************************/
 
+#include <inttypes.h>
 #include <stdio.h>
+#include <algorithm>
 #include <string>
+#include <vector>
 #if defined(ANDROID)
 #include <sstream>
 #include <android/log.h>
@@ -33,12 +36,17 @@
 #include "vktrace_filelike.h"
 #include "vktrace_trace_packet_utils.h"
 #include "vkreplay_main.h"
+#include "vkreplay_portability.h"
+#include "vktrace_vk_packet_id.h"
 #include "vkreplay_factory.h"
 #include "vkreplay_seq.h"
 #include "vkreplay_window.h"
 #include "screenshot_parsing.h"
+#include "vkreplay_benchmark.h"
+#include "vkreplay_recording_threads.h"
 
-vkreplayer_settings replaySettings = {NULL, 1, -1, -1, NULL, NULL, NULL};
+vkreplayer_settings replaySettings = {NULL, 1, -1, -1, NULL, NULL, NULL, FALSE, FALSE, NULL, 1, NULL, FALSE, 0, 0, NULL, 0, FALSE,
+                                      NULL, NULL, NULL, NULL};
 
 vktrace_SettingInfo g_settings_info[] = {
     {"o",
@@ -76,6 +84,38 @@ vktrace_SettingInfo g_settings_info[] = {
      {&replaySettings.loopEndFrame},
      TRUE,
      "The end frame number of the loop range."},
+    {"plm",
+     "PreloadLoopMemory",
+     VKTRACE_SETTING_UINT,
+     {&replaySettings.preloadLoopMemory},
+     {&replaySettings.preloadLoopMemory},
+     TRUE,
+     "Replay the loop range from memory after the first loop, using at most <uint> MB.\n\
+                                         0 (default) always reads the trace file."},
+    {"rt",
+     "RecordingThreads",
+     VKTRACE_SETTING_UINT,
+     {&replaySettings.recordingThreads},
+     {&replaySettings.recordingThreads},
+     TRUE,
+     "Replay command buffer recording on <uint> threads, keeping each traced thread on its own\n\
+                                         thread when there are enough. 0 (default) replays everything on one thread."},
+    {"pipelinecache",
+     "PipelineCache",
+     VKTRACE_SETTING_STRING,
+     {&replaySettings.pipelineCacheFile},
+     {&replaySettings.pipelineCacheFile},
+     TRUE,
+     "Create pipelines with a pipeline cache loaded from and saved to the file <string>.\n\
+                                         The file is only used for the same trace and driver version."},
+    {"sm",
+     "SubAllocateMemory",
+     VKTRACE_SETTING_UINT,
+     {&replaySettings.subAllocateMemory},
+     {&replaySettings.subAllocateMemory},
+     TRUE,
+     "Pack memory allocations into device memory blocks of <uint> MB.\n\
+                                         0 (default) makes one allocation per traced allocation."},
     {"s",
      "Screenshot",
      VKTRACE_SETTING_STRING,
@@ -93,6 +133,89 @@ vktrace_SettingInfo g_settings_info[] = {
      {&replaySettings.screenshotColorFormat},
      TRUE,
      "Color Space format of screenshot files. Formats are UNORM, SNORM, USCALED, SSCALED, UINT, SINT, SRGB"},
+    {"nd",
+     "NullDriver",
+     VKTRACE_SETTING_BOOL,
+     {&replaySettings.nullDriver},
+     {&replaySettings.nullDriver},
+     TRUE,
+     "Replay without a Vulkan driver: every command succeeds without doing any work.\n\
+                                         Measures the CPU cost of the replayer itself."},
+    {"hl",
+     "Headless",
+     VKTRACE_SETTING_BOOL,
+     {&replaySettings.headless},
+     {&replaySettings.headless},
+     TRUE,
+     "Replay without a window system: swapchains are replaced by offscreen images."},
+    {"cf",
+     "ChecksumFrames",
+     VKTRACE_SETTING_STRING,
+     {&replaySettings.checksumFrames},
+     {&replaySettings.checksumFrames},
+     TRUE,
+     "When replaying headless, read back the presented images of frames and log their checksums.\n\
+                                         <string> takes the same forms as the screenshot frame list."},
+    {"cm",
+     "ChecksumManifest",
+     VKTRACE_SETTING_STRING,
+     {&replaySettings.checksumManifest},
+     {&replaySettings.checksumManifest},
+     TRUE,
+     "Write the frame checksums to the manifest file <string>. Every frame is checksummed\n\
+                                         unless -cf or -cg select frames."},
+    {"cg",
+     "ChecksumGolden",
+     VKTRACE_SETTING_STRING,
+     {&replaySettings.checksumGolden},
+     {&replaySettings.checksumGolden},
+     TRUE,
+     "Compare the frame checksums against the golden manifest file <string>, and exit with\n\
+                                         an error if any differ. The frames in the manifest are checksummed."},
+    {"cd",
+     "ChecksumMismatchDir",
+     VKTRACE_SETTING_STRING,
+     {&replaySettings.checksumMismatchDir},
+     {&replaySettings.checksumMismatchDir},
+     TRUE,
+     "Directory the images of frames that don't match the golden manifest are written to.\n\
+                                         Defaults to the current directory."},
+    {"pt",
+     "PacketTimers",
+     VKTRACE_SETTING_BOOL,
+     {&replaySettings.packetTimers},
+     {&replaySettings.packetTimers},
+     TRUE,
+     "Time reading, interpreting and replaying each packet type and print a summary at exit."},
+    {"b",
+     "Benchmark",
+     VKTRACE_SETTING_STRING,
+     {&replaySettings.benchmarkOutput},
+     {&replaySettings.benchmarkOutput},
+     TRUE,
+     "Benchmark the replay and write per-frame timing statistics to <string>.\n\
+                                         Warmup loops are replayed before the -l measured loops."},
+    {"bw",
+     "BenchmarkWarmupLoops",
+     VKTRACE_SETTING_UINT,
+     {&replaySettings.benchmarkWarmupLoops},
+     {&replaySettings.benchmarkWarmupLoops},
+     TRUE,
+     "The number of unmeasured loops replayed before benchmarking."},
+    {"bf",
+     "BenchmarkFormat",
+     VKTRACE_SETTING_STRING,
+     {&replaySettings.benchmarkFormat},
+     {&replaySettings.benchmarkFormat},
+     TRUE,
+     "Format of the benchmark results. Formats are \"json\" (default) and \"csv\"."},
+    {"bg",
+     "BenchmarkGpuTime",
+     VKTRACE_SETTING_BOOL,
+     {&replaySettings.benchmarkGpuTime},
+     {&replaySettings.benchmarkGpuTime},
+     TRUE,
+     "Also measure GPU frame times with timestamp queries when benchmarking."},
 #if _DEBUG
     {"v",
      "Verbosity",
@@ -117,6 +240,70 @@ vktrace_SettingInfo g_settings_info[] = {
 vktrace_SettingGroup g_replaySettingGroup = {"vkreplay", sizeof(g_settings_info) / sizeof(g_settings_info[0]), &g_settings_info[0]};
 
 namespace vktrace_replay {
+// Time spent on each packet type by main_loop when packet timers are enabled
+struct PacketTimes {
+    uint64_t count;
+    uint64_t readTime;
+    uint64_t interpretTime;
+    uint64_t replayTime;
+};
+
+// Packet timers are kept for the entrypoint ids, then VKTRACE_TPI_BLOB, then all other ids together
+#define PACKET_TIMER_BLOB VKTRACE_TPI_VK_END
+#define PACKET_TIMER_UNKNOWN (VKTRACE_TPI_VK_END + 1)
+#define PACKET_TIMER_COUNT (VKTRACE_TPI_VK_END + 2)
+
+static size_t packet_timer_index(uint16_t packetId) {
+    if (packetId < VKTRACE_TPI_VK_END) return packetId;
+    return (packetId == VKTRACE_TPI_BLOB) ? PACKET_TIMER_BLOB : PACKET_TIMER_UNKNOWN;
+}
+
+static const char* packet_timer_name(size_t index) {
+    if (index == PACKET_TIMER_UNKNOWN) return "unknown";
+    return vktrace_packet_id_name((index == PACKET_TIMER_BLOB) ? (uint16_t)VKTRACE_TPI_BLOB : (uint16_t)index);
+}
+
+static void print_packet_times(const std::vector<PacketTimes>& times, uint64_t elapsedTime) {
+    std::vector<uint16_t> ids;
+    PacketTimes total = {};
+    for (size_t id = 0; id < times.size(); id++) {
+        if (times[id].count == 0) continue;
+        ids.push_back((uint16_t)id);
+        total.count += times[id].count;
+        total.readTime += times[id].readTime;
+        total.interpretTime += times[id].interpretTime;
+        total.replayTime += times[id].replayTime;
+    }
+    std::sort(ids.begin(), ids.end(), [&times](uint16_t a, uint16_t b) {
+        return times[a].readTime + times[a].interpretTime + times[a].replayTime >
+               times[b].readTime + times[b].interpretTime + times[b].replayTime;
+    });
+
+    vktrace_LogAlways("Packet timers (ms):");
+    vktrace_LogAlways("%-48s %10s %12s %12s %12s %10s", "packet", "count", "read", "interpret", "replay", "us/packet");
+    for (uint16_t id : ids) {
+        const PacketTimes& t = times[id];
+        vktrace_LogAlways("%-48s %10" PRIu64 " %12.3f %12.3f %12.3f %10.3f", packet_timer_name(id), t.count, t.readTime / 1e6,
+                          t.interpretTime / 1e6, t.replayTime / 1e6, (t.readTime + t.interpretTime + t.replayTime) / 1e3 / t.count);
+    }
+    vktrace_LogAlways("%-48s %10" PRIu64 " %12.3f %12.3f %12.3f", "total", total.count, total.readTime / 1e6,
+                      total.interpretTime / 1e6, total.replayTime / 1e6);
+    if (elapsedTime > 0) {
+        vktrace_LogAlways("Replayed %" PRIu64 " packets in %.3f s, %.0f packets/s", total.count, elapsedTime / 1e9,
+                          total.count * 1e9 / elapsedTime);
+    }
+}
+
+// Interprets a packet of the preloaded loop range the same way main_loop does before replaying it
+static vktrace_trace_packet_header* interpret_preloaded_packet(void* pUserData, vktrace_trace_packet_header* pPacket) {
+    vktrace_trace_packet_replay_library** replayerArray = (vktrace_trace_packet_replay_library**)pUserData;
+    if (pPacket->packet_id < VKTRACE_TPI_VK_vkApiVersion || pPacket->packet_id == VKTRACE_TPI_BLOB ||
+        pPacket->tracer_id >= VKTRACE_MAX_TRACER_ID_ARRAY_SIZE || replayerArray[pPacket->tracer_id] == NULL) {
+        return pPacket;
+    }
+    return replayerArray[pPacket->tracer_id]->Interpret(pPacket);
+}
+
 int main_loop(vktrace_replay::ReplayDisplay display, Sequencer& seq, vktrace_trace_packet_replay_library* replayerArray[],
               vkreplayer_settings settings) {
     int err = 0;
@@ -129,10 +316,38 @@ int main_loop(vktrace_replay::ReplayDisplay display, Sequencer& seq, vktrace_tra
     bool trace_running = true;
     int prevFrameNumber = -1;
 
+    // Packet timers; timing is skipped entirely when they aren't enabled
+    std::vector<PacketTimes> packetTimes;
+    uint64_t loopStartTime = 0, timeStamp = 0;
+    if (settings.packetTimers) {
+        packetTimes.resize(PACKET_TIMER_COUNT);
+        loopStartTime = vktrace_get_time();
+    }
+
+    // Benchmarking replays the warmup loops before the measured ones
+    Benchmark* pBenchmark = NULL;
+    unsigned int warmupLoops = 0, measuredLoops = settings.numLoops, loopIndex = 0;
+    uint64_t packetStartTime = 0;
+    if (settings.benchmarkOutput != NULL) {
+        pBenchmark = new Benchmark();
+        warmupLoops = settings.benchmarkWarmupLoops;
+        settings.numLoops += warmupLoops;
+    }
+
+    // Command buffer recording can be spread over worker threads
+    RecordingThreads* pRecordingThreads = NULL;
+    if (settings.recordingThreads > 0) pRecordingThreads = new RecordingThreads(settings.recordingThreads);
+
+    // The first loop reads the loop range from the trace file, later ones can replay it from memory
+    if (settings.preloadLoopMemory > 0 && settings.numLoops > 1) {
+        seq.begin_preload((uint64_t)settings.preloadLoopMemory << 20);
+    }
+
     // record the location of looping start packet
     seq.record_bookmark();
     seq.get_bookmark(startingPacket);
     while (settings.numLoops > 0) {
+        if (pBenchmark != NULL) pBenchmark->begin_loop(loopIndex >= warmupLoops);
         while (trace_running) {
             display.process_event();
             if (display.get_quit_status()) {
@@ -141,8 +356,17 @@ int main_loop(vktrace_replay::ReplayDisplay display, Sequencer& seq, vktrace_tra
             if (display.get_pause_status()) {
                 continue;
             } else {
+                if (settings.packetTimers) timeStamp = vktrace_get_time();
+                if (pBenchmark != NULL) packetStartTime = settings.packetTimers ? timeStamp : vktrace_get_time();
                 packet = seq.get_next_packet();
                 if (!packet) break;
+                if (settings.packetTimers) {
+                    uint64_t now = vktrace_get_time();
+                    PacketTimes& times = packetTimes[packet_timer_index(packet->packet_id)];
+                    times.count++;
+                    times.readTime += now - timeStamp;
+                    timeStamp = now;
+                }
             }
 
             switch (packet->packet_id) {
@@ -163,6 +387,12 @@ int main_loop(vktrace_replay::ReplayDisplay display, Sequencer& seq, vktrace_tra
                     break;
                 case VKTRACE_TPI_PORTABILITY_TABLE:
                     break;
+                case VKTRACE_TPI_BLOB:
+                    if (!vktrace_trace_packet_register_blob(packet)) {
+                        err = -1;
+                        goto out;
+                    }
+                    break;
                 // TODO processing code for all the above cases
                 default: {
                     if (packet->tracer_id >= VKTRACE_MAX_TRACER_ID_ARRAY_SIZE || packet->tracer_id == VKTRACE_TID_RESERVED) {
@@ -175,11 +405,39 @@ int main_loop(vktrace_replay::ReplayDisplay display, Sequencer& seq, vktrace_tra
                         continue;
                     }
                     if (packet->packet_id >= VKTRACE_TPI_VK_vkApiVersion) {
+                        // A packet handed to a recording thread may be freed before dispatch returns,
+                        // so only these copies are used once it has been replayed
+                        uint16_t packetId = packet->packet_id;
+                        uint64_t globalPacketIndex = packet->global_packet_index;
+
                         // replay the API packet
-                        res = replayer->Replay(replayer->Interpret(packet));
+                        vktrace_trace_packet_header* pInterpreted =
+                            seq.replaying_preloaded() ? packet : replayer->Interpret(packet);
+                        if (settings.packetTimers) {
+                            uint64_t now = vktrace_get_time();
+                            packetTimes[packet_timer_index(packetId)].interpretTime += now - timeStamp;
+                            timeStamp = now;
+                        }
+                        if (pRecordingThreads != NULL && pRecordingThreads->is_recording_packet(packetId)) {
+                            pRecordingThreads->dispatch(replayer, pInterpreted, seq.detach_last_packet());
+                            packet = NULL;
+                            pInterpreted = NULL;
+                            res = VKTRACE_REPLAY_SUCCESS;
+                        } else {
+                            // Everything else is replayed in trace order once the recording threads are idle
+                            if (pRecordingThreads != NULL) pRecordingThreads->wait_idle();
+                            res = replayer->Replay(pInterpreted);
+                        }
+                        if (settings.packetTimers) {
+                            packetTimes[packet_timer_index(packetId)].replayTime += vktrace_get_time() - timeStamp;
+                        }
+                        if (pBenchmark != NULL) {
+                            pBenchmark->add_packet(packetId, vktrace_get_time() - packetStartTime);
+                            if (packetId == VKTRACE_TPI_VK_vkQueuePresentKHR) pBenchmark->end_frame();
+                        }
                         if (res != VKTRACE_REPLAY_SUCCESS) {
-                            vktrace_LogError("Failed to replay packet_id %d, with global_packet_index %d.", packet->packet_id,
-                                             packet->global_packet_index);
+                            vktrace_LogError("Failed to replay packet_id %d, with global_packet_index %" PRIu64 ".", packetId,
+                                             globalPacketIndex);
                             static BOOL QuitOnAnyError = FALSE;
                             if (QuitOnAnyError) {
                                 err = -1;
@@ -211,6 +469,16 @@ int main_loop(vktrace_replay::ReplayDisplay display, Sequencer& seq, vktrace_tra
                 }
             }
         }
+        if (pRecordingThreads != NULL) pRecordingThreads->wait_idle();
+        if (pBenchmark != NULL && replayer != NULL && replayer->GetGpuFrameTimes != NULL) {
+            // Wait for this loop's timestamps so that they aren't mixed with the next loop's
+            double gpuFrameTimes[256];
+            unsigned int count;
+            while ((count = replayer->GetGpuFrameTimes(gpuFrameTimes, 256, TRUE)) > 0) {
+                if (pBenchmark->is_measuring()) pBenchmark->add_gpu_frame_times(gpuFrameTimes, count);
+            }
+        }
+        loopIndex++;
         settings.numLoops--;
         if (settings.numLoops)
             vktrace_LogAlways("Loop number %d completed. Remaining loops:%d", settings.numLoops + 1, settings.numLoops);
@@ -221,6 +489,7 @@ int main_loop(vktrace_replay::ReplayDisplay display, Sequencer& seq, vktrace_tra
             vktrace_free((char*)replaySettings.screenshotList);
             replaySettings.screenshotList = NULL;
         }
+        seq.end_preload(interpret_preloaded_packet, replayerArray);
         seq.set_bookmark(startingPacket);
         trace_running = true;
         if (replayer != NULL) {
@@ -229,7 +498,18 @@ int main_loop(vktrace_replay::ReplayDisplay display, Sequencer& seq, vktrace_tra
     }
 
 out:
+    // Joins the recording threads once they have replayed everything dispatched to them
+    delete pRecordingThreads;
+    if (settings.packetTimers) print_packet_times(packetTimes, vktrace_get_time() - loopStartTime);
+    if (pBenchmark != NULL) {
+        if (!pBenchmark->write(settings.benchmarkOutput, settings.benchmarkFormat ? settings.benchmarkFormat : "json",
+                               settings.pTraceFilePath, warmupLoops, measuredLoops))
+            err = -1;
+        pBenchmark->log_summary();
+        delete pBenchmark;
+    }
     seq.clean_up();
+    vktrace_trace_packet_clear_blobs();
     if (replaySettings.screenshotList != NULL) {
         vktrace_free((char*)replaySettings.screenshotList);
         replaySettings.screenshotList = NULL;
@@ -379,6 +659,39 @@ int vkreplay_main(int argc, char** argv, vktrace_window_handle window = 0) {
         vktrace_set_global_var("VK_SCREENSHOT_FORMAT", "");
     }
 
+    // Check the benchmark options
+    if (replaySettings.benchmarkFormat != NULL && strcmp(replaySettings.benchmarkFormat, "json") != 0 &&
+        strcmp(replaySettings.benchmarkFormat, "csv") != 0) {
+        vktrace_LogError("Invalid benchmark format '%s'.", replaySettings.benchmarkFormat);
+        vktrace_SettingGroup_print(&g_replaySettingGroup);
+        if (pAllSettings != NULL) {
+            vktrace_SettingGroup_Delete_Loaded(&pAllSettings, &numAllSettings);
+        }
+        return -1;
+    }
+    if (replaySettings.benchmarkGpuTime && replaySettings.benchmarkOutput == NULL) {
+        vktrace_LogWarning("GPU frame times are only measured when benchmarking!");
+    }
+    if (replaySettings.pipelineCacheFile != NULL && replaySettings.nullDriver) {
+        vktrace_LogWarning("The pipeline cache file is not used with the null driver!");
+    }
+    if (replaySettings.headless && replaySettings.nullDriver) {
+        vktrace_LogWarning("The null driver is always headless, offscreen images are not used!");
+    }
+    if ((replaySettings.checksumFrames != NULL || replaySettings.checksumManifest != NULL ||
+         replaySettings.checksumGolden != NULL) &&
+        !replaySettings.headless) {
+        vktrace_LogWarning("Frame checksums are only computed when replaying headless!");
+    }
+    if (replaySettings.checksumFrames != NULL && !screenshot::checkParsingFrameRange(replaySettings.checksumFrames)) {
+        vktrace_LogError("Checksum frame range error");
+        vktrace_SettingGroup_print(&g_replaySettingGroup);
+        if (pAllSettings != NULL) {
+            vktrace_SettingGroup_Delete_Loaded(&pAllSettings, &numAllSettings);
+        }
+        return -1;
+    }
+
     // open the trace file
     char* pTraceFile = replaySettings.pTraceFilePath;
     vktrace_trace_file_header fileHeader;
@@ -471,6 +784,8 @@ int vkreplay_main(int argc, char** argv, vktrace_window_handle window = 0) {
     if (pFileHeader->portability_table_valid) pFileHeader->portability_table_valid = readPortabilityTable();
     if (!pFileHeader->portability_table_valid)
         vktrace_LogAlways("Trace file does not appear to contain portability table. Will not attempt to map memoryType indices.");
+    else
+        portabilityIndex.build(pTraceFile, portabilityTable);
 
     // load any API specific driver libraries and init replayer objects
     uint8_t tidApi = VKTRACE_TID_RESERVED;
@@ -556,6 +871,11 @@ int vkreplay_main(int argc, char** argv, vktrace_window_handle window = 0) {
     // main loop
     Sequencer sequencer(traceFile);
     err = vktrace_replay::main_loop(disp, sequencer, replayer, replaySettings);
+    for (int i = 0; i < VKTRACE_MAX_TRACER_ID_ARRAY_SIZE; i++) {
+        if (replayer[i] != NULL && replayer[i]->GetChecksumMismatches != NULL && replayer[i]->GetChecksumMismatches() > 0) {
+            err = -1;
+        }
+    }
 
     for (int i = 0; i < VKTRACE_MAX_TRACER_ID_ARRAY_SIZE; i++) {
         if (replayer[i] != NULL) {
@@ -30,6 +30,21 @@ typedef struct vkreplayer_settings {
     const char* screenshotList;
     const char* screenshotColorFormat;
     const char* verbosity;
+    BOOL nullDriver;
+    BOOL packetTimers;
+    const char* benchmarkOutput;
+    unsigned int benchmarkWarmupLoops;
+    const char* benchmarkFormat;
+    BOOL benchmarkGpuTime;
+    unsigned int preloadLoopMemory;
+    unsigned int recordingThreads;
+    const char* pipelineCacheFile;
+    unsigned int subAllocateMemory;
+    BOOL headless;
+    const char* checksumFrames;
+    const char* checksumManifest;
+    const char* checksumGolden;
+    const char* checksumMismatchDir;
 } vkreplayer_settings;
 
 #include <vector>
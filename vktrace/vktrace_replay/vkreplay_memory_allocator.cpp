@@ -0,0 +1,205 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#include "vkreplay_memory_allocator.h"
+
+extern "C" {
+#include "vktrace_platform.h"
+#include "vktrace_trace_packet_utils.h"
+}
+
+#include "vkreplay_vk_func_ptrs.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace vktrace_replay {
+
+// Alignment used when the resources bound to an allocation aren't known yet, large enough for
+// any image on current devices
+static const VkDeviceSize kUnknownAlignment = 64 * 1024;
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+const MemorySubAllocator::DeviceInfo& MemorySubAllocator::device_info(VkDevice device, VkPhysicalDevice physicalDevice) {
+    auto it = m_devices.find(device);
+    if (it != m_devices.end()) return it->second;
+
+    DeviceInfo& info = m_devices[device];
+    VkPhysicalDeviceProperties properties;
+    m_vkFuncs.real_vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    m_vkFuncs.real_vkGetPhysicalDeviceMemoryProperties(physicalDevice, &info.memoryProperties);
+    // Starting every sub-allocation on a bufferImageGranularity page keeps linear and optimal
+    // resources of different sub-allocations apart, and starting it on a nonCoherentAtomSize
+    // boundary keeps the traced flush and invalidate offsets valid
+    info.atomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+    info.minAlignment = std::max<VkDeviceSize>(
+        {properties.limits.bufferImageGranularity, properties.limits.nonCoherentAtomSize, properties.limits.minMemoryMapAlignment, 256});
+    return info;
+}
+
+bool MemorySubAllocator::allocate_from(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* pOffset) {
+    // First fit
+    for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it) {
+        VkDeviceSize offset = align_up(it->first, alignment);
+        VkDeviceSize end = it->first + it->second;
+        if (offset + size > end) continue;
+
+        VkDeviceSize rangeStart = it->first;
+        block.freeRanges.erase(it);
+        if (offset > rangeStart) block.freeRanges[rangeStart] = offset - rangeStart;
+        if (offset + size < end) block.freeRanges[offset + size] = end - (offset + size);
+        block.usedRanges[offset] = size;
+        *pOffset = offset;
+        return true;
+    }
+    return false;
+}
+
+bool MemorySubAllocator::allocate(VkDevice device, VkPhysicalDevice physicalDevice, const VkMemoryAllocateInfo& allocateInfo,
+                                  VkDeviceSize alignment, VkDeviceMemory* pMemory, VkDeviceSize* pOffset) {
+    // Dedicated, imported and exported allocations need memory of their own
+    if (allocateInfo.pNext != NULL || allocateInfo.allocationSize > m_blockSize / 2) return false;
+    const DeviceInfo& info = device_info(device, physicalDevice);
+    if (allocateInfo.memoryTypeIndex >= info.memoryProperties.memoryTypeCount) return false;
+
+    alignment = std::max(info.minAlignment, (alignment != 0) ? alignment : kUnknownAlignment);
+    VkDeviceSize size = align_up(std::max<VkDeviceSize>(allocateInfo.allocationSize, 1), info.minAlignment);
+
+    std::vector<Block*>& blocks = m_typeBlocks[std::make_pair(device, allocateInfo.memoryTypeIndex)];
+    for (Block* pBlock : blocks) {
+        if (allocate_from(*pBlock, size, alignment, pOffset)) {
+            *pMemory = pBlock->memory;
+            return true;
+        }
+    }
+
+    VkMemoryAllocateInfo blockInfo = {};
+    blockInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    blockInfo.allocationSize = m_blockSize;
+    blockInfo.memoryTypeIndex = allocateInfo.memoryTypeIndex;
+    VkDeviceMemory memory;
+    if (m_vkFuncs.real_vkAllocateMemory(device, &blockInfo, NULL, &memory) != VK_SUCCESS) {
+        vktrace_LogWarning("Failed to allocate a %llu byte memory block of type %u, allocating memory without sub-allocation.",
+                           (unsigned long long)m_blockSize, allocateInfo.memoryTypeIndex);
+        return false;
+    }
+    Block* pBlock = new Block();
+    pBlock->device = device;
+    pBlock->memory = memory;
+    pBlock->memoryTypeIndex = allocateInfo.memoryTypeIndex;
+    pBlock->size = m_blockSize;
+    pBlock->atomSize = info.atomSize;
+    pBlock->pMapped = NULL;
+    pBlock->freeRanges[0] = m_blockSize;
+    blocks.push_back(pBlock);
+    m_blocks[memory] = pBlock;
+
+    allocate_from(*pBlock, size, alignment, pOffset);
+    *pMemory = memory;
+    return true;
+}
+
+void MemorySubAllocator::free(VkDeviceMemory memory, VkDeviceSize offset) {
+    auto blockIt = m_blocks.find(memory);
+    if (blockIt == m_blocks.end()) return;
+    Block* pBlock = blockIt->second;
+    auto usedIt = pBlock->usedRanges.find(offset);
+    if (usedIt == pBlock->usedRanges.end()) return;
+    VkDeviceSize size = usedIt->second;
+    pBlock->usedRanges.erase(usedIt);
+
+    // Coalesce with the free ranges on either side
+    auto next = pBlock->freeRanges.lower_bound(offset);
+    if (next != pBlock->freeRanges.end() && next->first == offset + size) {
+        size += next->second;
+        next = pBlock->freeRanges.erase(next);
+    }
+    auto prev = (next != pBlock->freeRanges.begin()) ? std::prev(next) : pBlock->freeRanges.end();
+    if (prev != pBlock->freeRanges.end() && prev->first + prev->second == offset)
+        prev->second += size;
+    else
+        pBlock->freeRanges[offset] = size;
+
+    // Traces often free and reallocate everything between levels or frames, so one empty block
+    // per memory type is kept for the next allocation instead of going back to the driver
+    if (!pBlock->usedRanges.empty()) return;
+    for (Block* pOther : m_typeBlocks[std::make_pair(pBlock->device, pBlock->memoryTypeIndex)]) {
+        if (pOther != pBlock && pOther->usedRanges.empty()) {
+            free_block(pBlock);
+            return;
+        }
+    }
+}
+
+void MemorySubAllocator::free_block(Block* pBlock) {
+    // Freeing the memory also unmaps it
+    m_vkFuncs.real_vkFreeMemory(pBlock->device, pBlock->memory, NULL);
+    m_blocks.erase(pBlock->memory);
+    std::vector<Block*>& blocks = m_typeBlocks[std::make_pair(pBlock->device, pBlock->memoryTypeIndex)];
+    blocks.erase(std::remove(blocks.begin(), blocks.end(), pBlock), blocks.end());
+    delete pBlock;
+}
+
+VkResult MemorySubAllocator::map(VkDeviceMemory memory, void** ppData) {
+    auto it = m_blocks.find(memory);
+    if (it == m_blocks.end()) return VK_ERROR_MEMORY_MAP_FAILED;
+    Block* pBlock = it->second;
+    if (pBlock->pMapped == NULL) {
+        VkResult result = m_vkFuncs.real_vkMapMemory(pBlock->device, pBlock->memory, 0, VK_WHOLE_SIZE, 0, &pBlock->pMapped);
+        if (result != VK_SUCCESS) {
+            pBlock->pMapped = NULL;
+            return result;
+        }
+    }
+    *ppData = pBlock->pMapped;
+    return VK_SUCCESS;
+}
+
+void MemorySubAllocator::remap_range(VkDeviceMemory memory, VkDeviceSize offset, VkMappedMemoryRange* pRange) const {
+    auto blockIt = m_blocks.find(memory);
+    if (blockIt == m_blocks.end()) return;
+    const Block* pBlock = blockIt->second;
+    auto usedIt = pBlock->usedRanges.find(offset);
+    if (usedIt == pBlock->usedRanges.end()) return;
+
+    // A size that isn't a multiple of nonCoherentAtomSize is only valid at the end of the traced
+    // allocation, and the reserved size is a multiple of it, so rounding up stays inside the
+    // sub-allocation
+    VkDeviceSize available = (pRange->offset < usedIt->second) ? usedIt->second - pRange->offset : 0;
+    if (pRange->size == VK_WHOLE_SIZE)
+        pRange->size = available;
+    else
+        pRange->size = std::min(align_up(pRange->size, pBlock->atomSize), available);
+    pRange->offset += offset;
+}
+
+void MemorySubAllocator::destroy_device(VkDevice device) {
+    std::vector<Block*> blocks;
+    for (auto& entry : m_blocks) {
+        if (entry.second->device == device) blocks.push_back(entry.second);
+    }
+    for (Block* pBlock : blocks) free_block(pBlock);
+    for (auto it = m_typeBlocks.begin(); it != m_typeBlocks.end();) {
+        it = (it->first.first == device) ? m_typeBlocks.erase(it) : std::next(it);
+    }
+    m_devices.erase(device);
+}
+
+}  // namespace vktrace_replay
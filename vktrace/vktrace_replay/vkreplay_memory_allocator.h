@@ -0,0 +1,87 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+struct vkFuncs;
+
+namespace vktrace_replay {
+
+// Packs traced memory allocations into large device memory blocks, one set of blocks per
+// device and memory type, so replay makes few vkAllocateMemory calls and stays under the
+// maxMemoryAllocationCount of the replay device.  A sub-allocation is identified by its block
+// and its offset in the block.  Host visible blocks are mapped once, the first time any of
+// their sub-allocations is mapped, and stay mapped until they are freed.  Empty blocks are
+// freed, except for one per device and memory type, which is kept until the device is destroyed.
+class MemorySubAllocator {
+   public:
+    MemorySubAllocator(vkFuncs& funcs, VkDeviceSize blockSize) : m_vkFuncs(funcs), m_blockSize(blockSize) {}
+
+    // Places an allocation in a block.  Returns false if the allocation should get its own
+    // memory instead: it has a pNext chain, is larger than half a block, or no block could be
+    // allocated.  alignment is the alignment required by the resources bound to the
+    // memory, 0 if unknown.
+    bool allocate(VkDevice device, VkPhysicalDevice physicalDevice, const VkMemoryAllocateInfo& allocateInfo,
+                  VkDeviceSize alignment, VkDeviceMemory* pMemory, VkDeviceSize* pOffset);
+    void free(VkDeviceMemory memory, VkDeviceSize offset);
+    // Returns the mapped address of the start of the block
+    VkResult map(VkDeviceMemory memory, void** ppData);
+    // Moves a traced flush or invalidate range of the sub-allocation at offset into its block.
+    // VK_WHOLE_SIZE and sizes that end the traced allocation are clamped to the sub-allocation.
+    void remap_range(VkDeviceMemory memory, VkDeviceSize offset, VkMappedMemoryRange* pRange) const;
+    // Frees every block of device
+    void destroy_device(VkDevice device);
+
+   private:
+    struct DeviceInfo {
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        VkDeviceSize minAlignment;
+        VkDeviceSize atomSize;
+    };
+    struct Block {
+        VkDevice device;
+        VkDeviceMemory memory;
+        uint32_t memoryTypeIndex;
+        VkDeviceSize size;
+        VkDeviceSize atomSize;
+        void* pMapped;
+        // Free ranges and used ranges by offset
+        std::map<VkDeviceSize, VkDeviceSize> freeRanges;
+        std::map<VkDeviceSize, VkDeviceSize> usedRanges;
+    };
+
+    const DeviceInfo& device_info(VkDevice device, VkPhysicalDevice physicalDevice);
+    static bool allocate_from(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* pOffset);
+    void free_block(Block* pBlock);
+
+    vkFuncs& m_vkFuncs;
+    VkDeviceSize m_blockSize;
+    std::unordered_map<VkDevice, DeviceInfo> m_devices;
+    // Blocks of each device and memory type, and every block by its memory
+    std::map<std::pair<VkDevice, uint32_t>, std::vector<Block*>> m_typeBlocks;
+    std::unordered_map<VkDeviceMemory, Block*> m_blocks;
+};
+
+}  // namespace vktrace_replay
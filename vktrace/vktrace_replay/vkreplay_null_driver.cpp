@@ -0,0 +1,300 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#include "vkreplay_null_driver.h"
+
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+static std::atomic<uint64_t> s_nextHandle(0x1000);
+
+// Host memory behind device memory, allocated when the memory is first mapped
+struct NullDeviceMemory {
+    VkDeviceSize size;
+    std::vector<uint8_t> data;
+};
+static std::mutex s_mutex;
+static std::unordered_map<VkDeviceMemory, NullDeviceMemory> s_memory;
+static std::unordered_map<VkSwapchainKHR, std::vector<VkImage>> s_swapchainImages;
+
+// Status of an event, and whether it has been polled since the host last set or reset it
+struct NullEvent {
+    VkResult status;
+    bool polled;
+};
+static std::unordered_map<VkEvent, NullEvent> s_events;
+
+uint64_t null_driver_new_handle() { return s_nextHandle++; }
+
+// Enumerations that replay passes the traced count to report that many items, so that replay
+// sees the same number of physical devices, queue families and swapchain images as the trace.
+static uint32_t null_driver_count(uint32_t requested) { return (requested != 0) ? requested : 1; }
+
+VKAPI_ATTR VkResult VKAPI_CALL null_vkEnumeratePhysicalDevices(VkInstance instance, uint32_t* pPhysicalDeviceCount,
+                                                               VkPhysicalDevice* pPhysicalDevices) {
+    *pPhysicalDeviceCount = null_driver_count(*pPhysicalDeviceCount);
+    if (pPhysicalDevices != NULL) {
+        // Physical devices don't depend on the instance and are the same for every call
+        for (uint32_t i = 0; i < *pPhysicalDeviceCount; i++) pPhysicalDevices[i] = (VkPhysicalDevice)(uintptr_t)(0x100 + i);
+    }
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL null_vkGetPhysicalDeviceFeatures(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures* pFeatures) {
+    VkBool32* pFeature = (VkBool32*)pFeatures;
+    for (size_t i = 0; i < sizeof(VkPhysicalDeviceFeatures) / sizeof(VkBool32); i++) pFeature[i] = VK_TRUE;
+}
+
+VKAPI_ATTR void VKAPI_CALL null_vkGetPhysicalDeviceFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format,
+                                                                    VkFormatProperties* pFormatProperties) {
+    pFormatProperties->linearTilingFeatures = ~0u;
+    pFormatProperties->optimalTilingFeatures = ~0u;
+    pFormatProperties->bufferFeatures = ~0u;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL null_vkGetPhysicalDeviceImageFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format,
+                                                                             VkImageType type, VkImageTiling tiling,
+                                                                             VkImageUsageFlags usage, VkImageCreateFlags flags,
+                                                                             VkImageFormatProperties* pImageFormatProperties) {
+    pImageFormatProperties->maxExtent = {16384, 16384, 2048};
+    pImageFormatProperties->maxMipLevels = 15;
+    pImageFormatProperties->maxArrayLayers = 2048;
+    pImageFormatProperties->sampleCounts = ~0u;
+    pImageFormatProperties->maxResourceSize = ~0ull;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL null_vkGetPhysicalDeviceProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties* pProperties) {
+    memset(pProperties, 0, sizeof(*pProperties));
+    pProperties->apiVersion = VK_MAKE_VERSION(1, 0, VK_HEADER_VERSION);
+    pProperties->driverVersion = 1;
+    pProperties->deviceType = VK_PHYSICAL_DEVICE_TYPE_CPU;
+    strncpy(pProperties->deviceName, "vkreplay null driver", VK_MAX_PHYSICAL_DEVICE_NAME_SIZE - 1);
+
+    VkPhysicalDeviceLimits& limits = pProperties->limits;
+    limits.maxImageDimension1D = 16384;
+    limits.maxImageDimension2D = 16384;
+    limits.maxImageDimension3D = 2048;
+    limits.maxImageDimensionCube = 16384;
+    limits.maxImageArrayLayers = 2048;
+    limits.maxTexelBufferElements = 1u << 27;
+    limits.maxUniformBufferRange = 1u << 16;
+    limits.maxStorageBufferRange = 1u << 30;
+    limits.maxPushConstantsSize = 256;
+    limits.maxMemoryAllocationCount = ~0u;
+    limits.maxSamplerAllocationCount = ~0u;
+    limits.bufferImageGranularity = 1;
+    limits.maxBoundDescriptorSets = 32;
+    limits.maxColorAttachments = 8;
+    limits.maxViewports = 16;
+    limits.maxViewportDimensions[0] = 16384;
+    limits.maxViewportDimensions[1] = 16384;
+    limits.maxFramebufferWidth = 16384;
+    limits.maxFramebufferHeight = 16384;
+    limits.maxFramebufferLayers = 2048;
+    limits.framebufferColorSampleCounts = ~0u;
+    limits.framebufferDepthSampleCounts = ~0u;
+    limits.framebufferStencilSampleCounts = ~0u;
+    limits.minMemoryMapAlignment = 64;
+    limits.minTexelBufferOffsetAlignment = 1;
+    limits.minUniformBufferOffsetAlignment = 1;
+    limits.minStorageBufferOffsetAlignment = 1;
+    limits.timestampComputeAndGraphics = VK_TRUE;
+    limits.timestampPeriod = 1.0f;
+    limits.optimalBufferCopyOffsetAlignment = 1;
+    limits.optimalBufferCopyRowPitchAlignment = 1;
+    limits.nonCoherentAtomSize = 1;
+}
+
+VKAPI_ATTR void VKAPI_CALL null_vkGetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice physicalDevice,
+                                                                         uint32_t* pQueueFamilyPropertyCount,
+                                                                         VkQueueFamilyProperties* pQueueFamilyProperties) {
+    *pQueueFamilyPropertyCount = null_driver_count(*pQueueFamilyPropertyCount);
+    if (pQueueFamilyProperties == NULL) return;
+    for (uint32_t i = 0; i < *pQueueFamilyPropertyCount; i++) {
+        pQueueFamilyProperties[i].queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT | VK_QUEUE_SPARSE_BINDING_BIT;
+        pQueueFamilyProperties[i].queueCount = 64;
+        pQueueFamilyProperties[i].timestampValidBits = 64;
+        pQueueFamilyProperties[i].minImageTransferGranularity = {1, 1, 1};
+    }
+}
+
+VKAPI_ATTR void VKAPI_CALL null_vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice physicalDevice,
+                                                                    VkPhysicalDeviceMemoryProperties* pMemoryProperties) {
+    // Every memory type index a trace can use exists and has every property
+    memset(pMemoryProperties, 0, sizeof(*pMemoryProperties));
+    pMemoryProperties->memoryTypeCount = VK_MAX_MEMORY_TYPES;
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++) {
+        pMemoryProperties->memoryTypes[i].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        pMemoryProperties->memoryTypes[i].heapIndex = 0;
+    }
+    pMemoryProperties->memoryHeapCount = 1;
+    pMemoryProperties->memoryHeaps[0].size = 1ull << 40;
+    pMemoryProperties->memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL null_vkAllocateMemory(VkDevice device, const VkMemoryAllocateInfo* pAllocateInfo,
+                                                     const VkAllocationCallbacks* pAllocator, VkDeviceMemory* pMemory) {
+    *pMemory = (VkDeviceMemory)null_driver_new_handle();
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_memory[*pMemory].size = pAllocateInfo->allocationSize;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL null_vkFreeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* pAllocator) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_memory.erase(memory);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL null_vkMapMemory(VkDevice device, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size,
+                                                VkMemoryMapFlags flags, void** ppData) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto it = s_memory.find(memory);
+    if (it == s_memory.end() || offset > it->second.size) return VK_ERROR_MEMORY_MAP_FAILED;
+    if (it->second.data.empty()) it->second.data.resize((size_t)it->second.size);
+    *ppData = it->second.data.data() + offset;
+    return VK_SUCCESS;
+}
+
+// Objects don't need memory, so any allocation of any memory type can back them
+VKAPI_ATTR void VKAPI_CALL null_vkGetBufferMemoryRequirements(VkDevice device, VkBuffer buffer,
+                                                              VkMemoryRequirements* pMemoryRequirements) {
+    pMemoryRequirements->size = 0;
+    pMemoryRequirements->alignment = 1;
+    pMemoryRequirements->memoryTypeBits = ~0u;
+}
+
+VKAPI_ATTR void VKAPI_CALL null_vkGetImageMemoryRequirements(VkDevice device, VkImage image, VkMemoryRequirements* pMemoryRequirements) {
+    pMemoryRequirements->size = 0;
+    pMemoryRequirements->alignment = 1;
+    pMemoryRequirements->memoryTypeBits = ~0u;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL null_vkCreateEvent(VkDevice device, const VkEventCreateInfo* pCreateInfo,
+                                                  const VkAllocationCallbacks* pAllocator, VkEvent* pEvent) {
+    *pEvent = (VkEvent)null_driver_new_handle();
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_events[*pEvent] = {VK_EVENT_RESET, false};
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL null_vkDestroyEvent(VkDevice device, VkEvent event, const VkAllocationCallbacks* pAllocator) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_events.erase(event);
+}
+
+// Command buffers never execute, so only the host sets and resets events.  Replay retries
+// vkGetEventStatus until it returns the traced status, so an event that is polled again without
+// the host changing it in between is taken to have been changed by the device, and flips.
+VKAPI_ATTR VkResult VKAPI_CALL null_vkGetEventStatus(VkDevice device, VkEvent event) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto it = s_events.find(event);
+    if (it == s_events.end()) it = s_events.insert(std::make_pair(event, NullEvent{VK_EVENT_RESET, false})).first;
+    NullEvent& nullEvent = it->second;
+    if (nullEvent.polled) nullEvent.status = (nullEvent.status == VK_EVENT_SET) ? VK_EVENT_RESET : VK_EVENT_SET;
+    nullEvent.polled = true;
+    return nullEvent.status;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL null_vkSetEvent(VkDevice device, VkEvent event) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_events[event] = {VK_EVENT_SET, false};
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL null_vkResetEvent(VkDevice device, VkEvent event) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_events[event] = {VK_EVENT_RESET, false};
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL null_vkGetPhysicalDeviceSurfaceSupportKHR(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex,
+                                                                         VkSurfaceKHR surface, VkBool32* pSupported) {
+    *pSupported = VK_TRUE;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL null_vkGetPhysicalDeviceSurfaceCapabilitiesKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface,
+                                                                              VkSurfaceCapabilitiesKHR* pSurfaceCapabilities) {
+    pSurfaceCapabilities->minImageCount = 1;
+    pSurfaceCapabilities->maxImageCount = 0;
+    pSurfaceCapabilities->currentExtent = {0xFFFFFFFF, 0xFFFFFFFF};
+    pSurfaceCapabilities->minImageExtent = {1, 1};
+    pSurfaceCapabilities->maxImageExtent = {16384, 16384};
+    pSurfaceCapabilities->maxImageArrayLayers = 2048;
+    pSurfaceCapabilities->supportedTransforms = ~0u;
+    pSurfaceCapabilities->currentTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    pSurfaceCapabilities->supportedCompositeAlpha = ~0u;
+    pSurfaceCapabilities->supportedUsageFlags = ~0u;
+    return VK_SUCCESS;
+}
+
+// A single VK_FORMAT_UNDEFINED means that the surface has no preferred format
+VKAPI_ATTR VkResult VKAPI_CALL null_vkGetPhysicalDeviceSurfaceFormatsKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface,
+                                                                         uint32_t* pSurfaceFormatCount,
+                                                                         VkSurfaceFormatKHR* pSurfaceFormats) {
+    if (pSurfaceFormats == NULL) {
+        *pSurfaceFormatCount = 1;
+        return VK_SUCCESS;
+    }
+    if (*pSurfaceFormatCount == 0) return VK_INCOMPLETE;
+    *pSurfaceFormatCount = 1;
+    pSurfaceFormats[0].format = VK_FORMAT_UNDEFINED;
+    pSurfaceFormats[0].colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL null_vkGetPhysicalDeviceSurfacePresentModesKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface,
+                                                                              uint32_t* pPresentModeCount,
+                                                                              VkPresentModeKHR* pPresentModes) {
+    static const VkPresentModeKHR presentModes[] = {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR,
+                                                    VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR};
+    const uint32_t count = sizeof(presentModes) / sizeof(presentModes[0]);
+    if (pPresentModes == NULL) {
+        *pPresentModeCount = count;
+        return VK_SUCCESS;
+    }
+    VkResult result = (*pPresentModeCount < count) ? VK_INCOMPLETE : VK_SUCCESS;
+    if (*pPresentModeCount > count) *pPresentModeCount = count;
+    memcpy(pPresentModes, presentModes, *pPresentModeCount * sizeof(VkPresentModeKHR));
+    return result;
+}
+
+VKAPI_ATTR void VKAPI_CALL null_vkDestroySwapchainKHR(VkDevice device, VkSwapchainKHR swapchain,
+                                                     const VkAllocationCallbacks* pAllocator) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_swapchainImages.erase(swapchain);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL null_vkGetSwapchainImagesKHR(VkDevice device, VkSwapchainKHR swapchain, uint32_t* pSwapchainImageCount,
+                                                            VkImage* pSwapchainImages) {
+    *pSwapchainImageCount = null_driver_count(*pSwapchainImageCount);
+    if (pSwapchainImages == NULL) return VK_SUCCESS;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    std::vector<VkImage>& images = s_swapchainImages[swapchain];
+    while (images.size() < *pSwapchainImageCount) images.push_back((VkImage)null_driver_new_handle());
+    memcpy(pSwapchainImages, images.data(), *pSwapchainImageCount * sizeof(VkImage));
+    return VK_SUCCESS;
+}
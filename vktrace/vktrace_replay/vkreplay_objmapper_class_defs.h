@@ -54,7 +54,7 @@ class gpuMemory {
         if (m_mapRange.empty()) {
             return;
         }
-        MapRange mr = m_mapRange.back();
+        const MapRange &mr = m_mapRange.back();
         if (!pSrcData || !mr.pData) {
             if (!pSrcData)
                 vktrace_LogError("gpuMemory::copyMappingData() null src pointer.");
@@ -64,18 +64,7 @@ class gpuMemory {
             return;
         }
 
-        PageGuardChangedBlockInfo *pChangedInfoArray = (PageGuardChangedBlockInfo *)pSrcData;
-        if (pChangedInfoArray[0].length) {
-            PBYTE pChangedData = (PBYTE)(pSrcData) + sizeof(PageGuardChangedBlockInfo) * (pChangedInfoArray[0].offset + 1);
-            DWORD CurrentOffset = 0;
-            for (DWORD i = 0; i < pChangedInfoArray[0].offset; i++) {
-                if ((size_t)pChangedInfoArray[i + 1].length) {
-                    memcpy(mr.pData + (size_t)pChangedInfoArray[i + 1].offset, pChangedData + CurrentOffset,
-                           (size_t)pChangedInfoArray[i + 1].length);
-                }
-                CurrentOffset += pChangedInfoArray[i + 1].length;
-            }
-        }
+        vktrace_pageguard_memcpy_changed_blocks(mr.pData, pSrcData);
     }
 
     void setMemoryMapRange(void *pBuf, const size_t size, const size_t offset, const bool pending) {
@@ -95,7 +84,7 @@ class gpuMemory {
         if (m_mapRange.empty()) {
             return;
         }
-        MapRange mr = m_mapRange.back();
+        const MapRange &mr = m_mapRange.back();
         if (!pSrcData || !mr.pData) {
             if (!pSrcData)
                 vktrace_LogError("gpuMemory::copyMappingData() null src pointer.");
@@ -111,7 +100,7 @@ class gpuMemory {
             assert(offset >= mr.offset);
             assert(size <= mr.size && (size + offset) <= (size_t)m_allocInfo.allocationSize);
         }
-        memcpy(mr.pData + offset, pSrcData, size);
+        vktrace_pageguard_memcpy(mr.pData + offset, pSrcData, size);
         if (!mr.pending && entire_map) m_mapRange.pop_back();
     }
 
@@ -142,6 +131,9 @@ typedef struct _bufferObj {
 typedef struct _devicememoryObj {
     gpuMemory *pGpuMem;
     VkDeviceMemory replayDeviceMemory;
+    // Where the memory starts in replayDeviceMemory when it is a sub-allocation
+    bool subAllocated;
+    VkDeviceSize replayOffset;
 } devicememoryObj;
 
 class vkReplayObjMapper {
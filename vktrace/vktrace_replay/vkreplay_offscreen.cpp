@@ -0,0 +1,813 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#include "vkreplay_vkreplay.h"
+
+extern "C" {
+#include "vktrace_platform.h"
+#include "vktrace_trace_packet_utils.h"
+}
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+vkOffscreenDisplay* vkOffscreenDisplay::s_pDisplay = NULL;
+
+// Bytes per texel of the color formats swapchains are created with, 0 for formats that aren't
+// checksummed
+static uint32_t texel_size(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+        case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+        case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+        case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+            return 4;
+        case VK_FORMAT_R5G6B5_UNORM_PACK16:
+        case VK_FORMAT_B5G6R5_UNORM_PACK16:
+            return 2;
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+vkOffscreenDisplay::vkOffscreenDisplay()
+    : m_pFuncs(NULL),
+      m_realGetInstanceProcAddr(NULL),
+      m_realGetDeviceProcAddr(NULL),
+      m_realCreateDevice(NULL),
+      m_realDestroyDevice(NULL),
+      m_realGetDeviceQueue(NULL),
+      m_pChecksums(NULL),
+      m_presentCount(0),
+      m_nextHandle(0x1000) {
+    m_checksumRange.valid = false;
+    set_headless(true);
+}
+
+vkOffscreenDisplay::~vkOffscreenDisplay() {
+    if (s_pDisplay == this) s_pDisplay = NULL;
+}
+
+void vkOffscreenDisplay::init_funcs(vkFuncs& funcs, const char* pChecksumFrames, vktrace_replay::FrameChecksums* pChecksums) {
+    s_pDisplay = this;
+    m_pFuncs = &funcs;
+    m_pChecksums = pChecksums;
+
+    if (pChecksumFrames != NULL && screenshot::isOptionBelongToScreenShotRange(pChecksumFrames)) {
+        screenshot::initScreenShotFrameRange(pChecksumFrames, &m_checksumRange);
+    } else if (pChecksumFrames != NULL) {
+        const char* pCur = pChecksumFrames;
+        while (*pCur != '\0') {
+            char* pEnd;
+            uint32_t frame = (uint32_t)strtoul(pCur, &pEnd, 10);
+            if (pEnd == pCur) break;
+            m_checksumFrames.push_back(frame);
+            pCur = (*pEnd == ',') ? pEnd + 1 : pEnd;
+        }
+    }
+
+    m_realGetInstanceProcAddr = funcs.real_vkGetInstanceProcAddr;
+    m_realGetDeviceProcAddr = funcs.real_vkGetDeviceProcAddr;
+    m_realCreateDevice = funcs.real_vkCreateDevice;
+    m_realDestroyDevice = funcs.real_vkDestroyDevice;
+    m_realGetDeviceQueue = funcs.real_vkGetDeviceQueue;
+
+    funcs.real_vkGetInstanceProcAddr = GetInstanceProcAddr;
+    funcs.real_vkGetDeviceProcAddr = GetDeviceProcAddr;
+    funcs.real_vkCreateDevice = CreateDevice;
+    funcs.real_vkDestroyDevice = DestroyDevice;
+    funcs.real_vkGetDeviceQueue = GetDeviceQueue;
+#if defined(VK_USE_PLATFORM_XCB_KHR)
+    funcs.real_vkCreateXcbSurfaceKHR = CreateXcbSurfaceKHR;
+    funcs.real_vkGetPhysicalDeviceXcbPresentationSupportKHR = GetPhysicalDeviceXcbPresentationSupportKHR;
+#endif
+#if defined(VK_USE_PLATFORM_XLIB_KHR)
+    funcs.real_vkCreateXlibSurfaceKHR = CreateXlibSurfaceKHR;
+    funcs.real_vkGetPhysicalDeviceXlibPresentationSupportKHR = GetPhysicalDeviceXlibPresentationSupportKHR;
+#endif
+#if defined(VK_USE_PLATFORM_WIN32_KHR)
+    funcs.real_vkCreateWin32SurfaceKHR = CreateWin32SurfaceKHR;
+    funcs.real_vkGetPhysicalDeviceWin32PresentationSupportKHR = GetPhysicalDeviceWin32PresentationSupportKHR;
+#endif
+#if defined(VK_USE_PLATFORM_ANDROID_KHR)
+    funcs.real_vkCreateAndroidSurfaceKHR = CreateAndroidSurfaceKHR;
+#endif
+    funcs.real_vkDestroySurfaceKHR = DestroySurfaceKHR;
+    funcs.real_vkGetPhysicalDeviceSurfaceSupportKHR = GetPhysicalDeviceSurfaceSupportKHR;
+    funcs.real_vkGetPhysicalDeviceSurfaceCapabilitiesKHR = GetPhysicalDeviceSurfaceCapabilitiesKHR;
+    funcs.real_vkGetPhysicalDeviceSurfaceFormatsKHR = GetPhysicalDeviceSurfaceFormatsKHR;
+    funcs.real_vkGetPhysicalDeviceSurfacePresentModesKHR = GetPhysicalDeviceSurfacePresentModesKHR;
+    funcs.real_vkGetPhysicalDeviceSurfaceCapabilities2KHR = GetPhysicalDeviceSurfaceCapabilities2KHR;
+    funcs.real_vkGetPhysicalDeviceSurfaceFormats2KHR = GetPhysicalDeviceSurfaceFormats2KHR;
+    funcs.real_vkGetPhysicalDeviceSurfaceCapabilities2EXT = GetPhysicalDeviceSurfaceCapabilities2EXT;
+    funcs.real_vkGetPhysicalDevicePresentRectanglesKHX = GetPhysicalDevicePresentRectanglesKHX;
+    funcs.real_vkGetDeviceGroupSurfacePresentModesKHX = GetDeviceGroupSurfacePresentModesKHX;
+    funcs.real_vkCreateSwapchainKHR = CreateSwapchainKHR;
+    funcs.real_vkDestroySwapchainKHR = DestroySwapchainKHR;
+    funcs.real_vkGetSwapchainImagesKHR = GetSwapchainImagesKHR;
+    funcs.real_vkAcquireNextImageKHR = AcquireNextImageKHR;
+    funcs.real_vkAcquireNextImage2KHX = AcquireNextImage2KHX;
+    funcs.real_vkCreateSharedSwapchainsKHR = CreateSharedSwapchainsKHR;
+    funcs.real_vkGetSwapchainStatusKHR = GetSwapchainStatusKHR;
+    funcs.real_vkGetSwapchainCounterEXT = GetSwapchainCounterEXT;
+    funcs.real_vkGetRefreshCycleDurationGOOGLE = GetRefreshCycleDurationGOOGLE;
+    funcs.real_vkGetPastPresentationTimingGOOGLE = GetPastPresentationTimingGOOGLE;
+    funcs.real_vkQueuePresentKHR = QueuePresentKHR;
+}
+
+PFN_vkVoidFunction vkOffscreenDisplay::offscreen_proc_addr(const char* pName) {
+    static const struct {
+        const char* pName;
+        PFN_vkVoidFunction pFunc;
+    } kFuncs[] = {
+        {"vkGetInstanceProcAddr", (PFN_vkVoidFunction)GetInstanceProcAddr},
+        {"vkGetDeviceProcAddr", (PFN_vkVoidFunction)GetDeviceProcAddr},
+        {"vkCreateDevice", (PFN_vkVoidFunction)CreateDevice},
+        {"vkDestroyDevice", (PFN_vkVoidFunction)DestroyDevice},
+        {"vkGetDeviceQueue", (PFN_vkVoidFunction)GetDeviceQueue},
+#if defined(VK_USE_PLATFORM_XCB_KHR)
+        {"vkCreateXcbSurfaceKHR", (PFN_vkVoidFunction)CreateXcbSurfaceKHR},
+        {"vkGetPhysicalDeviceXcbPresentationSupportKHR", (PFN_vkVoidFunction)GetPhysicalDeviceXcbPresentationSupportKHR},
+#endif
+#if defined(VK_USE_PLATFORM_XLIB_KHR)
+        {"vkCreateXlibSurfaceKHR", (PFN_vkVoidFunction)CreateXlibSurfaceKHR},
+        {"vkGetPhysicalDeviceXlibPresentationSupportKHR", (PFN_vkVoidFunction)GetPhysicalDeviceXlibPresentationSupportKHR},
+#endif
+#if defined(VK_USE_PLATFORM_WIN32_KHR)
+        {"vkCreateWin32SurfaceKHR", (PFN_vkVoidFunction)CreateWin32SurfaceKHR},
+        {"vkGetPhysicalDeviceWin32PresentationSupportKHR", (PFN_vkVoidFunction)GetPhysicalDeviceWin32PresentationSupportKHR},
+#endif
+#if defined(VK_USE_PLATFORM_ANDROID_KHR)
+        {"vkCreateAndroidSurfaceKHR", (PFN_vkVoidFunction)CreateAndroidSurfaceKHR},
+#endif
+        {"vkDestroySurfaceKHR", (PFN_vkVoidFunction)DestroySurfaceKHR},
+        {"vkGetPhysicalDeviceSurfaceSupportKHR", (PFN_vkVoidFunction)GetPhysicalDeviceSurfaceSupportKHR},
+        {"vkGetPhysicalDeviceSurfaceCapabilitiesKHR", (PFN_vkVoidFunction)GetPhysicalDeviceSurfaceCapabilitiesKHR},
+        {"vkGetPhysicalDeviceSurfaceFormatsKHR", (PFN_vkVoidFunction)GetPhysicalDeviceSurfaceFormatsKHR},
+        {"vkGetPhysicalDeviceSurfacePresentModesKHR", (PFN_vkVoidFunction)GetPhysicalDeviceSurfacePresentModesKHR},
+        {"vkGetPhysicalDeviceSurfaceCapabilities2KHR", (PFN_vkVoidFunction)GetPhysicalDeviceSurfaceCapabilities2KHR},
+        {"vkGetPhysicalDeviceSurfaceFormats2KHR", (PFN_vkVoidFunction)GetPhysicalDeviceSurfaceFormats2KHR},
+        {"vkGetPhysicalDeviceSurfaceCapabilities2EXT", (PFN_vkVoidFunction)GetPhysicalDeviceSurfaceCapabilities2EXT},
+        {"vkGetPhysicalDevicePresentRectanglesKHX", (PFN_vkVoidFunction)GetPhysicalDevicePresentRectanglesKHX},
+        {"vkGetDeviceGroupSurfacePresentModesKHX", (PFN_vkVoidFunction)GetDeviceGroupSurfacePresentModesKHX},
+        {"vkCreateSwapchainKHR", (PFN_vkVoidFunction)CreateSwapchainKHR},
+        {"vkDestroySwapchainKHR", (PFN_vkVoidFunction)DestroySwapchainKHR},
+        {"vkGetSwapchainImagesKHR", (PFN_vkVoidFunction)GetSwapchainImagesKHR},
+        {"vkAcquireNextImageKHR", (PFN_vkVoidFunction)AcquireNextImageKHR},
+        {"vkAcquireNextImage2KHX", (PFN_vkVoidFunction)AcquireNextImage2KHX},
+        {"vkCreateSharedSwapchainsKHR", (PFN_vkVoidFunction)CreateSharedSwapchainsKHR},
+        {"vkGetSwapchainStatusKHR", (PFN_vkVoidFunction)GetSwapchainStatusKHR},
+        {"vkGetSwapchainCounterEXT", (PFN_vkVoidFunction)GetSwapchainCounterEXT},
+        {"vkGetRefreshCycleDurationGOOGLE", (PFN_vkVoidFunction)GetRefreshCycleDurationGOOGLE},
+        {"vkGetPastPresentationTimingGOOGLE", (PFN_vkVoidFunction)GetPastPresentationTimingGOOGLE},
+        {"vkQueuePresentKHR", (PFN_vkVoidFunction)QueuePresentKHR},
+    };
+    for (size_t i = 0; i < sizeof(kFuncs) / sizeof(kFuncs[0]); i++) {
+        if (strcmp(pName, kFuncs[i].pName) == 0) return kFuncs[i].pFunc;
+    }
+    return NULL;
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkOffscreenDisplay::GetInstanceProcAddr(VkInstance instance, const char* pName) {
+    PFN_vkVoidFunction pFunc = offscreen_proc_addr(pName);
+    return (pFunc != NULL) ? pFunc : s_pDisplay->m_realGetInstanceProcAddr(instance, pName);
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkOffscreenDisplay::GetDeviceProcAddr(VkDevice device, const char* pName) {
+    PFN_vkVoidFunction pFunc = offscreen_proc_addr(pName);
+    return (pFunc != NULL) ? pFunc : s_pDisplay->m_realGetDeviceProcAddr(device, pName);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::CreateDevice(VkPhysicalDevice physicalDevice,
+                                                                const VkDeviceCreateInfo* pCreateInfo,
+                                                                const VkAllocationCallbacks* pAllocator, VkDevice* pDevice) {
+    VkResult result = s_pDisplay->m_realCreateDevice(physicalDevice, pCreateInfo, pAllocator, pDevice);
+    if (result == VK_SUCCESS) {
+        Device& device = s_pDisplay->m_devices[*pDevice];
+        device.physicalDevice = physicalDevice;
+        s_pDisplay->m_pFuncs->real_vkGetPhysicalDeviceMemoryProperties(physicalDevice, &device.memoryProperties);
+        device.queue = VK_NULL_HANDLE;
+    }
+    return result;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkOffscreenDisplay::DestroyDevice(VkDevice device, const VkAllocationCallbacks* pAllocator) {
+    for (auto it = s_pDisplay->m_swapchains.begin(); it != s_pDisplay->m_swapchains.end();) {
+        if (it->second.device == device) {
+            s_pDisplay->destroy_images(it->second);
+            it = s_pDisplay->m_swapchains.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = s_pDisplay->m_queues.begin(); it != s_pDisplay->m_queues.end();) {
+        if (it->second.device == device) {
+            it = s_pDisplay->m_queues.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    s_pDisplay->m_devices.erase(device);
+    s_pDisplay->m_realDestroyDevice(device, pAllocator);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkOffscreenDisplay::GetDeviceQueue(VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex,
+                                                              VkQueue* pQueue) {
+    s_pDisplay->m_realGetDeviceQueue(device, queueFamilyIndex, queueIndex, pQueue);
+    Queue& queue = s_pDisplay->m_queues[*pQueue];
+    queue.device = device;
+    queue.familyIndex = queueFamilyIndex;
+    auto it = s_pDisplay->m_devices.find(device);
+    if (it != s_pDisplay->m_devices.end() && it->second.queue == VK_NULL_HANDLE) it->second.queue = *pQueue;
+}
+
+#if defined(VK_USE_PLATFORM_XCB_KHR)
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::CreateXcbSurfaceKHR(VkInstance instance,
+                                                                       const VkXcbSurfaceCreateInfoKHR* pCreateInfo,
+                                                                       const VkAllocationCallbacks* pAllocator,
+                                                                       VkSurfaceKHR* pSurface) {
+    *pSurface = (VkSurfaceKHR)s_pDisplay->m_nextHandle++;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkBool32 VKAPI_CALL vkOffscreenDisplay::GetPhysicalDeviceXcbPresentationSupportKHR(VkPhysicalDevice physicalDevice,
+                                                                                              uint32_t queueFamilyIndex,
+                                                                                              xcb_connection_t* connection,
+                                                                                              xcb_visualid_t visual_id) {
+    return VK_TRUE;
+}
+#endif
+
+#if defined(VK_USE_PLATFORM_XLIB_KHR)
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::CreateXlibSurfaceKHR(VkInstance instance,
+                                                                        const VkXlibSurfaceCreateInfoKHR* pCreateInfo,
+                                                                        const VkAllocationCallbacks* pAllocator,
+                                                                        VkSurfaceKHR* pSurface) {
+    *pSurface = (VkSurfaceKHR)s_pDisplay->m_nextHandle++;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkBool32 VKAPI_CALL vkOffscreenDisplay::GetPhysicalDeviceXlibPresentationSupportKHR(VkPhysicalDevice physicalDevice,
+                                                                                               uint32_t queueFamilyIndex,
+                                                                                               Display* dpy, VisualID visualID) {
+    return VK_TRUE;
+}
+#endif
+
+#if defined(VK_USE_PLATFORM_WIN32_KHR)
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::CreateWin32SurfaceKHR(VkInstance instance,
+                                                                         const VkWin32SurfaceCreateInfoKHR* pCreateInfo,
+                                                                         const VkAllocationCallbacks* pAllocator,
+                                                                         VkSurfaceKHR* pSurface) {
+    *pSurface = (VkSurfaceKHR)s_pDisplay->m_nextHandle++;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkBool32 VKAPI_CALL vkOffscreenDisplay::GetPhysicalDeviceWin32PresentationSupportKHR(VkPhysicalDevice physicalDevice,
+                                                                                                uint32_t queueFamilyIndex) {
+    return VK_TRUE;
+}
+#endif
+
+#if defined(VK_USE_PLATFORM_ANDROID_KHR)
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::CreateAndroidSurfaceKHR(VkInstance instance,
+                                                                           const VkAndroidSurfaceCreateInfoKHR* pCreateInfo,
+                                                                           const VkAllocationCallbacks* pAllocator,
+                                                                           VkSurfaceKHR* pSurface) {
+    *pSurface = (VkSurfaceKHR)s_pDisplay->m_nextHandle++;
+    return VK_SUCCESS;
+}
+#endif
+
+VKAPI_ATTR void VKAPI_CALL vkOffscreenDisplay::DestroySurfaceKHR(VkInstance instance, VkSurfaceKHR surface,
+                                                                const VkAllocationCallbacks* pAllocator) {}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::GetPhysicalDeviceSurfaceSupportKHR(VkPhysicalDevice physicalDevice,
+                                                                                      uint32_t queueFamilyIndex,
+                                                                                      VkSurfaceKHR surface, VkBool32* pSupported) {
+    *pSupported = VK_TRUE;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::GetPhysicalDeviceSurfaceCapabilitiesKHR(
+    VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, VkSurfaceCapabilitiesKHR* pSurfaceCapabilities) {
+    VkPhysicalDeviceProperties properties;
+    s_pDisplay->m_pFuncs->real_vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    // Any extent the application asks for, as with a surface whose size is set by the swapchain
+    pSurfaceCapabilities->minImageCount = 1;
+    pSurfaceCapabilities->maxImageCount = 0;
+    pSurfaceCapabilities->currentExtent.width = UINT32_MAX;
+    pSurfaceCapabilities->currentExtent.height = UINT32_MAX;
+    pSurfaceCapabilities->minImageExtent.width = 1;
+    pSurfaceCapabilities->minImageExtent.height = 1;
+    pSurfaceCapabilities->maxImageExtent.width = properties.limits.maxImageDimension2D;
+    pSurfaceCapabilities->maxImageExtent.height = properties.limits.maxImageDimension2D;
+    pSurfaceCapabilities->maxImageArrayLayers = properties.limits.maxImageArrayLayers;
+    pSurfaceCapabilities->supportedTransforms = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    pSurfaceCapabilities->currentTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    pSurfaceCapabilities->supportedCompositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR | VK_COMPOSITE_ALPHA_PRE_MULTIPLIED_BIT_KHR |
+                                                    VK_COMPOSITE_ALPHA_POST_MULTIPLIED_BIT_KHR | VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR;
+    pSurfaceCapabilities->supportedUsageFlags = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                                                VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT |
+                                                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::GetPhysicalDeviceSurfaceFormatsKHR(VkPhysicalDevice physicalDevice,
+                                                                                      VkSurfaceKHR surface,
+                                                                                      uint32_t* pSurfaceFormatCount,
+                                                                                      VkSurfaceFormatKHR* pSurfaceFormats) {
+    // A single VK_FORMAT_UNDEFINED entry means the surface has no preferred format, so the
+    // swapchains keep the traced formats
+    if (pSurfaceFormats != NULL && *pSurfaceFormatCount == 0) return VK_INCOMPLETE;
+    *pSurfaceFormatCount = 1;
+    if (pSurfaceFormats != NULL) {
+        pSurfaceFormats[0].format = VK_FORMAT_UNDEFINED;
+        pSurfaceFormats[0].colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+    }
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::GetPhysicalDeviceSurfacePresentModesKHR(VkPhysicalDevice physicalDevice,
+                                                                                           VkSurfaceKHR surface,
+                                                                                           uint32_t* pPresentModeCount,
+                                                                                           VkPresentModeKHR* pPresentModes) {
+    static const VkPresentModeKHR presentModes[] = {VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+                                                    VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
+    const uint32_t count = sizeof(presentModes) / sizeof(presentModes[0]);
+    if (pPresentModes == NULL) {
+        *pPresentModeCount = count;
+        return VK_SUCCESS;
+    }
+    VkResult result = (*pPresentModeCount < count) ? VK_INCOMPLETE : VK_SUCCESS;
+    if (*pPresentModeCount > count) *pPresentModeCount = count;
+    memcpy(pPresentModes, presentModes, *pPresentModeCount * sizeof(VkPresentModeKHR));
+    return result;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::GetPhysicalDeviceSurfaceCapabilities2KHR(
+    VkPhysicalDevice physicalDevice, const VkPhysicalDeviceSurfaceInfo2KHR* pSurfaceInfo,
+    VkSurfaceCapabilities2KHR* pSurfaceCapabilities) {
+    return GetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, pSurfaceInfo->surface,
+                                                   &pSurfaceCapabilities->surfaceCapabilities);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::GetPhysicalDeviceSurfaceFormats2KHR(
+    VkPhysicalDevice physicalDevice, const VkPhysicalDeviceSurfaceInfo2KHR* pSurfaceInfo, uint32_t* pSurfaceFormatCount,
+    VkSurfaceFormat2KHR* pSurfaceFormats) {
+    // The single format of GetPhysicalDeviceSurfaceFormatsKHR
+    VkSurfaceFormatKHR surfaceFormat;
+    VkResult result = GetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, pSurfaceInfo->surface, pSurfaceFormatCount,
+                                                         (pSurfaceFormats != NULL) ? &surfaceFormat : NULL);
+    if (pSurfaceFormats != NULL && *pSurfaceFormatCount > 0) pSurfaceFormats[0].surfaceFormat = surfaceFormat;
+    return result;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::GetPhysicalDeviceSurfaceCapabilities2EXT(
+    VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, VkSurfaceCapabilities2EXT* pSurfaceCapabilities) {
+    VkSurfaceCapabilitiesKHR capabilities;
+    VkResult result = GetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities);
+    pSurfaceCapabilities->minImageCount = capabilities.minImageCount;
+    pSurfaceCapabilities->maxImageCount = capabilities.maxImageCount;
+    pSurfaceCapabilities->currentExtent = capabilities.currentExtent;
+    pSurfaceCapabilities->minImageExtent = capabilities.minImageExtent;
+    pSurfaceCapabilities->maxImageExtent = capabilities.maxImageExtent;
+    pSurfaceCapabilities->maxImageArrayLayers = capabilities.maxImageArrayLayers;
+    pSurfaceCapabilities->supportedTransforms = capabilities.supportedTransforms;
+    pSurfaceCapabilities->currentTransform = capabilities.currentTransform;
+    pSurfaceCapabilities->supportedCompositeAlpha = capabilities.supportedCompositeAlpha;
+    pSurfaceCapabilities->supportedUsageFlags = capabilities.supportedUsageFlags;
+    // Presents are counted as if each of them was a vertical blank, see GetSwapchainCounterEXT
+    pSurfaceCapabilities->supportedSurfaceCounters = VK_SURFACE_COUNTER_VBLANK_EXT;
+    return result;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::GetPhysicalDevicePresentRectanglesKHX(VkPhysicalDevice physicalDevice,
+                                                                                         VkSurfaceKHR surface, uint32_t* pRectCount,
+                                                                                         VkRect2D* pRects) {
+    if (pRects == NULL) {
+        *pRectCount = 1;
+        return VK_SUCCESS;
+    }
+    if (*pRectCount == 0) return VK_INCOMPLETE;
+    *pRectCount = 1;
+    // The whole of the largest image the surface takes, as its capabilities report
+    VkPhysicalDeviceProperties properties;
+    s_pDisplay->m_pFuncs->real_vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    pRects[0].offset.x = 0;
+    pRects[0].offset.y = 0;
+    pRects[0].extent.width = properties.limits.maxImageDimension2D;
+    pRects[0].extent.height = properties.limits.maxImageDimension2D;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::GetDeviceGroupSurfacePresentModesKHX(VkDevice device, VkSurfaceKHR surface,
+                                                                                        VkDeviceGroupPresentModeFlagsKHX* pModes) {
+    // Each device of the group presents its own images
+    *pModes = VK_DEVICE_GROUP_PRESENT_MODE_LOCAL_BIT_KHX;
+    return VK_SUCCESS;
+}
+
+uint32_t vkOffscreenDisplay::find_memory_type(const Device& device, uint32_t memoryTypeBits,
+                                              VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < device.memoryProperties.memoryTypeCount; i++) {
+        VkMemoryPropertyFlags typeProperties = device.memoryProperties.memoryTypes[i].propertyFlags;
+        if ((memoryTypeBits & (1u << i)) != 0 && (typeProperties & properties) == properties) return i;
+    }
+    return UINT32_MAX;
+}
+
+VkResult vkOffscreenDisplay::add_images(Swapchain& swapchain, uint32_t count) {
+    auto device_it = m_devices.find(swapchain.device);
+    if (device_it == m_devices.end()) return VK_ERROR_INITIALIZATION_FAILED;
+
+    while (swapchain.images.size() < count) {
+        VkImage image;
+        VkResult result = m_pFuncs->real_vkCreateImage(swapchain.device, &swapchain.imageCreateInfo, NULL, &image);
+        if (result != VK_SUCCESS) return result;
+
+        VkMemoryRequirements requirements;
+        m_pFuncs->real_vkGetImageMemoryRequirements(swapchain.device, image, &requirements);
+        VkMemoryAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = requirements.size;
+        allocateInfo.memoryTypeIndex =
+            find_memory_type(device_it->second, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (allocateInfo.memoryTypeIndex == UINT32_MAX) {
+            allocateInfo.memoryTypeIndex = find_memory_type(device_it->second, requirements.memoryTypeBits, 0);
+        }
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        result = m_pFuncs->real_vkAllocateMemory(swapchain.device, &allocateInfo, NULL, &memory);
+        if (result == VK_SUCCESS) result = m_pFuncs->real_vkBindImageMemory(swapchain.device, image, memory, 0);
+        if (result != VK_SUCCESS) {
+            if (memory != VK_NULL_HANDLE) m_pFuncs->real_vkFreeMemory(swapchain.device, memory, NULL);
+            m_pFuncs->real_vkDestroyImage(swapchain.device, image, NULL);
+            return result;
+        }
+        swapchain.images.push_back(image);
+        swapchain.memory.push_back(memory);
+    }
+    return VK_SUCCESS;
+}
+
+void vkOffscreenDisplay::destroy_images(Swapchain& swapchain) {
+    for (size_t i = 0; i < swapchain.images.size(); i++) {
+        m_pFuncs->real_vkDestroyImage(swapchain.device, swapchain.images[i], NULL);
+        m_pFuncs->real_vkFreeMemory(swapchain.device, swapchain.memory[i], NULL);
+    }
+    swapchain.images.clear();
+    swapchain.memory.clear();
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::CreateSwapchainKHR(VkDevice device, const VkSwapchainCreateInfoKHR* pCreateInfo,
+                                                                      const VkAllocationCallbacks* pAllocator,
+                                                                      VkSwapchainKHR* pSwapchain) {
+    Swapchain swapchain;
+    swapchain.device = device;
+    swapchain.nextImage = 0;
+    swapchain.presentCount = 0;
+    VkImageCreateInfo& imageCreateInfo = swapchain.imageCreateInfo;
+    memset(&imageCreateInfo, 0, sizeof(imageCreateInfo));
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.format = pCreateInfo->imageFormat;
+    imageCreateInfo.extent.width = pCreateInfo->imageExtent.width;
+    imageCreateInfo.extent.height = pCreateInfo->imageExtent.height;
+    imageCreateInfo.extent.depth = 1;
+    imageCreateInfo.mipLevels = 1;
+    imageCreateInfo.arrayLayers = pCreateInfo->imageArrayLayers;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    // Transfers from the images are needed to read them back
+    imageCreateInfo.usage = pCreateInfo->imageUsage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageCreateInfo.sharingMode = pCreateInfo->imageSharingMode;
+    imageCreateInfo.queueFamilyIndexCount = 0;
+    imageCreateInfo.pQueueFamilyIndices = NULL;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    // The queue family indices don't outlive this call, and don't matter to the images anyway
+    // since they are only ever used on one queue at a time
+    if (imageCreateInfo.sharingMode == VK_SHARING_MODE_CONCURRENT) imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkResult result = s_pDisplay->add_images(swapchain, (pCreateInfo->minImageCount > 0) ? pCreateInfo->minImageCount : 1);
+    if (result != VK_SUCCESS) {
+        s_pDisplay->destroy_images(swapchain);
+        return result;
+    }
+    *pSwapchain = (VkSwapchainKHR)s_pDisplay->m_nextHandle++;
+    s_pDisplay->m_swapchains[*pSwapchain] = swapchain;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkOffscreenDisplay::DestroySwapchainKHR(VkDevice device, VkSwapchainKHR swapchain,
+                                                                  const VkAllocationCallbacks* pAllocator) {
+    auto it = s_pDisplay->m_swapchains.find(swapchain);
+    if (it == s_pDisplay->m_swapchains.end()) return;
+    s_pDisplay->destroy_images(it->second);
+    s_pDisplay->m_swapchains.erase(it);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::GetSwapchainImagesKHR(VkDevice device, VkSwapchainKHR swapchain,
+                                                                         uint32_t* pSwapchainImageCount,
+                                                                         VkImage* pSwapchainImages) {
+    auto it = s_pDisplay->m_swapchains.find(swapchain);
+    if (it == s_pDisplay->m_swapchains.end()) return VK_ERROR_SURFACE_LOST_KHR;
+    Swapchain& offscreenSwapchain = it->second;
+
+    // Replay asks for as many images as the traced swapchain had, so grow the ring to that size
+    // and every traced image gets an image of its own
+    VkResult result = s_pDisplay->add_images(offscreenSwapchain, *pSwapchainImageCount);
+    if (result != VK_SUCCESS) return result;
+    *pSwapchainImageCount = (uint32_t)offscreenSwapchain.images.size();
+    if (pSwapchainImages != NULL) {
+        memcpy(pSwapchainImages, offscreenSwapchain.images.data(), *pSwapchainImageCount * sizeof(VkImage));
+    }
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::AcquireNextImageKHR(VkDevice device, VkSwapchainKHR swapchain, uint64_t timeout,
+                                                                       VkSemaphore semaphore, VkFence fence,
+                                                                       uint32_t* pImageIndex) {
+    auto it = s_pDisplay->m_swapchains.find(swapchain);
+    if (it == s_pDisplay->m_swapchains.end()) return VK_ERROR_SURFACE_LOST_KHR;
+    Swapchain& offscreenSwapchain = it->second;
+    *pImageIndex = offscreenSwapchain.nextImage;
+    offscreenSwapchain.nextImage = (offscreenSwapchain.nextImage + 1) % offscreenSwapchain.images.size();
+
+    // Images are available as soon as they are acquired, but the semaphore and fence still have
+    // to be signaled
+    if (semaphore == VK_NULL_HANDLE && fence == VK_NULL_HANDLE) return VK_SUCCESS;
+    auto device_it = s_pDisplay->m_devices.find(device);
+    if (device_it == s_pDisplay->m_devices.end() || device_it->second.queue == VK_NULL_HANDLE) {
+        vktrace_LogError("vkAcquireNextImageKHR(): the device has no queue to signal the semaphore and fence with.");
+        return VK_ERROR_DEVICE_LOST;
+    }
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.signalSemaphoreCount = (semaphore != VK_NULL_HANDLE) ? 1 : 0;
+    submitInfo.pSignalSemaphores = &semaphore;
+    return s_pDisplay->m_pFuncs->real_vkQueueSubmit(device_it->second.queue, 1, &submitInfo, fence);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::AcquireNextImage2KHX(VkDevice device,
+                                                                        const VkAcquireNextImageInfoKHX* pAcquireInfo,
+                                                                        uint32_t* pImageIndex) {
+    // All the devices of a group share the images, so the device mask doesn't matter
+    return AcquireNextImageKHR(device, pAcquireInfo->swapchain, pAcquireInfo->timeout, pAcquireInfo->semaphore,
+                               pAcquireInfo->fence, pImageIndex);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::CreateSharedSwapchainsKHR(VkDevice device, uint32_t swapchainCount,
+                                                                             const VkSwapchainCreateInfoKHR* pCreateInfos,
+                                                                             const VkAllocationCallbacks* pAllocator,
+                                                                             VkSwapchainKHR* pSwapchains) {
+    for (uint32_t i = 0; i < swapchainCount; i++) {
+        VkResult result = CreateSwapchainKHR(device, &pCreateInfos[i], pAllocator, &pSwapchains[i]);
+        if (result != VK_SUCCESS) {
+            while (i > 0) DestroySwapchainKHR(device, pSwapchains[--i], pAllocator);
+            return result;
+        }
+    }
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::GetSwapchainStatusKHR(VkDevice device, VkSwapchainKHR swapchain) {
+    auto it = s_pDisplay->m_swapchains.find(swapchain);
+    return (it == s_pDisplay->m_swapchains.end()) ? VK_ERROR_SURFACE_LOST_KHR : VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::GetSwapchainCounterEXT(VkDevice device, VkSwapchainKHR swapchain,
+                                                                          VkSurfaceCounterFlagBitsEXT counter,
+                                                                          uint64_t* pCounterValue) {
+    auto it = s_pDisplay->m_swapchains.find(swapchain);
+    if (it == s_pDisplay->m_swapchains.end()) return VK_ERROR_SURFACE_LOST_KHR;
+    // There is no display to blank, the presents of the swapchain stand in for the vertical blanks
+    *pCounterValue = it->second.presentCount;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::GetRefreshCycleDurationGOOGLE(
+    VkDevice device, VkSwapchainKHR swapchain, VkRefreshCycleDurationGOOGLE* pDisplayTimingProperties) {
+    if (s_pDisplay->m_swapchains.find(swapchain) == s_pDisplay->m_swapchains.end()) return VK_ERROR_SURFACE_LOST_KHR;
+    // A 60Hz display
+    pDisplayTimingProperties->refreshDuration = 16666667;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::GetPastPresentationTimingGOOGLE(
+    VkDevice device, VkSwapchainKHR swapchain, uint32_t* pPresentationTimingCount,
+    VkPastPresentationTimingGOOGLE* pPresentationTimings) {
+    if (s_pDisplay->m_swapchains.find(swapchain) == s_pDisplay->m_swapchains.end()) return VK_ERROR_SURFACE_LOST_KHR;
+    // Nothing is displayed, so no present ever has its timing available
+    *pPresentationTimingCount = 0;
+    return VK_SUCCESS;
+}
+
+void vkOffscreenDisplay::checksum_image(VkQueue queue, uint32_t swapchainIndex, const Swapchain& swapchain, uint32_t imageIndex,
+                                        uint32_t* pWaitSemaphoreCount, const VkSemaphore* pWaitSemaphores) {
+    const VkImageCreateInfo& imageInfo = swapchain.imageCreateInfo;
+    uint32_t texelSize = texel_size(imageInfo.format);
+    if (texelSize == 0) {
+        vktrace_LogWarning("Frame %u can't be checksummed, images of format %d aren't supported.", m_presentCount,
+                           imageInfo.format);
+        return;
+    }
+    auto device_it = m_devices.find(swapchain.device);
+    auto queue_it = m_queues.find(queue);
+    if (device_it == m_devices.end() || queue_it == m_queues.end() || imageIndex >= swapchain.images.size()) {
+        vktrace_LogError("Frame %u can't be checksummed, its queue or image is unknown.", m_presentCount);
+        return;
+    }
+    VkDevice device = swapchain.device;
+    VkDeviceSize size = (VkDeviceSize)imageInfo.extent.width * imageInfo.extent.height * texelSize;
+
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    VkBufferCreateInfo bufferCreateInfo = {};
+    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.size = size;
+    bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkResult result = m_pFuncs->real_vkCreateBuffer(device, &bufferCreateInfo, NULL, &buffer);
+    if (result == VK_SUCCESS) {
+        VkMemoryRequirements requirements;
+        m_pFuncs->real_vkGetBufferMemoryRequirements(device, buffer, &requirements);
+        VkMemoryAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = requirements.size;
+        allocateInfo.memoryTypeIndex = find_memory_type(device_it->second, requirements.memoryTypeBits,
+                                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        result = m_pFuncs->real_vkAllocateMemory(device, &allocateInfo, NULL, &memory);
+    }
+    if (result == VK_SUCCESS) result = m_pFuncs->real_vkBindBufferMemory(device, buffer, memory, 0);
+
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    if (result == VK_SUCCESS) {
+        VkCommandPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolCreateInfo.queueFamilyIndex = queue_it->second.familyIndex;
+        result = m_pFuncs->real_vkCreateCommandPool(device, &poolCreateInfo, NULL, &commandPool);
+    }
+    if (result == VK_SUCCESS) {
+        VkCommandBufferAllocateInfo commandBufferInfo = {};
+        commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferInfo.commandPool = commandPool;
+        commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferInfo.commandBufferCount = 1;
+        result = m_pFuncs->real_vkAllocateCommandBuffers(device, &commandBufferInfo, &commandBuffer);
+    }
+    if (result == VK_SUCCESS) {
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        result = m_pFuncs->real_vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    }
+    if (result == VK_SUCCESS) {
+        // The application left the image in the present layout, put it back there afterwards
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = swapchain.images[imageIndex];
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.layerCount = 1;
+        m_pFuncs->real_vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
+                                            NULL, 0, NULL, 1, &barrier);
+
+        VkBufferImageCopy region = {};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = imageInfo.extent;
+        m_pFuncs->real_vkCmdCopyImageToBuffer(commandBuffer, barrier.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1,
+                                              &region);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        VkBufferMemoryBarrier bufferBarrier = {};
+        bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        bufferBarrier.buffer = buffer;
+        bufferBarrier.size = VK_WHOLE_SIZE;
+        m_pFuncs->real_vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1,
+                                            &bufferBarrier, 1, &barrier);
+        result = m_pFuncs->real_vkEndCommandBuffer(commandBuffer);
+    }
+    if (result == VK_SUCCESS) {
+        VkFenceCreateInfo fenceCreateInfo = {};
+        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        result = m_pFuncs->real_vkCreateFence(device, &fenceCreateInfo, NULL, &fence);
+    }
+    if (result == VK_SUCCESS) {
+        std::vector<VkPipelineStageFlags> waitStages(*pWaitSemaphoreCount, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = *pWaitSemaphoreCount;
+        submitInfo.pWaitSemaphores = pWaitSemaphores;
+        submitInfo.pWaitDstStageMask = waitStages.data();
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        result = m_pFuncs->real_vkQueueSubmit(queue, 1, &submitInfo, fence);
+        if (result == VK_SUCCESS) *pWaitSemaphoreCount = 0;
+    }
+    if (result == VK_SUCCESS) result = m_pFuncs->real_vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+
+    void* pData = NULL;
+    if (result == VK_SUCCESS) result = m_pFuncs->real_vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &pData);
+    if (result == VK_SUCCESS) {
+        m_pChecksums->add(m_presentCount, swapchainIndex, imageInfo.extent, imageInfo.format, pData, (size_t)size);
+        m_pFuncs->real_vkUnmapMemory(device, memory);
+    } else {
+        vktrace_LogError("Failed to read back frame %u for its checksum.", m_presentCount);
+    }
+
+    if (fence != VK_NULL_HANDLE) m_pFuncs->real_vkDestroyFence(device, fence, NULL);
+    if (commandPool != VK_NULL_HANDLE) m_pFuncs->real_vkDestroyCommandPool(device, commandPool, NULL);
+    if (buffer != VK_NULL_HANDLE) m_pFuncs->real_vkDestroyBuffer(device, buffer, NULL);
+    if (memory != VK_NULL_HANDLE) m_pFuncs->real_vkFreeMemory(device, memory, NULL);
+}
+
+bool vkOffscreenDisplay::is_checksum_frame(uint32_t frame) const {
+    if (m_pChecksums == NULL) return false;
+    if (m_pChecksums->is_golden_frame(frame)) return true;
+    if (m_checksumRange.valid) {
+        if (frame < (uint32_t)m_checksumRange.startFrame) return false;
+        uint32_t offset = frame - m_checksumRange.startFrame;
+        if (offset % m_checksumRange.interval != 0) return false;
+        return m_checksumRange.count == screenshot::SCREEN_SHOT_FRAMES_UNLIMITED ||
+               offset / m_checksumRange.interval < (uint32_t)m_checksumRange.count;
+    }
+    return std::find(m_checksumFrames.begin(), m_checksumFrames.end(), frame) != m_checksumFrames.end();
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkOffscreenDisplay::QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* pPresentInfo) {
+    vkOffscreenDisplay* pDisplay = s_pDisplay;
+    uint32_t waitSemaphoreCount = pPresentInfo->waitSemaphoreCount;
+    VkResult result = VK_SUCCESS;
+
+    if (pDisplay->is_checksum_frame(pDisplay->m_presentCount)) {
+        for (uint32_t i = 0; i < pPresentInfo->swapchainCount; i++) {
+            auto it = pDisplay->m_swapchains.find(pPresentInfo->pSwapchains[i]);
+            if (it == pDisplay->m_swapchains.end()) continue;
+            // The first readback waits for the semaphores, the ones after it are submitted
+            // to the same queue and follow it
+            pDisplay->checksum_image(queue, i, it->second, pPresentInfo->pImageIndices[i], &waitSemaphoreCount,
+                                     pPresentInfo->pWaitSemaphores);
+        }
+    }
+
+    // Nothing is displayed, but the wait semaphores are unsignaled by presenting
+    if (waitSemaphoreCount > 0) {
+        std::vector<VkPipelineStageFlags> waitStages(waitSemaphoreCount, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = waitSemaphoreCount;
+        submitInfo.pWaitSemaphores = pPresentInfo->pWaitSemaphores;
+        submitInfo.pWaitDstStageMask = waitStages.data();
+        result = pDisplay->m_pFuncs->real_vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+    }
+    for (uint32_t i = 0; i < pPresentInfo->swapchainCount; i++) {
+        auto it = pDisplay->m_swapchains.find(pPresentInfo->pSwapchains[i]);
+        if (it != pDisplay->m_swapchains.end()) it->second.presentCount++;
+        if (pPresentInfo->pResults != NULL) pPresentInfo->pResults[i] = result;
+    }
+    pDisplay->m_presentCount++;
+    return result;
+}
@@ -0,0 +1,182 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "screenshot_parsing.h"
+#include "vkreplay_frame_checksums.h"
+#include "vkreplay_vkdisplay.h"
+
+// A display for machines without a window system, such as render farm nodes.  Surfaces and
+// swapchains are emulated on top of the driver: a swapchain is a ring of device-local images,
+// vkAcquireNextImageKHR hands them out in turn and vkQueuePresentKHR only waits for its
+// semaphores.  The images presented in selected frames can be read back and checksummed.
+class vkOffscreenDisplay : public vkDisplay {
+   public:
+    vkOffscreenDisplay();
+    ~vkOffscreenDisplay();
+
+    // Replaces the window system commands of funcs, and the commands that return them, with
+    // the offscreen ones.  pChecksumFrames selects the frames to read back, in the syntax of
+    // the screenshot frame list, and pChecksums receives their images.  Frames of its golden
+    // manifest are read back as well.  pChecksums may be NULL if no frames are read back.
+    void init_funcs(vkFuncs& funcs, const char* pChecksumFrames, vktrace_replay::FrameChecksums* pChecksums);
+    // Frames are numbered from the start of each loop
+    void reset_frame_number() { m_presentCount = 0; }
+
+   private:
+    struct Device {
+        VkPhysicalDevice physicalDevice;
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        VkQueue queue;  // any queue of the device, used to signal acquire semaphores and fences
+    };
+    struct Swapchain {
+        VkDevice device;
+        VkImageCreateInfo imageCreateInfo;
+        std::vector<VkImage> images;
+        std::vector<VkDeviceMemory> memory;
+        uint32_t nextImage;
+        uint64_t presentCount;  // for the vertical blanking counter
+    };
+    struct Queue {
+        VkDevice device;
+        uint32_t familyIndex;
+    };
+
+    static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL GetInstanceProcAddr(VkInstance instance, const char* pName);
+    static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL GetDeviceProcAddr(VkDevice device, const char* pName);
+    static VKAPI_ATTR VkResult VKAPI_CALL CreateDevice(VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo* pCreateInfo,
+                                                       const VkAllocationCallbacks* pAllocator, VkDevice* pDevice);
+    static VKAPI_ATTR void VKAPI_CALL DestroyDevice(VkDevice device, const VkAllocationCallbacks* pAllocator);
+    static VKAPI_ATTR void VKAPI_CALL GetDeviceQueue(VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex,
+                                                     VkQueue* pQueue);
+#if defined(VK_USE_PLATFORM_XCB_KHR)
+    static VKAPI_ATTR VkResult VKAPI_CALL CreateXcbSurfaceKHR(VkInstance instance, const VkXcbSurfaceCreateInfoKHR* pCreateInfo,
+                                                              const VkAllocationCallbacks* pAllocator, VkSurfaceKHR* pSurface);
+    static VKAPI_ATTR VkBool32 VKAPI_CALL GetPhysicalDeviceXcbPresentationSupportKHR(VkPhysicalDevice physicalDevice,
+                                                                                     uint32_t queueFamilyIndex,
+                                                                                     xcb_connection_t* connection,
+                                                                                     xcb_visualid_t visual_id);
+#endif
+#if defined(VK_USE_PLATFORM_XLIB_KHR)
+    static VKAPI_ATTR VkResult VKAPI_CALL CreateXlibSurfaceKHR(VkInstance instance, const VkXlibSurfaceCreateInfoKHR* pCreateInfo,
+                                                               const VkAllocationCallbacks* pAllocator, VkSurfaceKHR* pSurface);
+    static VKAPI_ATTR VkBool32 VKAPI_CALL GetPhysicalDeviceXlibPresentationSupportKHR(VkPhysicalDevice physicalDevice,
+                                                                                      uint32_t queueFamilyIndex, Display* dpy,
+                                                                                      VisualID visualID);
+#endif
+#if defined(VK_USE_PLATFORM_WIN32_KHR)
+    static VKAPI_ATTR VkResult VKAPI_CALL CreateWin32SurfaceKHR(VkInstance instance, const VkWin32SurfaceCreateInfoKHR* pCreateInfo,
+                                                                const VkAllocationCallbacks* pAllocator, VkSurfaceKHR* pSurface);
+    static VKAPI_ATTR VkBool32 VKAPI_CALL GetPhysicalDeviceWin32PresentationSupportKHR(VkPhysicalDevice physicalDevice,
+                                                                                       uint32_t queueFamilyIndex);
+#endif
+#if defined(VK_USE_PLATFORM_ANDROID_KHR)
+    static VKAPI_ATTR VkResult VKAPI_CALL CreateAndroidSurfaceKHR(VkInstance instance,
+                                                                  const VkAndroidSurfaceCreateInfoKHR* pCreateInfo,
+                                                                  const VkAllocationCallbacks* pAllocator, VkSurfaceKHR* pSurface);
+#endif
+    static VKAPI_ATTR void VKAPI_CALL DestroySurfaceKHR(VkInstance instance, VkSurfaceKHR surface,
+                                                       const VkAllocationCallbacks* pAllocator);
+    static VKAPI_ATTR VkResult VKAPI_CALL GetPhysicalDeviceSurfaceSupportKHR(VkPhysicalDevice physicalDevice,
+                                                                             uint32_t queueFamilyIndex, VkSurfaceKHR surface,
+                                                                             VkBool32* pSupported);
+    static VKAPI_ATTR VkResult VKAPI_CALL GetPhysicalDeviceSurfaceCapabilitiesKHR(VkPhysicalDevice physicalDevice,
+                                                                                  VkSurfaceKHR surface,
+                                                                                  VkSurfaceCapabilitiesKHR* pSurfaceCapabilities);
+    static VKAPI_ATTR VkResult VKAPI_CALL GetPhysicalDeviceSurfaceFormatsKHR(VkPhysicalDevice physicalDevice,
+                                                                             VkSurfaceKHR surface, uint32_t* pSurfaceFormatCount,
+                                                                             VkSurfaceFormatKHR* pSurfaceFormats);
+    static VKAPI_ATTR VkResult VKAPI_CALL GetPhysicalDeviceSurfacePresentModesKHR(VkPhysicalDevice physicalDevice,
+                                                                                  VkSurfaceKHR surface, uint32_t* pPresentModeCount,
+                                                                                  VkPresentModeKHR* pPresentModes);
+    static VKAPI_ATTR VkResult VKAPI_CALL GetPhysicalDeviceSurfaceCapabilities2KHR(
+        VkPhysicalDevice physicalDevice, const VkPhysicalDeviceSurfaceInfo2KHR* pSurfaceInfo,
+        VkSurfaceCapabilities2KHR* pSurfaceCapabilities);
+    static VKAPI_ATTR VkResult VKAPI_CALL GetPhysicalDeviceSurfaceFormats2KHR(VkPhysicalDevice physicalDevice,
+                                                                              const VkPhysicalDeviceSurfaceInfo2KHR* pSurfaceInfo,
+                                                                              uint32_t* pSurfaceFormatCount,
+                                                                              VkSurfaceFormat2KHR* pSurfaceFormats);
+    static VKAPI_ATTR VkResult VKAPI_CALL GetPhysicalDeviceSurfaceCapabilities2EXT(VkPhysicalDevice physicalDevice,
+                                                                                   VkSurfaceKHR surface,
+                                                                                   VkSurfaceCapabilities2EXT* pSurfaceCapabilities);
+    static VKAPI_ATTR VkResult VKAPI_CALL GetPhysicalDevicePresentRectanglesKHX(VkPhysicalDevice physicalDevice,
+                                                                                VkSurfaceKHR surface, uint32_t* pRectCount,
+                                                                                VkRect2D* pRects);
+    static VKAPI_ATTR VkResult VKAPI_CALL GetDeviceGroupSurfacePresentModesKHX(VkDevice device, VkSurfaceKHR surface,
+                                                                               VkDeviceGroupPresentModeFlagsKHX* pModes);
+    static VKAPI_ATTR VkResult VKAPI_CALL CreateSwapchainKHR(VkDevice device, const VkSwapchainCreateInfoKHR* pCreateInfo,
+                                                             const VkAllocationCallbacks* pAllocator, VkSwapchainKHR* pSwapchain);
+    static VKAPI_ATTR void VKAPI_CALL DestroySwapchainKHR(VkDevice device, VkSwapchainKHR swapchain,
+                                                         const VkAllocationCallbacks* pAllocator);
+    static VKAPI_ATTR VkResult VKAPI_CALL GetSwapchainImagesKHR(VkDevice device, VkSwapchainKHR swapchain,
+                                                                uint32_t* pSwapchainImageCount, VkImage* pSwapchainImages);
+    static VKAPI_ATTR VkResult VKAPI_CALL AcquireNextImageKHR(VkDevice device, VkSwapchainKHR swapchain, uint64_t timeout,
+                                                              VkSemaphore semaphore, VkFence fence, uint32_t* pImageIndex);
+    static VKAPI_ATTR VkResult VKAPI_CALL AcquireNextImage2KHX(VkDevice device, const VkAcquireNextImageInfoKHX* pAcquireInfo,
+                                                               uint32_t* pImageIndex);
+    static VKAPI_ATTR VkResult VKAPI_CALL CreateSharedSwapchainsKHR(VkDevice device, uint32_t swapchainCount,
+                                                                    const VkSwapchainCreateInfoKHR* pCreateInfos,
+                                                                    const VkAllocationCallbacks* pAllocator,
+                                                                    VkSwapchainKHR* pSwapchains);
+    static VKAPI_ATTR VkResult VKAPI_CALL GetSwapchainStatusKHR(VkDevice device, VkSwapchainKHR swapchain);
+    static VKAPI_ATTR VkResult VKAPI_CALL GetSwapchainCounterEXT(VkDevice device, VkSwapchainKHR swapchain,
+                                                                 VkSurfaceCounterFlagBitsEXT counter, uint64_t* pCounterValue);
+    static VKAPI_ATTR VkResult VKAPI_CALL GetRefreshCycleDurationGOOGLE(VkDevice device, VkSwapchainKHR swapchain,
+                                                                        VkRefreshCycleDurationGOOGLE* pDisplayTimingProperties);
+    static VKAPI_ATTR VkResult VKAPI_CALL GetPastPresentationTimingGOOGLE(VkDevice device, VkSwapchainKHR swapchain,
+                                                                          uint32_t* pPresentationTimingCount,
+                                                                          VkPastPresentationTimingGOOGLE* pPresentationTimings);
+    static VKAPI_ATTR VkResult VKAPI_CALL QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* pPresentInfo);
+
+    // Returns the offscreen version of a command, or NULL if it is not replaced
+    static PFN_vkVoidFunction offscreen_proc_addr(const char* pName);
+
+    bool is_checksum_frame(uint32_t frame) const;
+    uint32_t find_memory_type(const Device& device, uint32_t memoryTypeBits, VkMemoryPropertyFlags properties) const;
+    VkResult add_images(Swapchain& swapchain, uint32_t count);
+    void destroy_images(Swapchain& swapchain);
+    // Copies a presented image to host memory once the wait semaphores are signaled and adds
+    // it to m_pChecksums.  *pWaitSemaphoreCount is set to 0 once the semaphores were waited for.
+    void checksum_image(VkQueue queue, uint32_t swapchainIndex, const Swapchain& swapchain, uint32_t imageIndex,
+                        uint32_t* pWaitSemaphoreCount, const VkSemaphore* pWaitSemaphores);
+
+    static vkOffscreenDisplay* s_pDisplay;
+
+    vkFuncs* m_pFuncs;
+    // Commands replaced to track devices and queues, still called
+    PFN_vkGetInstanceProcAddr m_realGetInstanceProcAddr;
+    PFN_vkGetDeviceProcAddr m_realGetDeviceProcAddr;
+    PFN_vkCreateDevice m_realCreateDevice;
+    PFN_vkDestroyDevice m_realDestroyDevice;
+    PFN_vkGetDeviceQueue m_realGetDeviceQueue;
+
+    vktrace_replay::FrameChecksums* m_pChecksums;
+    screenshot::FrameRange m_checksumRange;
+    std::vector<uint32_t> m_checksumFrames;
+    uint32_t m_presentCount;
+
+    uint64_t m_nextHandle;
+    std::unordered_map<VkDevice, Device> m_devices;
+    std::unordered_map<VkQueue, Queue> m_queues;
+    std::unordered_map<VkSwapchainKHR, Swapchain> m_swapchains;
+};
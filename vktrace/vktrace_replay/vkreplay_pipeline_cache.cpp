@@ -0,0 +1,185 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#include "vkreplay_pipeline_cache.h"
+
+extern "C" {
+#include "vktrace_platform.h"
+#include "vktrace_trace_packet_utils.h"
+}
+
+#include "vkreplay_vk_func_ptrs.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace vktrace_replay {
+
+// File layout: a FileHeader, then for each entry its Key, a uint64_t data size and the data
+static const char kMagic[8] = {'V', 'K', 'R', 'P', 'C', 'A', 'C', 'H'};
+static const uint32_t kFileVersion = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t traceUuid[4];
+    uint32_t entryCount;
+};
+
+PipelineCacheFile::PipelineCacheFile(vkFuncs& funcs, const char* pPath, const uint32_t traceUuid[4])
+    : m_vkFuncs(funcs), m_path(pPath), m_dirty(false) {
+    memcpy(m_traceUuid, traceUuid, sizeof(m_traceUuid));
+    load();
+}
+
+PipelineCacheFile::~PipelineCacheFile() { save(); }
+
+void PipelineCacheFile::load() {
+    FILE* pFile = fopen(m_path.c_str(), "rb");
+    if (pFile == NULL) {
+        vktrace_LogVerbose("Pipeline cache file %s not found, pipelines will be compiled.", m_path.c_str());
+        return;
+    }
+
+    FileHeader header;
+    if (fread(&header, sizeof(header), 1, pFile) != 1 || memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != kFileVersion) {
+        vktrace_LogWarning("%s is not a vkreplay pipeline cache file, it will be overwritten.", m_path.c_str());
+        fclose(pFile);
+        return;
+    }
+    if (memcmp(header.traceUuid, m_traceUuid, sizeof(m_traceUuid)) != 0) {
+        vktrace_LogAlways("Pipeline cache file %s was written for another trace, it will be overwritten.", m_path.c_str());
+        fclose(pFile);
+        return;
+    }
+
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        Entry entry;
+        uint64_t size = 0;
+        if (fread(&entry.key, sizeof(entry.key), 1, pFile) != 1 || fread(&size, sizeof(size), 1, pFile) != 1) break;
+        entry.data.resize((size_t)size);
+        if (size > 0 && fread(entry.data.data(), (size_t)size, 1, pFile) != 1) break;
+        m_entries.push_back(std::move(entry));
+    }
+    if (m_entries.size() != header.entryCount) {
+        vktrace_LogWarning("Pipeline cache file %s is truncated, only %u of %u caches were read.", m_path.c_str(),
+                           (uint32_t)m_entries.size(), header.entryCount);
+    }
+    fclose(pFile);
+}
+
+VkPipelineCache PipelineCacheFile::get(VkDevice device, VkPhysicalDevice physicalDevice) {
+    auto it = m_devices.find(device);
+    if (it != m_devices.end()) return it->second.cache;
+
+    VkPhysicalDeviceProperties properties;
+    m_vkFuncs.real_vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    Key key;
+    memset(&key, 0, sizeof(key));
+    key.vendorID = properties.vendorID;
+    key.deviceID = properties.deviceID;
+    key.driverVersion = properties.driverVersion;
+    memcpy(key.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    size_t entryIndex = 0;
+    while (entryIndex < m_entries.size() && memcmp(&m_entries[entryIndex].key, &key, sizeof(key)) != 0) entryIndex++;
+    if (entryIndex == m_entries.size()) {
+        Entry entry;
+        entry.key = key;
+        m_entries.push_back(std::move(entry));
+    }
+    const std::vector<uint8_t>& data = m_entries[entryIndex].data;
+
+    VkPipelineCacheCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData = data.empty() ? NULL : data.data();
+    DeviceCache deviceCache = {VK_NULL_HANDLE, entryIndex};
+    if (m_vkFuncs.real_vkCreatePipelineCache(device, &createInfo, NULL, &deviceCache.cache) != VK_SUCCESS) {
+        vktrace_LogWarning("Failed to create the replay pipeline cache, pipelines will be compiled without it.");
+        deviceCache.cache = VK_NULL_HANDLE;
+    } else if (!data.empty()) {
+        vktrace_LogVerbose("Loaded %u bytes of pipeline cache data from %s.", (uint32_t)data.size(), m_path.c_str());
+    }
+    // A failed cache is remembered too, so creation isn't retried for every pipeline
+    m_devices[device] = deviceCache;
+    return deviceCache.cache;
+}
+
+void PipelineCacheFile::keep(VkDevice device, const DeviceCache& deviceCache) {
+    if (deviceCache.cache == VK_NULL_HANDLE) return;
+    size_t size = 0;
+    if (m_vkFuncs.real_vkGetPipelineCacheData(device, deviceCache.cache, &size, NULL) != VK_SUCCESS || size == 0) return;
+    std::vector<uint8_t> data(size);
+    if (m_vkFuncs.real_vkGetPipelineCacheData(device, deviceCache.cache, &size, data.data()) != VK_SUCCESS) return;
+    data.resize(size);
+    m_entries[deviceCache.entryIndex].data.swap(data);
+    m_dirty = true;
+}
+
+void PipelineCacheFile::destroy_device(VkDevice device) {
+    auto it = m_devices.find(device);
+    if (it == m_devices.end()) return;
+    keep(device, it->second);
+    if (it->second.cache != VK_NULL_HANDLE) m_vkFuncs.real_vkDestroyPipelineCache(device, it->second.cache, NULL);
+    m_devices.erase(it);
+}
+
+void PipelineCacheFile::save() {
+    for (auto& entry : m_devices) keep(entry.first, entry.second);
+    if (!m_dirty) return;
+
+    // Write a temporary file and rename it, so an interrupted replay never leaves a partial file
+    std::string tempPath = m_path + ".tmp";
+    FILE* pFile = fopen(tempPath.c_str(), "wb");
+    if (pFile == NULL) {
+        vktrace_LogError("Failed to open %s to write the pipeline cache.", tempPath.c_str());
+        return;
+    }
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFileVersion;
+    memcpy(header.traceUuid, m_traceUuid, sizeof(m_traceUuid));
+    uint32_t entryCount = 0;
+    for (const Entry& entry : m_entries) entryCount += entry.data.empty() ? 0 : 1;
+    header.entryCount = entryCount;
+    bool ok = fwrite(&header, sizeof(header), 1, pFile) == 1;
+    for (const Entry& entry : m_entries) {
+        if (!ok || entry.data.empty()) continue;
+        uint64_t size = entry.data.size();
+        ok = fwrite(&entry.key, sizeof(entry.key), 1, pFile) == 1 && fwrite(&size, sizeof(size), 1, pFile) == 1 &&
+             fwrite(entry.data.data(), entry.data.size(), 1, pFile) == 1;
+    }
+    ok = (fclose(pFile) == 0) && ok;
+    if (ok) {
+        remove(m_path.c_str());
+        ok = rename(tempPath.c_str(), m_path.c_str()) == 0;
+    }
+    if (!ok) {
+        vktrace_LogError("Failed to write the pipeline cache to %s.", m_path.c_str());
+        remove(tempPath.c_str());
+        return;
+    }
+    m_dirty = false;
+    vktrace_LogVerbose("Saved %u pipeline caches to %s.", entryCount, m_path.c_str());
+}
+
+}  // namespace vktrace_replay
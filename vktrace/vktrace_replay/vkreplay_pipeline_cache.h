@@ -0,0 +1,76 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+struct vkFuncs;
+
+namespace vktrace_replay {
+
+// Pipeline cache kept across replay runs.  One replay-side VkPipelineCache per device is used
+// for every pipeline creation and saved to a file when the device is destroyed or replay ends.
+// The file is keyed by the trace UUID, and each cache in it by the vendor, device, driver
+// version and pipeline cache UUID of the physical device it was created on, so data from a
+// different trace or driver is never handed to the driver.
+class PipelineCacheFile {
+   public:
+    PipelineCacheFile(vkFuncs& funcs, const char* pPath, const uint32_t traceUuid[4]);
+    ~PipelineCacheFile();
+
+    // Returns the replay-side cache of device, creating it from the file the first time
+    VkPipelineCache get(VkDevice device, VkPhysicalDevice physicalDevice);
+    // Keeps the cache data of device and destroys its cache
+    void destroy_device(VkDevice device);
+    // Keeps the data of every live cache and writes the file
+    void save();
+
+   private:
+    struct Key {
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    };
+    struct Entry {
+        Key key;
+        std::vector<uint8_t> data;
+    };
+    struct DeviceCache {
+        VkPipelineCache cache;
+        size_t entryIndex;
+    };
+
+    void load();
+    void keep(VkDevice device, const DeviceCache& deviceCache);
+
+    vkFuncs& m_vkFuncs;
+    std::string m_path;
+    uint32_t m_traceUuid[4];
+    std::vector<Entry> m_entries;
+    std::unordered_map<VkDevice, DeviceCache> m_devices;
+    bool m_dirty;
+};
+
+}  // namespace vktrace_replay
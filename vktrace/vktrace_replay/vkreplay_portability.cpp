@@ -0,0 +1,179 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#include "vkreplay_portability.h"
+
+extern "C" {
+#include "vktrace_common.h"
+#include "vktrace_trace_packet_identifiers.h"
+}
+
+#include "vktrace_trace_header_reader.h"
+#include "vktrace_vk_packet_id.h"
+#include "vktrace_vk_vk_packets.h"
+
+vktrace_replay::PortabilityIndex portabilityIndex;
+
+namespace vktrace_replay {
+
+void PortabilityIndex::build(const char* pTraceFile, const std::vector<size_t>& table) {
+    wait();
+    std::string traceFile(pTraceFile);
+    m_thread = std::thread([this, traceFile, table]() {
+        FILE* pFile = fopen(traceFile.c_str(), "rb");
+        if (pFile == NULL) {
+            vktrace_LogError("Cannot open trace file '%s' to index the portability table.", traceFile.c_str());
+            return;
+        }
+        m_valid = build_index(pFile, table);
+        fclose(pFile);
+        if (!m_valid) {
+            vktrace_LogError("Failed to index the portability table, trace file may be corrupt.");
+            m_allocations.clear();
+        }
+    });
+}
+
+void PortabilityIndex::wait() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_thread.joinable()) m_thread.join();
+}
+
+const PortabilityAllocation* PortabilityIndex::find_allocation(uint64_t globalPacketIndex) {
+    wait();
+    if (!m_valid) return NULL;
+    auto it = m_allocations.find(globalPacketIndex);
+    return (it != m_allocations.end()) ? &it->second : NULL;
+}
+
+static bool read_packet(FILE* pFile, size_t offset, vktrace_trace_packet_header* pHeader) {
+    return vktrace_fseek64(pFile, offset) && fread(pHeader, sizeof(*pHeader), 1, pFile) == 1;
+}
+
+// Reads the packet struct that follows the header read by read_packet()
+template <typename T>
+static bool read_body(FILE* pFile, const vktrace_trace_packet_header& header, T* pBody) {
+    return header.size >= sizeof(header) + sizeof(T) && fread(pBody, sizeof(T), 1, pFile) == 1;
+}
+
+// This is a single pass version of the searches vkAllocateMemory used to do in the trace file:
+// forward from each allocation to the first bind of its memory, unless the memory is freed first,
+// then backwards from the bind to the last requirements query for the bound object, unless the
+// object is destroyed in between.
+bool PortabilityIndex::build_index(FILE* pFile, const std::vector<size_t>& table) {
+    struct PendingAllocation {
+        PortabilityAllocation* pAllocation;
+        size_t tableIndex;
+    };
+    std::unordered_map<VkDeviceMemory, PendingAllocation> unboundMemory;
+    std::unordered_map<VkImage, uint16_t> lastRequirements;
+    vktrace_trace_packet_header header;
+
+    for (size_t i = 0; i < table.size(); i++) {
+        if (!read_packet(pFile, table[i], &header)) return false;
+
+        switch (header.packet_id) {
+            case VKTRACE_TPI_VK_vkAllocateMemory: {
+                // The returned VkDeviceMemory is the last buffer in the packet
+                VkDeviceMemory memory;
+                if (header.size < sizeof(header) + sizeof(VkDeviceMemory*) ||
+                    !vktrace_fseek64(pFile, table[i] + header.size - sizeof(VkDeviceMemory*)) ||
+                    fread(&memory, sizeof(memory), 1, pFile) != 1)
+                    return false;
+                PortabilityAllocation& allocation = m_allocations[header.global_packet_index];
+                allocation.bindPacketId = 0;
+                allocation.boundObject = VK_NULL_HANDLE;
+                allocation.requirementsPacketId = 0;
+                allocation.createPacket.clear();
+                unboundMemory[memory] = {&allocation, i};
+                break;
+            }
+            case VKTRACE_TPI_VK_vkFreeMemory: {
+                packet_vkFreeMemory freeMemoryPacket;
+                if (!read_body(pFile, header, &freeMemoryPacket)) return false;
+                // Memory freed before it is bound isn't used, vkAllocateMemory keeps the traced memoryTypeIndex
+                unboundMemory.erase(freeMemoryPacket.memory);
+                break;
+            }
+            case VKTRACE_TPI_VK_vkGetImageMemoryRequirements:
+            case VKTRACE_TPI_VK_vkGetBufferMemoryRequirements: {
+                // We rely on the fact that packet_vkGetBufferMemoryRequirements is the same size
+                packet_vkGetImageMemoryRequirements gimrPacket;
+                if (!read_body(pFile, header, &gimrPacket)) return false;
+                lastRequirements[gimrPacket.image] = header.packet_id;
+                break;
+            }
+            case VKTRACE_TPI_VK_vkDestroyImage:
+            case VKTRACE_TPI_VK_vkDestroyBuffer: {
+                packet_vkDestroyImage destroyImagePacket;
+                if (!read_body(pFile, header, &destroyImagePacket)) return false;
+                lastRequirements.erase(destroyImagePacket.image);
+                break;
+            }
+            case VKTRACE_TPI_VK_vkBindImageMemory:
+            case VKTRACE_TPI_VK_vkBindBufferMemory: {
+                // We rely on the fact that packet_vkBindBufferMemory is the same size
+                packet_vkBindImageMemory bimPacket;
+                if (!read_body(pFile, header, &bimPacket)) return false;
+                auto pending = unboundMemory.find(bimPacket.memory);
+                if (pending == unboundMemory.end()) break;
+
+                PortabilityAllocation* pAllocation = pending->second.pAllocation;
+                size_t allocationIndex = pending->second.tableIndex;
+                unboundMemory.erase(pending);
+                pAllocation->bindPacketId = header.packet_id;
+                pAllocation->boundObject = bimPacket.image;
+
+                auto requirements = lastRequirements.find(bimPacket.image);
+                if (requirements != lastRequirements.end()) {
+                    pAllocation->requirementsPacketId = requirements->second;
+                    break;
+                }
+
+                // The object might be created after the allocation, in which case it isn't
+                // created yet when vkAllocateMemory is replayed; keep its create packet.
+                uint16_t createPacketId = (header.packet_id == VKTRACE_TPI_VK_vkBindImageMemory) ? VKTRACE_TPI_VK_vkCreateImage
+                                                                                                : VKTRACE_TPI_VK_vkCreateBuffer;
+                vktrace_trace_packet_header createHeader;
+                for (size_t j = i - 1; j > allocationIndex; j--) {
+                    if (!read_packet(pFile, table[j], &createHeader)) return false;
+                    if (createHeader.packet_id != createPacketId) continue;
+
+                    std::vector<uint8_t> createPacket(createHeader.size);
+                    packet_vkCreateImage* pCreatePacket = (packet_vkCreateImage*)(createPacket.data() + sizeof(createHeader));
+                    if (createHeader.size < sizeof(createHeader) + sizeof(packet_vkCreateImage) ||
+                        !vktrace_fseek64(pFile, table[j]) || fread(createPacket.data(), createHeader.size, 1, pFile) != 1)
+                        return false;
+                    size_t handleOffset = sizeof(createHeader) + (size_t)pCreatePacket->pImage;
+                    if (handleOffset + sizeof(VkImage) > createHeader.size) return false;
+                    if (*(VkImage*)(createPacket.data() + handleOffset) == bimPacket.image) {
+                        pAllocation->createPacket.swap(createPacket);
+                        break;
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+}  // namespace vktrace_replay
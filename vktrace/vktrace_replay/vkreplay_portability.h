@@ -0,0 +1,76 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+namespace vktrace_replay {
+
+// What vkAllocateMemory needs to know about the rest of the trace to translate
+// memoryTypeIndex when the trace and replay platforms differ.
+struct PortabilityAllocation {
+    // vkBindImageMemory or vkBindBufferMemory packet id, 0 if the memory is freed or the
+    // trace ends before it is bound
+    uint16_t bindPacketId;
+    // Traced VkImage, or VkBuffer cast to VkImage, bound to the memory
+    VkImage boundObject;
+    // vkGetImageMemoryRequirements or vkGetBufferMemoryRequirements packet id for the bound
+    // object, 0 if the trace binds the memory without querying the requirements
+    uint16_t requirementsPacketId;
+    // When requirementsPacketId is 0: the vkCreateImage/vkCreateBuffer packet of the bound
+    // object if it is created between the allocation and the bind, empty otherwise
+    std::vector<uint8_t> createPacket;
+};
+
+// Index from each vkAllocateMemory packet to the packets it depends on, built from the
+// trace file's portability table on a background thread while replay starts up, so that
+// vkAllocateMemory doesn't have to search the trace file.
+class PortabilityIndex {
+   public:
+    ~PortabilityIndex() { wait(); }
+
+    // Starts building the index; the trace file is opened again so that replay can keep
+    // reading from its own FILE
+    void build(const char* pTraceFile, const std::vector<size_t>& table);
+
+    // Returns the entry for the vkAllocateMemory packet with this global_packet_index, or
+    // NULL if there is none.  Blocks until the index is built.
+    const PortabilityAllocation* find_allocation(uint64_t globalPacketIndex);
+
+    void wait();
+
+   private:
+    bool build_index(FILE* pFile, const std::vector<size_t>& table);
+
+    std::mutex m_mutex;
+    std::thread m_thread;
+    bool m_valid = false;
+    std::unordered_map<uint64_t, PortabilityAllocation> m_allocations;
+};
+
+}  // namespace vktrace_replay
+
+extern vktrace_replay::PortabilityIndex portabilityIndex;
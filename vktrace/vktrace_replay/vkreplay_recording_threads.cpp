@@ -0,0 +1,137 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#include "vkreplay_recording_threads.h"
+
+extern "C" {
+#include "vktrace_common.h"
+#include "vktrace_trace_packet_utils.h"
+}
+
+#include "vktrace_vk_packet_id.h"
+#include "vkreplay_factory.h"
+
+#include <string.h>
+
+namespace vktrace_replay {
+
+RecordingThreads::RecordingThreads(unsigned int threadCount)
+    : m_nextWorker(0), m_lastThreadId(0), m_pLastWorker(NULL), m_outstanding(0), m_done(false) {
+    m_recordingPackets.resize(VKTRACE_TPI_VK_END);
+    for (uint32_t id = VKTRACE_TPI_VK_vkApiVersion; id < VKTRACE_TPI_VK_END; id++) {
+        const char* pName = vktrace_vk_packet_id_name((VKTRACE_TRACE_PACKET_ID_VK)id);
+        m_recordingPackets[id] = pName != NULL && (strncmp(pName, "vkCmd", 5) == 0 || strcmp(pName, "vkBeginCommandBuffer") == 0 ||
+                                                   strcmp(pName, "vkEndCommandBuffer") == 0);
+    }
+
+    if (threadCount == 0) threadCount = 1;
+    for (unsigned int i = 0; i < threadCount; i++) {
+        Worker* pWorker = new Worker();
+        pWorker->pending.reserve(kBatchSize);
+        m_workers.push_back(pWorker);
+    }
+    for (Worker* pWorker : m_workers) pWorker->thread = std::thread(&RecordingThreads::work, this, pWorker);
+}
+
+RecordingThreads::~RecordingThreads() {
+    wait_idle();
+    {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        m_done = true;
+    }
+    for (Worker* pWorker : m_workers) {
+        {
+            std::lock_guard<std::mutex> lock(pWorker->mutex);
+        }
+        pWorker->notEmpty.notify_one();
+        pWorker->thread.join();
+        delete pWorker;
+    }
+}
+
+void RecordingThreads::dispatch(vktrace_trace_packet_replay_library* pReplayer, vktrace_trace_packet_header* pPacket,
+                                vktrace_trace_packet_header* pOwnedPacket) {
+    // Traced threads are bound to workers in the order they first record.  Consecutive packets
+    // nearly always come from the same thread, so skip the lookup for those.
+    if (m_pLastWorker == NULL || pPacket->thread_id != m_lastThreadId) {
+        Worker*& pWorker = m_tracedThreads[pPacket->thread_id];
+        if (pWorker == NULL) pWorker = m_workers[m_nextWorker++ % m_workers.size()];
+        m_lastThreadId = pPacket->thread_id;
+        m_pLastWorker = pWorker;
+    }
+    Worker* pWorker = m_pLastWorker;
+
+    Job job = {pReplayer, pPacket, pOwnedPacket};
+    pWorker->pending.push_back(job);
+    if (pWorker->pending.size() == kBatchSize) flush(*pWorker);
+}
+
+void RecordingThreads::flush(Worker& worker) {
+    if (worker.pending.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        m_outstanding++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queue.push_back(std::move(worker.pending));
+    }
+    worker.notEmpty.notify_one();
+    worker.pending = Batch();
+    worker.pending.reserve(kBatchSize);
+}
+
+void RecordingThreads::wait_idle() {
+    for (Worker* pWorker : m_workers) flush(*pWorker);
+    std::unique_lock<std::mutex> lock(m_idleMutex);
+    m_idle.wait(lock, [this] { return m_outstanding == 0; });
+}
+
+void RecordingThreads::work(Worker* pWorker) {
+    while (true) {
+        Batch batch;
+        {
+            std::unique_lock<std::mutex> lock(pWorker->mutex);
+            pWorker->notEmpty.wait(lock, [this, pWorker] {
+                if (!pWorker->queue.empty()) return true;
+                std::lock_guard<std::mutex> idleLock(m_idleMutex);
+                return m_done;
+            });
+            if (pWorker->queue.empty()) return;
+            batch = std::move(pWorker->queue.front());
+            pWorker->queue.pop_front();
+        }
+
+        for (Job& job : batch) {
+            VKTRACE_REPLAY_RESULT res = job.pReplayer->Replay(job.pPacket);
+            if (res != VKTRACE_REPLAY_SUCCESS) {
+                vktrace_LogError("Failed to replay packet_id %d, with global_packet_index %d.", job.pPacket->packet_id,
+                                 job.pPacket->global_packet_index);
+            }
+            if (job.pOwnedPacket != NULL) vktrace_free(job.pOwnedPacket);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_idleMutex);
+            if (--m_outstanding == 0) m_idle.notify_all();
+        }
+    }
+}
+
+}  // namespace vktrace_replay
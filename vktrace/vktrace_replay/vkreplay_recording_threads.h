@@ -0,0 +1,94 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include "vktrace_trace_packet_identifiers.h"
+}
+
+namespace vktrace_replay {
+
+struct vktrace_trace_packet_replay_library;
+
+// Replays command buffer recording packets (vkBeginCommandBuffer, vkCmd*, vkEndCommandBuffer)
+// on worker threads.  Each traced thread is bound to one worker, so a traced thread's packets
+// are replayed in their traced order while different traced threads record in parallel, as
+// they did in the application.  Every other packet is a synchronization point: the caller
+// waits for the workers with wait_idle() and replays it on the main thread.
+class RecordingThreads {
+   public:
+    RecordingThreads(unsigned int threadCount);
+    ~RecordingThreads();
+
+    bool is_recording_packet(uint16_t packet_id) const {
+        return packet_id < m_recordingPackets.size() && m_recordingPackets[packet_id];
+    }
+
+    // Queues an interpreted packet for the worker of its traced thread; pOwnedPacket, if not
+    // NULL, is freed once the packet has been replayed
+    void dispatch(vktrace_trace_packet_replay_library* pReplayer, vktrace_trace_packet_header* pPacket,
+                  vktrace_trace_packet_header* pOwnedPacket);
+    // Returns once every dispatched packet has been replayed
+    void wait_idle();
+
+   private:
+    struct Job {
+        vktrace_trace_packet_replay_library* pReplayer;
+        vktrace_trace_packet_header* pPacket;
+        vktrace_trace_packet_header* pOwnedPacket;
+    };
+    typedef std::vector<Job> Batch;
+
+    // Packets are handed to a worker in batches to keep locking off the per-packet path
+    static const size_t kBatchSize = 64;
+
+    struct Worker {
+        std::thread thread;
+        Batch pending;  // only touched by the main thread
+        std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::deque<Batch> queue;
+    };
+
+    void flush(Worker& worker);
+    void work(Worker* pWorker);
+
+    std::vector<bool> m_recordingPackets;
+    std::vector<Worker*> m_workers;
+    std::unordered_map<uint32_t, Worker*> m_tracedThreads;
+    size_t m_nextWorker;
+    uint32_t m_lastThreadId;
+    Worker* m_pLastWorker;
+
+    // Batches queued but not replayed yet, across all workers
+    std::mutex m_idleMutex;
+    std::condition_variable m_idle;
+    size_t m_outstanding;
+    bool m_done;
+};
+
+}  // namespace vktrace_replay
@@ -24,19 +24,103 @@ extern "C" {
 #include "vktrace_trace_packet_utils.h"
 }
 
+#include <string.h>
+
 namespace vktrace_replay {
 
 vktrace_trace_packet_header *Sequencer::get_next_packet() {
+    if (m_preloadState == PRELOAD_REPLAYING) {
+        if (m_nextPreloadedPacket >= m_preloadOffsets.size()) return (NULL);
+        size_t offset = m_preloadOffsets[m_nextPreloadedPacket++];
+        vktrace_trace_packet_header *pHeader = (vktrace_trace_packet_header *)&m_preloadArena[offset];
+        memcpy(pHeader, &m_preloadPristine[offset], (size_t)pHeader->size);
+        return (pHeader);
+    }
+
     vktrace_free(m_lastPacket);
     if (!m_pFile) return (NULL);
     m_lastPacket = vktrace_read_trace_packet(m_pFile);
+
+    if (m_lastPacket != NULL && m_preloadState == PRELOAD_RECORDING) {
+        // Keep packets 16 byte aligned; the arena and its pristine copy both count against the budget
+        size_t offset = (m_preloadArena.size() + 15) & ~(size_t)15;
+        size_t end = offset + (size_t)m_lastPacket->size;
+        if (2 * (uint64_t)end > m_preloadBudget) {
+            vktrace_LogWarning("Loop range is larger than the preload budget of %llu MB, replaying it from the trace file.",
+                               (unsigned long long)(m_preloadBudget >> 20));
+            release_preload();
+        } else {
+            m_preloadArena.resize(end);
+            memcpy(&m_preloadArena[offset], m_lastPacket, (size_t)m_lastPacket->size);
+            m_preloadOffsets.push_back(offset);
+        }
+    }
     return (m_lastPacket);
 }
 
+vktrace_trace_packet_header *Sequencer::detach_last_packet() {
+    if (m_preloadState == PRELOAD_REPLAYING) return (NULL);
+    vktrace_trace_packet_header *pPacket = m_lastPacket;
+    m_lastPacket = NULL;
+    return (pPacket);
+}
+
 void Sequencer::get_bookmark(seqBookmark &bookmark) { bookmark.file_offset = m_bookmark.file_offset; }
 
-void Sequencer::set_bookmark(const seqBookmark &bookmark) { fseek(m_pFile->mFile, m_bookmark.file_offset, SEEK_SET); }
+void Sequencer::set_bookmark(const seqBookmark &bookmark) {
+    if (m_preloadState == PRELOAD_REPLAYING) {
+        m_nextPreloadedPacket = 0;
+        return;
+    }
+    fseek(m_pFile->mFile, m_bookmark.file_offset, SEEK_SET);
+}
+
+void Sequencer::record_bookmark() {
+    // The preloaded range can't move
+    if (m_preloadState == PRELOAD_REPLAYING) return;
+    if (m_preloadState == PRELOAD_RECORDING) {
+        m_preloadArena.clear();
+        m_preloadOffsets.clear();
+    }
+    m_bookmark.file_offset = ftell(m_pFile->mFile);
+}
+
+void Sequencer::begin_preload(uint64_t budget) {
+    release_preload();
+    m_preloadBudget = budget;
+    m_preloadState = PRELOAD_RECORDING;
+}
+
+void Sequencer::end_preload(PFN_interpretPacket pInterpret, void *pUserData) {
+    if (m_preloadState != PRELOAD_RECORDING) return;
+    if (m_preloadOffsets.empty()) {
+        release_preload();
+        return;
+    }
 
-void Sequencer::record_bookmark() { m_bookmark.file_offset = ftell(m_pFile->mFile); }
+    for (size_t offset : m_preloadOffsets) {
+        vktrace_trace_packet_header *pHeader = (vktrace_trace_packet_header *)&m_preloadArena[offset];
+        pHeader->pBody = (uintptr_t)pHeader + sizeof(vktrace_trace_packet_header);
+        if (pInterpret(pUserData, pHeader) == NULL) {
+            vktrace_LogWarning("Failed to interpret preloaded packet %llu, replaying the loop range from the trace file.",
+                               (unsigned long long)pHeader->global_packet_index);
+            release_preload();
+            return;
+        }
+    }
+    m_preloadPristine = m_preloadArena;
+    m_preloadState = PRELOAD_REPLAYING;
+    m_nextPreloadedPacket = 0;
+    vktrace_LogVerbose("Preloaded %llu packets (%llu bytes) of the loop range.", (unsigned long long)m_preloadOffsets.size(),
+                       (unsigned long long)m_preloadArena.size());
+}
+
+void Sequencer::release_preload() {
+    m_preloadState = PRELOAD_OFF;
+    std::vector<uint8_t>().swap(m_preloadArena);
+    std::vector<uint8_t>().swap(m_preloadPristine);
+    std::vector<size_t>().swap(m_preloadOffsets);
+    m_nextPreloadedPacket = 0;
+}
 
 } /* namespace vktrace_replay */
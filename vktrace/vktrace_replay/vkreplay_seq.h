@@ -25,6 +25,9 @@ extern "C" {
 #include "vktrace_trace_packet_identifiers.h"
 }
 
+#include <stdint.h>
+#include <vector>
+
 /* Class to handle fetching and sequencing packets from a tracefile.
  * Contains no knowledge of type of tracer needed to process packet.
  * Requires low level file/stream reading/seeking support. */
@@ -43,9 +46,13 @@ class AbstractSequencer {
     virtual void set_bookmark(const seqBookmark &bookmark) = 0;
 };
 
+// Interprets a packet in place, returns NULL if it can't be interpreted
+typedef vktrace_trace_packet_header *(*PFN_interpretPacket)(void *pUserData, vktrace_trace_packet_header *pPacket);
+
 class Sequencer : public AbstractSequencer {
    public:
-    Sequencer(FileLike *pFile) : m_lastPacket(NULL), m_pFile(pFile) {}
+    Sequencer(FileLike *pFile)
+        : m_lastPacket(NULL), m_pFile(pFile), m_preloadBudget(0), m_preloadState(PRELOAD_OFF), m_nextPreloadedPacket(0) {}
     ~Sequencer() { this->clean_up(); }
 
     void clean_up() {
@@ -53,17 +60,44 @@ class Sequencer : public AbstractSequencer {
             free(m_lastPacket);
             m_lastPacket = NULL;
         }
+        release_preload();
     }
 
     vktrace_trace_packet_header *get_next_packet();
+    // Hands the packet last returned by get_next_packet() over to the caller, who frees it
+    // with vktrace_free().  Returns NULL for preloaded packets, which stay owned by the sequencer.
+    vktrace_trace_packet_header *detach_last_packet();
     void get_bookmark(seqBookmark &bookmark);
     void set_bookmark(const seqBookmark &bookmark);
     void record_bookmark();
 
+    // Loop range preloading.  While preloading, every packet read after the bookmark is also
+    // copied into an arena.  Once the loop range has been read, end_preload() interprets the
+    // copies once and later loops replay them from memory instead of reading the trace file
+    // again.  If the range doesn't fit in budget bytes, preloading is abandoned and packets
+    // keep being read from the file.
+    void begin_preload(uint64_t budget);
+    void end_preload(PFN_interpretPacket pInterpret, void *pUserData);
+    // True when get_next_packet() returns packets that are already interpreted
+    bool replaying_preloaded() const { return m_preloadState == PRELOAD_REPLAYING; }
+
    private:
+    enum PreloadState { PRELOAD_OFF, PRELOAD_RECORDING, PRELOAD_REPLAYING };
+
+    void release_preload();
+
     vktrace_trace_packet_header *m_lastPacket;
     seqBookmark m_bookmark;
     FileLike *m_pFile;
+
+    uint64_t m_preloadBudget;
+    PreloadState m_preloadState;
+    // Packets of the loop range, interpreted in place in m_preloadArena.  Replay may patch
+    // packets, so each one is restored from m_preloadPristine before it is returned.
+    std::vector<uint8_t> m_preloadArena;
+    std::vector<uint8_t> m_preloadPristine;
+    std::vector<size_t> m_preloadOffsets;
+    size_t m_nextPreloadedPacket;
 };
 
 } /* namespace vktrace_replay */
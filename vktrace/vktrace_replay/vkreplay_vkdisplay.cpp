@@ -136,6 +136,9 @@ int vkDisplay::init(const unsigned int gpu_idx) {
         m_initedVK = true;
     }
 #endif
+    set_pause_status(false);
+    set_quit_status(false);
+    if (m_headless) return 0;
 #if defined(PLATFORM_LINUX) && !defined(ANDROID)
     const xcb_setup_t *setup;
     xcb_screen_iterator_t iter;
@@ -146,8 +149,6 @@ int vkDisplay::init(const unsigned int gpu_idx) {
     while (scr-- > 0) xcb_screen_next(&iter);
     m_pXcbScreen = iter.data;
 #endif
-    set_pause_status(false);
-    set_quit_status(false);
     return 0;
 }
 
@@ -183,6 +184,11 @@ int vkDisplay::set_window(vktrace_window_handle hWindow, unsigned int width, uns
 }
 
 int vkDisplay::create_window(const unsigned int width, const unsigned int height) {
+    if (m_headless) {
+        m_windowWidth = width;
+        m_windowHeight = height;
+        return 0;
+    }
 #if defined(PLATFORM_LINUX)
 #if defined(ANDROID)
     return 0;
@@ -260,6 +266,11 @@ int vkDisplay::create_window(const unsigned int width, const unsigned int height
 }
 
 void vkDisplay::resize_window(const unsigned int width, const unsigned int height) {
+    if (m_headless) {
+        m_windowWidth = width;
+        m_windowHeight = height;
+        return;
+    }
 #if defined(PLATFORM_LINUX)
 #if defined(ANDROID)
     m_windowWidth = width;
@@ -299,6 +310,7 @@ void vkDisplay::resize_window(const unsigned int width, const unsigned int heigh
 }
 
 void vkDisplay::process_event() {
+    if (m_headless) return;
 #if defined(PLATFORM_LINUX)
 #if defined(ANDROID)
 // TODO
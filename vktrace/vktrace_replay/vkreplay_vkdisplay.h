@@ -42,6 +42,9 @@ class vkDisplay : public vktrace_replay::ReplayDisplayImp {
     void set_pause_status(bool pause) { m_pause = pause; }
     bool get_quit_status() { return m_quit; }
     void set_quit_status(bool quit) { m_quit = quit; }
+    // A headless display has no window system connection; used with the null driver and by
+    // vkOffscreenDisplay
+    void set_headless(bool headless) { m_headless = headless; }
     VkSurfaceKHR get_surface() { return (VkSurfaceKHR)&m_surface; };
 // VK_DEVICE get_device() { return m_dev[m_gpuIdx];}
 #if defined(PLATFORM_LINUX)
@@ -51,6 +54,8 @@ class vkDisplay : public vktrace_replay::ReplayDisplayImp {
     xcb_window_t get_window_handle() { return m_XcbWindow; }
     xcb_connection_t* get_connection_handle() { return m_pXcbConnection; }
     xcb_screen_t* get_screen_handle() { return m_pXcbScreen; }
+    // 0 for a headless display
+    xcb_visualid_t get_root_visual() { return (m_pXcbScreen != NULL) ? m_pXcbScreen->root_visual : 0; }
 #endif
 #elif defined(WIN32)
     HWND get_window_handle() { return m_windowHandle; }
@@ -93,4 +98,5 @@ class vkDisplay : public vktrace_replay::ReplayDisplayImp {
     std::vector<char*> m_extensions;
     bool m_pause = false;
     bool m_quit = false;
+    bool m_headless = false;
 };
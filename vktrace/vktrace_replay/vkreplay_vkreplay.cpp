@@ -29,6 +29,7 @@
 #include "vkreplay.h"
 #include "vkreplay_settings.h"
 #include "vkreplay_main.h"
+#include "vkreplay_portability.h"
 
 #include <algorithm>
 
@@ -45,6 +46,11 @@ vkreplayer_settings *g_pReplaySettings;
 vkReplay::vkReplay(vkreplayer_settings *pReplaySettings, vktrace_trace_file_header *pFileHeader) {
     g_pReplaySettings = pReplaySettings;
     m_display = new vkDisplay();
+    m_pGpuFrameTimer = NULL;
+    m_pPipelineCacheFile = NULL;
+    m_pMemoryAllocator = NULL;
+    m_pOffscreenDisplay = NULL;
+    m_pFrameChecksums = NULL;
     m_pDSDump = NULL;
     m_pCBDump = NULL;
     //    m_pVktraceSnapshotPrint = NULL;
@@ -54,29 +60,71 @@ vkReplay::vkReplay(vkreplayer_settings *pReplaySettings, vktrace_trace_file_head
     m_pFileHeader = pFileHeader;
     m_pGpuinfo = (struct_gpuinfo *)(pFileHeader + 1);
     m_platformMatch = -1;
+#if defined(USE_PAGEGUARD_SPEEDUP) && !defined(PAGEGUARD_MEMCPY_USE_PPL_LIB)
+    vktrace_pageguard_init_multi_threads_memcpy();
+#endif
 }
 
 std::vector<size_t> portabilityTable;
 FILE *tracefp;
 
 vkReplay::~vkReplay() {
+    delete m_pGpuFrameTimer;
+    delete m_pPipelineCacheFile;
+    delete m_pMemoryAllocator;
+    delete m_pFrameChecksums;
     delete m_display;
-    vktrace_platform_close_library(m_vkFuncs.m_libHandle);
+#if defined(USE_PAGEGUARD_SPEEDUP) && !defined(PAGEGUARD_MEMCPY_USE_PPL_LIB)
+    vktrace_pageguard_done_multi_threads_memcpy();
+#endif
+    if (m_vkFuncs.m_libHandle != NULL) vktrace_platform_close_library(m_vkFuncs.m_libHandle);
 }
 
 int vkReplay::init(vktrace_replay::ReplayDisplay &disp) {
     int err;
+    if (g_pReplaySettings->nullDriver) {
+        vktrace_LogAlways("Replaying with the null driver, no Vulkan commands reach a GPU.");
+        m_vkFuncs.init_null_funcs();
+        m_display->set_headless(true);
+    } else {
 #if defined(PLATFORM_LINUX)
-    void *handle = dlopen("lib" API_LOWERCASE ".so", RTLD_LAZY);
+        void *handle = dlopen("lib" API_LOWERCASE ".so", RTLD_LAZY);
 #else
-    HMODULE handle = LoadLibrary(API_LOWERCASE "-1.dll");
+        HMODULE handle = LoadLibrary(API_LOWERCASE "-1.dll");
 #endif
 
-    if (handle == NULL) {
-        vktrace_LogError("Failed to open vulkan library.");
-        return -1;
+        if (handle == NULL) {
+            vktrace_LogError("Failed to open vulkan library.");
+            return -1;
+        }
+        m_vkFuncs.init_funcs(handle);
+        if (g_pReplaySettings->headless) {
+            vktrace_LogAlways("Replaying headless, swapchains are replaced by offscreen images.");
+            const char *pChecksumFrames = g_pReplaySettings->checksumFrames;
+            if (pChecksumFrames != NULL || g_pReplaySettings->checksumManifest != NULL ||
+                g_pReplaySettings->checksumGolden != NULL) {
+                m_pFrameChecksums = new vktrace_replay::FrameChecksums(
+                    g_pReplaySettings->checksumManifest, g_pReplaySettings->checksumGolden, g_pReplaySettings->checksumMismatchDir);
+                // A manifest on its own has every frame
+                if (pChecksumFrames == NULL && g_pReplaySettings->checksumGolden == NULL) pChecksumFrames = "all";
+            }
+            m_pOffscreenDisplay = new vkOffscreenDisplay();
+            m_pOffscreenDisplay->init_funcs(m_vkFuncs, pChecksumFrames, m_pFrameChecksums);
+            delete m_display;
+            m_display = m_pOffscreenDisplay;
+        }
+        if (g_pReplaySettings->benchmarkOutput != NULL && g_pReplaySettings->benchmarkGpuTime) {
+            m_pGpuFrameTimer = new vktrace_replay::GpuFrameTimer(m_vkFuncs);
+        }
+        if (g_pReplaySettings->pipelineCacheFile != NULL) {
+            m_pPipelineCacheFile =
+                new vktrace_replay::PipelineCacheFile(m_vkFuncs, g_pReplaySettings->pipelineCacheFile, m_pFileHeader->uuid);
+        }
+    }
+    if (g_pReplaySettings->subAllocateMemory > 0) {
+        m_pMemoryAllocator =
+            new vktrace_replay::MemorySubAllocator(m_vkFuncs, (VkDeviceSize)g_pReplaySettings->subAllocateMemory << 20);
     }
-    m_vkFuncs.init_funcs(handle);
     disp.set_implementation(m_display);
     if ((err = m_display->init(disp.get_gpu())) != 0) {
         vktrace_LogError("Failed to init vulkan display.");
@@ -262,39 +310,39 @@ bool vkReplay::getQueueFamilyIdx(VkPhysicalDevice tracePhysicalDevice, VkPhysica
         return true;
     }
 
-    if (traceQueueFamilyProperties.find(tracePhysicalDevice) == traceQueueFamilyProperties.end() ||
-        replayQueueFamilyProperties.find(replayPhysicalDevice) == replayQueueFamilyProperties.end()) {
-        goto fail;
-    }
-
-    if (min(traceQueueFamilyProperties[tracePhysicalDevice].count, replayQueueFamilyProperties[replayPhysicalDevice].count) == 0) {
+    // Only find() is used here, as barriers are remapped on the recording threads
+    auto traceIt = traceQueueFamilyProperties.find(tracePhysicalDevice);
+    auto replayIt = replayQueueFamilyProperties.find(replayPhysicalDevice);
+    if (traceIt == traceQueueFamilyProperties.end() || replayIt == replayQueueFamilyProperties.end()) {
         goto fail;
     }
 
-    if (replayQueueFamilyProperties[replayPhysicalDevice].count == 1) {
-        *pReplayIdx = 0;
-        return true;
-    }
+    {
+        const QueueFamilyProperties &traceProps = traceIt->second;
+        const QueueFamilyProperties &replayProps = replayIt->second;
+        if (min(traceProps.count, replayProps.count) == 0) {
+            goto fail;
+        }
 
-    for (uint32_t i = 0;
-         i < min(traceQueueFamilyProperties[tracePhysicalDevice].count, replayQueueFamilyProperties[replayPhysicalDevice].count);
-         i++) {
-        if (traceQueueFamilyProperties[tracePhysicalDevice].queueFamilyProperties[traceIdx].queueFlags ==
-            replayQueueFamilyProperties[replayPhysicalDevice].queueFamilyProperties[i].queueFlags) {
-            *pReplayIdx = i;
+        if (replayProps.count == 1) {
+            *pReplayIdx = 0;
             return true;
         }
-    }
 
-    // Didn't find an exact match, search for a superset
-    for (uint32_t i = 0;
-         i < min(traceQueueFamilyProperties[tracePhysicalDevice].count, replayQueueFamilyProperties[replayPhysicalDevice].count);
-         i++) {
-        if (traceQueueFamilyProperties[tracePhysicalDevice].queueFamilyProperties[traceIdx].queueFlags ==
-            (traceQueueFamilyProperties[tracePhysicalDevice].queueFamilyProperties[traceIdx].queueFlags &
-             replayQueueFamilyProperties[replayPhysicalDevice].queueFamilyProperties[i].queueFlags)) {
-            *pReplayIdx = i;
-            return true;
+        for (uint32_t i = 0; i < min(traceProps.count, replayProps.count); i++) {
+            if (traceProps.queueFamilyProperties[traceIdx].queueFlags == replayProps.queueFamilyProperties[i].queueFlags) {
+                *pReplayIdx = i;
+                return true;
+            }
+        }
+
+        // Didn't find an exact match, search for a superset
+        for (uint32_t i = 0; i < min(traceProps.count, replayProps.count); i++) {
+            if (traceProps.queueFamilyProperties[traceIdx].queueFlags ==
+                (traceProps.queueFamilyProperties[traceIdx].queueFlags & replayProps.queueFamilyProperties[i].queueFlags)) {
+                *pReplayIdx = i;
+                return true;
+            }
         }
     }
 
@@ -305,19 +353,22 @@ fail:
 }
 
 bool vkReplay::getQueueFamilyIdx(VkDevice traceDevice, VkDevice replayDevice, uint32_t traceIdx, uint32_t *pReplayIdx) {
-    VkPhysicalDevice tracePhysicalDevice;
-    VkPhysicalDevice replayPhysicalDevice;
-
-    if (tracePhysicalDevices.find(traceDevice) == tracePhysicalDevices.end() ||
-        replayPhysicalDevices.find(replayDevice) == replayPhysicalDevices.end()) {
+    auto traceIt = tracePhysicalDevices.find(traceDevice);
+    auto replayIt = replayPhysicalDevices.find(replayDevice);
+    if (traceIt == tracePhysicalDevices.end() || replayIt == replayPhysicalDevices.end()) {
         vktrace_LogWarning("Cannot determine queue family index - has vkGetPhysicalDeviceQueueFamilyProperties been called?");
         return false;
     }
 
-    tracePhysicalDevice = tracePhysicalDevices[traceDevice];
-    replayPhysicalDevice = replayPhysicalDevices[replayDevice];
+    return getQueueFamilyIdx(traceIt->second, replayIt->second, traceIdx, pReplayIdx);
+}
 
-    return getQueueFamilyIdx(tracePhysicalDevice, replayPhysicalDevice, traceIdx, pReplayIdx);
+// Device of a buffer or image, or VK_NULL_HANDLE if it is unknown.  The barrier commands that use
+// this are replayed on the recording threads, so the map must not be written as operator[] would.
+template <typename Handle>
+static VkDevice findObjectDevice(const std::unordered_map<Handle, VkDevice> &objectToDevice, Handle object) {
+    auto it = objectToDevice.find(object);
+    return (it != objectToDevice.end()) ? it->second : VK_NULL_HANDLE;
 }
 
 VkResult vkReplay::manually_replay_vkCreateDevice(packet_vkCreateDevice *pPacket) {
@@ -710,6 +761,7 @@ VkResult vkReplay::manually_replay_vkQueueBindSparse(packet_vkQueueBindSparse *p
                     goto FAILURE;
                 }
                 pRemappedBufferMemories[bindCountIdx].memory = replay_mem;
+                pRemappedBufferMemories[bindCountIdx].memoryOffset += local_mem.replayOffset;
             }
             sBMBinf->pBinds = pRemappedBufferMemories;
             remappedBindSparseInfos[bindInfo_idx].pBufferBinds = sBMBinf;
@@ -743,6 +795,7 @@ VkResult vkReplay::manually_replay_vkQueueBindSparse(packet_vkQueueBindSparse *p
                     goto FAILURE;
                 }
                 pRemappedImageMemories[bindCountIdx].memory = replay_mem;
+                pRemappedImageMemories[bindCountIdx].memoryOffset += local_mem.replayOffset;
             }
             sIMBinf->pBinds = pRemappedImageMemories;
             remappedBindSparseInfos[bindInfo_idx].pImageBinds = sIMBinf;
@@ -778,6 +831,7 @@ VkResult vkReplay::manually_replay_vkQueueBindSparse(packet_vkQueueBindSparse *p
                     goto FAILURE;
                 }
                 pRemappedImageOpaqueMemories[bindCountIdx].memory = replay_mem;
+                pRemappedImageOpaqueMemories[bindCountIdx].memoryOffset += local_mem.replayOffset;
             }
             sIMOBinf->pBinds = pRemappedImageOpaqueMemories;
             remappedBindSparseInfos[bindInfo_idx].pImageOpaqueBinds = sIMOBinf;
@@ -1423,6 +1477,16 @@ VkResult vkReplay::manually_replay_vkGetPipelineCacheData(packet_vkGetPipelineCa
     return replayResult;
 }
 
+VkPipelineCache vkReplay::replay_pipeline_cache(VkDevice device, VkPipelineCache tracedCache) {
+    if (m_pPipelineCacheFile == NULL) return tracedCache;
+    auto it = replayPhysicalDevices.find(device);
+    if (it == replayPhysicalDevices.end()) return tracedCache;
+    // The persistent cache replaces the traced one.  Data the application loaded into its own
+    // cache was created by the capture driver and is rarely usable on the replay driver anyway.
+    VkPipelineCache cache = m_pPipelineCacheFile->get(device, it->second);
+    return (cache != VK_NULL_HANDLE) ? cache : tracedCache;
+}
+
 VkResult vkReplay::manually_replay_vkCreateComputePipelines(packet_vkCreateComputePipelines *pPacket) {
     VkResult replayResult = VK_ERROR_VALIDATION_FAILED_EXT;
     VkDevice remappeddevice = m_objMapper.remap_devices(pPacket->device);
@@ -1433,7 +1497,7 @@ VkResult vkReplay::manually_replay_vkCreateComputePipelines(packet_vkCreateCompu
     }
 
     VkPipelineCache pipelineCache;
-    pipelineCache = m_objMapper.remap_pipelinecaches(pPacket->pipelineCache);
+    pipelineCache = replay_pipeline_cache(remappeddevice, m_objMapper.remap_pipelinecaches(pPacket->pipelineCache));
 
     VkComputePipelineCreateInfo *pLocalCIs = VKTRACE_NEW_ARRAY(VkComputePipelineCreateInfo, pPacket->createInfoCount);
     memcpy((void *)pLocalCIs, (void *)(pPacket->pCreateInfos), sizeof(VkComputePipelineCreateInfo) * pPacket->createInfoCount);
@@ -1581,6 +1645,7 @@ VkResult vkReplay::manually_replay_vkCreateGraphicsPipelines(packet_vkCreateGrap
     uint32_t createInfoCount = pPacket->createInfoCount;
     VkPipeline *local_pPipelines = VKTRACE_NEW_ARRAY(VkPipeline, pPacket->createInfoCount);
 
+    remappedPipelineCache = replay_pipeline_cache(remappedDevice, remappedPipelineCache);
     replayResult = m_vkFuncs.real_vkCreateGraphicsPipelines(remappedDevice, remappedPipelineCache, createInfoCount, pLocalCIs, NULL,
                                                             local_pPipelines);
 
@@ -1668,7 +1733,7 @@ void vkReplay::manually_replay_vkCmdWaitEvents(packet_vkCmdWaitEvents *pPacket)
     for (idx = 0; idx < pPacket->bufferMemoryBarrierCount; idx++) {
         VkBufferMemoryBarrier *pNextBuf = (VkBufferMemoryBarrier *)&(pPacket->pBufferMemoryBarriers[idx]);
         saveBuf[numRemapBuf++] = pNextBuf->buffer;
-        traceDevice = traceBufferToDevice[pNextBuf->buffer];
+        traceDevice = findObjectDevice(traceBufferToDevice, pNextBuf->buffer);
         pNextBuf->buffer = m_objMapper.remap_buffers(pNextBuf->buffer);
         if (pNextBuf->buffer == VK_NULL_HANDLE) {
             vktrace_LogError("Skipping vkCmdWaitEvents() due to invalid remapped VkBuffer.");
@@ -1676,7 +1741,7 @@ void vkReplay::manually_replay_vkCmdWaitEvents(packet_vkCmdWaitEvents *pPacket)
             VKTRACE_DELETE(saveBuf);
             return;
         }
-        replayDevice = replayBufferToDevice[pNextBuf->buffer];
+        replayDevice = findObjectDevice(replayBufferToDevice, pNextBuf->buffer);
         if (getQueueFamilyIdx(traceDevice, replayDevice, pPacket->pBufferMemoryBarriers[idx].srcQueueFamilyIndex, &srcReplayIdx) &&
             getQueueFamilyIdx(traceDevice, replayDevice, pPacket->pBufferMemoryBarriers[idx].dstQueueFamilyIndex, &dstReplayIdx)) {
             *((uint32_t *)&pPacket->pBufferMemoryBarriers[idx].srcQueueFamilyIndex) = srcReplayIdx;
@@ -1692,7 +1757,7 @@ void vkReplay::manually_replay_vkCmdWaitEvents(packet_vkCmdWaitEvents *pPacket)
     for (idx = 0; idx < pPacket->imageMemoryBarrierCount; idx++) {
         VkImageMemoryBarrier *pNextImg = (VkImageMemoryBarrier *)&(pPacket->pImageMemoryBarriers[idx]);
         saveImg[numRemapImg++] = pNextImg->image;
-        traceDevice = traceImageToDevice[pNextImg->image];
+        traceDevice = findObjectDevice(traceImageToDevice, pNextImg->image);
         pNextImg->image = m_objMapper.remap_images(pNextImg->image);
         if (pNextImg->image == VK_NULL_HANDLE) {
             vktrace_LogError("Skipping vkCmdWaitEvents() due to invalid remapped VkImage.");
@@ -1701,7 +1766,7 @@ void vkReplay::manually_replay_vkCmdWaitEvents(packet_vkCmdWaitEvents *pPacket)
             VKTRACE_DELETE(saveImg);
             return;
         }
-        replayDevice = replayImageToDevice[pNextImg->image];
+        replayDevice = findObjectDevice(replayImageToDevice, pNextImg->image);
         if (getQueueFamilyIdx(traceDevice, replayDevice, pPacket->pImageMemoryBarriers[idx].srcQueueFamilyIndex, &srcReplayIdx) &&
             getQueueFamilyIdx(traceDevice, replayDevice, pPacket->pImageMemoryBarriers[idx].dstQueueFamilyIndex, &dstReplayIdx)) {
             *((uint32_t *)&pPacket->pImageMemoryBarriers[idx].srcQueueFamilyIndex) = srcReplayIdx;
@@ -1755,7 +1820,7 @@ void vkReplay::manually_replay_vkCmdPipelineBarrier(packet_vkCmdPipelineBarrier
     for (idx = 0; idx < pPacket->bufferMemoryBarrierCount; idx++) {
         VkBufferMemoryBarrier *pNextBuf = (VkBufferMemoryBarrier *)&(pPacket->pBufferMemoryBarriers[idx]);
         saveBuf[numRemapBuf++] = pNextBuf->buffer;
-        traceDevice = traceBufferToDevice[pNextBuf->buffer];
+        traceDevice = findObjectDevice(traceBufferToDevice, pNextBuf->buffer);
         pNextBuf->buffer = m_objMapper.remap_buffers(pNextBuf->buffer);
         if (pNextBuf->buffer == VK_NULL_HANDLE && saveBuf[numRemapBuf - 1] != VK_NULL_HANDLE) {
             vktrace_LogError("Skipping vkCmdPipelineBarrier() due to invalid remapped VkBuffer.");
@@ -1763,7 +1828,7 @@ void vkReplay::manually_replay_vkCmdPipelineBarrier(packet_vkCmdPipelineBarrier
             VKTRACE_DELETE(saveImg);
             return;
         }
-        replayDevice = replayBufferToDevice[pNextBuf->buffer];
+        replayDevice = findObjectDevice(replayBufferToDevice, pNextBuf->buffer);
         if (getQueueFamilyIdx(traceDevice, replayDevice, pPacket->pBufferMemoryBarriers[idx].srcQueueFamilyIndex, &srcReplayIdx) &&
             getQueueFamilyIdx(traceDevice, replayDevice, pPacket->pBufferMemoryBarriers[idx].dstQueueFamilyIndex, &dstReplayIdx)) {
             *((uint32_t *)&pPacket->pBufferMemoryBarriers[idx].srcQueueFamilyIndex) = srcReplayIdx;
@@ -1778,7 +1843,7 @@ void vkReplay::manually_replay_vkCmdPipelineBarrier(packet_vkCmdPipelineBarrier
     for (idx = 0; idx < pPacket->imageMemoryBarrierCount; idx++) {
         VkImageMemoryBarrier *pNextImg = (VkImageMemoryBarrier *)&(pPacket->pImageMemoryBarriers[idx]);
         saveImg[numRemapImg++] = pNextImg->image;
-        traceDevice = traceImageToDevice[pNextImg->image];
+        traceDevice = findObjectDevice(traceImageToDevice, pNextImg->image);
         if (traceDevice == NULL) vktrace_LogError("DEBUG: traceDevice is NULL");
         pNextImg->image = m_objMapper.remap_images(pNextImg->image);
         if (pNextImg->image == VK_NULL_HANDLE && saveImg[numRemapImg - 1] != VK_NULL_HANDLE) {
@@ -1787,7 +1852,7 @@ void vkReplay::manually_replay_vkCmdPipelineBarrier(packet_vkCmdPipelineBarrier
             VKTRACE_DELETE(saveImg);
             return;
         }
-        replayDevice = replayImageToDevice[pNextImg->image];
+        replayDevice = findObjectDevice(replayImageToDevice, pNextImg->image);
         if (getQueueFamilyIdx(traceDevice, replayDevice, pPacket->pImageMemoryBarriers[idx].srcQueueFamilyIndex, &srcReplayIdx) &&
             getQueueFamilyIdx(traceDevice, replayDevice, pPacket->pImageMemoryBarriers[idx].dstQueueFamilyIndex, &dstReplayIdx)) {
             *((uint32_t *)&pPacket->pImageMemoryBarriers[idx].srcQueueFamilyIndex) = srcReplayIdx;
@@ -2100,38 +2165,32 @@ fail:
     return false;
 }
 
-#define FSEEK(_stream, _offset, _whence)                                                                                  \
-    if (0 != fseek(_stream, _offset, _whence)) {                                                                          \
-        vktrace_LogError("fseek during vkAllocateMemory() failed, can't determine memory type index");                    \
-        replayResult =                                                                                                    \
-            m_vkFuncs.real_vkAllocateMemory(remappedDevice, pPacket->pAllocateInfo, NULL, &local_mem.replayDeviceMemory); \
-        fseek(_stream, saveFilePos, SEEK_SET);                                                                            \
-        goto wrapItUp;                                                                                                    \
+VkResult vkReplay::allocate_memory(VkDevice device, const VkMemoryAllocateInfo *pAllocateInfo, VkDeviceSize alignment,
+                                   devicememoryObj *pMem) {
+    if (m_pMemoryAllocator != NULL) {
+        auto it = replayPhysicalDevices.find(device);
+        if (it != replayPhysicalDevices.end() &&
+            m_pMemoryAllocator->allocate(device, it->second, *pAllocateInfo, alignment, &pMem->replayDeviceMemory,
+                                         &pMem->replayOffset)) {
+            pMem->subAllocated = true;
+            return VK_SUCCESS;
+        }
     }
+    return m_vkFuncs.real_vkAllocateMemory(device, pAllocateInfo, NULL, &pMem->replayDeviceMemory);
+}
 
-#define FREAD(_ptr, _size, _nmemb, _stream)                                                                               \
-    if (_nmemb != fread(_ptr, _size, _nmemb, _stream)) {                                                                  \
-        vktrace_LogError("fread during vkAllocateMemory() failed, can't determine memory type index");                    \
-        replayResult =                                                                                                    \
-            m_vkFuncs.real_vkAllocateMemory(remappedDevice, pPacket->pAllocateInfo, NULL, &local_mem.replayDeviceMemory); \
-        fseek(_stream, saveFilePos, SEEK_SET);                                                                            \
-        goto wrapItUp;                                                                                                    \
-    }
+VkDeviceSize vkReplay::replay_memory_offset(VkDeviceMemory tracedMemory) {
+    auto it = m_objMapper.m_devicememorys.find(tracedMemory);
+    return (it != m_objMapper.m_devicememorys.end()) ? it->second.replayOffset : 0;
+}
 
 VkResult vkReplay::manually_replay_vkAllocateMemory(packet_vkAllocateMemory *pPacket) {
     VkResult replayResult = VK_ERROR_VALIDATION_FAILED_EXT;
     devicememoryObj local_mem;
     VkMemoryRequirements memRequirements;
     uint32_t replayMemTypeIndex;
-    vktrace_trace_packet_header packetHeader1, packetHeader2;
-    VkDeviceMemory traceAllocateMemoryRval;
-    packet_vkBindImageMemory bimPacket;              // We rely on the fact that packet_vkBindBufferMemory is the same size
-    packet_vkGetImageMemoryRequirements gimrPacket;  // We rely on the fact that packet_vkGetBufferMemoryRequires is the same size
-    packet_vkFreeMemory freeMemoryPacket;
-    packet_vkDestroyImage destroyImagePacket;
-    bool foundBindMem;
-    size_t bindMemIdx;
-    bool foundGetMR;
+    local_mem.subAllocated = false;
+    local_mem.replayOffset = 0;
 
     VkDevice remappedDevice = m_objMapper.remap_devices(pPacket->device);
     if (remappedDevice == VK_NULL_HANDLE) {
@@ -2166,122 +2225,30 @@ VkResult vkReplay::manually_replay_vkAllocateMemory(packet_vkAllocateMemory *pPa
     }
 
     if (m_pFileHeader->portability_table_valid && m_platformMatch != 1) {
-        long saveFilePos;
-        size_t amIdx;
-        static size_t amSearchPos = 0;
-
-        // Save current file position so we can restore it
-        saveFilePos = ftell(tracefp);
-
-        // First find this vkAM call in portabilityTable
+        // Find the vkBind{Image|Buffer}Memory call that binds this memory and the
+        // vkGet{Image|Buffer}MemoryRequirements call for the bound image/buffer.
         pPacket->header = (vktrace_trace_packet_header *)((PBYTE)pPacket - sizeof(vktrace_trace_packet_header));
-        for (amIdx = amSearchPos; amIdx < portabilityTable.size(); amIdx++) {
-            FSEEK(tracefp, (long)portabilityTable[amIdx], SEEK_SET);
-            FREAD(&packetHeader1, sizeof(vktrace_trace_packet_header), 1, tracefp);  // Read the packet header
-
-            if (packetHeader1.global_packet_index == pPacket->header->global_packet_index &&
-                packetHeader1.packet_id == VKTRACE_TPI_VK_vkAllocateMemory) {
-                // Found it
-                // Save away the vkAM return val from the trace file
-                traceAllocateMemoryRval =
-                    *((VkDeviceMemory *)((PBYTE)pPacket->header + pPacket->header->size - sizeof(VkDeviceMemory *)));
-
-                // Save the index where we will start the next search for vkAM
-                amSearchPos = amIdx + 1;
-                break;
-            }
-        }
-        if (amIdx == portabilityTable.size()) {
+        const vktrace_replay::PortabilityAllocation *pAllocation =
+            portabilityIndex.find_allocation(pPacket->header->global_packet_index);
+        if (pAllocation == NULL) {
             // Didn't find the current vkAM packet, something is wrong with the trace file.
             // Just use the index from the trace file and attempt to continue.
             vktrace_LogError("Replay of vkAllocateMemory() failed, trace file may be corrupt.");
-            replayResult =
-                m_vkFuncs.real_vkAllocateMemory(remappedDevice, pPacket->pAllocateInfo, NULL, &local_mem.replayDeviceMemory);
-            fseek(tracefp, saveFilePos, SEEK_SET);
+            replayResult = allocate_memory(remappedDevice, pPacket->pAllocateInfo, 0, &local_mem);
             goto wrapItUp;
         }
 
-        // Search forward from amIdx for vkBIM/vkBBM call that binds this memory.
-        // Then search backwards for the vkGIMR/vkGBMR call that uses the
-        // same image/buffer. If we don't find one, generate an error and do the best we can.
-        foundBindMem = false;
-        foundGetMR = false;
-        for (size_t i = amIdx + 1; !foundBindMem && i < portabilityTable.size(); i++) {
-            FSEEK(tracefp, (long)portabilityTable[i], SEEK_SET);
-            FREAD(&packetHeader1, sizeof(vktrace_trace_packet_header), 1, tracefp);  // Read the packet header
-
-            if (packetHeader1.packet_id == VKTRACE_TPI_VK_vkBindImageMemory ||
-                packetHeader1.packet_id == VKTRACE_TPI_VK_vkBindBufferMemory) {
-                assert(packetHeader1.size == sizeof(packetHeader1) + sizeof(bimPacket));
-                FREAD(&bimPacket, sizeof(bimPacket), 1, tracefp);
-            }
-
-            if (packetHeader1.packet_id == VKTRACE_TPI_VK_vkFreeMemory) {
-                FREAD(&freeMemoryPacket, sizeof(freeMemoryPacket), 1, tracefp);
-                if (freeMemoryPacket.memory == traceAllocateMemoryRval) {
-                    // Found a free of this memory, end the forward search
-                    vktrace_LogWarning("Memory allocated by vkAllocateMemory is not used.");
-                    break;
-                }
-            }
-
-            if ((packetHeader1.packet_id == VKTRACE_TPI_VK_vkBindImageMemory ||
-                 packetHeader1.packet_id == VKTRACE_TPI_VK_vkBindBufferMemory) &&
-                traceAllocateMemoryRval == bimPacket.memory) {
-                // A vkBIM/vkBBM binds memory allocated by this vkAM call.
-                foundBindMem = true;
-                bindMemIdx = i;
-
-                // Search backwards for the vkGIMR/vkGBMR call.
-                if (amIdx > 0) {
-                    for (size_t j = i - 1; !foundGetMR; j--) {
-                        FSEEK(tracefp, (long)portabilityTable[j], SEEK_SET);
-                        FREAD(&packetHeader2, sizeof(vktrace_trace_packet_header), 1, tracefp);  // Read the packet header
-                        if (packetHeader2.packet_id == VKTRACE_TPI_VK_vkGetImageMemoryRequirements ||
-                            packetHeader2.packet_id == VKTRACE_TPI_VK_vkGetBufferMemoryRequirements) {
-                            assert(packetHeader2.size >= sizeof(packetHeader2) + sizeof(gimrPacket) + sizeof(VkMemoryRequirements));
-                            FREAD(&gimrPacket, sizeof(gimrPacket), 1, tracefp);
-                        }
-                        if ((packetHeader2.packet_id == VKTRACE_TPI_VK_vkGetImageMemoryRequirements ||
-                             packetHeader2.packet_id == VKTRACE_TPI_VK_vkGetBufferMemoryRequirements) &&
-                            gimrPacket.image == bimPacket.image) {
-                            // Found the corresponding gimr/gbmr packet
-                            FSEEK(tracefp, (long)portabilityTable[j] + sizeof(packetHeader2) + (long)gimrPacket.pMemoryRequirements,
-                                  SEEK_SET);
-                            FREAD(&memRequirements, sizeof(memRequirements), 1, tracefp);
-                            foundGetMR = true;
-                            break;
-                        }
-
-                        if (packetHeader2.packet_id == VKTRACE_TPI_VK_vkDestroyImage ||
-                            packetHeader2.packet_id == VKTRACE_TPI_VK_vkDestroyBuffer) {
-                            FREAD(&destroyImagePacket, sizeof(destroyImagePacket), 1, tracefp);
-                            if (destroyImagePacket.image == bimPacket.image) {
-                                // Found a destroy of this Buffer/Image, stop the back search.
-                                break;
-                            }
-                        }
-                        if (j == 0) {
-                            // Got to the beginning of the list w/o finding the vkGIMR/vkGBMR call
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-
-        fseek(tracefp, saveFilePos, SEEK_SET);
-
-        if (!foundBindMem) {
+        if (pAllocation->bindPacketId == 0) {
             // Didn't find vkBind{Image|Buffer}Memory call for this vkAllocateMemory.
             // This isn't an error - the memory is allocated but never used.
             // So just use the index from the trace file and continue.
-            replayResult =
-                m_vkFuncs.real_vkAllocateMemory(remappedDevice, pPacket->pAllocateInfo, NULL, &local_mem.replayDeviceMemory);
+            replayResult = allocate_memory(remappedDevice, pPacket->pAllocateInfo, 0, &local_mem);
             goto wrapItUp;
         }
 
-        if (!foundGetMR) {
+        bool bindImage = (pAllocation->bindPacketId == VKTRACE_TPI_VK_vkBindImageMemory);
+        VkImage boundImage = pAllocation->boundObject;
+        if (pAllocation->requirementsPacketId == 0) {
             // Didn't find corresponding gimr call.
             // vkAllocateMemory and vkBind{Image|Buffer}Memory were called without first calling
             // vkGet{Image|Buffer}MemoryRequirements.
@@ -2291,90 +2258,74 @@ VkResult vkReplay::manually_replay_vkAllocateMemory(packet_vkAllocateMemory *pPa
             // in the trace file between the current vkAM and the vkBindImageMem/vkBindBufMem calls.
 
             VkImage remappedImage;
-            if (packetHeader1.packet_id == VKTRACE_TPI_VK_vkBindImageMemory)
-                remappedImage = m_objMapper.remap_images(bimPacket.image);
+            if (bindImage)
+                remappedImage = m_objMapper.remap_images(boundImage);
             else
-                remappedImage = (VkImage)m_objMapper.remap_buffers((VkBuffer)bimPacket.image);
+                remappedImage = (VkImage)m_objMapper.remap_buffers((VkBuffer)boundImage);
             if (!remappedImage) {
-                // Search backwards from the bindMem cmd for the create image/buffer command, and execute it
-                for (size_t i = bindMemIdx - 1; true; i++) {
-                    vktrace_trace_packet_header createPacketHeaderHeader;
-                    vktrace_trace_packet_header *pCreatePacketFull;
-                    packet_vkCreateImage *pCreatePacket;
-                    FSEEK(tracefp, (long)portabilityTable[i], SEEK_SET);
-                    FREAD(&createPacketHeaderHeader, sizeof(vktrace_trace_packet_header), 1, tracefp);
-                    if ((packetHeader1.packet_id == VKTRACE_TPI_VK_vkBindImageMemory &&
-                         createPacketHeaderHeader.packet_id == VKTRACE_TPI_VK_vkCreateImage) ||
-                        (packetHeader1.packet_id == VKTRACE_TPI_VK_vkBindBufferMemory &&
-                         createPacketHeaderHeader.packet_id == VKTRACE_TPI_VK_vkCreateBuffer)) {
-                        // Read the whole packet
-                        pCreatePacketFull = (vktrace_trace_packet_header *)vktrace_malloc(createPacketHeaderHeader.size);
-                        if (!pCreatePacketFull) {
-                            vktrace_LogError("malloc failed during vkAllocateMemory()");
-                            return VK_ERROR_OUT_OF_HOST_MEMORY;
-                        }
-                        FSEEK(tracefp, (long)portabilityTable[i], SEEK_SET);
-                        FREAD(pCreatePacketFull, createPacketHeaderHeader.size, 1, tracefp);
-                        pCreatePacket = (packet_vkCreateImage *)(pCreatePacketFull + 1);
-                        pCreatePacket->header = pCreatePacketFull;
-                        pCreatePacketFull->pBody = (uintptr_t)pCreatePacket;
-                        pCreatePacket->pImage = (VkImage *)vktrace_trace_packet_interpret_buffer_pointer(
-                            pCreatePacketFull, (intptr_t)pCreatePacket->pImage);
-                        pCreatePacket->pCreateInfo = (VkImageCreateInfo *)vktrace_trace_packet_interpret_buffer_pointer(
-                            pCreatePacketFull, (intptr_t)pCreatePacket->pCreateInfo);
-                        pCreatePacket->pAllocator = (VkAllocationCallbacks *)vktrace_trace_packet_interpret_buffer_pointer(
-                            pCreatePacketFull, (intptr_t)pCreatePacket->pAllocator);
-                        if (*(pCreatePacket->pImage) == bimPacket.image) {
-                            // Create the image/buffer
-                            if (createPacketHeaderHeader.packet_id == VKTRACE_TPI_VK_vkCreateBuffer)
-                                replayResult = manually_replay_vkCreateBuffer((packet_vkCreateBuffer *)pCreatePacket);
-                            else
-                                replayResult = manually_replay_vkCreateImage((packet_vkCreateImage *)pCreatePacket);
-                            vktrace_free(pCreatePacketFull);
-                            if (replayResult != VK_SUCCESS) {
-                                vktrace_LogError("vkCreateBuffer/Image failed during vkAllocateMemory()");
-                                return replayResult;
-                            }
-                            if (packetHeader1.packet_id == VKTRACE_TPI_VK_vkBindImageMemory)
-                                remappedImage = m_objMapper.remap_images(bimPacket.image);
-                            else
-                                remappedImage = (VkImage)m_objMapper.remap_buffers((VkBuffer)bimPacket.image);
-                            break;
-                        }
-                        vktrace_free(pCreatePacketFull);
-                    }
-                    if (i == amIdx) {
-                        // This image/buffer is not created before it is bound
-                        vktrace_LogError("Bad buffer/image in call to vkBindImageMemory/vkBindBuffer");
-                        return VK_ERROR_VALIDATION_FAILED_EXT;
-                    }
+                if (pAllocation->createPacket.empty()) {
+                    // This image/buffer is not created before it is bound
+                    vktrace_LogError("Bad buffer/image in call to vkBindImageMemory/vkBindBuffer");
+                    return VK_ERROR_VALIDATION_FAILED_EXT;
+                }
+
+                // Replay a copy of the create image/buffer packet, replay may modify it
+                vktrace_trace_packet_header *pCreatePacketFull =
+                    (vktrace_trace_packet_header *)vktrace_malloc(pAllocation->createPacket.size());
+                if (!pCreatePacketFull) {
+                    vktrace_LogError("malloc failed during vkAllocateMemory()");
+                    return VK_ERROR_OUT_OF_HOST_MEMORY;
                 }
+                memcpy(pCreatePacketFull, pAllocation->createPacket.data(), pAllocation->createPacket.size());
+                packet_vkCreateImage *pCreatePacket = (packet_vkCreateImage *)(pCreatePacketFull + 1);
+                pCreatePacket->header = pCreatePacketFull;
+                pCreatePacketFull->pBody = (uintptr_t)pCreatePacket;
+                pCreatePacket->pImage =
+                    (VkImage *)vktrace_trace_packet_interpret_buffer_pointer(pCreatePacketFull, (intptr_t)pCreatePacket->pImage);
+                pCreatePacket->pCreateInfo = (VkImageCreateInfo *)vktrace_trace_packet_interpret_buffer_pointer(
+                    pCreatePacketFull, (intptr_t)pCreatePacket->pCreateInfo);
+                pCreatePacket->pAllocator = (VkAllocationCallbacks *)vktrace_trace_packet_interpret_buffer_pointer(
+                    pCreatePacketFull, (intptr_t)pCreatePacket->pAllocator);
+
+                // Create the image/buffer
+                if (bindImage)
+                    replayResult = manually_replay_vkCreateImage(pCreatePacket);
+                else
+                    replayResult = manually_replay_vkCreateBuffer((packet_vkCreateBuffer *)pCreatePacket);
+                vktrace_free(pCreatePacketFull);
+                if (replayResult != VK_SUCCESS) {
+                    vktrace_LogError("vkCreateBuffer/Image failed during vkAllocateMemory()");
+                    return replayResult;
+                }
+                if (bindImage)
+                    remappedImage = m_objMapper.remap_images(boundImage);
+                else
+                    remappedImage = (VkImage)m_objMapper.remap_buffers((VkBuffer)boundImage);
             }
 
             // Now call GIMR/GBMR
             VkMemoryRequirements mem_reqs;
-            if (packetHeader1.packet_id == VKTRACE_TPI_VK_vkBindImageMemory) {
+            if (bindImage) {
                 m_vkFuncs.real_vkGetImageMemoryRequirements(remappedDevice, remappedImage, &mem_reqs);
-                replayGetImageMemoryRequirements[bimPacket.image] = mem_reqs;
+                replayGetImageMemoryRequirements[boundImage] = mem_reqs;
             } else {
                 m_vkFuncs.real_vkGetBufferMemoryRequirements(remappedDevice, (VkBuffer)remappedImage, &mem_reqs);
-                replayGetBufferMemoryRequirements[(VkBuffer)bimPacket.image] = mem_reqs;
+                replayGetBufferMemoryRequirements[(VkBuffer)boundImage] = mem_reqs;
             }
+            memRequirements = mem_reqs;
+        } else if (pAllocation->requirementsPacketId == VKTRACE_TPI_VK_vkGetImageMemoryRequirements) {
+            memRequirements = replayGetImageMemoryRequirements[boundImage];
+        } else {
+            memRequirements = replayGetBufferMemoryRequirements[(VkBuffer)boundImage];
         }
 
-        if (packetHeader2.packet_id == VKTRACE_TPI_VK_vkGetImageMemoryRequirements)
-            memRequirements = replayGetImageMemoryRequirements[bimPacket.image];
-        else
-            memRequirements = replayGetBufferMemoryRequirements[(VkBuffer)bimPacket.image];
-
         if (!m_objMapper.m_adjustForGPU) {
             if (getMemoryTypeIdx(pPacket->device, remappedDevice, pPacket->pAllocateInfo->memoryTypeIndex, &memRequirements,
                                  &replayMemTypeIndex)) {
                 *((uint32_t *)&pPacket->pAllocateInfo->memoryTypeIndex) = replayMemTypeIndex;
                 if (*((VkDeviceSize *)&pPacket->pAllocateInfo->allocationSize) < memRequirements.size)
                     *((VkDeviceSize *)&pPacket->pAllocateInfo->allocationSize) = memRequirements.size;
-                replayResult =
-                    m_vkFuncs.real_vkAllocateMemory(remappedDevice, pPacket->pAllocateInfo, NULL, &local_mem.replayDeviceMemory);
+                replayResult = allocate_memory(remappedDevice, pPacket->pAllocateInfo, memRequirements.alignment, &local_mem);
             } else {
                 vktrace_LogError("vkAllocateMemory() failed, couldn't find memory type for memoryTypeIndex");
                 return VK_ERROR_VALIDATION_FAILED_EXT;
@@ -2384,7 +2335,7 @@ VkResult vkReplay::manually_replay_vkAllocateMemory(packet_vkAllocateMemory *pPa
     } else {
         // Platform matched exactly or there isn't a valid portablity table in the trace file,
         // so use memoryTypeIndex from trace file.
-        replayResult = m_vkFuncs.real_vkAllocateMemory(remappedDevice, pPacket->pAllocateInfo, NULL, &local_mem.replayDeviceMemory);
+        replayResult = allocate_memory(remappedDevice, pPacket->pAllocateInfo, 0, &local_mem);
     }
 
 wrapItUp:
@@ -2411,7 +2362,10 @@ void vkReplay::manually_replay_vkFreeMemory(packet_vkFreeMemory *pPacket) {
     devicememoryObj local_mem;
     local_mem = m_objMapper.m_devicememorys.find(pPacket->memory)->second;
     // TODO how/when to free pendingAlloc that did not use and existing devicememoryObj
-    m_vkFuncs.real_vkFreeMemory(remappedDevice, local_mem.replayDeviceMemory, NULL);
+    if (local_mem.subAllocated)
+        m_pMemoryAllocator->free(local_mem.replayDeviceMemory, local_mem.replayOffset);
+    else
+        m_vkFuncs.real_vkFreeMemory(remappedDevice, local_mem.replayDeviceMemory, NULL);
     delete local_mem.pGpuMem;
     m_objMapper.rm_from_devicememorys_map(pPacket->memory);
 }
@@ -2428,8 +2382,14 @@ VkResult vkReplay::manually_replay_vkMapMemory(packet_vkMapMemory *pPacket) {
     devicememoryObj local_mem = m_objMapper.m_devicememorys.find(pPacket->memory)->second;
     void *pData;
     if (!local_mem.pGpuMem->isPendingAlloc()) {
-        replayResult = m_vkFuncs.real_vkMapMemory(remappedDevice, local_mem.replayDeviceMemory, pPacket->offset, pPacket->size,
-                                                  pPacket->flags, &pData);
+        if (local_mem.subAllocated) {
+            // Blocks stay mapped, so sub-allocations sharing a block can be mapped at the same time
+            replayResult = m_pMemoryAllocator->map(local_mem.replayDeviceMemory, &pData);
+            if (replayResult == VK_SUCCESS) pData = (uint8_t *)pData + local_mem.replayOffset + pPacket->offset;
+        } else {
+            replayResult = m_vkFuncs.real_vkMapMemory(remappedDevice, local_mem.replayDeviceMemory, pPacket->offset, pPacket->size,
+                                                      pPacket->flags, &pData);
+        }
         if (replayResult == VK_SUCCESS) {
             if (local_mem.pGpuMem) {
                 local_mem.pGpuMem->setMemoryMapRange(pData, (size_t)pPacket->size, (size_t)pPacket->offset, false);
@@ -2456,7 +2416,7 @@ void vkReplay::manually_replay_vkUnmapMemory(packet_vkUnmapMemory *pPacket) {
             if (pPacket->pData)
                 local_mem.pGpuMem->copyMappingData(pPacket->pData, true, 0, 0);  // copies data from packet into memory buffer
         }
-        m_vkFuncs.real_vkUnmapMemory(remappedDevice, local_mem.replayDeviceMemory);
+        if (!local_mem.subAllocated) m_vkFuncs.real_vkUnmapMemory(remappedDevice, local_mem.replayDeviceMemory);
     } else {
         if (local_mem.pGpuMem) {
             unsigned char *pBuf = (unsigned char *)vktrace_malloc(local_mem.pGpuMem->getMemoryMapSize());
@@ -2504,6 +2464,8 @@ VkResult vkReplay::manually_replay_vkFlushMappedMemoryRanges(packet_vkFlushMappe
             VKTRACE_DELETE(pLocalMems);
             return VK_ERROR_VALIDATION_FAILED_EXT;
         }
+        if (pLocalMems[i].subAllocated)
+            m_pMemoryAllocator->remap_range(localRanges[i].memory, pLocalMems[i].replayOffset, &localRanges[i]);
 
         if (!pLocalMems[i].pGpuMem->isPendingAlloc()) {
             if (pPacket->pMemoryRanges[i].size != 0) {
@@ -2576,6 +2538,8 @@ VkResult vkReplay::manually_replay_vkInvalidateMappedMemoryRanges(packet_vkInval
             VKTRACE_DELETE(pLocalMems);
             return VK_ERROR_VALIDATION_FAILED_EXT;
         }
+        if (pLocalMems[i].subAllocated)
+            m_pMemoryAllocator->remap_range(localRanges[i].memory, pLocalMems[i].replayOffset, &localRanges[i]);
 
         if (!pLocalMems[i].pGpuMem->isPendingAlloc()) {
             if (pPacket->pMemoryRanges[i].size != 0) {
@@ -2970,11 +2934,11 @@ VkResult vkReplay::manually_replay_vkCreateSwapchainKHR(packet_vkCreateSwapchain
     uint32_t formatCount;
     VkResult U_ASSERT_ONLY res;
     // Note that pPacket->pCreateInfo->surface has been remapped above
-    res = vkGetPhysicalDeviceSurfaceFormatsKHR(remappedPhysicalDevice, pPacket->pCreateInfo->surface, &formatCount, NULL);
+    res = m_vkFuncs.real_vkGetPhysicalDeviceSurfaceFormatsKHR(remappedPhysicalDevice, pPacket->pCreateInfo->surface, &formatCount, NULL);
     assert(!res);
     VkSurfaceFormatKHR *surfFormats = (VkSurfaceFormatKHR *)malloc(formatCount * sizeof(VkSurfaceFormatKHR));
     assert(surfFormats);
-    res = vkGetPhysicalDeviceSurfaceFormatsKHR(remappedPhysicalDevice, pPacket->pCreateInfo->surface, &formatCount, surfFormats);
+    res = m_vkFuncs.real_vkGetPhysicalDeviceSurfaceFormatsKHR(remappedPhysicalDevice, pPacket->pCreateInfo->surface, &formatCount, surfFormats);
     assert(!res);
     // If the format list includes just one entry of VK_FORMAT_UNDEFINED,
     // the surface has no preferred format.  Otherwise, at least one
@@ -3134,6 +3098,8 @@ VkResult vkReplay::manually_replay_vkQueuePresentKHR(packet_vkQueuePresentKHR *p
             present.pResults = pResults;
         }
 
+        if (m_pGpuFrameTimer != NULL) m_pGpuFrameTimer->frame_boundary(remappedQueue);
+
         replayResult = m_vkFuncs.real_vkQueuePresentKHR(remappedQueue, &present);
 
         m_frameNumber++;
@@ -3387,6 +3353,21 @@ void vkReplay::manually_replay_vkDestroyDebugReportCallbackEXT(packet_vkDestroyD
     }
 }
 
+void vkReplay::add_gpu_frame_timer_queue(VkDevice device, uint32_t queueFamilyIndex, VkQueue queue) {
+    auto it = replayPhysicalDevices.find(device);
+    if (it == replayPhysicalDevices.end()) return;
+
+    VkPhysicalDeviceProperties properties;
+    m_vkFuncs.real_vkGetPhysicalDeviceProperties(it->second, &properties);
+    uint32_t count = 0;
+    m_vkFuncs.real_vkGetPhysicalDeviceQueueFamilyProperties(it->second, &count, NULL);
+    std::vector<VkQueueFamilyProperties> families(count);
+    m_vkFuncs.real_vkGetPhysicalDeviceQueueFamilyProperties(it->second, &count, families.data());
+    if (queueFamilyIndex >= count) return;
+    m_pGpuFrameTimer->add_queue(device, queue, queueFamilyIndex, families[queueFamilyIndex].timestampValidBits,
+                                properties.limits.timestampPeriod);
+}
+
 VkResult vkReplay::manually_replay_vkAllocateCommandBuffers(packet_vkAllocateCommandBuffers *pPacket) {
     VkResult replayResult = VK_ERROR_VALIDATION_FAILED_EXT;
     VkDevice remappedDevice = m_objMapper.remap_devices(pPacket->device);
@@ -3430,7 +3411,7 @@ VkBool32 vkReplay::manually_replay_vkGetPhysicalDeviceXcbPresentationSupportKHR(
     VkIcdSurfaceXcb *pSurf = (VkIcdSurfaceXcb *)m_display->get_surface();
     m_display->get_window_handle();
     return (m_vkFuncs.real_vkGetPhysicalDeviceXcbPresentationSupportKHR(
-        remappedphysicalDevice, pPacket->queueFamilyIndex, pSurf->connection, m_display->get_screen_handle()->root_visual));
+        remappedphysicalDevice, pPacket->queueFamilyIndex, pSurf->connection, m_display->get_root_visual()));
 #elif defined WIN32
     return (m_vkFuncs.real_vkGetPhysicalDeviceWin32PresentationSupportKHR(remappedphysicalDevice, pPacket->queueFamilyIndex));
 #else
@@ -3452,12 +3433,12 @@ VkBool32 vkReplay::manually_replay_vkGetPhysicalDeviceXlibPresentationSupportKHR
     VkIcdSurfaceXlib *pSurf = (VkIcdSurfaceXlib *)m_display->get_surface();
     m_display->get_window_handle();
     return (m_vkFuncs.real_vkGetPhysicalDeviceXlibPresentationSupportKHR(remappedphysicalDevice, pPacket->queueFamilyIndex,
-                                                                         pSurf->dpy, m_display->get_screen_handle()->root_visual));
+                                                                         pSurf->dpy, m_display->get_root_visual()));
 #elif defined PLATFORM_LINUX && defined VK_USE_PLATFORM_XCB_KHR
     VkIcdSurfaceXcb *pSurf = (VkIcdSurfaceXcb *)m_display->get_surface();
     m_display->get_window_handle();
     return (m_vkFuncs.real_vkGetPhysicalDeviceXcbPresentationSupportKHR(
-        remappedphysicalDevice, pPacket->queueFamilyIndex, pSurf->connection, m_display->get_screen_handle()->root_visual));
+        remappedphysicalDevice, pPacket->queueFamilyIndex, pSurf->connection, m_display->get_root_visual()));
 #elif defined PLATFORM_LINUX && defined VK_USE_PLATFORM_ANDROID_KHR
     // This is not defined for Android
     return VK_TRUE;
@@ -3484,7 +3465,7 @@ VkBool32 vkReplay::manually_replay_vkGetPhysicalDeviceWin32PresentationSupportKH
     VkIcdSurfaceXcb *pSurf = (VkIcdSurfaceXcb *)m_display->get_surface();
     m_display->get_window_handle();
     return (m_vkFuncs.real_vkGetPhysicalDeviceXcbPresentationSupportKHR(
-        remappedphysicalDevice, pPacket->queueFamilyIndex, pSurf->connection, m_display->get_screen_handle()->root_visual));
+        remappedphysicalDevice, pPacket->queueFamilyIndex, pSurf->connection, m_display->get_root_visual()));
 #else
     vktrace_LogError("manually_replay_vkGetPhysicalDeviceWin32PresentationSupportKHR not implemented on this playback platform");
     return VK_FALSE;
@@ -50,6 +50,10 @@ extern "C" {
 #include "vulkan/vulkan.h"
 
 #include "vkreplay_vkdisplay.h"
+#include "vkreplay_gpu_frame_timer.h"
+#include "vkreplay_pipeline_cache.h"
+#include "vkreplay_memory_allocator.h"
+#include "vkreplay_offscreen.h"
 #include "vkreplay_vk_func_ptrs.h"
 #include "vkreplay_vk_objmapper.h"
 
@@ -74,7 +78,14 @@ class vkReplay {
     vktrace_replay::VKTRACE_REPLAY_RESULT pop_validation_msgs();
     int dump_validation_data();
     int get_frame_number() { return m_frameNumber; }
-    void reset_frame_number() { m_frameNumber = 0; }
+    void reset_frame_number() {
+        m_frameNumber = 0;
+        if (m_pOffscreenDisplay != NULL) m_pOffscreenDisplay->reset_frame_number();
+    }
+    unsigned int get_gpu_frame_times(double* pFrameTimes, unsigned int maxCount, bool wait) {
+        return (m_pGpuFrameTimer != NULL) ? m_pGpuFrameTimer->take_frame_times(pFrameTimes, maxCount, wait) : 0;
+    }
+    unsigned int get_checksum_mismatches() { return (m_pFrameChecksums != NULL) ? m_pFrameChecksums->mismatch_count() : 0; }
 
    private:
     struct vkFuncs m_vkFuncs;
@@ -83,6 +94,16 @@ class vkReplay {
     void (*m_pCBDump)(char*);
     // VKTRACESNAPSHOT_PRINT_OBJECTS m_pVktraceSnapshotPrint;
     vkDisplay* m_display;
+    // Only created when benchmarking GPU frame times
+    vktrace_replay::GpuFrameTimer* m_pGpuFrameTimer;
+    // Only created when replaying with a persistent pipeline cache
+    vktrace_replay::PipelineCacheFile* m_pPipelineCacheFile;
+    // Only created when sub-allocating memory
+    vktrace_replay::MemorySubAllocator* m_pMemoryAllocator;
+    // m_display when replaying headless, otherwise NULL
+    vkOffscreenDisplay* m_pOffscreenDisplay;
+    // Only created when replaying headless with frame checksums
+    vktrace_replay::FrameChecksums* m_pFrameChecksums;
 
     int m_frameNumber;
     vktrace_trace_file_header* m_pFileHeader;
@@ -139,6 +160,10 @@ class vkReplay {
     void manually_replay_vkCmdBindDescriptorSets(packet_vkCmdBindDescriptorSets* pPacket);
     void manually_replay_vkCmdBindVertexBuffers(packet_vkCmdBindVertexBuffers* pPacket);
     VkResult manually_replay_vkGetPipelineCacheData(packet_vkGetPipelineCacheData* pPacket);
+    VkPipelineCache replay_pipeline_cache(VkDevice device, VkPipelineCache tracedCache);
+    VkResult allocate_memory(VkDevice device, const VkMemoryAllocateInfo* pAllocateInfo, VkDeviceSize alignment,
+                             devicememoryObj* pMem);
+    VkDeviceSize replay_memory_offset(VkDeviceMemory tracedMemory);
     VkResult manually_replay_vkCreateGraphicsPipelines(packet_vkCreateGraphicsPipelines* pPacket);
     VkResult manually_replay_vkCreateComputePipelines(packet_vkCreateComputePipelines* pPacket);
     VkResult manually_replay_vkCreatePipelineLayout(packet_vkCreatePipelineLayout* pPacket);
@@ -183,6 +208,8 @@ class vkReplay {
     VkResult manually_replay_vkCreateDebugReportCallbackEXT(packet_vkCreateDebugReportCallbackEXT* pPacket);
     void manually_replay_vkDestroyDebugReportCallbackEXT(packet_vkDestroyDebugReportCallbackEXT* pPacket);
 
+    void add_gpu_frame_timer_queue(VkDevice device, uint32_t queueFamilyIndex, VkQueue queue);
+
     void process_screenshot_list(const char* list) {
         std::string spec(list), word;
         size_t start = 0, comma = 0;
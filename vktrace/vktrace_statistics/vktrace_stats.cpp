@@ -0,0 +1,590 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#include "vktrace_stats.h"
+
+extern "C" {
+#include "vktrace_common.h"
+#include "vktrace_trace_packet_identifiers.h"
+#include "vktrace_trace_packet_utils.h"
+}
+
+#include "vktrace_trace_header_reader.h"
+#include "vktrace_vk_packet_id.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// vktrace_stats reports where the time and bytes of a trace go: calls, payload bytes and CPU time
+// per entrypoint, per thread and per frame, plus how much of each call was spent in the tracer.
+// Only packet headers are needed, so bodies are never parsed.  Packet boundaries can only be
+// found by following the header size fields, so one thread walks the headers and hands
+// batches of them to worker threads that accumulate the statistics.
+
+vktrace_stats_settings g_settings;
+vktrace_stats_settings g_default_settings;
+
+vktrace_SettingInfo g_settings_info[] = {
+    {"i", "InputTrace", VKTRACE_SETTING_STRING, {&g_settings.input_trace}, {&g_default_settings.input_trace}, TRUE,
+     "The trace file to analyze."},
+    {"o", "Output", VKTRACE_SETTING_STRING, {&g_settings.output_file}, {&g_default_settings.output_file}, TRUE,
+     "File to write the report to, default is stdout."},
+    {"f", "Format", VKTRACE_SETTING_STRING, {&g_settings.format}, {&g_default_settings.format}, TRUE,
+     "Report format. Formats are \"text\", \"csv\", \"json\"."},
+    {"t", "Threads", VKTRACE_SETTING_UINT, {&g_settings.num_threads}, {&g_default_settings.num_threads}, TRUE,
+     "Number of worker threads, 0 uses one per core."},
+    {"n", "Top", VKTRACE_SETTING_UINT, {&g_settings.top}, {&g_default_settings.top}, TRUE,
+     "Number of entrypoints and frames listed in the text report, 0 lists all of them."},
+#if _DEBUG
+    {"v", "Verbosity", VKTRACE_SETTING_STRING, {&g_settings.verbosity}, {&g_default_settings.verbosity}, TRUE,
+     "Verbosity mode. Modes are \"quiet\", \"errors\", \"warnings\", \"full\", \"debug\"."},
+#else
+    {"v", "Verbosity", VKTRACE_SETTING_STRING, {&g_settings.verbosity}, {&g_default_settings.verbosity}, TRUE,
+     "Verbosity mode. Modes are \"quiet\", \"errors\", \"warnings\", \"full\"."},
+#endif
+};
+
+vktrace_SettingGroup g_settingGroup = {"vktrace_stats", sizeof(g_settings_info) / sizeof(g_settings_info[0]), &g_settings_info[0]};
+
+// ------------------------------------------------------------------------------------------------
+// The report may go to stdout, so log messages go to stderr
+void loggingCallback(VktraceLogLevel level, const char* pMessage) {
+    if (level == VKTRACE_LOG_NONE) return;
+
+    switch (level) {
+        case VKTRACE_LOG_DEBUG:
+            fprintf(stderr, "vktrace_stats debug: %s\n", pMessage);
+            break;
+        case VKTRACE_LOG_ERROR:
+            fprintf(stderr, "vktrace_stats error: %s\n", pMessage);
+            break;
+        case VKTRACE_LOG_WARNING:
+            fprintf(stderr, "vktrace_stats warning: %s\n", pMessage);
+            break;
+        case VKTRACE_LOG_VERBOSE:
+            fprintf(stderr, "vktrace_stats info: %s\n", pMessage);
+            break;
+        default:
+            fprintf(stderr, "%s\n", pMessage);
+            break;
+    }
+    fflush(stderr);
+
+#if defined(WIN32)
+#if _DEBUG
+    OutputDebugString(pMessage);
+#endif
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------
+// The part of a packet header the statistics need, plus the frame the packet belongs to
+struct PacketRecord {
+    uint64_t size;
+    uint64_t entrypoint_begin_time;
+    uint64_t entrypoint_end_time;
+    uint64_t vktrace_begin_time;
+    uint64_t vktrace_end_time;
+    uint32_t thread_id;
+    uint32_t frame;
+    uint16_t packet_id;
+};
+
+// API time histogram buckets, one per decade starting at 1us
+static const uint32_t kHistogramBuckets = 8;
+static const char* const kHistogramLabels[kHistogramBuckets] = {"<1us",  "<10us", "<100us", "<1ms",
+                                                                "<10ms", "<100ms", "<1s",   ">=1s"};
+
+struct CallStats {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    uint64_t api_time = 0;    // time spent in the driver, entrypoint_end_time - entrypoint_begin_time
+    uint64_t trace_time = 0;  // time spent in the whole traced call, vktrace_end_time - vktrace_begin_time
+    uint64_t min_api_time = UINT64_MAX;
+    uint64_t max_api_time = 0;
+    uint64_t histogram[kHistogramBuckets] = {};
+
+    void add(const PacketRecord& rec) {
+        uint64_t api = (rec.entrypoint_end_time > rec.entrypoint_begin_time) ? rec.entrypoint_end_time - rec.entrypoint_begin_time : 0;
+        uint64_t trace = (rec.vktrace_end_time > rec.vktrace_begin_time) ? rec.vktrace_end_time - rec.vktrace_begin_time : 0;
+        count++;
+        bytes += rec.size;
+        api_time += api;
+        trace_time += std::max(trace, api);
+        min_api_time = std::min(min_api_time, api);
+        max_api_time = std::max(max_api_time, api);
+
+        uint32_t bucket = 0;
+        for (uint64_t limit = 1000; bucket < kHistogramBuckets - 1 && api >= limit; limit *= 10) bucket++;
+        histogram[bucket]++;
+    }
+
+    void merge(const CallStats& other) {
+        count += other.count;
+        bytes += other.bytes;
+        api_time += other.api_time;
+        trace_time += other.trace_time;
+        min_api_time = std::min(min_api_time, other.min_api_time);
+        max_api_time = std::max(max_api_time, other.max_api_time);
+        for (uint32_t i = 0; i < kHistogramBuckets; i++) histogram[i] += other.histogram[i];
+    }
+
+    uint64_t overhead() const { return trace_time - api_time; }
+};
+
+struct FrameStats {
+    CallStats calls;
+    uint64_t first_begin_time = UINT64_MAX;
+    uint64_t last_end_time = 0;
+
+    void add(const PacketRecord& rec) {
+        calls.add(rec);
+        if (rec.vktrace_begin_time != 0) first_begin_time = std::min(first_begin_time, rec.vktrace_begin_time);
+        last_end_time = std::max(last_end_time, rec.vktrace_end_time);
+    }
+
+    void merge(const FrameStats& other) {
+        calls.merge(other.calls);
+        first_begin_time = std::min(first_begin_time, other.first_begin_time);
+        last_end_time = std::max(last_end_time, other.last_end_time);
+    }
+
+    uint64_t wall_time() const { return (last_end_time > first_begin_time) ? last_end_time - first_begin_time : 0; }
+};
+
+struct TraceStats {
+    CallStats total;
+    std::unordered_map<uint16_t, CallStats> entrypoints;  // by packet id
+    std::unordered_map<uint32_t, CallStats> threads;
+    std::unordered_map<uint32_t, FrameStats> frames;
+
+    void add(const PacketRecord& rec) {
+        total.add(rec);
+        entrypoints[rec.packet_id].add(rec);
+        threads[rec.thread_id].add(rec);
+        frames[rec.frame].add(rec);
+    }
+
+    void merge(const TraceStats& other) {
+        total.merge(other.total);
+        for (const auto& entrypoint : other.entrypoints) entrypoints[entrypoint.first].merge(entrypoint.second);
+        for (const auto& thread : other.threads) threads[thread.first].merge(thread.second);
+        for (const auto& frame : other.frames) frames[frame.first].merge(frame.second);
+    }
+};
+
+// ------------------------------------------------------------------------------------------------
+class TraceScanner {
+   public:
+    TraceScanner(unsigned int numThreads) : m_numThreads(numThreads) {}
+
+    bool scan(FILE* pFile, uint64_t firstPacketOffset, TraceStats* pStats);
+
+    uint64_t packet_count() const { return m_packetCount; }
+    uint64_t file_size() const { return m_fileSize; }
+
+   private:
+    typedef std::vector<PacketRecord> Batch;
+
+    static const size_t kBatchSize = 64 * 1024;
+
+    bool walk(FILE* pFile, uint64_t firstPacketOffset);
+    void push(Batch&& batch);
+    void work(TraceStats* pStats);
+
+    unsigned int m_numThreads;
+    uint64_t m_packetCount = 0;
+    uint64_t m_fileSize = 0;
+
+    // Batches waiting for a worker.  The queue is bounded so the walker can't run ahead
+    // of the workers by more than a few batches.
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    std::deque<Batch> m_queue;
+    bool m_done = false;
+};
+
+void TraceScanner::push(Batch&& batch) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notFull.wait(lock, [this] { return m_queue.size() < 2 * m_numThreads; });
+    m_queue.push_back(std::move(batch));
+    m_notEmpty.notify_one();
+}
+
+void TraceScanner::work(TraceStats* pStats) {
+    while (true) {
+        Batch batch;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notEmpty.wait(lock, [this] { return !m_queue.empty() || m_done; });
+            if (m_queue.empty()) return;
+            batch = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_notFull.notify_one();
+        }
+        for (const PacketRecord& rec : batch) pStats->add(rec);
+    }
+}
+
+bool TraceScanner::walk(FILE* pFile, uint64_t firstPacketOffset) {
+    vktrace_trace_header_reader reader;
+    if (!reader.open(pFile, firstPacketOffset)) return false;
+    m_fileSize = reader.file_size();
+
+    uint32_t frame = 0;
+    Batch batch;
+    batch.reserve(kBatchSize);
+    while (const vktrace_trace_packet_header* pHeader = reader.next()) {
+        PacketRecord rec;
+        rec.size = pHeader->size;
+        rec.entrypoint_begin_time = pHeader->entrypoint_begin_time;
+        rec.entrypoint_end_time = pHeader->entrypoint_end_time;
+        rec.vktrace_begin_time = pHeader->vktrace_begin_time;
+        rec.vktrace_end_time = pHeader->vktrace_end_time;
+        rec.thread_id = pHeader->thread_id;
+        rec.frame = frame;
+        rec.packet_id = pHeader->packet_id;
+        batch.push_back(rec);
+        if (batch.size() == kBatchSize) {
+            push(std::move(batch));
+            batch = Batch();
+            batch.reserve(kBatchSize);
+        }
+
+        // A present is the last call of its frame
+        if (pHeader->packet_id == VKTRACE_TPI_VK_vkQueuePresentKHR) frame++;
+        m_packetCount++;
+    }
+
+    if (!batch.empty()) push(std::move(batch));
+    return !reader.failed();
+}
+
+bool TraceScanner::scan(FILE* pFile, uint64_t firstPacketOffset, TraceStats* pStats) {
+    // Each worker accumulates into its own TraceStats, they are merged once all batches are done
+    std::vector<TraceStats> workerStats(m_numThreads);
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < m_numThreads; i++) workers.emplace_back(&TraceScanner::work, this, &workerStats[i]);
+
+    bool result = walk(pFile, firstPacketOffset);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_done = true;
+    }
+    m_notEmpty.notify_all();
+    for (std::thread& worker : workers) worker.join();
+
+    for (const TraceStats& stats : workerStats) pStats->merge(stats);
+    return result;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Report writers
+
+static double ns_to_ms(uint64_t ns) { return ns / 1000000.0; }
+static double ns_to_us(uint64_t ns) { return ns / 1000.0; }
+static double percent(uint64_t part, uint64_t whole) { return whole ? 100.0 * part / whole : 0.0; }
+
+struct NamedStats {
+    std::string name;
+    const CallStats* pStats;
+};
+
+struct NamedFrame {
+    uint32_t frame;
+    const FrameStats* pStats;
+};
+
+static std::vector<NamedStats> sorted_entrypoints(const TraceStats& stats) {
+    std::vector<NamedStats> sorted;
+    for (const auto& entrypoint : stats.entrypoints) {
+        sorted.push_back({vktrace_packet_id_name(entrypoint.first), &entrypoint.second});
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const NamedStats& a, const NamedStats& b) { return a.pStats->api_time > b.pStats->api_time; });
+    return sorted;
+}
+
+static std::vector<NamedStats> sorted_threads(const TraceStats& stats) {
+    std::vector<NamedStats> sorted;
+    for (const auto& thread : stats.threads) sorted.push_back({std::to_string(thread.first), &thread.second});
+    std::sort(sorted.begin(), sorted.end(),
+              [](const NamedStats& a, const NamedStats& b) { return a.pStats->api_time > b.pStats->api_time; });
+    return sorted;
+}
+
+static std::vector<NamedFrame> sorted_frames(const TraceStats& stats) {
+    std::vector<NamedFrame> sorted;
+    for (const auto& frame : stats.frames) sorted.push_back({frame.first, &frame.second});
+    std::sort(sorted.begin(), sorted.end(), [](const NamedFrame& a, const NamedFrame& b) { return a.frame < b.frame; });
+    return sorted;
+}
+
+static void write_text_calls_row(FILE* pOut, const char* pName, const CallStats& calls, uint64_t totalApiTime) {
+    fprintf(pOut, "%-48s %10llu %14llu %12.3f %6.2f %10.3f %10.3f %9.2f", pName, (unsigned long long)calls.count,
+            (unsigned long long)calls.bytes, ns_to_ms(calls.api_time), percent(calls.api_time, totalApiTime),
+            calls.count ? ns_to_us(calls.api_time) / calls.count : 0.0, ns_to_us(calls.max_api_time),
+            percent(calls.overhead(), calls.trace_time));
+    for (uint32_t i = 0; i < kHistogramBuckets; i++) fprintf(pOut, " %9llu", (unsigned long long)calls.histogram[i]);
+    fprintf(pOut, "\n");
+}
+
+static void write_text_calls_header(FILE* pOut, const char* pName) {
+    fprintf(pOut, "%-48s %10s %14s %12s %6s %10s %10s %9s", pName, "Calls", "Bytes", "API ms", "API %", "Mean us", "Max us",
+            "Overhd %");
+    for (uint32_t i = 0; i < kHistogramBuckets; i++) fprintf(pOut, " %9s", kHistogramLabels[i]);
+    fprintf(pOut, "\n");
+}
+
+static void write_text(FILE* pOut, const TraceScanner& scanner, const TraceStats& stats, unsigned int top) {
+    const CallStats& total = stats.total;
+    std::vector<NamedFrame> frames = sorted_frames(stats);
+
+    fprintf(pOut, "Trace file:       %s\n", g_settings.input_trace);
+    fprintf(pOut, "File size:        %llu bytes\n", (unsigned long long)scanner.file_size());
+    fprintf(pOut, "Packets:          %llu (%llu bytes)\n", (unsigned long long)total.count, (unsigned long long)total.bytes);
+    fprintf(pOut, "Frames:           %u\n", (unsigned int)frames.size());
+    fprintf(pOut, "Threads:          %u\n", (unsigned int)stats.threads.size());
+    fprintf(pOut, "API time:         %.3f ms\n", ns_to_ms(total.api_time));
+    fprintf(pOut, "Tracer overhead:  %.3f ms (%.2f%% of traced call time)\n\n", ns_to_ms(total.overhead()),
+            percent(total.overhead(), total.trace_time));
+
+    std::vector<NamedStats> entrypoints = sorted_entrypoints(stats);
+    size_t count = (top == 0) ? entrypoints.size() : std::min<size_t>(top, entrypoints.size());
+    fprintf(pOut, "Entrypoints by API time (%u of %u)\n", (unsigned int)count, (unsigned int)entrypoints.size());
+    write_text_calls_header(pOut, "Entrypoint");
+    for (size_t i = 0; i < count; i++) write_text_calls_row(pOut, entrypoints[i].name.c_str(), *entrypoints[i].pStats, total.api_time);
+
+    fprintf(pOut, "\nThreads by API time\n");
+    write_text_calls_header(pOut, "Thread");
+    for (const NamedStats& thread : sorted_threads(stats)) write_text_calls_row(pOut, thread.name.c_str(), *thread.pStats, total.api_time);
+
+    if (!frames.empty()) {
+        uint64_t minWall = UINT64_MAX, maxWall = 0, sumWall = 0;
+        for (const NamedFrame& frame : frames) {
+            uint64_t wall = frame.pStats->wall_time();
+            minWall = std::min(minWall, wall);
+            maxWall = std::max(maxWall, wall);
+            sumWall += wall;
+        }
+        fprintf(pOut, "\nFrame time: min %.3f ms, mean %.3f ms, max %.3f ms\n", ns_to_ms(minWall),
+                ns_to_ms(sumWall) / frames.size(), ns_to_ms(maxWall));
+
+        std::sort(frames.begin(), frames.end(),
+                  [](const NamedFrame& a, const NamedFrame& b) { return a.pStats->wall_time() > b.pStats->wall_time(); });
+        count = (top == 0) ? frames.size() : std::min<size_t>(top, frames.size());
+        fprintf(pOut, "\nFrames by frame time (%u of %u)\n", (unsigned int)count, (unsigned int)frames.size());
+        fprintf(pOut, "%10s %12s %10s %14s %12s %9s\n", "Frame", "Frame ms", "Calls", "Bytes", "API ms", "Overhd %");
+        for (size_t i = 0; i < count; i++) {
+            const FrameStats& frame = *frames[i].pStats;
+            fprintf(pOut, "%10u %12.3f %10llu %14llu %12.3f %9.2f\n", frames[i].frame, ns_to_ms(frame.wall_time()),
+                    (unsigned long long)frame.calls.count, (unsigned long long)frame.calls.bytes, ns_to_ms(frame.calls.api_time),
+                    percent(frame.calls.overhead(), frame.calls.trace_time));
+        }
+    }
+}
+
+// One table for everything, the first column tells entrypoint, thread and frame rows apart
+static void write_csv_row(FILE* pOut, const char* pSection, const std::string& name, const CallStats& calls, const FrameStats* pFrame) {
+    fprintf(pOut, "%s,%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu,", pSection, name.c_str(), (unsigned long long)calls.count,
+            (unsigned long long)calls.bytes, (unsigned long long)calls.api_time, (unsigned long long)calls.trace_time,
+            (unsigned long long)calls.overhead(), (unsigned long long)(calls.count ? calls.min_api_time : 0),
+            (unsigned long long)calls.max_api_time);
+    if (pFrame) fprintf(pOut, "%llu", (unsigned long long)pFrame->wall_time());
+    for (uint32_t i = 0; i < kHistogramBuckets; i++) fprintf(pOut, ",%llu", (unsigned long long)calls.histogram[i]);
+    fprintf(pOut, "\n");
+}
+
+static void write_csv(FILE* pOut, const TraceStats& stats) {
+    fprintf(pOut, "section,name,calls,bytes,api_ns,trace_ns,overhead_ns,min_api_ns,max_api_ns,frame_ns");
+    for (uint32_t i = 0; i < kHistogramBuckets; i++) fprintf(pOut, ",%s", kHistogramLabels[i]);
+    fprintf(pOut, "\n");
+
+    write_csv_row(pOut, "total", "all", stats.total, NULL);
+    for (const NamedStats& entrypoint : sorted_entrypoints(stats)) write_csv_row(pOut, "entrypoint", entrypoint.name, *entrypoint.pStats, NULL);
+    for (const NamedStats& thread : sorted_threads(stats)) write_csv_row(pOut, "thread", thread.name, *thread.pStats, NULL);
+    for (const NamedFrame& frame : sorted_frames(stats))
+        write_csv_row(pOut, "frame", std::to_string(frame.frame), frame.pStats->calls, frame.pStats);
+}
+
+static void write_json_string(FILE* pOut, const char* pString) {
+    fputc('"', pOut);
+    for (const char* p = pString; *p; p++) {
+        if (*p == '"' || *p == '\\')
+            fprintf(pOut, "\\%c", *p);
+        else if ((unsigned char)*p < 0x20)
+            fprintf(pOut, "\\u%04x", (unsigned int)*p);
+        else
+            fputc(*p, pOut);
+    }
+    fputc('"', pOut);
+}
+
+static void write_json_calls(FILE* pOut, const CallStats& calls) {
+    fprintf(pOut,
+            "\"calls\": %llu, \"bytes\": %llu, \"api_ns\": %llu, \"trace_ns\": %llu, \"overhead_ns\": %llu, "
+            "\"min_api_ns\": %llu, \"max_api_ns\": %llu, \"histogram\": [",
+            (unsigned long long)calls.count, (unsigned long long)calls.bytes, (unsigned long long)calls.api_time,
+            (unsigned long long)calls.trace_time, (unsigned long long)calls.overhead(),
+            (unsigned long long)(calls.count ? calls.min_api_time : 0), (unsigned long long)calls.max_api_time);
+    for (uint32_t i = 0; i < kHistogramBuckets; i++) fprintf(pOut, "%s%llu", i ? ", " : "", (unsigned long long)calls.histogram[i]);
+    fprintf(pOut, "]");
+}
+
+static void write_json(FILE* pOut, const TraceScanner& scanner, const TraceStats& stats) {
+    fprintf(pOut, "{\n  \"trace_file\": ");
+    write_json_string(pOut, g_settings.input_trace);
+    fprintf(pOut, ",\n  \"file_size\": %llu,\n  \"histogram_buckets\": [", (unsigned long long)scanner.file_size());
+    for (uint32_t i = 0; i < kHistogramBuckets; i++) fprintf(pOut, "%s\"%s\"", i ? ", " : "", kHistogramLabels[i]);
+    fprintf(pOut, "],\n  \"total\": {");
+    write_json_calls(pOut, stats.total);
+    fprintf(pOut, "},\n  \"entrypoints\": [");
+
+    const char* pSeparator = "\n";
+    for (const NamedStats& entrypoint : sorted_entrypoints(stats)) {
+        fprintf(pOut, "%s    {\"name\": \"%s\", ", pSeparator, entrypoint.name.c_str());
+        write_json_calls(pOut, *entrypoint.pStats);
+        fprintf(pOut, "}");
+        pSeparator = ",\n";
+    }
+    fprintf(pOut, "\n  ],\n  \"threads\": [");
+
+    pSeparator = "\n";
+    for (const NamedStats& thread : sorted_threads(stats)) {
+        fprintf(pOut, "%s    {\"thread_id\": %s, ", pSeparator, thread.name.c_str());
+        write_json_calls(pOut, *thread.pStats);
+        fprintf(pOut, "}");
+        pSeparator = ",\n";
+    }
+    fprintf(pOut, "\n  ],\n  \"frames\": [");
+
+    pSeparator = "\n";
+    for (const NamedFrame& frame : sorted_frames(stats)) {
+        fprintf(pOut, "%s    {\"frame\": %u, \"frame_ns\": %llu, ", pSeparator, frame.frame,
+                (unsigned long long)frame.pStats->wall_time());
+        write_json_calls(pOut, frame.pStats->calls);
+        fprintf(pOut, "}");
+        pSeparator = ",\n";
+    }
+    fprintf(pOut, "\n  ]\n}\n");
+}
+
+// ------------------------------------------------------------------------------------------------
+int main(int argc, char* argv[]) {
+    int exitval = 0;
+    memset(&g_settings, 0, sizeof(vktrace_stats_settings));
+
+    vktrace_LogSetCallback(loggingCallback);
+    vktrace_LogSetLevel(VKTRACE_LOG_ERROR);
+
+    // setup defaults
+    memset(&g_default_settings, 0, sizeof(vktrace_stats_settings));
+    g_default_settings.format = "text";
+    g_default_settings.top = 20;
+    g_default_settings.verbosity = "errors";
+
+    if (vktrace_SettingGroup_init(&g_settingGroup, NULL, argc, argv, NULL) != 0) {
+        // invalid cmd-line parameters
+        vktrace_SettingGroup_delete(&g_settingGroup);
+        return -1;
+    }
+
+    BOOL validArgs = TRUE;
+    if (strcmp(g_settings.verbosity, "quiet") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_NONE);
+    else if (strcmp(g_settings.verbosity, "errors") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_ERROR);
+    else if (strcmp(g_settings.verbosity, "warnings") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_WARNING);
+    else if (strcmp(g_settings.verbosity, "full") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_VERBOSE);
+#if _DEBUG
+    else if (strcmp(g_settings.verbosity, "debug") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_DEBUG);
+#endif
+    else
+        validArgs = FALSE;
+
+    if (g_settings.input_trace == NULL || strlen(g_settings.input_trace) == 0) validArgs = FALSE;
+    if (strcmp(g_settings.format, "text") != 0 && strcmp(g_settings.format, "csv") != 0 && strcmp(g_settings.format, "json") != 0) {
+        vktrace_LogError("Unknown report format \"%s\".", g_settings.format);
+        validArgs = FALSE;
+    }
+
+    if (!validArgs) {
+        vktrace_SettingGroup_print(&g_settingGroup);
+        vktrace_SettingGroup_delete(&g_settingGroup);
+        return -1;
+    }
+
+    unsigned int numThreads = g_settings.num_threads;
+    if (numThreads == 0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    FILE* pIn = fopen(g_settings.input_trace, "rb");
+    FILE* pOut = NULL;
+    vktrace_trace_file_header fileHeader;
+    if (pIn == NULL) {
+        vktrace_LogError("Cannot open trace file: '%s'.", g_settings.input_trace);
+        exitval = -1;
+    } else if (fread(&fileHeader, sizeof(fileHeader), 1, pIn) != 1) {
+        vktrace_LogError("Unable to read header from file.");
+        exitval = -1;
+    } else if (fileHeader.magic != VKTRACE_FILE_MAGIC) {
+        vktrace_LogError("%s does not appear to be a valid Vulkan trace file.", g_settings.input_trace);
+        exitval = -1;
+    } else if (fileHeader.trace_file_version < VKTRACE_TRACE_FILE_VERSION_MINIMUM_COMPATIBLE) {
+        vktrace_LogError("Trace file version %u is older than minimum compatible version (%u).", fileHeader.trace_file_version,
+                         VKTRACE_TRACE_FILE_VERSION_MINIMUM_COMPATIBLE);
+        exitval = -1;
+    } else {
+        TraceStats stats;
+        TraceScanner scanner(numThreads);
+        uint64_t startTime = vktrace_get_time();
+        if (!scanner.scan(pIn, fileHeader.first_packet_offset, &stats)) {
+            vktrace_LogError("Failed to scan trace file '%s'.", g_settings.input_trace);
+            exitval = -1;
+        } else if (g_settings.output_file != NULL && (pOut = fopen(g_settings.output_file, "w")) == NULL) {
+            vktrace_LogError("Cannot create report file: '%s'.", g_settings.output_file);
+            exitval = -1;
+        } else {
+            vktrace_LogVerbose("Scanned %llu packets with %u threads in %.3f ms.", (unsigned long long)scanner.packet_count(),
+                               numThreads, ns_to_ms(vktrace_get_time() - startTime));
+            FILE* pReport = (pOut != NULL) ? pOut : stdout;
+            if (strcmp(g_settings.format, "csv") == 0)
+                write_csv(pReport, stats);
+            else if (strcmp(g_settings.format, "json") == 0)
+                write_json(pReport, scanner, stats);
+            else
+                write_text(pReport, scanner, stats, g_settings.top);
+        }
+    }
+
+    if (pIn != NULL) fclose(pIn);
+    if (pOut != NULL) fclose(pOut);
+    vktrace_SettingGroup_delete(&g_settingGroup);
+    return exitval;
+}
@@ -0,0 +1,1099 @@
+/**************************************************************************
+ *
+ * Copyright 2018 Valve Corporation
+ * Copyright (C) 2018 LunarG, Inc.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+#include "vktrace_trim.h"
+
+extern "C" {
+#include "vktrace_common.h"
+#include "vktrace_filelike.h"
+#include "vktrace_trace_packet_identifiers.h"
+#include "vktrace_trace_packet_utils.h"
+}
+
+#include "vktrace_trace_header_reader.h"
+#include "vktrace_vk_packet_id.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+// vktrace_trim reads a complete trace file and writes a new trace file that replays only
+// frames [start_frame, end_frame] of the original.  Everything before start_frame is reduced
+// to the calls needed to rebuild the state the trimmed frames depend on:
+//  - presents, acquires, waits and fence/query polling are dropped,
+//  - command buffer recordings that are never submitted again are dropped,
+//  - buffers, images, memory, views, framebuffers, fences and semaphores that are created and
+//    destroyed before start_frame are dropped along with their binds and maps, and the ranges
+//    and descriptor writes that point at them are removed from their flushes, invalidates and
+//    vkUpdateDescriptorSets,
+//  - submits of command buffers that only contain transfer commands (staging uploads) are kept,
+//    stripped of their semaphores and fence, and followed by a vkQueueWaitIdle,
+//  - fences that are still alive are created in the signal state they had at start_frame.
+// All of this is done from the packet stream alone, no Vulkan driver is needed.
+
+vktrace_trim_settings g_settings;
+vktrace_trim_settings g_default_settings;
+
+vktrace_SettingInfo g_settings_info[] = {
+    {"i", "InputTrace", VKTRACE_SETTING_STRING, {&g_settings.input_trace}, {&g_default_settings.input_trace}, TRUE,
+     "The trace file to trim."},
+    {"o", "OutputTrace", VKTRACE_SETTING_STRING, {&g_settings.output_trace}, {&g_default_settings.output_trace}, TRUE,
+     "Name of the trimmed trace file to write."},
+    {"s", "StartFrame", VKTRACE_SETTING_UINT, {&g_settings.start_frame}, {&g_default_settings.start_frame}, TRUE,
+     "The first frame to keep."},
+    {"e", "EndFrame", VKTRACE_SETTING_INT, {&g_settings.end_frame}, {&g_default_settings.end_frame}, TRUE,
+     "The last frame to keep, -1 keeps everything up to the end of the trace."},
+#if _DEBUG
+    {"v", "Verbosity", VKTRACE_SETTING_STRING, {&g_settings.verbosity}, {&g_default_settings.verbosity}, TRUE,
+     "Verbosity mode. Modes are \"quiet\", \"errors\", \"warnings\", \"full\", \"debug\"."},
+#else
+    {"v", "Verbosity", VKTRACE_SETTING_STRING, {&g_settings.verbosity}, {&g_default_settings.verbosity}, TRUE,
+     "Verbosity mode. Modes are \"quiet\", \"errors\", \"warnings\", \"full\"."},
+#endif
+};
+
+vktrace_SettingGroup g_settingGroup = {"vktrace_trim", sizeof(g_settings_info) / sizeof(g_settings_info[0]), &g_settings_info[0]};
+
+// ------------------------------------------------------------------------------------------------
+void loggingCallback(VktraceLogLevel level, const char* pMessage) {
+    if (level == VKTRACE_LOG_NONE) return;
+
+    switch (level) {
+        case VKTRACE_LOG_DEBUG:
+            printf("vktrace_trim debug: %s\n", pMessage);
+            break;
+        case VKTRACE_LOG_ERROR:
+            printf("vktrace_trim error: %s\n", pMessage);
+            break;
+        case VKTRACE_LOG_WARNING:
+            printf("vktrace_trim warning: %s\n", pMessage);
+            break;
+        case VKTRACE_LOG_VERBOSE:
+            printf("vktrace_trim info: %s\n", pMessage);
+            break;
+        default:
+            printf("%s\n", pMessage);
+            break;
+    }
+    fflush(stdout);
+
+#if defined(WIN32)
+#if _DEBUG
+    OutputDebugString(pMessage);
+#endif
+#endif
+}
+
+// What to do with a packet that precedes the trim range
+enum TrimAction : uint8_t {
+    TRIM_KEEP = 0,
+    TRIM_DROP,
+    TRIM_PATCH_SUBMIT,              // strip semaphores and fence, then wait for the queue to go idle
+    TRIM_PATCH_FENCE_SIGNALED,      // create the fence signaled
+    TRIM_PATCH_FENCE_UNSIGNALED,    // create the fence unsignaled
+    TRIM_PATCH_DESCRIPTOR_WRITES,   // remove the descriptor writes that point at dropped objects
+    TRIM_PATCH_MEMORY_RANGES,       // remove the flushed or invalidated ranges of dropped memory objects
+};
+
+static const uint64_t TRIM_NOT_DESTROYED = UINT64_MAX;
+
+// A buffer, image, memory object, view, framebuffer, fence or semaphore created before the trim range
+struct TrimObject {
+    uint16_t createPacketId;
+    uint64_t createIndex;
+    uint64_t destroyIndex;
+    std::vector<uint64_t> packets;  // packets that only make sense while this object exists
+    std::vector<size_t> parents;    // objects this one depends on (view->image, buffer->memory, ...)
+    bool pinned;                    // must survive even though it is destroyed before the trim range
+    // (packet, write) of the descriptor writes that point at this object
+    std::vector<std::pair<uint64_t, uint32_t>> descriptorWrites;
+    // (packet, range) of the flushed or invalidated ranges of this memory object
+    std::vector<std::pair<uint64_t, uint32_t>> memoryRanges;
+};
+
+// A vkUpdateDescriptorSets packet before the trim range.  Writes that point at dropped objects
+// are removed from it, the others still have to reach the descriptor sets they update.
+struct TrimDescriptorUpdate {
+    std::vector<bool> droppedWrites;
+    bool hasCopies;
+};
+
+// The packets of one vkBeginCommandBuffer ... vkEndCommandBuffer sequence
+struct TrimRecording {
+    TrimRecording() : transferOnly(true), keep(false) {}
+    std::vector<uint64_t> packets;
+    std::vector<size_t> references;      // objects used by the transfer commands in this recording
+    std::vector<uint64_t> secondaries;  // command buffers executed by this recording
+    bool transferOnly;
+    bool keep;
+};
+
+struct TrimCommandBuffer {
+    TrimCommandBuffer() : beganInRange(false) {}
+    TrimRecording recording;
+    bool beganInRange;
+};
+
+template <typename T>
+static uint64_t trim_handle(T* handle) {
+    return (uint64_t)(uintptr_t)handle;
+}
+static uint64_t trim_handle(uint64_t handle) { return handle; }
+
+// All vkCmd* packets start with the command buffer the command is recorded into
+static VkCommandBuffer trim_command_buffer_of(vktrace_trace_packet_header* pHeader) {
+    return ((packet_vkEndCommandBuffer*)pHeader->pBody)->commandBuffer;
+}
+
+static bool is_command_packet(uint16_t packet_id) {
+    const char* pName = vktrace_vk_packet_id_name((VKTRACE_TRACE_PACKET_ID_VK)packet_id);
+    return (pName != NULL && strncmp(pName, "vkCmd", 5) == 0);
+}
+
+static bool is_portability_packet(uint16_t packet_id) {
+    return (packet_id == VKTRACE_TPI_VK_vkBindImageMemory || packet_id == VKTRACE_TPI_VK_vkBindBufferMemory ||
+            packet_id == VKTRACE_TPI_VK_vkGetImageMemoryRequirements || packet_id == VKTRACE_TPI_VK_vkGetBufferMemoryRequirements ||
+            packet_id == VKTRACE_TPI_VK_vkAllocateMemory || packet_id == VKTRACE_TPI_VK_vkDestroyImage ||
+            packet_id == VKTRACE_TPI_VK_vkDestroyBuffer || packet_id == VKTRACE_TPI_VK_vkFreeMemory ||
+            packet_id == VKTRACE_TPI_VK_vkCreateBuffer || packet_id == VKTRACE_TPI_VK_vkCreateImage);
+}
+
+// Packets whose body is needed before the trim range
+static bool is_tracked_packet(uint16_t packet_id) {
+    switch (packet_id) {
+        case VKTRACE_TPI_VK_vkCreateBuffer:
+        case VKTRACE_TPI_VK_vkCreateImage:
+        case VKTRACE_TPI_VK_vkAllocateMemory:
+        case VKTRACE_TPI_VK_vkCreateImageView:
+        case VKTRACE_TPI_VK_vkCreateBufferView:
+        case VKTRACE_TPI_VK_vkCreateFramebuffer:
+        case VKTRACE_TPI_VK_vkCreateFence:
+        case VKTRACE_TPI_VK_vkCreateSemaphore:
+        case VKTRACE_TPI_VK_vkDestroyBuffer:
+        case VKTRACE_TPI_VK_vkDestroyImage:
+        case VKTRACE_TPI_VK_vkFreeMemory:
+        case VKTRACE_TPI_VK_vkDestroyImageView:
+        case VKTRACE_TPI_VK_vkDestroyBufferView:
+        case VKTRACE_TPI_VK_vkDestroyFramebuffer:
+        case VKTRACE_TPI_VK_vkDestroyFence:
+        case VKTRACE_TPI_VK_vkDestroySemaphore:
+        case VKTRACE_TPI_VK_vkBindBufferMemory:
+        case VKTRACE_TPI_VK_vkBindImageMemory:
+        case VKTRACE_TPI_VK_vkGetBufferMemoryRequirements:
+        case VKTRACE_TPI_VK_vkGetImageMemoryRequirements:
+        case VKTRACE_TPI_VK_vkGetImageSparseMemoryRequirements:
+        case VKTRACE_TPI_VK_vkGetImageSubresourceLayout:
+        case VKTRACE_TPI_VK_vkMapMemory:
+        case VKTRACE_TPI_VK_vkUnmapMemory:
+        case VKTRACE_TPI_VK_vkFlushMappedMemoryRanges:
+        case VKTRACE_TPI_VK_vkInvalidateMappedMemoryRanges:
+        case VKTRACE_TPI_VK_vkGetDeviceMemoryCommitment:
+        case VKTRACE_TPI_VK_vkUpdateDescriptorSets:
+        case VKTRACE_TPI_VK_vkQueueSubmit:
+        case VKTRACE_TPI_VK_vkResetFences:
+        case VKTRACE_TPI_VK_vkAcquireNextImageKHR:
+        case VKTRACE_TPI_VK_vkAllocateCommandBuffers:
+        case VKTRACE_TPI_VK_vkFreeCommandBuffers:
+        case VKTRACE_TPI_VK_vkResetCommandPool:
+        case VKTRACE_TPI_VK_vkDestroyCommandPool:
+        case VKTRACE_TPI_VK_vkBeginCommandBuffer:
+        case VKTRACE_TPI_VK_vkEndCommandBuffer:
+        case VKTRACE_TPI_VK_vkResetCommandBuffer:
+        case VKTRACE_TPI_VK_vkQueuePresentKHR:
+        case VKTRACE_TPI_VK_vkQueueWaitIdle:
+        case VKTRACE_TPI_VK_vkDeviceWaitIdle:
+        case VKTRACE_TPI_VK_vkWaitForFences:
+        case VKTRACE_TPI_VK_vkGetFenceStatus:
+        case VKTRACE_TPI_VK_vkGetEventStatus:
+        case VKTRACE_TPI_VK_vkGetQueryPoolResults:
+            return true;
+        default:
+            return is_command_packet(packet_id);
+    }
+}
+
+// Packets whose body is needed inside the trim range
+static bool is_range_packet(uint16_t packet_id) {
+    return (packet_id == VKTRACE_TPI_VK_vkBeginCommandBuffer || packet_id == VKTRACE_TPI_VK_vkQueueSubmit ||
+            packet_id == VKTRACE_TPI_VK_vkCmdExecuteCommands);
+}
+
+class TraceTrimmer {
+   public:
+    TraceTrimmer(uint32_t startFrame, int32_t endFrame)
+        : m_startFrame(startFrame), m_endFrame(endFrame), m_frameCount(0), m_rangeStart(0), m_rangeEnd(0), m_inRange(false) {}
+
+    bool scan(FILE* pFile, uint64_t firstPacketOffset);
+    bool write(FILE* pIn, FILE* pOut, const vktrace_trace_file_header* pFileHeader, size_t fileHeaderSize);
+
+   private:
+    vktrace_trace_packet_header* read_packet(FILE* pFile, const vktrace_trace_packet_header& hdr, bool readBody);
+
+    void track_pre_range(vktrace_trace_packet_header* pHeader, uint64_t index);
+    void track_in_range(vktrace_trace_packet_header* pHeader);
+    void track_command(vktrace_trace_packet_header* pHeader, uint64_t index);
+    void track_submit(packet_vkQueueSubmit* pPacket, uint64_t index);
+    void finalize();
+
+    void create_object(uint64_t handle, uint16_t packetId, uint64_t index);
+    void destroy_object(uint64_t handle, uint64_t index);
+    void relate(uint64_t handle, uint64_t index);
+    void relate_descriptor_write(uint64_t handle, uint64_t index, uint32_t write);
+    void relate_memory_ranges(vktrace_trace_packet_header* pHeader, uint64_t index);
+    void add_parent(uint64_t handle, uint64_t parent);
+    void pin_parents(size_t object);
+    void reference(TrimRecording& recording, uint64_t handle);
+
+    void retire(uint64_t commandBuffer);
+    void keep_recording(uint64_t commandBuffer);
+
+    uint32_t m_startFrame;
+    int32_t m_endFrame;
+    uint32_t m_frameCount;
+    uint64_t m_rangeStart;  // index of the first packet of start_frame
+    uint64_t m_rangeEnd;    // index one past the last packet of end_frame
+    bool m_inRange;
+
+    std::vector<uint64_t> m_scratch;
+    std::vector<uint8_t> m_actions;  // one per packet before the trim range
+
+    std::vector<TrimObject> m_objects;
+    std::unordered_map<uint64_t, size_t> m_liveObjects;
+    std::unordered_map<uint64_t, bool> m_fenceSignaled;
+    std::unordered_map<uint64_t, TrimCommandBuffer> m_commandBuffers;
+    std::unordered_map<uint64_t, std::vector<uint64_t>> m_poolCommandBuffers;
+    std::unordered_map<uint64_t, TrimDescriptorUpdate> m_descriptorUpdates;  // by packet index
+    std::unordered_map<uint64_t, std::vector<bool>> m_droppedMemoryRanges;    // by packet index
+};
+
+// Completes a packet whose header has just been read, reading the body when readBody is set.
+// The packet lives in a scratch buffer that is reused by the next call.  When the body is not
+// read, the file is positioned at the next packet.
+vktrace_trace_packet_header* TraceTrimmer::read_packet(FILE* pFile, const vktrace_trace_packet_header& hdr, bool readBody) {
+    if (hdr.size < sizeof(hdr)) {
+        vktrace_LogError("Packet %llu has an invalid size of %llu bytes.", hdr.global_packet_index, hdr.size);
+        return NULL;
+    }
+
+    size_t words = (size_t)(readBody ? hdr.size : sizeof(hdr));
+    words = (words + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    if (m_scratch.size() < words) m_scratch.resize(words);
+    vktrace_trace_packet_header* pHeader = (vktrace_trace_packet_header*)m_scratch.data();
+    *pHeader = hdr;
+    pHeader->pBody = (uintptr_t)(pHeader + 1);
+
+    if (readBody) {
+        if (hdr.size > sizeof(hdr) && fread(pHeader + 1, (size_t)(hdr.size - sizeof(hdr)), 1, pFile) != 1) {
+            vktrace_LogError("Failed to read packet %llu.", hdr.global_packet_index);
+            return NULL;
+        }
+    } else if (!vktrace_fskip64(pFile, hdr.size - sizeof(hdr))) {
+        vktrace_LogError("Failed to skip packet %llu.", hdr.global_packet_index);
+        return NULL;
+    }
+    return pHeader;
+}
+
+void TraceTrimmer::create_object(uint64_t handle, uint16_t packetId, uint64_t index) {
+    if (handle == 0) return;
+    TrimObject object;
+    object.createPacketId = packetId;
+    object.createIndex = index;
+    object.destroyIndex = TRIM_NOT_DESTROYED;
+    object.pinned = false;
+    // Handles can be reused once destroyed, so the map always refers to the latest object
+    m_liveObjects[handle] = m_objects.size();
+    m_objects.push_back(object);
+}
+
+void TraceTrimmer::destroy_object(uint64_t handle, uint64_t index) {
+    auto it = m_liveObjects.find(handle);
+    if (it == m_liveObjects.end()) return;
+    m_objects[it->second].destroyIndex = index;
+    m_liveObjects.erase(it);
+}
+
+void TraceTrimmer::relate(uint64_t handle, uint64_t index) {
+    auto it = m_liveObjects.find(handle);
+    if (it != m_liveObjects.end()) m_objects[it->second].packets.push_back(index);
+}
+
+void TraceTrimmer::relate_descriptor_write(uint64_t handle, uint64_t index, uint32_t write) {
+    auto it = m_liveObjects.find(handle);
+    if (it != m_liveObjects.end()) m_objects[it->second].descriptorWrites.push_back(std::make_pair(index, write));
+}
+
+// vkFlushMappedMemoryRanges and vkInvalidateMappedMemoryRanges packets have the same layout.  Each of
+// their ranges only has to survive as long as its memory object does.
+void TraceTrimmer::relate_memory_ranges(vktrace_trace_packet_header* pHeader, uint64_t index) {
+    packet_vkFlushMappedMemoryRanges* pPacket = (packet_vkFlushMappedMemoryRanges*)pHeader->pBody;
+    const VkMappedMemoryRange* pMemoryRanges =
+        (const VkMappedMemoryRange*)vktrace_trace_packet_interpret_buffer_pointer(pHeader, (intptr_t)pPacket->pMemoryRanges);
+    if (pMemoryRanges == NULL) return;
+    m_droppedMemoryRanges[index].assign(pPacket->memoryRangeCount, false);
+    for (uint32_t i = 0; i < pPacket->memoryRangeCount; i++) {
+        auto it = m_liveObjects.find(trim_handle(pMemoryRanges[i].memory));
+        if (it != m_liveObjects.end()) m_objects[it->second].memoryRanges.push_back(std::make_pair(index, i));
+    }
+}
+
+void TraceTrimmer::add_parent(uint64_t handle, uint64_t parent) {
+    auto child = m_liveObjects.find(handle);
+    auto it = m_liveObjects.find(parent);
+    if (child != m_liveObjects.end() && it != m_liveObjects.end()) m_objects[child->second].parents.push_back(it->second);
+}
+
+void TraceTrimmer::pin_parents(size_t object) {
+    for (size_t parent : m_objects[object].parents) {
+        if (!m_objects[parent].pinned) {
+            m_objects[parent].pinned = true;
+            pin_parents(parent);
+        }
+    }
+}
+
+void TraceTrimmer::reference(TrimRecording& recording, uint64_t handle) {
+    auto it = m_liveObjects.find(handle);
+    if (it != m_liveObjects.end()) recording.references.push_back(it->second);
+}
+
+// The current recording of a command buffer is being replaced; drop it unless a kept submit uses it
+void TraceTrimmer::retire(uint64_t commandBuffer) {
+    auto it = m_commandBuffers.find(commandBuffer);
+    if (it == m_commandBuffers.end()) return;
+    TrimRecording& recording = it->second.recording;
+    if (!recording.keep) {
+        for (uint64_t index : recording.packets) m_actions[index] = TRIM_DROP;
+    }
+    recording = TrimRecording();
+}
+
+// A recording made before the trim range is submitted or executed inside it
+void TraceTrimmer::keep_recording(uint64_t commandBuffer) {
+    auto it = m_commandBuffers.find(commandBuffer);
+    if (it == m_commandBuffers.end() || it->second.beganInRange || it->second.recording.keep) return;
+    TrimRecording& recording = it->second.recording;
+    recording.keep = true;
+    for (size_t object : recording.references) m_objects[object].pinned = true;
+    for (uint64_t secondary : recording.secondaries) keep_recording(secondary);
+}
+
+void TraceTrimmer::track_command(vktrace_trace_packet_header* pHeader, uint64_t index) {
+    uint64_t commandBuffer = trim_handle(trim_command_buffer_of(pHeader));
+    TrimRecording& recording = m_commandBuffers[commandBuffer].recording;
+    recording.packets.push_back(index);
+
+    switch (pHeader->packet_id) {
+        case VKTRACE_TPI_VK_vkEndCommandBuffer:
+        case VKTRACE_TPI_VK_vkCmdDebugMarkerBeginEXT:
+        case VKTRACE_TPI_VK_vkCmdDebugMarkerEndEXT:
+        case VKTRACE_TPI_VK_vkCmdDebugMarkerInsertEXT:
+            break;
+        case VKTRACE_TPI_VK_vkCmdCopyBuffer: {
+            packet_vkCmdCopyBuffer* pPacket = interpret_body_as_vkCmdCopyBuffer(pHeader);
+            reference(recording, trim_handle(pPacket->srcBuffer));
+            reference(recording, trim_handle(pPacket->dstBuffer));
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCmdCopyImage: {
+            packet_vkCmdCopyImage* pPacket = interpret_body_as_vkCmdCopyImage(pHeader);
+            reference(recording, trim_handle(pPacket->srcImage));
+            reference(recording, trim_handle(pPacket->dstImage));
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCmdBlitImage: {
+            packet_vkCmdBlitImage* pPacket = interpret_body_as_vkCmdBlitImage(pHeader);
+            reference(recording, trim_handle(pPacket->srcImage));
+            reference(recording, trim_handle(pPacket->dstImage));
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCmdCopyBufferToImage: {
+            packet_vkCmdCopyBufferToImage* pPacket = interpret_body_as_vkCmdCopyBufferToImage(pHeader);
+            reference(recording, trim_handle(pPacket->srcBuffer));
+            reference(recording, trim_handle(pPacket->dstImage));
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCmdCopyImageToBuffer: {
+            packet_vkCmdCopyImageToBuffer* pPacket = interpret_body_as_vkCmdCopyImageToBuffer(pHeader);
+            reference(recording, trim_handle(pPacket->srcImage));
+            reference(recording, trim_handle(pPacket->dstBuffer));
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCmdUpdateBuffer: {
+            // pData may be a blob reference, and blobs are never registered here; only the handle is needed
+            packet_vkCmdUpdateBuffer* pPacket = (packet_vkCmdUpdateBuffer*)pHeader->pBody;
+            reference(recording, trim_handle(pPacket->dstBuffer));
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCmdFillBuffer: {
+            packet_vkCmdFillBuffer* pPacket = interpret_body_as_vkCmdFillBuffer(pHeader);
+            reference(recording, trim_handle(pPacket->dstBuffer));
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCmdClearColorImage: {
+            packet_vkCmdClearColorImage* pPacket = interpret_body_as_vkCmdClearColorImage(pHeader);
+            reference(recording, trim_handle(pPacket->image));
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCmdClearDepthStencilImage: {
+            packet_vkCmdClearDepthStencilImage* pPacket = interpret_body_as_vkCmdClearDepthStencilImage(pHeader);
+            reference(recording, trim_handle(pPacket->image));
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCmdPipelineBarrier: {
+            packet_vkCmdPipelineBarrier* pPacket = interpret_body_as_vkCmdPipelineBarrier(pHeader);
+            for (uint32_t i = 0; i < pPacket->bufferMemoryBarrierCount && pPacket->pBufferMemoryBarriers != NULL; i++)
+                reference(recording, trim_handle(pPacket->pBufferMemoryBarriers[i].buffer));
+            for (uint32_t i = 0; i < pPacket->imageMemoryBarrierCount && pPacket->pImageMemoryBarriers != NULL; i++)
+                reference(recording, trim_handle(pPacket->pImageMemoryBarriers[i].image));
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCmdExecuteCommands: {
+            packet_vkCmdExecuteCommands* pPacket = interpret_body_as_vkCmdExecuteCommands(pHeader);
+            for (uint32_t i = 0; i < pPacket->commandBufferCount && pPacket->pCommandBuffers != NULL; i++)
+                recording.secondaries.push_back(trim_handle(pPacket->pCommandBuffers[i]));
+            recording.transferOnly = false;
+            break;
+        }
+        default:
+            recording.transferOnly = false;
+            break;
+    }
+}
+
+// Submits before the trim range are dropped, except for those that only upload data
+void TraceTrimmer::track_submit(packet_vkQueueSubmit* pPacket, uint64_t index) {
+    bool upload = (pPacket->submitCount > 0 && pPacket->pSubmits != NULL);
+    for (uint32_t i = 0; upload && i < pPacket->submitCount; i++) {
+        const VkSubmitInfo* pSubmit = &pPacket->pSubmits[i];
+        for (uint32_t j = 0; upload && j < pSubmit->commandBufferCount; j++) {
+            auto it = m_commandBuffers.find(trim_handle(pSubmit->pCommandBuffers[j]));
+            upload = (it != m_commandBuffers.end() && !it->second.recording.packets.empty() && it->second.recording.transferOnly);
+        }
+    }
+
+    if (upload) {
+        m_actions[index] = TRIM_PATCH_SUBMIT;
+        for (uint32_t i = 0; i < pPacket->submitCount; i++) {
+            for (uint32_t j = 0; j < pPacket->pSubmits[i].commandBufferCount; j++) {
+                TrimRecording& recording = m_commandBuffers[trim_handle(pPacket->pSubmits[i].pCommandBuffers[j])].recording;
+                recording.keep = true;
+                for (size_t object : recording.references) m_objects[object].pinned = true;
+            }
+        }
+    } else {
+        m_actions[index] = TRIM_DROP;
+    }
+
+    if (trim_handle(pPacket->fence) != 0) m_fenceSignaled[trim_handle(pPacket->fence)] = true;
+}
+
+void TraceTrimmer::track_pre_range(vktrace_trace_packet_header* pHeader, uint64_t index) {
+    switch (pHeader->packet_id) {
+        case VKTRACE_TPI_VK_vkCreateBuffer: {
+            packet_vkCreateBuffer* pPacket = interpret_body_as_vkCreateBuffer(pHeader);
+            if (pPacket->pBuffer != NULL) create_object(trim_handle(*pPacket->pBuffer), pHeader->packet_id, index);
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCreateImage: {
+            packet_vkCreateImage* pPacket = interpret_body_as_vkCreateImage(pHeader);
+            if (pPacket->pImage != NULL) create_object(trim_handle(*pPacket->pImage), pHeader->packet_id, index);
+            break;
+        }
+        case VKTRACE_TPI_VK_vkAllocateMemory: {
+            packet_vkAllocateMemory* pPacket = interpret_body_as_vkAllocateMemory(pHeader);
+            if (pPacket->pMemory != NULL) create_object(trim_handle(*pPacket->pMemory), pHeader->packet_id, index);
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCreateImageView: {
+            packet_vkCreateImageView* pPacket = interpret_body_as_vkCreateImageView(pHeader);
+            if (pPacket->pView != NULL && pPacket->pCreateInfo != NULL) {
+                create_object(trim_handle(*pPacket->pView), pHeader->packet_id, index);
+                add_parent(trim_handle(*pPacket->pView), trim_handle(pPacket->pCreateInfo->image));
+            }
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCreateBufferView: {
+            packet_vkCreateBufferView* pPacket = interpret_body_as_vkCreateBufferView(pHeader);
+            if (pPacket->pView != NULL && pPacket->pCreateInfo != NULL) {
+                create_object(trim_handle(*pPacket->pView), pHeader->packet_id, index);
+                add_parent(trim_handle(*pPacket->pView), trim_handle(pPacket->pCreateInfo->buffer));
+            }
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCreateFramebuffer: {
+            packet_vkCreateFramebuffer* pPacket = interpret_body_as_vkCreateFramebuffer(pHeader);
+            if (pPacket->pFramebuffer != NULL && pPacket->pCreateInfo != NULL) {
+                uint64_t framebuffer = trim_handle(*pPacket->pFramebuffer);
+                create_object(framebuffer, pHeader->packet_id, index);
+                for (uint32_t i = 0; i < pPacket->pCreateInfo->attachmentCount && pPacket->pCreateInfo->pAttachments != NULL; i++)
+                    add_parent(framebuffer, trim_handle(pPacket->pCreateInfo->pAttachments[i]));
+            }
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCreateFence: {
+            packet_vkCreateFence* pPacket = interpret_body_as_vkCreateFence(pHeader);
+            if (pPacket->pFence != NULL && pPacket->pCreateInfo != NULL) {
+                create_object(trim_handle(*pPacket->pFence), pHeader->packet_id, index);
+                m_fenceSignaled[trim_handle(*pPacket->pFence)] = (pPacket->pCreateInfo->flags & VK_FENCE_CREATE_SIGNALED_BIT) != 0;
+            }
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCreateSemaphore: {
+            packet_vkCreateSemaphore* pPacket = interpret_body_as_vkCreateSemaphore(pHeader);
+            if (pPacket->pSemaphore != NULL) create_object(trim_handle(*pPacket->pSemaphore), pHeader->packet_id, index);
+            break;
+        }
+        case VKTRACE_TPI_VK_vkDestroyBuffer:
+            destroy_object(trim_handle(interpret_body_as_vkDestroyBuffer(pHeader)->buffer), index);
+            break;
+        case VKTRACE_TPI_VK_vkDestroyImage:
+            destroy_object(trim_handle(interpret_body_as_vkDestroyImage(pHeader)->image), index);
+            break;
+        case VKTRACE_TPI_VK_vkFreeMemory:
+            destroy_object(trim_handle(interpret_body_as_vkFreeMemory(pHeader)->memory), index);
+            break;
+        case VKTRACE_TPI_VK_vkDestroyImageView:
+            destroy_object(trim_handle(interpret_body_as_vkDestroyImageView(pHeader)->imageView), index);
+            break;
+        case VKTRACE_TPI_VK_vkDestroyBufferView:
+            destroy_object(trim_handle(interpret_body_as_vkDestroyBufferView(pHeader)->bufferView), index);
+            break;
+        case VKTRACE_TPI_VK_vkDestroyFramebuffer:
+            destroy_object(trim_handle(interpret_body_as_vkDestroyFramebuffer(pHeader)->framebuffer), index);
+            break;
+        case VKTRACE_TPI_VK_vkDestroyFence: {
+            uint64_t fence = trim_handle(interpret_body_as_vkDestroyFence(pHeader)->fence);
+            destroy_object(fence, index);
+            m_fenceSignaled.erase(fence);
+            break;
+        }
+        case VKTRACE_TPI_VK_vkDestroySemaphore:
+            destroy_object(trim_handle(interpret_body_as_vkDestroySemaphore(pHeader)->semaphore), index);
+            break;
+        case VKTRACE_TPI_VK_vkBindBufferMemory: {
+            packet_vkBindBufferMemory* pPacket = interpret_body_as_vkBindBufferMemory(pHeader);
+            relate(trim_handle(pPacket->buffer), index);
+            relate(trim_handle(pPacket->memory), index);
+            add_parent(trim_handle(pPacket->buffer), trim_handle(pPacket->memory));
+            break;
+        }
+        case VKTRACE_TPI_VK_vkBindImageMemory: {
+            packet_vkBindImageMemory* pPacket = interpret_body_as_vkBindImageMemory(pHeader);
+            relate(trim_handle(pPacket->image), index);
+            relate(trim_handle(pPacket->memory), index);
+            add_parent(trim_handle(pPacket->image), trim_handle(pPacket->memory));
+            break;
+        }
+        case VKTRACE_TPI_VK_vkGetBufferMemoryRequirements:
+            relate(trim_handle(interpret_body_as_vkGetBufferMemoryRequirements(pHeader)->buffer), index);
+            break;
+        case VKTRACE_TPI_VK_vkGetImageMemoryRequirements:
+            relate(trim_handle(interpret_body_as_vkGetImageMemoryRequirements(pHeader)->image), index);
+            break;
+        case VKTRACE_TPI_VK_vkGetImageSparseMemoryRequirements:
+            relate(trim_handle(interpret_body_as_vkGetImageSparseMemoryRequirements(pHeader)->image), index);
+            break;
+        case VKTRACE_TPI_VK_vkGetImageSubresourceLayout:
+            relate(trim_handle(interpret_body_as_vkGetImageSubresourceLayout(pHeader)->image), index);
+            break;
+        case VKTRACE_TPI_VK_vkMapMemory:
+            relate(trim_handle(interpret_body_as_vkMapMemory(pHeader)->memory), index);
+            break;
+        case VKTRACE_TPI_VK_vkUnmapMemory:
+            // pData may be a blob reference, like the mapped data of the flushes below; only the handles are needed
+            relate(trim_handle(((packet_vkUnmapMemory*)pHeader->pBody)->memory), index);
+            break;
+        case VKTRACE_TPI_VK_vkGetDeviceMemoryCommitment:
+            relate(trim_handle(interpret_body_as_vkGetDeviceMemoryCommitment(pHeader)->memory), index);
+            break;
+        case VKTRACE_TPI_VK_vkFlushMappedMemoryRanges:
+        case VKTRACE_TPI_VK_vkInvalidateMappedMemoryRanges:
+            relate_memory_ranges(pHeader, index);
+            break;
+        case VKTRACE_TPI_VK_vkUpdateDescriptorSets: {
+            // Descriptor writes pointing at a dropped view or buffer have to go as well
+            packet_vkUpdateDescriptorSets* pPacket = interpret_body_as_vkUpdateDescriptorSets(pHeader);
+            TrimDescriptorUpdate& update = m_descriptorUpdates[index];
+            update.droppedWrites.assign(pPacket->pDescriptorWrites != NULL ? pPacket->descriptorWriteCount : 0, false);
+            update.hasCopies = (pPacket->descriptorCopyCount > 0);
+            for (uint32_t i = 0; i < pPacket->descriptorWriteCount && pPacket->pDescriptorWrites != NULL; i++) {
+                const VkWriteDescriptorSet* pWrite = &pPacket->pDescriptorWrites[i];
+                for (uint32_t j = 0; j < pWrite->descriptorCount; j++) {
+                    uint64_t handle = 0;
+                    switch (pWrite->descriptorType) {
+                        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+                        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+                        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+                        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+                            if (pWrite->pImageInfo != NULL) handle = trim_handle(pWrite->pImageInfo[j].imageView);
+                            break;
+                        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+                        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+                            if (pWrite->pTexelBufferView != NULL) handle = trim_handle(pWrite->pTexelBufferView[j]);
+                            break;
+                        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+                        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+                        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+                        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+                            if (pWrite->pBufferInfo != NULL) handle = trim_handle(pWrite->pBufferInfo[j].buffer);
+                            break;
+                        default:
+                            break;
+                    }
+                    relate_descriptor_write(handle, index, i);
+                }
+            }
+            break;
+        }
+        case VKTRACE_TPI_VK_vkQueueSubmit:
+            track_submit(interpret_body_as_vkQueueSubmit(pHeader), index);
+            break;
+        case VKTRACE_TPI_VK_vkResetFences: {
+            packet_vkResetFences* pPacket = interpret_body_as_vkResetFences(pHeader);
+            for (uint32_t i = 0; i < pPacket->fenceCount && pPacket->pFences != NULL; i++)
+                m_fenceSignaled[trim_handle(pPacket->pFences[i])] = false;
+            m_actions[index] = TRIM_DROP;
+            break;
+        }
+        case VKTRACE_TPI_VK_vkAcquireNextImageKHR: {
+            packet_vkAcquireNextImageKHR* pPacket = interpret_body_as_vkAcquireNextImageKHR(pHeader);
+            if (trim_handle(pPacket->fence) != 0) m_fenceSignaled[trim_handle(pPacket->fence)] = true;
+            m_actions[index] = TRIM_DROP;
+            break;
+        }
+        case VKTRACE_TPI_VK_vkAllocateCommandBuffers: {
+            packet_vkAllocateCommandBuffers* pPacket = interpret_body_as_vkAllocateCommandBuffers(pHeader);
+            if (pPacket->pAllocateInfo != NULL && pPacket->pCommandBuffers != NULL) {
+                std::vector<uint64_t>& poolCommandBuffers = m_poolCommandBuffers[trim_handle(pPacket->pAllocateInfo->commandPool)];
+                for (uint32_t i = 0; i < pPacket->pAllocateInfo->commandBufferCount; i++)
+                    poolCommandBuffers.push_back(trim_handle(pPacket->pCommandBuffers[i]));
+            }
+            break;
+        }
+        case VKTRACE_TPI_VK_vkFreeCommandBuffers: {
+            packet_vkFreeCommandBuffers* pPacket = interpret_body_as_vkFreeCommandBuffers(pHeader);
+            for (uint32_t i = 0; i < pPacket->commandBufferCount && pPacket->pCommandBuffers != NULL; i++) {
+                retire(trim_handle(pPacket->pCommandBuffers[i]));
+                m_commandBuffers.erase(trim_handle(pPacket->pCommandBuffers[i]));
+            }
+            break;
+        }
+        case VKTRACE_TPI_VK_vkResetCommandPool: {
+            packet_vkResetCommandPool* pPacket = interpret_body_as_vkResetCommandPool(pHeader);
+            for (uint64_t commandBuffer : m_poolCommandBuffers[trim_handle(pPacket->commandPool)]) retire(commandBuffer);
+            break;
+        }
+        case VKTRACE_TPI_VK_vkDestroyCommandPool: {
+            packet_vkDestroyCommandPool* pPacket = interpret_body_as_vkDestroyCommandPool(pHeader);
+            auto it = m_poolCommandBuffers.find(trim_handle(pPacket->commandPool));
+            if (it != m_poolCommandBuffers.end()) {
+                for (uint64_t commandBuffer : it->second) {
+                    retire(commandBuffer);
+                    m_commandBuffers.erase(commandBuffer);
+                }
+                m_poolCommandBuffers.erase(it);
+            }
+            break;
+        }
+        case VKTRACE_TPI_VK_vkBeginCommandBuffer: {
+            uint64_t commandBuffer = trim_handle(interpret_body_as_vkBeginCommandBuffer(pHeader)->commandBuffer);
+            retire(commandBuffer);
+            m_commandBuffers[commandBuffer].recording.packets.push_back(index);
+            break;
+        }
+        case VKTRACE_TPI_VK_vkResetCommandBuffer:
+            retire(trim_handle(interpret_body_as_vkResetCommandBuffer(pHeader)->commandBuffer));
+            break;
+        case VKTRACE_TPI_VK_vkQueuePresentKHR:
+        case VKTRACE_TPI_VK_vkQueueWaitIdle:
+        case VKTRACE_TPI_VK_vkDeviceWaitIdle:
+        case VKTRACE_TPI_VK_vkWaitForFences:
+        case VKTRACE_TPI_VK_vkGetFenceStatus:
+        case VKTRACE_TPI_VK_vkGetEventStatus:
+        case VKTRACE_TPI_VK_vkGetQueryPoolResults:
+            m_actions[index] = TRIM_DROP;
+            break;
+        case VKTRACE_TPI_VK_vkEndCommandBuffer:
+            track_command(pHeader, index);
+            break;
+        default:
+            if (is_command_packet(pHeader->packet_id)) track_command(pHeader, index);
+            break;
+    }
+}
+
+void TraceTrimmer::track_in_range(vktrace_trace_packet_header* pHeader) {
+    switch (pHeader->packet_id) {
+        case VKTRACE_TPI_VK_vkBeginCommandBuffer: {
+            uint64_t commandBuffer = trim_handle(interpret_body_as_vkBeginCommandBuffer(pHeader)->commandBuffer);
+            m_commandBuffers[commandBuffer].beganInRange = true;
+            break;
+        }
+        case VKTRACE_TPI_VK_vkQueueSubmit: {
+            packet_vkQueueSubmit* pPacket = interpret_body_as_vkQueueSubmit(pHeader);
+            for (uint32_t i = 0; i < pPacket->submitCount && pPacket->pSubmits != NULL; i++) {
+                for (uint32_t j = 0; j < pPacket->pSubmits[i].commandBufferCount; j++)
+                    keep_recording(trim_handle(pPacket->pSubmits[i].pCommandBuffers[j]));
+            }
+            break;
+        }
+        case VKTRACE_TPI_VK_vkCmdExecuteCommands: {
+            packet_vkCmdExecuteCommands* pPacket = interpret_body_as_vkCmdExecuteCommands(pHeader);
+            for (uint32_t i = 0; i < pPacket->commandBufferCount && pPacket->pCommandBuffers != NULL; i++)
+                keep_recording(trim_handle(pPacket->pCommandBuffers[i]));
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Decide the fate of everything that was left open when the trim range started
+void TraceTrimmer::finalize() {
+    for (auto& it : m_commandBuffers) {
+        TrimRecording& recording = it.second.recording;
+        if (!recording.keep) {
+            for (uint64_t index : recording.packets) m_actions[index] = TRIM_DROP;
+        }
+    }
+
+    // Objects that are still alive, or that a kept recording uses, keep everything they were built from
+    for (size_t i = 0; i < m_objects.size(); i++) {
+        if (m_objects[i].pinned || m_objects[i].destroyIndex == TRIM_NOT_DESTROYED) pin_parents(i);
+    }
+
+    for (TrimObject& object : m_objects) {
+        if (object.pinned || object.destroyIndex == TRIM_NOT_DESTROYED) continue;
+        m_actions[object.createIndex] = TRIM_DROP;
+        m_actions[object.destroyIndex] = TRIM_DROP;
+        for (uint64_t index : object.packets) m_actions[index] = TRIM_DROP;
+        for (auto& write : object.descriptorWrites) m_descriptorUpdates[write.first].droppedWrites[write.second] = true;
+        for (auto& range : object.memoryRanges) m_droppedMemoryRanges[range.first][range.second] = true;
+    }
+
+    for (auto it = m_descriptorUpdates.begin(); it != m_descriptorUpdates.end();) {
+        const TrimDescriptorUpdate& update = it->second;
+        size_t dropped = std::count(update.droppedWrites.begin(), update.droppedWrites.end(), true);
+        if (dropped == 0) {
+            it = m_descriptorUpdates.erase(it);
+            continue;
+        }
+        bool empty = (dropped == update.droppedWrites.size() && !update.hasCopies);
+        m_actions[it->first] = empty ? TRIM_DROP : TRIM_PATCH_DESCRIPTOR_WRITES;
+        ++it;
+    }
+
+    for (auto it = m_droppedMemoryRanges.begin(); it != m_droppedMemoryRanges.end();) {
+        const std::vector<bool>& droppedRanges = it->second;
+        size_t dropped = std::count(droppedRanges.begin(), droppedRanges.end(), true);
+        if (dropped == 0) {
+            it = m_droppedMemoryRanges.erase(it);
+            continue;
+        }
+        m_actions[it->first] = (dropped == droppedRanges.size()) ? TRIM_DROP : TRIM_PATCH_MEMORY_RANGES;
+        ++it;
+    }
+
+    for (auto& it : m_liveObjects) {
+        const TrimObject& object = m_objects[it.second];
+        if (object.createPacketId != VKTRACE_TPI_VK_vkCreateFence) continue;
+        m_actions[object.createIndex] = m_fenceSignaled[it.first] ? TRIM_PATCH_FENCE_SIGNALED : TRIM_PATCH_FENCE_UNSIGNALED;
+    }
+}
+
+bool TraceTrimmer::scan(FILE* pFile, uint64_t firstPacketOffset) {
+    if (!vktrace_fseek64(pFile, firstPacketOffset)) return false;
+
+    m_inRange = (m_startFrame == 0);
+    uint64_t index = 0;
+    vktrace_trace_packet_header* pHeader;
+    while (true) {
+        // Look at the packet id first so that bodies we do not care about are never read
+        vktrace_trace_packet_header hdr;
+        if (fread(&hdr, sizeof(hdr), 1, pFile) != 1) break;
+        if (hdr.packet_id == VKTRACE_TPI_PORTABILITY_TABLE) break;
+
+        bool readBody = (hdr.tracer_id == VKTRACE_TID_VULKAN) &&
+                        (m_inRange ? is_range_packet(hdr.packet_id) : is_tracked_packet(hdr.packet_id));
+        if ((pHeader = read_packet(pFile, hdr, readBody)) == NULL) return false;
+
+        if (!m_inRange) {
+            m_actions.push_back(TRIM_KEEP);
+            if (readBody) track_pre_range(pHeader, index);
+        } else if (readBody) {
+            track_in_range(pHeader);
+        }
+        index++;
+
+        if (hdr.packet_id == VKTRACE_TPI_VK_vkQueuePresentKHR) {
+            m_frameCount++;
+            if (!m_inRange && m_frameCount == m_startFrame) {
+                m_inRange = true;
+                m_rangeStart = index;
+            } else if (m_inRange && m_endFrame >= 0 && m_frameCount == (uint32_t)m_endFrame + 1) {
+                break;
+            }
+        }
+    }
+    m_rangeEnd = index;
+
+    if (!m_inRange) {
+        vktrace_LogError("Trace file only contains %u frames, can't start at frame %u.", m_frameCount, m_startFrame);
+        return false;
+    }
+    if (m_endFrame >= 0 && m_frameCount < (uint32_t)m_endFrame + 1)
+        vktrace_LogWarning("Trace file ends in frame %u, before end frame %d.", m_frameCount, m_endFrame);
+
+    finalize();
+    return true;
+}
+
+bool TraceTrimmer::write(FILE* pIn, FILE* pOut, const vktrace_trace_file_header* pFileHeader, size_t fileHeaderSize) {
+    std::vector<size_t> portabilityTable;
+    vktrace_trace_packet_header* pHeader = NULL;
+    uint64_t droppedPackets = 0, droppedBytes = 0, lastPacketIndex = 0, lastPacketEndTime = 0;
+    uint64_t addedPackets = 0;  // inserted vkQueueWaitIdle packets, which shift the index of every later packet
+    uint32_t lastPacketThreadId = 0;
+
+    // The header is rewritten without the portability table, which is only valid once it has been appended
+    std::vector<uint8_t> header((const uint8_t*)pFileHeader, (const uint8_t*)pFileHeader + fileHeaderSize);
+    ((vktrace_trace_file_header*)header.data())->portability_table_valid = 0;
+    if (fwrite(header.data(), fileHeaderSize, 1, pOut) != 1) return false;
+    if (!vktrace_fseek64(pIn, pFileHeader->first_packet_offset)) return false;
+    size_t fileOffset = (size_t)pFileHeader->first_packet_offset;
+
+    for (uint64_t index = 0; index < m_rangeEnd; index++) {
+        uint8_t action = (index < m_rangeStart) ? m_actions[index] : (uint8_t)TRIM_KEEP;
+        vktrace_trace_packet_header hdr;
+        if (fread(&hdr, sizeof(hdr), 1, pIn) != 1) return false;
+        if ((pHeader = read_packet(pIn, hdr, action != TRIM_DROP)) == NULL) return false;
+        if (action == TRIM_DROP) {
+            droppedPackets++;
+            droppedBytes += pHeader->size;
+            continue;
+        }
+
+        if (action == TRIM_PATCH_SUBMIT) {
+            // Nothing waits on an upload any more, so take its semaphores and fence away
+            packet_vkQueueSubmit* pPacket = (packet_vkQueueSubmit*)pHeader->pBody;
+            VkSubmitInfo* pSubmits =
+                (VkSubmitInfo*)vktrace_trace_packet_interpret_buffer_pointer(pHeader, (intptr_t)pPacket->pSubmits);
+            for (uint32_t i = 0; i < pPacket->submitCount && pSubmits != NULL; i++) {
+                pSubmits[i].waitSemaphoreCount = 0;
+                pSubmits[i].signalSemaphoreCount = 0;
+            }
+            pPacket->fence = VK_NULL_HANDLE;
+        } else if (action == TRIM_PATCH_FENCE_SIGNALED || action == TRIM_PATCH_FENCE_UNSIGNALED) {
+            packet_vkCreateFence* pPacket = (packet_vkCreateFence*)pHeader->pBody;
+            VkFenceCreateInfo* pCreateInfo =
+                (VkFenceCreateInfo*)vktrace_trace_packet_interpret_buffer_pointer(pHeader, (intptr_t)pPacket->pCreateInfo);
+            if (pCreateInfo != NULL) {
+                if (action == TRIM_PATCH_FENCE_SIGNALED)
+                    pCreateInfo->flags |= VK_FENCE_CREATE_SIGNALED_BIT;
+                else
+                    pCreateInfo->flags &= ~VK_FENCE_CREATE_SIGNALED_BIT;
+            }
+        } else if (action == TRIM_PATCH_DESCRIPTOR_WRITES) {
+            // The writes keep their pointers into the packet, so the kept ones are just moved down
+            packet_vkUpdateDescriptorSets* pPacket = (packet_vkUpdateDescriptorSets*)pHeader->pBody;
+            VkWriteDescriptorSet* pWrites =
+                (VkWriteDescriptorSet*)vktrace_trace_packet_interpret_buffer_pointer(pHeader, (intptr_t)pPacket->pDescriptorWrites);
+            const std::vector<bool>& droppedWrites = m_descriptorUpdates[index].droppedWrites;
+            uint32_t writeCount = 0;
+            for (uint32_t i = 0; i < pPacket->descriptorWriteCount && pWrites != NULL; i++) {
+                if (!droppedWrites[i]) pWrites[writeCount++] = pWrites[i];
+            }
+            pPacket->descriptorWriteCount = writeCount;
+        } else if (action == TRIM_PATCH_MEMORY_RANGES) {
+            // Same for the ranges, along with the offsets of the data flushed to them
+            packet_vkFlushMappedMemoryRanges* pPacket = (packet_vkFlushMappedMemoryRanges*)pHeader->pBody;
+            VkMappedMemoryRange* pMemoryRanges =
+                (VkMappedMemoryRange*)vktrace_trace_packet_interpret_buffer_pointer(pHeader, (intptr_t)pPacket->pMemoryRanges);
+            void** ppData = (void**)vktrace_trace_packet_interpret_buffer_pointer(pHeader, (intptr_t)pPacket->ppData);
+            const std::vector<bool>& droppedRanges = m_droppedMemoryRanges[index];
+            uint32_t rangeCount = 0;
+            for (uint32_t i = 0; i < pPacket->memoryRangeCount && pMemoryRanges != NULL; i++) {
+                if (droppedRanges[i]) continue;
+                pMemoryRanges[rangeCount] = pMemoryRanges[i];
+                if (ppData != NULL) ppData[rangeCount] = ppData[i];
+                rangeCount++;
+            }
+            pPacket->memoryRangeCount = rangeCount;
+        }
+
+        pHeader->global_packet_index += addedPackets;
+        if (is_portability_packet(pHeader->packet_id)) portabilityTable.push_back(fileOffset);
+        if (fwrite(pHeader, (size_t)pHeader->size, 1, pOut) != 1) return false;
+        fileOffset += (size_t)pHeader->size;
+        lastPacketIndex = pHeader->global_packet_index;
+        lastPacketThreadId = pHeader->thread_id;
+        lastPacketEndTime = pHeader->vktrace_end_time;
+
+        if (action == TRIM_PATCH_SUBMIT) {
+            // The upload has to finish before the staging resources it reads are destroyed
+            struct {
+                vktrace_trace_packet_header hdr;
+                packet_vkQueueWaitIdle body;
+            } waitIdle;
+            memset(&waitIdle, 0, sizeof(waitIdle));
+            // It follows the submit immediately, on the same thread, and takes no time of its own
+            waitIdle.hdr = *pHeader;
+            waitIdle.hdr.size = sizeof(waitIdle);
+            waitIdle.hdr.global_packet_index = ++lastPacketIndex;
+            waitIdle.hdr.vktrace_begin_time = waitIdle.hdr.entrypoint_begin_time = waitIdle.hdr.entrypoint_end_time =
+                waitIdle.hdr.vktrace_end_time = pHeader->vktrace_end_time;
+            waitIdle.hdr.packet_id = VKTRACE_TPI_VK_vkQueueWaitIdle;
+            waitIdle.hdr.next_buffers_offset = 0;
+            waitIdle.hdr.pBody = (uintptr_t)NULL;
+            waitIdle.body.queue = ((packet_vkQueueSubmit*)pHeader->pBody)->queue;
+            waitIdle.body.result = VK_SUCCESS;
+            if (fwrite(&waitIdle, sizeof(waitIdle), 1, pOut) != 1) return false;
+            fileOffset += sizeof(waitIdle);
+            addedPackets++;
+        }
+    }
+
+    // Append a new portability table, the same way vktrace does at the end of a capture
+    portabilityTable.push_back(portabilityTable.size());
+    vktrace_trace_packet_header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.size = sizeof(hdr) + portabilityTable.size() * sizeof(size_t);
+    hdr.global_packet_index = lastPacketIndex + 1;
+    hdr.tracer_id = VKTRACE_TID_VULKAN;
+    hdr.packet_id = VKTRACE_TPI_PORTABILITY_TABLE;
+    hdr.thread_id = lastPacketThreadId;
+    hdr.vktrace_begin_time = hdr.entrypoint_begin_time = hdr.entrypoint_end_time = hdr.vktrace_end_time = lastPacketEndTime;
+    if (fwrite(&hdr, sizeof(hdr), 1, pOut) != 1 ||
+        fwrite(&portabilityTable[0], sizeof(size_t), portabilityTable.size(), pOut) != portabilityTable.size())
+        return false;
+    uint64_t one_64 = 1;
+    if (!vktrace_fseek64(pOut, offsetof(vktrace_trace_file_header, portability_table_valid)) ||
+        fwrite(&one_64, sizeof(uint64_t), 1, pOut) != 1)
+        return false;
+
+    vktrace_LogVerbose("Kept %llu packets, dropped %llu packets (%llu bytes) before frame %u.", m_rangeEnd - droppedPackets,
+                       droppedPackets, droppedBytes, m_startFrame);
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+int main(int argc, char* argv[]) {
+    int exitval = 0;
+    memset(&g_settings, 0, sizeof(vktrace_trim_settings));
+
+    vktrace_LogSetCallback(loggingCallback);
+    vktrace_LogSetLevel(VKTRACE_LOG_ERROR);
+
+    // setup defaults
+    memset(&g_default_settings, 0, sizeof(vktrace_trim_settings));
+    g_default_settings.output_trace = vktrace_allocate_and_copy("vktrace_trim_out.vktrace");
+    g_default_settings.end_frame = -1;
+    g_default_settings.verbosity = "errors";
+
+    if (vktrace_SettingGroup_init(&g_settingGroup, NULL, argc, argv, NULL) != 0) {
+        // invalid cmd-line parameters
+        vktrace_SettingGroup_delete(&g_settingGroup);
+        vktrace_free(g_default_settings.output_trace);
+        return -1;
+    }
+
+    BOOL validArgs = TRUE;
+    if (strcmp(g_settings.verbosity, "quiet") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_NONE);
+    else if (strcmp(g_settings.verbosity, "errors") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_ERROR);
+    else if (strcmp(g_settings.verbosity, "warnings") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_WARNING);
+    else if (strcmp(g_settings.verbosity, "full") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_VERBOSE);
+#if _DEBUG
+    else if (strcmp(g_settings.verbosity, "debug") == 0)
+        vktrace_LogSetLevel(VKTRACE_LOG_DEBUG);
+#endif
+    else
+        validArgs = FALSE;
+
+    if (g_settings.input_trace == NULL || strlen(g_settings.input_trace) == 0) validArgs = FALSE;
+    if (g_settings.output_trace == NULL || strlen(g_settings.output_trace) == 0) validArgs = FALSE;
+    if (g_settings.end_frame >= 0 && (unsigned int)g_settings.end_frame < g_settings.start_frame) {
+        vktrace_LogError("End frame %d is before start frame %u.", g_settings.end_frame, g_settings.start_frame);
+        validArgs = FALSE;
+    }
+
+    if (!validArgs) {
+        vktrace_SettingGroup_print(&g_settingGroup);
+        vktrace_SettingGroup_delete(&g_settingGroup);
+        vktrace_free(g_default_settings.output_trace);
+        return -1;
+    }
+
+    FILE* pIn = fopen(g_settings.input_trace, "rb");
+    FILE* pOut = NULL;
+    vktrace_trace_file_header fileHeader;
+    std::vector<uint8_t> fullHeader;
+    if (pIn == NULL) {
+        vktrace_LogError("Cannot open trace file: '%s'.", g_settings.input_trace);
+        exitval = -1;
+    } else if (fread(&fileHeader, sizeof(fileHeader), 1, pIn) != 1) {
+        vktrace_LogError("Unable to read header from file.");
+        exitval = -1;
+    } else if (fileHeader.magic != VKTRACE_FILE_MAGIC || fileHeader.n_gpuinfo < 1) {
+        vktrace_LogError("%s does not appear to be a valid Vulkan trace file.", g_settings.input_trace);
+        exitval = -1;
+    } else if (fileHeader.trace_file_version < VKTRACE_TRACE_FILE_VERSION_MINIMUM_COMPATIBLE) {
+        vktrace_LogError("Trace file version %u is older than minimum compatible version (%u).", fileHeader.trace_file_version,
+                         VKTRACE_TRACE_FILE_VERSION_MINIMUM_COMPATIBLE);
+        exitval = -1;
+    } else if (fileHeader.ptrsize != sizeof(void*)) {
+        // Packet bodies hold pointer-sized fields, so they are only readable by a tool of the same size
+        vktrace_LogError("Trace file was captured by a %llu-bit application, vktrace_trim is %u-bit.", fileHeader.ptrsize * 8,
+                         (unsigned int)sizeof(void*) * 8);
+        exitval = -1;
+    } else {
+        vktrace_set_trace_version(fileHeader.trace_file_version);
+
+        // Keep the gpuinfo array that follows the header
+        size_t fileHeaderSize = sizeof(fileHeader) + (size_t)fileHeader.n_gpuinfo * sizeof(struct_gpuinfo);
+        fullHeader.resize(fileHeaderSize);
+        memcpy(fullHeader.data(), &fileHeader, sizeof(fileHeader));
+        if (fread(fullHeader.data() + sizeof(fileHeader), fileHeaderSize - sizeof(fileHeader), 1, pIn) != 1) {
+            vktrace_LogError("Unable to read header from file.");
+            exitval = -1;
+        } else {
+            TraceTrimmer trimmer(g_settings.start_frame, g_settings.end_frame);
+            if (!trimmer.scan(pIn, fileHeader.first_packet_offset)) {
+                vktrace_LogError("Failed to scan trace file '%s'.", g_settings.input_trace);
+                exitval = -1;
+            } else if ((pOut = fopen(g_settings.output_trace, "wb")) == NULL) {
+                vktrace_LogError("Cannot create trace file: '%s'.", g_settings.output_trace);
+                exitval = -1;
+            } else if (!trimmer.write(pIn, pOut, (const vktrace_trace_file_header*)fullHeader.data(), fileHeaderSize)) {
+                vktrace_LogError("Failed to write trimmed trace file '%s'.", g_settings.output_trace);
+                exitval = -1;
+            }
+        }
+    }
+
+    if (pIn != NULL) fclose(pIn);
+    if (pOut != NULL) fclose(pOut);
+    vktrace_SettingGroup_delete(&g_settingGroup);
+    vktrace_free(g_default_settings.output_trace);
+    return exitval;
+}
@@ -255,6 +255,9 @@ void vktraceviewer_QReplayWorker::playCurrentTraceFile(uint64_t startPacketIndex
                 break;
             case VKTRACE_TPI_PORTABILITY_TABLE:
                 break;
+            case VKTRACE_TPI_BLOB:
+                // registered when the trace file was loaded
+                break;
             // TODO processing code for all the above cases
             default: {
                 if (pCurPacket->pHeader->tracer_id >= VKTRACE_MAX_TRACER_ID_ARRAY_SIZE ||
@@ -72,6 +72,9 @@ void vktraceviewer_QTraceFileLoader::loadTraceFile(const QString& filename) {
                 connect(m_pController, SIGNAL(OutputMessage(VktraceLogLevel, uint64_t, const QString&)), this,
                         SIGNAL(OutputMessage(VktraceLogLevel, uint64_t, const QString&)));
 
+                // blob ids restart with every trace file
+                vktrace_trace_packet_clear_blobs();
+
                 // interpret the trace file packets
                 for (uint64_t i = 0; i < m_traceFileInfo.packetCount; i++) {
                     vktraceviewer_trace_file_packet_offsets* pOffsets = &m_traceFileInfo.pPacketOffsets[i];
@@ -92,6 +95,12 @@ void vktraceviewer_QTraceFileLoader::loadTraceFile(const QString& filename) {
                             break;
                         case VKTRACE_TPI_PORTABILITY_TABLE:
                             break;
+                        case VKTRACE_TPI_BLOB:
+                            if (!vktrace_trace_packet_register_blob(pOffsets->pHeader)) {
+                                bOpened = false;
+                                emit OutputMessage(VKTRACE_LOG_ERROR, QString("Invalid blob packet at index %1").arg(i));
+                            }
+                            break;
                         // TODO processing code for all the above cases
                         default: {
                             vktrace_trace_packet_header* pHeader = m_pController->InterpretTracePacket(pOffsets->pHeader);